@@ -66,6 +66,7 @@ typedef struct {
 	gpointer progress_user_data;
 	GDestroyNotify destroy_progress_user_data;
 	GDataFeed *feed;
+	GMainContext *context; /* main context the progress callbacks are dispatched in */
 } GetRulesAsyncData;
 
 static void
@@ -76,12 +77,20 @@ get_rules_async_data_free (GetRulesAsyncData *self)
 	if (self->feed != NULL)
 		g_object_unref (self->feed);
 
+	/* The progress callbacks may be dispatched after the feed has been parsed, so we can only be sure they've finished once the operation has
+	 * completed */
+	if (self->destroy_progress_user_data != NULL)
+		self->destroy_progress_user_data (self->progress_user_data);
+	if (self->context != NULL)
+		g_main_context_unref (self->context);
+
 	g_slice_free (GetRulesAsyncData, self);
 }
 
 static GDataFeed *
 _gdata_access_handler_get_rules (GDataAccessHandler *self, GDataService *service, GCancellable *cancellable,
-                                 GDataQueryProgressCallback progress_callback, gpointer progress_user_data, gboolean is_async, GError **error)
+                                 GDataQueryProgressCallback progress_callback, gpointer progress_user_data, GMainContext *progress_context,
+                                 GError **error)
 {
 	GDataAccessHandlerIface *iface;
 	GDataAuthorizationDomain *domain = NULL;
@@ -104,7 +113,7 @@ _gdata_access_handler_get_rules (GDataAccessHandler *self, GDataService *service
 
 	g_assert (message->response_body->data != NULL);
 	feed = _gdata_feed_new_from_xml (GDATA_TYPE_FEED, message->response_body->data, message->response_body->length, GDATA_TYPE_ACCESS_RULE,
-	                                 progress_callback, progress_user_data, is_async, error);
+	                                 progress_callback, NULL, progress_user_data, progress_context, error);
 	g_object_unref (message);
 
 	return feed;
@@ -118,15 +127,11 @@ get_rules_thread (GSimpleAsyncResult *result, GDataAccessHandler *access_handler
 
 	/* Execute the query and return */
 	data->feed = _gdata_access_handler_get_rules (access_handler, data->service, cancellable, data->progress_callback, data->progress_user_data,
-	                                              TRUE, &error);
+	                                              data->context, &error);
 	if (data->feed == NULL && error != NULL) {
 		g_simple_async_result_set_from_error (result, error);
 		g_error_free (error);
 	}
-
-	if (data->destroy_progress_user_data != NULL) {
-		data->destroy_progress_user_data (data->progress_user_data);
-	}
 }
 
 /**
@@ -147,6 +152,9 @@ get_rules_thread (GSimpleAsyncResult *result, GDataAccessHandler *access_handler
  * For more details, see gdata_access_handler_get_rules(), which is the synchronous version of this function, and gdata_service_query_async(), which
  * is the base asynchronous query function.
  *
+ * Note that, unlike gdata_service_query_async(), this runs gdata_access_handler_get_rules() in a thread from GIO's worker pool, which is blocked for
+ * the duration of the request.
+ *
  * When the operation is finished, @callback will be called. You can then call gdata_service_query_finish()
  * to get the results of the operation.
  *
@@ -171,6 +179,9 @@ gdata_access_handler_get_rules_async (GDataAccessHandler *self, GDataService *se
 	data->progress_callback = progress_callback;
 	data->progress_user_data = progress_user_data;
 	data->destroy_progress_user_data = destroy_progress_user_data;
+	data->feed = NULL;
+	data->context = g_main_context_get_thread_default ();
+	data->context = g_main_context_ref ((data->context != NULL) ? data->context : g_main_context_default ());
 
 	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_query_async);
 	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) get_rules_async_data_free);
@@ -211,5 +222,5 @@ gdata_access_handler_get_rules (GDataAccessHandler *self, GDataService *service,
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	return _gdata_access_handler_get_rules (self, service, cancellable, progress_callback, progress_user_data, FALSE, error);
+	return _gdata_access_handler_get_rules (self, service, cancellable, progress_callback, progress_user_data, NULL, error);
 }
@@ -649,7 +649,7 @@ gdata_batch_operation_run (GDataBatchOperation *self, GCancellable *cancellable,
 	}
 
 	upload_data = gdata_parsable_get_xml (GDATA_PARSABLE (feed));
-	soup_message_set_request (message, "application/atom+xml", SOUP_MEMORY_TAKE, upload_data, strlen (upload_data));
+	_gdata_service_set_request_body (priv->service, message, "application/atom+xml", upload_data, strlen (upload_data));
 
 	g_object_unref (feed);
 
@@ -726,6 +726,9 @@ run_thread (GSimpleAsyncResult *result, GDataBatchOperation *operation, GCancell
  *
  * For more details, see gdata_batch_operation_run(), which is the synchronous version of this function.
  *
+ * Note that, unlike gdata_service_query_async() and the other asynchronous #GDataService operations, this runs gdata_batch_operation_run() in a
+ * thread from GIO's worker pool, which is blocked for the duration of the request.
+ *
  * When the entire batch operation is finished, @callback will be called. You can then call gdata_batch_operation_run_finish() to get the results of
  * the batch operation.
  *
@@ -25,6 +25,15 @@
  *
  * #GDataBuffer is a simple object which allows threadsafe buffering of data meaning, for example, data can be received from
  * the network in a "push" fashion, buffered, then sent out to an output stream in a "pull" fashion.
+ *
+ * Data can be pushed by copying it into the buffer (gdata_buffer_push_data()), or by adding a reference to a #SoupBuffer which already holds it
+ * (gdata_buffer_push_buffer()). Similarly, it can be popped by copying it out (gdata_buffer_pop_data()) or as a #SoupBuffer which references the
+ * buffered data (gdata_buffer_pop_buffer()). Pushing and popping #SoupBuffer<!-- -->s allows large downloads to pass through the buffer without
+ * being copied.
+ *
+ * The amount of data in the buffer can be bounded by setting a high water mark with gdata_buffer_set_high_water_mark(). Once the buffer holds that
+ * much data, gdata_buffer_push_buffer() blocks until half of it has been popped, which applies backpressure to the pushing thread when the
+ * popping thread can't keep up.
  */
 
 #include <config.h>
@@ -32,16 +41,85 @@
 #include <string.h>
 
 #include "gdata-buffer.h"
+#include "gdata-trace.h"
 
 struct _GDataBufferChunk {
 	/*< private >*/
 	guint8 *data;
 	gsize length;
 	GDataBufferChunk *next;
-	/* Note: the data is actually allocated in the same memory block, so it's inside this comment right now.
+	SoupBuffer *buffer; /* if non-NULL, data points into this buffer, which we hold a reference to */
+	/* Note: if buffer is NULL, the data is actually allocated in the same memory block, so it's inside this comment right now.
 	 * We simply set chunk->data to point to chunk + sizeof (GDataBufferChunk). */
 };
 
+static void
+chunk_free (GDataBufferChunk *chunk)
+{
+	if (chunk->buffer != NULL)
+		soup_buffer_free (chunk->buffer);
+	g_free (chunk);
+}
+
+/* Add @chunk to the tail of the buffer and signal any threads waiting to pop. Must be called with the mutex held. */
+static void
+append_chunk (GDataBuffer *self, GDataBufferChunk *chunk)
+{
+	if (self->tail != NULL)
+		*(self->tail) = chunk;
+	else
+		self->head = chunk;
+	self->tail = &(chunk->next);
+	self->total_length += chunk->length;
+
+	GDATA_TRACE_BUFFER_PUSH (self, chunk->length);
+
+	/* Signal any threads waiting to pop that data is available */
+	g_cond_signal (&(self->cond));
+}
+
+/* Mark the buffer as having reached EOF if it hasn't already. Returns %FALSE if it had already reached EOF. Must be called with the mutex held. */
+static gboolean
+check_eof (GDataBuffer *self, gboolean push_eof)
+{
+	if (G_UNLIKELY (self->reached_eof == TRUE)) {
+		/* If we're marked as having reached EOF, don't accept any more data */
+		return FALSE;
+	} else if (G_UNLIKELY (push_eof == TRUE)) {
+		/* Mark the buffer as having reached EOF, and signal any waiting threads. */
+		self->reached_eof = TRUE;
+		g_cond_signal (&(self->cond));
+		g_cond_broadcast (&(self->space_cond));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Wake up any threads blocked in gdata_buffer_push_buffer() if enough data has been popped. Must be called with the mutex held. */
+static void
+signal_space (GDataBuffer *self)
+{
+	if (self->high_water_mark > 0 && self->total_length <= self->high_water_mark / 2)
+		g_cond_broadcast (&(self->space_cond));
+}
+
+typedef struct {
+	GDataBuffer *buffer;
+	GCond *cond;
+	gboolean *cancelled;
+} CancelledData;
+
+static void
+cancelled_cb (GCancellable *cancellable, CancelledData *data)
+{
+	/* Signal the blocking push or pop function that it should stop blocking and cancel */
+	g_mutex_lock (&(data->buffer->mutex));
+	*(data->cancelled) = TRUE;
+	g_cond_broadcast (data->cond);
+	g_mutex_unlock (&(data->buffer->mutex));
+}
+
 /**
  * gdata_buffer_new:
  *
@@ -58,6 +136,7 @@ gdata_buffer_new (void)
 
 	g_mutex_init (&(buffer->mutex));
 	g_cond_init (&(buffer->cond));
+	g_cond_init (&(buffer->space_cond));
 
 	return buffer;
 }
@@ -80,9 +159,10 @@ gdata_buffer_free (GDataBuffer *self)
 
 	for (chunk = self->head; chunk != NULL; chunk = next_chunk) {
 		next_chunk = chunk->next;
-		g_free (chunk);
+		chunk_free (chunk);
 	}
 
+	g_cond_clear (&(self->space_cond));
 	g_cond_clear (&(self->cond));
 	g_mutex_clear (&(self->mutex));
 
@@ -117,15 +197,8 @@ gdata_buffer_push_data (GDataBuffer *self, const guint8 *data, gsize length)
 
 	g_mutex_lock (&(self->mutex));
 
-	if (G_UNLIKELY (self->reached_eof == TRUE)) {
-		/* If we're marked as having reached EOF, don't accept any more data */
-		g_mutex_unlock (&(self->mutex));
-		return FALSE;
-	} else if (G_UNLIKELY (data == NULL && length == 0)) {
-		/* If @data is NULL and @length is 0, mark the buffer as having reached EOF,
-		 * and signal any waiting threads. */
-		self->reached_eof = TRUE;
-		g_cond_signal (&(self->cond));
+	/* If @data is NULL and @length is 0, mark the buffer as having reached EOF */
+	if (check_eof (self, data == NULL && length == 0) == FALSE) {
 		g_mutex_unlock (&(self->mutex));
 		return FALSE;
 	}
@@ -135,40 +208,141 @@ gdata_buffer_push_data (GDataBuffer *self, const guint8 *data, gsize length)
 	chunk->data = (guint8*) ((guint8*) chunk + sizeof (GDataBufferChunk)); /* pointer arithmetic in terms of bytes here */
 	chunk->length = length;
 	chunk->next = NULL;
+	chunk->buffer = NULL;
 
 	/* Copy the data to the chunk */
 	if (G_LIKELY (data != NULL))
 		memcpy (chunk->data, data, length);
 
 	/* Add it to the buffer's tail */
-	if (self->tail != NULL)
-		*(self->tail) = chunk;
-	else
-		self->head = chunk;
-	self->tail = &(chunk->next);
-	self->total_length += length;
-
-	/* Signal any threads waiting to pop that data is available */
-	g_cond_signal (&(self->cond));
+	append_chunk (self, chunk);
 
 	g_mutex_unlock (&(self->mutex));
 
 	return TRUE;
 }
 
-typedef struct {
-	GDataBuffer *buffer;
-	gboolean *cancelled;
-} CancelledData;
+/**
+ * gdata_buffer_push_buffer:
+ * @self: a #GDataBuffer
+ * @buffer: (allow-none): the #SoupBuffer to push onto the buffer, or %NULL
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ *
+ * Pushes the data in @buffer onto the buffer without copying it, by taking a reference to @buffer (using soup_buffer_copy(), so
+ * %SOUP_MEMORY_TEMPORARY buffers are still copied). If @buffer is %NULL, the buffer will be marked as having reached the EOF, as with
+ * gdata_buffer_push_data().
+ *
+ * If the buffer has a high water mark (see gdata_buffer_set_high_water_mark()) and already holds at least that much data, this function blocks
+ * until half of it has been popped before pushing @buffer. It stops blocking early if a call to gdata_buffer_pop_data() is waiting for more data
+ * than the high water mark allows, the buffer is marked as having reached EOF, or @cancellable is cancelled (from another thread).
+ *
+ * This function is threadsafe, and behaves in the same way as gdata_buffer_push_data() otherwise.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ **/
+gboolean
+gdata_buffer_push_buffer (GDataBuffer *self, SoupBuffer *buffer, GCancellable *cancellable)
+{
+	GDataBufferChunk *chunk = NULL;
+	CancelledData cancelled_data;
+	gulong cancelled_signal = 0;
+	gboolean cancelled = FALSE;
 
-static void
-pop_cancelled_cb (GCancellable *cancellable, CancelledData *data)
+	g_return_val_if_fail (self != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+	/* As in gdata_buffer_pop_data(), this must be done before we lock @self->mutex */
+	if (buffer != NULL && cancellable != NULL) {
+		cancelled_data.buffer = self;
+		cancelled_data.cond = &(self->space_cond);
+		cancelled_data.cancelled = &cancelled;
+
+		cancelled_signal = g_cancellable_connect (cancellable, (GCallback) cancelled_cb, &cancelled_data, NULL);
+	}
+
+	g_mutex_lock (&(self->mutex));
+
+	/* Apply backpressure if the buffer's full: wait until it's drained to the low water mark (half the high water mark) */
+	if (buffer != NULL && self->high_water_mark > 0 && self->total_length >= self->high_water_mark) {
+		while (self->total_length > self->high_water_mark / 2 && self->n_waiting_pops == 0 && self->reached_eof == FALSE &&
+		       cancelled == FALSE) {
+			g_cond_wait (&(self->space_cond), &(self->mutex));
+		}
+	}
+
+	if (check_eof (self, buffer == NULL) == FALSE) {
+		g_mutex_unlock (&(self->mutex));
+		goto done;
+	}
+
+	/* Create a chunk which references the buffer */
+	chunk = g_malloc (sizeof (GDataBufferChunk));
+	chunk->buffer = soup_buffer_copy (buffer);
+	chunk->data = (guint8*) chunk->buffer->data;
+	chunk->length = chunk->buffer->length;
+	chunk->next = NULL;
+
+	append_chunk (self, chunk);
+
+	g_mutex_unlock (&(self->mutex));
+
+done:
+	/* As in gdata_buffer_pop_data(), this has to be done without @self->mutex held */
+	if (cancelled_signal != 0)
+		g_cancellable_disconnect (cancellable, cancelled_signal);
+
+	return (chunk != NULL) ? TRUE : FALSE;
+}
+
+/**
+ * gdata_buffer_set_high_water_mark:
+ * @self: a #GDataBuffer
+ * @high_water_mark: the number of bytes at which gdata_buffer_push_buffer() starts blocking, or <code class="literal">0</code> to never block
+ *
+ * Sets the high water mark for the buffer. Once at least @high_water_mark bytes are buffered, gdata_buffer_push_buffer() blocks until the amount
+ * of buffered data falls to half of @high_water_mark. gdata_buffer_push_data() never blocks. By default, there is no high water mark.
+ *
+ * This function is threadsafe.
+ *
+ * Since: 0.15.0
+ **/
+void
+gdata_buffer_set_high_water_mark (GDataBuffer *self, gsize high_water_mark)
 {
-	/* Signal the pop_data function that it should stop blocking and cancel */
-	g_mutex_lock (&(data->buffer->mutex));
-	*(data->cancelled) = TRUE;
-	g_cond_signal (&(data->buffer->cond));
-	g_mutex_unlock (&(data->buffer->mutex));
+	g_return_if_fail (self != NULL);
+
+	g_mutex_lock (&(self->mutex));
+	self->high_water_mark = high_water_mark;
+	g_cond_broadcast (&(self->space_cond));
+	g_mutex_unlock (&(self->mutex));
+}
+
+/**
+ * gdata_buffer_get_length:
+ * @self: a #GDataBuffer
+ *
+ * Gets the number of bytes currently in the buffer, waiting to be popped.
+ *
+ * This function is threadsafe.
+ *
+ * Return value: the number of bytes in the buffer
+ *
+ * Since: 0.15.0
+ **/
+gsize
+gdata_buffer_get_length (GDataBuffer *self)
+{
+	gsize length;
+
+	g_return_val_if_fail (self != NULL, 0);
+
+	g_mutex_lock (&(self->mutex));
+	length = self->total_length;
+	g_mutex_unlock (&(self->mutex));
+
+	return length;
 }
 
 /**
@@ -218,15 +392,16 @@ gdata_buffer_pop_data (GDataBuffer *self, guint8 *data, gsize length_requested,
 	 *    for remaining fraction */
 
 	/* Set up a handler so we can stop if we're cancelled. This must be done before we lock @self->mutex, or deadlock could occur if the
-	 * cancellable has already been cancelled — g_cancellable_connect() would call pop_cancelled_cb() directly, and it would attempt to lock
+	 * cancellable has already been cancelled — g_cancellable_connect() would call cancelled_cb() directly, and it would attempt to lock
 	 * @self->mutex again. */
 	if (cancellable != NULL) {
 		CancelledData cancelled_data;
 
 		cancelled_data.buffer = self;
+		cancelled_data.cond = &(self->cond);
 		cancelled_data.cancelled = &cancelled;
 
-		cancelled_signal = g_cancellable_connect (cancellable, (GCallback) pop_cancelled_cb, &cancelled_data, NULL);
+		cancelled_signal = g_cancellable_connect (cancellable, (GCallback) cancelled_cb, &cancelled_data, NULL);
 	}
 
 	g_mutex_lock (&(self->mutex));
@@ -239,7 +414,11 @@ gdata_buffer_pop_data (GDataBuffer *self, guint8 *data, gsize length_requested,
 		/* Return data up to the EOF */
 		return_length = self->total_length;
 	} else if (length_requested > self->total_length) {
-		/* Block until more data is available */
+		/* Block until more data is available. Let any blocked pushers continue past the high water mark, since they'd otherwise never push
+		 * enough data to satisfy us. */
+		self->n_waiting_pops++;
+		g_cond_broadcast (&(self->space_cond));
+
 		while (length_requested > self->total_length) {
 			/* If we've already been cancelled, don't wait on @self->cond, since it'll never be signalled again. */
 			if (cancelled == FALSE) {
@@ -255,6 +434,8 @@ gdata_buffer_pop_data (GDataBuffer *self, guint8 *data, gsize length_requested,
 				return_length = length_requested;
 			}
 		}
+
+		self->n_waiting_pops--;
 	} else {
 		return_length = length_requested;
 	}
@@ -281,7 +462,7 @@ gdata_buffer_pop_data (GDataBuffer *self, guint8 *data, gsize length_requested,
 
 		/* Free the chunk and move on */
 		next_chunk = chunk->next;
-		g_free (chunk);
+		chunk_free (chunk);
 		chunk = next_chunk;
 
 		/* Reset the head read offset, since we've processed at least the first chunk now */
@@ -304,6 +485,9 @@ gdata_buffer_pop_data (GDataBuffer *self, guint8 *data, gsize length_requested,
 	if (self->head == NULL)
 		self->tail = NULL;
 	self->total_length -= return_length;
+	signal_space (self);
+
+	GDATA_TRACE_BUFFER_POP (self, return_length);
 
 done:
 	g_mutex_unlock (&(self->mutex));
@@ -348,3 +532,107 @@ gdata_buffer_pop_data_limited (GDataBuffer *self, guint8 *data, gsize maximum_le
 
 	return gdata_buffer_pop_data (self, data, MIN (maximum_length, self->total_length), reached_eof, NULL);
 }
+
+/**
+ * gdata_buffer_pop_buffer:
+ * @self: a #GDataBuffer
+ * @maximum_length: the maximum number of bytes to return
+ * @reached_eof: return location for a value which is %TRUE when we've reached EOF, %FALSE otherwise, or %NULL
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ *
+ * Pops up to @maximum_length bytes off the head of the buffer, returning them as a #SoupBuffer. Data which was pushed using
+ * gdata_buffer_push_buffer() is returned without being copied, so the returned #SoupBuffer never contains more than one pushed buffer's
+ * worth of data, and may contain fewer than @maximum_length bytes even if more are available.
+ *
+ * If the buffer is empty, this function blocks until data is pushed onto it, the buffer reaches EOF or @cancellable is cancelled (from another
+ * thread). In the latter two cases, %NULL is returned.
+ *
+ * Return value: (transfer full) (allow-none): a #SoupBuffer containing at least one byte of data, or %NULL; free with soup_buffer_free()
+ *
+ * Since: 0.15.0
+ **/
+SoupBuffer *
+gdata_buffer_pop_buffer (GDataBuffer *self, gsize maximum_length, gboolean *reached_eof, GCancellable *cancellable)
+{
+	GDataBufferChunk *chunk;
+	SoupBuffer *buffer = NULL;
+	gsize length;
+	CancelledData cancelled_data;
+	gulong cancelled_signal = 0;
+	gboolean cancelled = FALSE;
+
+	g_return_val_if_fail (self != NULL, NULL);
+	g_return_val_if_fail (maximum_length > 0, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+
+	/* As in gdata_buffer_pop_data(), this must be done before we lock @self->mutex */
+	if (cancellable != NULL) {
+		cancelled_data.buffer = self;
+		cancelled_data.cond = &(self->cond);
+		cancelled_data.cancelled = &cancelled;
+
+		cancelled_signal = g_cancellable_connect (cancellable, (GCallback) cancelled_cb, &cancelled_data, NULL);
+	}
+
+	g_mutex_lock (&(self->mutex));
+
+	/* Block until some data is available */
+	while (self->total_length == 0 && self->reached_eof == FALSE && cancelled == FALSE)
+		g_cond_wait (&(self->cond), &(self->mutex));
+
+	/* Skip over any empty chunks */
+	while (self->head != NULL && self->head->length == self->head_read_offset) {
+		chunk = self->head;
+		self->head = chunk->next;
+		self->head_read_offset = 0;
+		chunk_free (chunk);
+	}
+
+	if (self->head == NULL) {
+		self->tail = NULL;
+		goto done;
+	}
+
+	chunk = self->head;
+	length = MIN (maximum_length, chunk->length - self->head_read_offset);
+
+	if (chunk->buffer != NULL) {
+		/* Reference the data rather than copying it */
+		buffer = soup_buffer_new_subbuffer (chunk->buffer, self->head_read_offset, length);
+	} else if (self->head_read_offset == 0 && length == chunk->length) {
+		/* Hand ownership of the whole chunk over to the SoupBuffer, since it's about to be removed from the buffer anyway */
+		buffer = soup_buffer_new_with_owner (chunk->data, length, chunk, g_free);
+		chunk = NULL;
+	} else {
+		buffer = soup_buffer_new (SOUP_MEMORY_COPY, chunk->data + self->head_read_offset, length);
+	}
+
+	self->head_read_offset += length;
+	self->total_length -= length;
+	signal_space (self);
+
+	/* Remove the head chunk if it's been completely popped */
+	if (chunk == NULL || self->head_read_offset == chunk->length) {
+		self->head = self->head->next;
+		if (self->head == NULL)
+			self->tail = NULL;
+		self->head_read_offset = 0;
+
+		if (chunk != NULL)
+			chunk_free (chunk);
+	}
+
+	GDATA_TRACE_BUFFER_POP (self, length);
+
+done:
+	if (reached_eof != NULL)
+		*reached_eof = self->reached_eof && self->total_length == 0;
+
+	g_mutex_unlock (&(self->mutex));
+
+	/* As in gdata_buffer_pop_data(), this has to be done without @self->mutex held */
+	if (cancelled_signal != 0)
+		g_cancellable_disconnect (cancellable, cancelled_signal);
+
+	return buffer;
+}
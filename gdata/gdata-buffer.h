@@ -23,6 +23,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <libsoup/soup.h>
 
 G_BEGIN_DECLS
 
@@ -45,6 +46,10 @@ typedef struct {
 
 	GMutex mutex; /* mutex protecting the entire structure on push and pop */
 	GCond cond; /* a GCond to allow a popping thread to block on data being pushed into the buffer */
+
+	gsize high_water_mark; /* if non-zero, gdata_buffer_push_buffer() blocks once this many bytes are buffered, until half of them are popped */
+	guint n_waiting_pops; /* number of pops blocked waiting for more data than the high water mark allows to be buffered */
+	GCond space_cond; /* a GCond to allow a pushing thread to block on data being popped from the buffer */
 } GDataBuffer;
 
 GDataBuffer *gdata_buffer_new (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
@@ -54,6 +59,13 @@ gboolean gdata_buffer_push_data (GDataBuffer *self, const guint8 *data, gsize le
 gsize gdata_buffer_pop_data (GDataBuffer *self, guint8 *data, gsize length_requested, gboolean *reached_eof, GCancellable *cancellable);
 gsize gdata_buffer_pop_data_limited (GDataBuffer *self, guint8 *data, gsize maximum_length, gboolean *reached_eof);
 
+void gdata_buffer_set_high_water_mark (GDataBuffer *self, gsize high_water_mark);
+gsize gdata_buffer_get_length (GDataBuffer *self);
+
+gboolean gdata_buffer_push_buffer (GDataBuffer *self, SoupBuffer *buffer, GCancellable *cancellable);
+SoupBuffer *gdata_buffer_pop_buffer (GDataBuffer *self, gsize maximum_length, gboolean *reached_eof,
+                                     GCancellable *cancellable) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
 G_END_DECLS
 
 #endif /* !GDATA_BUFFER_H */
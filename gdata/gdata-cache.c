@@ -0,0 +1,196 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-cache
+ * @short_description: GData response cache
+ * @stability: Unstable
+ * @include: gdata/gdata-cache.h
+ *
+ * #GDataCache is an abstract class for caches of query responses, which can be set as the #GDataService:cache of a #GDataService to allow
+ * conditional queries to be answered without re-downloading unchanged feeds and entries.
+ *
+ * Responses are stored by the URI they were retrieved from (as returned by gdata_query_get_query_uri()), along with the ETag and content type the
+ * server returned for them. When a query is made for a URI which has a cached response, the #GDataService sends the cached ETag in an
+ * <literal>If-None-Match</literal> header; if the server replies that the resource hasn't been modified, the cached response is parsed and returned
+ * instead of the query returning %NULL. Cached responses are always revalidated with the server in this way; they are never returned without a
+ * network round trip.
+ *
+ * Two implementations are provided: #GDataMemoryCache, which stores responses in memory, and #GDataFileCache, which stores them in a directory on
+ * disk so they persist between runs of the application. Other implementations can be provided by subclassing #GDataCache and implementing all of
+ * its virtual functions.
+ *
+ * Since cached responses are keyed only by URI, a single #GDataCache instance should not be shared between #GDataService<!-- -->s which are
+ * authorized as different users.
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+
+#include "gdata-cache.h"
+
+G_DEFINE_ABSTRACT_TYPE (GDataCache, gdata_cache, G_TYPE_OBJECT)
+
+static void
+gdata_cache_class_init (GDataCacheClass *klass)
+{
+	/* Nothing to see here */
+}
+
+static void
+gdata_cache_init (GDataCache *self)
+{
+	/* Nothing to see here */
+}
+
+/**
+ * gdata_cache_look_up:
+ * @self: a #GDataCache
+ * @uri: the URI to look up
+ * @etag: (out callee-allocates) (transfer full) (allow-none): return location for the ETag of the cached response, or %NULL
+ * @content_type: (out callee-allocates) (transfer full) (allow-none): return location for the content type of the cached response, or %NULL
+ * @body: (out callee-allocates) (transfer full) (allow-none): return location for the body of the cached response, or %NULL
+ *
+ * Looks up the response cached for @uri. If one is found, %TRUE is returned and @etag, @content_type and @body are set to newly-allocated copies of
+ * the cached ETag, content type and body. Otherwise, %FALSE is returned and the output parameters are set to %NULL.
+ *
+ * This function is thread safe.
+ *
+ * Return value: %TRUE if a response was cached for @uri, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_cache_look_up (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body)
+{
+	GDataCacheClass *klass;
+	gchar *_etag = NULL, *_content_type = NULL;
+	SoupBuffer *_body = NULL;
+	gboolean found;
+
+	g_return_val_if_fail (GDATA_IS_CACHE (self), FALSE);
+	g_return_val_if_fail (uri != NULL && *uri != '\0', FALSE);
+
+	klass = GDATA_CACHE_GET_CLASS (self);
+	g_assert (klass->look_up != NULL);
+
+	found = klass->look_up (self, uri, &_etag, &_content_type, &_body);
+	g_assert (found == TRUE || (_etag == NULL && _content_type == NULL && _body == NULL));
+
+	if (etag != NULL) {
+		*etag = _etag;
+	} else {
+		g_free (_etag);
+	}
+
+	if (content_type != NULL) {
+		*content_type = _content_type;
+	} else {
+		g_free (_content_type);
+	}
+
+	if (body != NULL) {
+		*body = _body;
+	} else if (_body != NULL) {
+		soup_buffer_free (_body);
+	}
+
+	return found;
+}
+
+/**
+ * gdata_cache_store:
+ * @self: a #GDataCache
+ * @uri: the URI the response was retrieved from
+ * @etag: the ETag the server returned for the response
+ * @content_type: (allow-none): the content type of the response, or %NULL
+ * @body: the response body
+ *
+ * Stores a response retrieved from @uri in the cache, replacing any response previously cached for @uri. @body is copied (or reffed, if it is not
+ * temporary) by the cache, so may be freed after this function returns.
+ *
+ * This function is thread safe.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_cache_store (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body)
+{
+	GDataCacheClass *klass;
+
+	g_return_if_fail (GDATA_IS_CACHE (self));
+	g_return_if_fail (uri != NULL && *uri != '\0');
+	g_return_if_fail (etag != NULL && *etag != '\0');
+	g_return_if_fail (body != NULL);
+
+	klass = GDATA_CACHE_GET_CLASS (self);
+	g_assert (klass->store != NULL);
+
+	klass->store (self, uri, etag, content_type, body);
+}
+
+/**
+ * gdata_cache_remove:
+ * @self: a #GDataCache
+ * @uri: the URI to remove the cached response for
+ *
+ * Removes the response cached for @uri, if there is one. If there isn't, this function does nothing.
+ *
+ * This function is thread safe.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_cache_remove (GDataCache *self, const gchar *uri)
+{
+	GDataCacheClass *klass;
+
+	g_return_if_fail (GDATA_IS_CACHE (self));
+	g_return_if_fail (uri != NULL && *uri != '\0');
+
+	klass = GDATA_CACHE_GET_CLASS (self);
+	g_assert (klass->remove != NULL);
+
+	klass->remove (self, uri);
+}
+
+/**
+ * gdata_cache_clear:
+ * @self: a #GDataCache
+ *
+ * Removes all the responses stored in the cache.
+ *
+ * This function is thread safe.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_cache_clear (GDataCache *self)
+{
+	GDataCacheClass *klass;
+
+	g_return_if_fail (GDATA_IS_CACHE (self));
+
+	klass = GDATA_CACHE_GET_CLASS (self);
+	g_assert (klass->clear != NULL);
+
+	klass->clear (self);
+}
@@ -0,0 +1,79 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_CACHE_H
+#define GDATA_CACHE_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <libsoup/soup.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_CACHE		(gdata_cache_get_type ())
+#define GDATA_CACHE(o)			(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_CACHE, GDataCache))
+#define GDATA_CACHE_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_CACHE, GDataCacheClass))
+#define GDATA_IS_CACHE(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_CACHE))
+#define GDATA_IS_CACHE_CLASS(k)		(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_CACHE))
+#define GDATA_CACHE_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_CACHE, GDataCacheClass))
+
+/**
+ * GDataCache:
+ *
+ * All the fields in the #GDataCache structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+} GDataCache;
+
+/**
+ * GDataCacheClass:
+ * @parent: the parent class
+ * @look_up: a function to look up the cached response for the given URI, returning %TRUE and setting the output parameters if one was found;
+ * this must be thread safe
+ * @store: a function to store a response for the given URI, replacing any response previously stored for it; this must be thread safe
+ * @remove: a function to remove any response stored for the given URI; this must be thread safe
+ * @clear: a function to remove all stored responses; this must be thread safe
+ *
+ * The class structure for the #GDataCache type. All virtual functions must be implemented by subclasses.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	GObjectClass parent;
+
+	gboolean (*look_up) (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body);
+	void (*store) (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body);
+	void (*remove) (GDataCache *self, const gchar *uri);
+	void (*clear) (GDataCache *self);
+} GDataCacheClass;
+
+GType gdata_cache_get_type (void) G_GNUC_CONST;
+
+gboolean gdata_cache_look_up (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body);
+void gdata_cache_store (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body);
+void gdata_cache_remove (GDataCache *self, const gchar *uri);
+void gdata_cache_clear (GDataCache *self);
+
+G_END_DECLS
+
+#endif /* !GDATA_CACHE_H */
@@ -0,0 +1,618 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-circuit-breaker
+ * @short_description: GData per-host circuit breaker
+ * @stability: Unstable
+ * @include: gdata/gdata-circuit-breaker.h
+ *
+ * #GDataCircuitBreaker stops a #GDataService from sending requests to a host which appears to be down, so that operations fail straight away with
+ * %GDATA_SERVICE_ERROR_CIRCUIT_OPEN rather than each waiting for its own connection timeout.
+ *
+ * The breaker keeps a circuit for each host the service talks to. While the circuit is %GDATA_CIRCUIT_STATE_CLOSED, requests are sent as normal
+ * and the outcomes of the last #GDataCircuitBreaker:window-size of them are recorded. A request fails if it couldn't be sent or no response was
+ * received (for example, because a connection couldn't be made), or if the server responded with one of the <literal>500</literal>,
+ * <literal>502</literal>, <literal>503</literal> or <literal>504</literal> status codes. Once the window is full and at least a
+ * #GDataCircuitBreaker:failure-threshold proportion of the requests in it have failed, the circuit opens (%GDATA_CIRCUIT_STATE_OPEN) and further
+ * requests to the host fail immediately.
+ *
+ * After #GDataCircuitBreaker:open-duration milliseconds, the circuit becomes %GDATA_CIRCUIT_STATE_HALF_OPEN and the next request to the host is
+ * sent as a trial, while any others still fail immediately. If the trial succeeds, the circuit closes again; if it fails, the circuit re-opens for
+ * another #GDataCircuitBreaker:open-duration.
+ *
+ * The state of each circuit can be queried using gdata_circuit_breaker_get_state(), and changes to it are notified using the
+ * #GDataCircuitBreaker::state-changed signal, which is useful for health checks. A circuit can be closed by hand using
+ * gdata_circuit_breaker_reset().
+ *
+ * Circuits are not broken by default: a #GDataCircuitBreaker has to be set as the #GDataService:circuit-breaker of each service which should use
+ * it. A single breaker can be shared between several services, in which case they share the state of each host's circuit.
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsoup/soup.h>
+
+#include "gdata-circuit-breaker.h"
+#include "gdata-private.h"
+#include "gdata-marshal.h"
+#include "gdata-enums.h"
+
+#define DEFAULT_FAILURE_THRESHOLD 0.5
+#define DEFAULT_WINDOW_SIZE 20
+#define DEFAULT_OPEN_DURATION 30000 /* ms */
+
+typedef struct {
+	GDataCircuitState state;
+	guint8 *outcomes; /* ring buffer of the outcomes of recent requests; TRUE for failures */
+	guint n_outcomes;
+	guint next_outcome;
+	guint n_failures;
+	gint64 opened_time; /* monotonic time, in microseconds */
+	gboolean trial_in_progress;
+} Circuit;
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataCircuitBreakerPrivate {
+	gdouble failure_threshold;
+	guint window_size;
+	guint open_duration;
+
+	GMutex mutex; /* protects circuits, since the breaker may be shared between services used from several threads */
+	GHashTable *circuits; /* owned host string → owned Circuit */
+};
+
+enum {
+	PROP_FAILURE_THRESHOLD = 1,
+	PROP_WINDOW_SIZE,
+	PROP_OPEN_DURATION,
+};
+
+enum {
+	SIGNAL_STATE_CHANGED,
+	LAST_SIGNAL
+};
+
+static guint circuit_breaker_signals[LAST_SIGNAL] = { 0, };
+
+G_DEFINE_TYPE (GDataCircuitBreaker, gdata_circuit_breaker, G_TYPE_OBJECT)
+
+static void
+gdata_circuit_breaker_class_init (GDataCircuitBreakerClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataCircuitBreakerPrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	/**
+	 * GDataCircuitBreaker:failure-threshold:
+	 *
+	 * The proportion of the requests in the window which have to fail for a host's circuit to open.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_FAILURE_THRESHOLD,
+	                                 g_param_spec_double ("failure-threshold",
+	                                                      "Failure threshold", "The proportion of recent requests which have to fail to open a circuit.",
+	                                                      0.0, 1.0, DEFAULT_FAILURE_THRESHOLD,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataCircuitBreaker:window-size:
+	 *
+	 * The number of recent requests to each host whose outcomes are used to decide whether to open its circuit. A circuit can't open until this
+	 * many requests have been made since it last closed. Changing it resets the recorded outcomes of all circuits.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
+	                                 g_param_spec_uint ("window-size",
+	                                                    "Window size", "The number of recent requests used to decide whether to open a circuit.",
+	                                                    1, G_MAXUINT8, DEFAULT_WINDOW_SIZE,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataCircuitBreaker:open-duration:
+	 *
+	 * The time, in milliseconds, for which a circuit stays open before a trial request is allowed through to the host.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_OPEN_DURATION,
+	                                 g_param_spec_uint ("open-duration",
+	                                                    "Open duration", "The time, in milliseconds, for which a circuit stays open.",
+	                                                    0, G_MAXUINT, DEFAULT_OPEN_DURATION,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataCircuitBreaker::state-changed:
+	 * @breaker: the #GDataCircuitBreaker
+	 * @host: the host whose circuit has changed state
+	 * @state: the new state of the circuit
+	 *
+	 * The #GDataCircuitBreaker::state-changed signal is emitted whenever the circuit for a host changes state. It's emitted in the thread which
+	 * made the request that caused the change, which might not be the main thread.
+	 *
+	 * Since: 0.15.0
+	 */
+	circuit_breaker_signals[SIGNAL_STATE_CHANGED] = g_signal_new ("state-changed",
+	                                                              G_TYPE_FROM_CLASS (klass),
+	                                                              G_SIGNAL_RUN_LAST,
+	                                                              0, NULL, NULL,
+	                                                              gdata_marshal_VOID__STRING_ENUM,
+	                                                              G_TYPE_NONE, 2, G_TYPE_STRING, GDATA_TYPE_CIRCUIT_STATE);
+}
+
+static void
+circuit_free (Circuit *circuit)
+{
+	g_free (circuit->outcomes);
+	g_slice_free (Circuit, circuit);
+}
+
+static void
+gdata_circuit_breaker_init (GDataCircuitBreaker *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_CIRCUIT_BREAKER, GDataCircuitBreakerPrivate);
+
+	self->priv->failure_threshold = DEFAULT_FAILURE_THRESHOLD;
+	self->priv->window_size = DEFAULT_WINDOW_SIZE;
+	self->priv->open_duration = DEFAULT_OPEN_DURATION;
+
+	g_mutex_init (&(self->priv->mutex));
+	self->priv->circuits = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) circuit_free);
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataCircuitBreakerPrivate *priv = GDATA_CIRCUIT_BREAKER (object)->priv;
+
+	g_hash_table_destroy (priv->circuits);
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_circuit_breaker_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataCircuitBreakerPrivate *priv = GDATA_CIRCUIT_BREAKER (object)->priv;
+
+	switch (property_id) {
+		case PROP_FAILURE_THRESHOLD:
+			g_value_set_double (value, priv->failure_threshold);
+			break;
+		case PROP_WINDOW_SIZE:
+			g_value_set_uint (value, priv->window_size);
+			break;
+		case PROP_OPEN_DURATION:
+			g_value_set_uint (value, priv->open_duration);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataCircuitBreaker *self = GDATA_CIRCUIT_BREAKER (object);
+
+	switch (property_id) {
+		case PROP_FAILURE_THRESHOLD:
+			gdata_circuit_breaker_set_failure_threshold (self, g_value_get_double (value));
+			break;
+		case PROP_WINDOW_SIZE:
+			gdata_circuit_breaker_set_window_size (self, g_value_get_uint (value));
+			break;
+		case PROP_OPEN_DURATION:
+			gdata_circuit_breaker_set_open_duration (self, g_value_get_uint (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/* Forget the outcomes of all the requests recorded for @circuit. Must be called with the mutex held. */
+static void
+circuit_clear_outcomes (GDataCircuitBreaker *self, Circuit *circuit)
+{
+	g_free (circuit->outcomes);
+	circuit->outcomes = g_malloc0 (self->priv->window_size);
+	circuit->n_outcomes = 0;
+	circuit->next_outcome = 0;
+	circuit->n_failures = 0;
+}
+
+/* Get the circuit for @host, creating a closed one if it doesn't exist yet. Must be called with the mutex held. */
+static Circuit *
+look_up_circuit (GDataCircuitBreaker *self, const gchar *host)
+{
+	Circuit *circuit;
+
+	circuit = g_hash_table_lookup (self->priv->circuits, host);
+
+	if (circuit == NULL) {
+		circuit = g_slice_new0 (Circuit);
+		circuit->state = GDATA_CIRCUIT_STATE_CLOSED;
+		circuit_clear_outcomes (self, circuit);
+
+		g_hash_table_insert (self->priv->circuits, g_strdup (host), circuit);
+	}
+
+	return circuit;
+}
+
+/* Change the state of @circuit, returning %TRUE if the state-changed signal needs to be emitted (once the mutex has been released). Must be called
+ * with the mutex held. */
+static gboolean
+circuit_set_state (GDataCircuitBreaker *self, Circuit *circuit, GDataCircuitState state)
+{
+	if (circuit->state == state)
+		return FALSE;
+
+	circuit->state = state;
+	circuit->trial_in_progress = FALSE;
+
+	if (state == GDATA_CIRCUIT_STATE_OPEN)
+		circuit->opened_time = g_get_monotonic_time ();
+	else if (state == GDATA_CIRCUIT_STATE_CLOSED)
+		circuit_clear_outcomes (self, circuit);
+
+	return TRUE;
+}
+
+static void
+emit_state_changed (GDataCircuitBreaker *self, const gchar *host, GDataCircuitState state)
+{
+	g_debug ("Circuit for host %s is now %s.", host,
+	         (state == GDATA_CIRCUIT_STATE_CLOSED) ? "closed" : (state == GDATA_CIRCUIT_STATE_OPEN) ? "open" : "half-open");
+	g_signal_emit (self, circuit_breaker_signals[SIGNAL_STATE_CHANGED], 0, host, state);
+}
+
+/**
+ * gdata_circuit_breaker_new:
+ *
+ * Creates a new #GDataCircuitBreaker with the default settings.
+ *
+ * Return value: (transfer full): a new #GDataCircuitBreaker; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataCircuitBreaker *
+gdata_circuit_breaker_new (void)
+{
+	return g_object_new (GDATA_TYPE_CIRCUIT_BREAKER, NULL);
+}
+
+/**
+ * gdata_circuit_breaker_get_failure_threshold:
+ * @self: a #GDataCircuitBreaker
+ *
+ * Gets the #GDataCircuitBreaker:failure-threshold property.
+ *
+ * Return value: the proportion of recent requests which have to fail to open a circuit
+ *
+ * Since: 0.15.0
+ */
+gdouble
+gdata_circuit_breaker_get_failure_threshold (GDataCircuitBreaker *self)
+{
+	g_return_val_if_fail (GDATA_IS_CIRCUIT_BREAKER (self), DEFAULT_FAILURE_THRESHOLD);
+	return self->priv->failure_threshold;
+}
+
+/**
+ * gdata_circuit_breaker_set_failure_threshold:
+ * @self: a #GDataCircuitBreaker
+ * @failure_threshold: the proportion of recent requests which have to fail to open a circuit; between <code class="literal">0</code> and
+ * <code class="literal">1</code>
+ *
+ * Sets the #GDataCircuitBreaker:failure-threshold property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_circuit_breaker_set_failure_threshold (GDataCircuitBreaker *self, gdouble failure_threshold)
+{
+	g_return_if_fail (GDATA_IS_CIRCUIT_BREAKER (self));
+	g_return_if_fail (failure_threshold >= 0.0 && failure_threshold <= 1.0);
+
+	self->priv->failure_threshold = failure_threshold;
+	g_object_notify (G_OBJECT (self), "failure-threshold");
+}
+
+/**
+ * gdata_circuit_breaker_get_window_size:
+ * @self: a #GDataCircuitBreaker
+ *
+ * Gets the #GDataCircuitBreaker:window-size property.
+ *
+ * Return value: the number of recent requests used to decide whether to open a circuit
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_circuit_breaker_get_window_size (GDataCircuitBreaker *self)
+{
+	g_return_val_if_fail (GDATA_IS_CIRCUIT_BREAKER (self), DEFAULT_WINDOW_SIZE);
+	return self->priv->window_size;
+}
+
+/**
+ * gdata_circuit_breaker_set_window_size:
+ * @self: a #GDataCircuitBreaker
+ * @window_size: the number of recent requests used to decide whether to open a circuit; between <code class="literal">1</code> and
+ * <code class="literal">255</code>
+ *
+ * Sets the #GDataCircuitBreaker:window-size property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_circuit_breaker_set_window_size (GDataCircuitBreaker *self, guint window_size)
+{
+	GHashTableIter iter;
+	Circuit *circuit;
+
+	g_return_if_fail (GDATA_IS_CIRCUIT_BREAKER (self));
+	g_return_if_fail (window_size >= 1 && window_size <= G_MAXUINT8);
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	self->priv->window_size = window_size;
+
+	g_hash_table_iter_init (&iter, self->priv->circuits);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &circuit) == TRUE)
+		circuit_clear_outcomes (self, circuit);
+
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "window-size");
+}
+
+/**
+ * gdata_circuit_breaker_get_open_duration:
+ * @self: a #GDataCircuitBreaker
+ *
+ * Gets the #GDataCircuitBreaker:open-duration property.
+ *
+ * Return value: the time for which a circuit stays open, in milliseconds
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_circuit_breaker_get_open_duration (GDataCircuitBreaker *self)
+{
+	g_return_val_if_fail (GDATA_IS_CIRCUIT_BREAKER (self), DEFAULT_OPEN_DURATION);
+	return self->priv->open_duration;
+}
+
+/**
+ * gdata_circuit_breaker_set_open_duration:
+ * @self: a #GDataCircuitBreaker
+ * @open_duration: the time for which a circuit stays open, in milliseconds
+ *
+ * Sets the #GDataCircuitBreaker:open-duration property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_circuit_breaker_set_open_duration (GDataCircuitBreaker *self, guint open_duration)
+{
+	g_return_if_fail (GDATA_IS_CIRCUIT_BREAKER (self));
+
+	self->priv->open_duration = open_duration;
+	g_object_notify (G_OBJECT (self), "open-duration");
+}
+
+/**
+ * gdata_circuit_breaker_get_state:
+ * @self: a #GDataCircuitBreaker
+ * @host: the host name to look up
+ *
+ * Gets the state of the circuit for @host. Hosts which no requests have been made to yet have a %GDATA_CIRCUIT_STATE_CLOSED circuit.
+ *
+ * Note that an open circuit is only changed to %GDATA_CIRCUIT_STATE_HALF_OPEN when the next request is made to its host after
+ * #GDataCircuitBreaker:open-duration has passed.
+ *
+ * Return value: the state of the circuit for @host
+ *
+ * Since: 0.15.0
+ */
+GDataCircuitState
+gdata_circuit_breaker_get_state (GDataCircuitBreaker *self, const gchar *host)
+{
+	Circuit *circuit;
+	GDataCircuitState state;
+
+	g_return_val_if_fail (GDATA_IS_CIRCUIT_BREAKER (self), GDATA_CIRCUIT_STATE_CLOSED);
+	g_return_val_if_fail (host != NULL, GDATA_CIRCUIT_STATE_CLOSED);
+
+	g_mutex_lock (&(self->priv->mutex));
+	circuit = g_hash_table_lookup (self->priv->circuits, host);
+	state = (circuit != NULL) ? circuit->state : GDATA_CIRCUIT_STATE_CLOSED;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return state;
+}
+
+/**
+ * gdata_circuit_breaker_reset:
+ * @self: a #GDataCircuitBreaker
+ * @host: the host name whose circuit should be reset
+ *
+ * Closes the circuit for @host and forgets the outcomes of its recent requests, for example because the application knows that the host has
+ * recovered. #GDataCircuitBreaker::state-changed is emitted if the circuit wasn't already closed.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_circuit_breaker_reset (GDataCircuitBreaker *self, const gchar *host)
+{
+	Circuit *circuit;
+	gboolean changed = FALSE;
+
+	g_return_if_fail (GDATA_IS_CIRCUIT_BREAKER (self));
+	g_return_if_fail (host != NULL);
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	circuit = g_hash_table_lookup (self->priv->circuits, host);
+	if (circuit != NULL) {
+		changed = circuit_set_state (self, circuit, GDATA_CIRCUIT_STATE_CLOSED);
+		circuit_clear_outcomes (self, circuit);
+	}
+
+	g_mutex_unlock (&(self->priv->mutex));
+
+	if (changed == TRUE)
+		emit_state_changed (self, host, GDATA_CIRCUIT_STATE_CLOSED);
+}
+
+/*
+ * _gdata_circuit_breaker_allow:
+ * @self: a #GDataCircuitBreaker
+ * @host: the host a request is about to be sent to
+ *
+ * Decides whether a request may be sent to @host. If this returns %TRUE, _gdata_circuit_breaker_report() must be called once the request has
+ * finished (or been cancelled).
+ *
+ * Return value: %TRUE if the request may be sent, %FALSE if it should fail immediately
+ *
+ * Since: 0.15.0
+ */
+gboolean
+_gdata_circuit_breaker_allow (GDataCircuitBreaker *self, const gchar *host)
+{
+	Circuit *circuit;
+	gboolean allow = TRUE, changed = FALSE;
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	circuit = look_up_circuit (self, host);
+
+	/* Once the circuit's been open for long enough, let a trial request through */
+	if (circuit->state == GDATA_CIRCUIT_STATE_OPEN &&
+	    g_get_monotonic_time () - circuit->opened_time >= (gint64) self->priv->open_duration * 1000) {
+		changed = circuit_set_state (self, circuit, GDATA_CIRCUIT_STATE_HALF_OPEN);
+	}
+
+	if (circuit->state == GDATA_CIRCUIT_STATE_OPEN) {
+		allow = FALSE;
+	} else if (circuit->state == GDATA_CIRCUIT_STATE_HALF_OPEN) {
+		allow = (circuit->trial_in_progress == FALSE) ? TRUE : FALSE;
+		circuit->trial_in_progress = TRUE;
+	}
+
+	g_mutex_unlock (&(self->priv->mutex));
+
+	if (changed == TRUE)
+		emit_state_changed (self, host, GDATA_CIRCUIT_STATE_HALF_OPEN);
+
+	return allow;
+}
+
+static gboolean
+status_is_failure (guint status)
+{
+	switch (status) {
+		case SOUP_STATUS_INTERNAL_SERVER_ERROR:
+		case SOUP_STATUS_BAD_GATEWAY:
+		case SOUP_STATUS_SERVICE_UNAVAILABLE:
+		case SOUP_STATUS_GATEWAY_TIMEOUT:
+			return TRUE;
+		case SOUP_STATUS_NONE:
+		case SOUP_STATUS_CANCELLED:
+			return FALSE;
+		default:
+			return SOUP_STATUS_IS_TRANSPORT_ERROR (status);
+	}
+}
+
+/*
+ * _gdata_circuit_breaker_report:
+ * @self: a #GDataCircuitBreaker
+ * @host: the host the request was sent to
+ * @status: the status code the request finished with
+ *
+ * Records the outcome of a request to @host which was allowed by _gdata_circuit_breaker_allow(), opening or closing its circuit if appropriate.
+ * Cancelled requests count as neither successes nor failures.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_circuit_breaker_report (GDataCircuitBreaker *self, const gchar *host, guint status)
+{
+	GDataCircuitBreakerPrivate *priv = self->priv;
+	Circuit *circuit;
+	gboolean failed, changed = FALSE;
+	GDataCircuitState state;
+
+	failed = status_is_failure (status);
+
+	g_mutex_lock (&(priv->mutex));
+
+	circuit = look_up_circuit (self, host);
+
+	if (status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
+		/* Let another trial request through */
+		circuit->trial_in_progress = FALSE;
+	} else if (circuit->state == GDATA_CIRCUIT_STATE_HALF_OPEN) {
+		changed = circuit_set_state (self, circuit, (failed == TRUE) ? GDATA_CIRCUIT_STATE_OPEN : GDATA_CIRCUIT_STATE_CLOSED);
+	} else if (circuit->state == GDATA_CIRCUIT_STATE_CLOSED) {
+		/* Replace the oldest outcome in the window */
+		if (circuit->n_outcomes == priv->window_size)
+			circuit->n_failures -= circuit->outcomes[circuit->next_outcome];
+		else
+			circuit->n_outcomes++;
+
+		circuit->outcomes[circuit->next_outcome] = failed;
+		circuit->n_failures += failed;
+		circuit->next_outcome = (circuit->next_outcome + 1) % priv->window_size;
+
+		if (circuit->n_outcomes == priv->window_size && circuit->n_failures > 0 &&
+		    circuit->n_failures >= priv->failure_threshold * priv->window_size) {
+			changed = circuit_set_state (self, circuit, GDATA_CIRCUIT_STATE_OPEN);
+		}
+	}
+	/* Requests which were already in progress when the circuit opened are ignored */
+
+	state = circuit->state;
+
+	g_mutex_unlock (&(priv->mutex));
+
+	if (changed == TRUE)
+		emit_state_changed (self, host, state);
+}
@@ -0,0 +1,96 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_CIRCUIT_BREAKER_H
+#define GDATA_CIRCUIT_BREAKER_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GDataCircuitState:
+ * @GDATA_CIRCUIT_STATE_CLOSED: requests to the host are sent as normal
+ * @GDATA_CIRCUIT_STATE_OPEN: too many recent requests to the host have failed, so further requests fail immediately without being sent
+ * @GDATA_CIRCUIT_STATE_HALF_OPEN: the host has been unavailable, and a single trial request is allowed through to check whether it has recovered
+ *
+ * The state of the circuit for a host in a #GDataCircuitBreaker.
+ *
+ * Since: 0.15.0
+ */
+typedef enum {
+	GDATA_CIRCUIT_STATE_CLOSED = 0,
+	GDATA_CIRCUIT_STATE_OPEN,
+	GDATA_CIRCUIT_STATE_HALF_OPEN
+} GDataCircuitState;
+
+#define GDATA_TYPE_CIRCUIT_BREAKER		(gdata_circuit_breaker_get_type ())
+#define GDATA_CIRCUIT_BREAKER(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_CIRCUIT_BREAKER, GDataCircuitBreaker))
+#define GDATA_CIRCUIT_BREAKER_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_CIRCUIT_BREAKER, GDataCircuitBreakerClass))
+#define GDATA_IS_CIRCUIT_BREAKER(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_CIRCUIT_BREAKER))
+#define GDATA_IS_CIRCUIT_BREAKER_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_CIRCUIT_BREAKER))
+#define GDATA_CIRCUIT_BREAKER_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_CIRCUIT_BREAKER, GDataCircuitBreakerClass))
+
+typedef struct _GDataCircuitBreakerPrivate	GDataCircuitBreakerPrivate;
+
+/**
+ * GDataCircuitBreaker:
+ *
+ * All the fields in the #GDataCircuitBreaker structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataCircuitBreakerPrivate *priv;
+} GDataCircuitBreaker;
+
+/**
+ * GDataCircuitBreakerClass:
+ *
+ * All the fields in the #GDataCircuitBreakerClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataCircuitBreakerClass;
+
+GType gdata_circuit_breaker_get_type (void) G_GNUC_CONST;
+
+GDataCircuitBreaker *gdata_circuit_breaker_new (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+gdouble gdata_circuit_breaker_get_failure_threshold (GDataCircuitBreaker *self) G_GNUC_PURE;
+void gdata_circuit_breaker_set_failure_threshold (GDataCircuitBreaker *self, gdouble failure_threshold);
+
+guint gdata_circuit_breaker_get_window_size (GDataCircuitBreaker *self) G_GNUC_PURE;
+void gdata_circuit_breaker_set_window_size (GDataCircuitBreaker *self, guint window_size);
+
+guint gdata_circuit_breaker_get_open_duration (GDataCircuitBreaker *self) G_GNUC_PURE;
+void gdata_circuit_breaker_set_open_duration (GDataCircuitBreaker *self, guint open_duration);
+
+GDataCircuitState gdata_circuit_breaker_get_state (GDataCircuitBreaker *self, const gchar *host);
+void gdata_circuit_breaker_reset (GDataCircuitBreaker *self, const gchar *host);
+
+G_END_DECLS
+
+#endif /* !GDATA_CIRCUIT_BREAKER_H */
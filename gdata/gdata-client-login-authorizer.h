@@ -24,6 +24,7 @@
 #include <glib-object.h>
 
 #include "gdata-authorizer.h"
+#include "gdata-connection-pool.h"
 
 G_BEGIN_DECLS
 
@@ -125,6 +126,8 @@ void gdata_client_login_authorizer_set_proxy_uri (GDataClientLoginAuthorizer *se
 guint gdata_client_login_authorizer_get_timeout (GDataClientLoginAuthorizer *self) G_GNUC_PURE;
 void gdata_client_login_authorizer_set_timeout (GDataClientLoginAuthorizer *self, guint timeout);
 
+GDataConnectionPool *gdata_client_login_authorizer_get_connection_pool (GDataClientLoginAuthorizer *self) G_GNUC_PURE;
+
 G_END_DECLS
 
 #endif /* !GDATA_CLIENT_LOGIN_AUTHORIZER_H */
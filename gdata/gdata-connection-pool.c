@@ -0,0 +1,367 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-connection-pool
+ * @short_description: GData HTTP connection pool
+ * @stability: Unstable
+ * @include: gdata/gdata-connection-pool.h
+ *
+ * #GDataConnectionPool is a pool of HTTP connections which can be shared between several #GDataService<!-- -->s and #GDataAuthorizer<!-- -->s,
+ * by passing it as their <literal>connection-pool</literal> construct property. Requests made by any of them can then re-use connections (and
+ * their TLS sessions) which were opened by the others, which saves a round trip or two per connection when, for example, an application uses
+ * #GDataCalendarService, #GDataContactsService and #GDataDocumentsService at once, since they all talk to the same Google hosts.
+ *
+ * The number of connections in the pool is bounded by #GDataConnectionPool:max-connections overall, and by
+ * #GDataConnectionPool:max-connections-per-host for each host; requests are queued once the limits are reached. Connections which are idle for
+ * longer than #GDataConnectionPool:idle-timeout are closed.
+ *
+ * Note that the other network settings of the services and authorizers sharing a pool, such as their <literal>proxy-uri</literal> and
+ * <literal>timeout</literal> properties, are also shared: changing them on one changes them on all the others.
+ *
+ * If a service or authorizer isn't given a connection pool at construction time, it creates its own private one.
+ *
+ * <example>
+ * 	<title>Sharing a Connection Pool Between Services</title>
+ * 	<programlisting>
+ *	GDataConnectionPool *pool;
+ *	GDataCalendarService *calendar_service;
+ *	GDataContactsService *contacts_service;
+ *
+ *	pool = gdata_connection_pool_new ();
+ *	gdata_connection_pool_set_max_connections_per_host (pool, 4);
+ *
+ *	calendar_service = g_object_new (GDATA_TYPE_CALENDAR_SERVICE, "authorizer", authorizer, "connection-pool", pool, NULL);
+ *	contacts_service = g_object_new (GDATA_TYPE_CONTACTS_SERVICE, "authorizer", authorizer, "connection-pool", pool, NULL);
+ *
+ *	g_object_unref (pool);
+ * 	</programlisting>
+ * </example>
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsoup/soup.h>
+
+#include "gdata-connection-pool.h"
+#include "gdata-private.h"
+
+/* The defaults are the same as libsoup's, so that services which don't share a pool behave as they always have. */
+#define DEFAULT_MAX_CONNECTIONS 10
+#define DEFAULT_MAX_CONNECTIONS_PER_HOST 2
+#define DEFAULT_IDLE_TIMEOUT 60 /* seconds */
+
+static void dispose (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataConnectionPoolPrivate {
+	SoupSession *session;
+};
+
+enum {
+	PROP_MAX_CONNECTIONS = 1,
+	PROP_MAX_CONNECTIONS_PER_HOST,
+	PROP_IDLE_TIMEOUT,
+};
+
+G_DEFINE_TYPE (GDataConnectionPool, gdata_connection_pool, G_TYPE_OBJECT)
+
+static void
+gdata_connection_pool_class_init (GDataConnectionPoolClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataConnectionPoolPrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->dispose = dispose;
+
+	/**
+	 * GDataConnectionPool:max-connections:
+	 *
+	 * The maximum number of connections the pool will have open at once, to all hosts. Requests made once this limit has been reached are queued
+	 * until a connection becomes free.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MAX_CONNECTIONS,
+	                                 g_param_spec_uint ("max-connections",
+	                                                    "Maximum connections", "The maximum number of connections open at once, to all hosts.",
+	                                                    1, G_MAXUINT, DEFAULT_MAX_CONNECTIONS,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataConnectionPool:max-connections-per-host:
+	 *
+	 * The maximum number of connections the pool will have open at once to any single host. Requests to a host made once this limit has been
+	 * reached are queued until a connection to that host becomes free.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MAX_CONNECTIONS_PER_HOST,
+	                                 g_param_spec_uint ("max-connections-per-host",
+	                                                    "Maximum connections per host", "The maximum number of connections open at once to a host.",
+	                                                    1, G_MAXUINT, DEFAULT_MAX_CONNECTIONS_PER_HOST,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataConnectionPool:idle-timeout:
+	 *
+	 * The time, in seconds, for which a connection may be idle before it's closed. Keeping idle connections open for longer increases the chances
+	 * of them being re-used, at the cost of holding resources on both ends of the connection.
+	 *
+	 * If this is <code class="literal">0</code>, idle connections are kept open until the server closes them.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+	                                 g_param_spec_uint ("idle-timeout",
+	                                                    "Idle timeout", "The time, in seconds, for which a connection may be idle before it's closed.",
+	                                                    0, G_MAXUINT, DEFAULT_IDLE_TIMEOUT,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdata_connection_pool_init (GDataConnectionPool *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_CONNECTION_POOL, GDataConnectionPoolPrivate);
+
+	self->priv->session = _gdata_service_build_session ();
+	g_object_set (self->priv->session,
+	              SOUP_SESSION_MAX_CONNS, DEFAULT_MAX_CONNECTIONS,
+	              SOUP_SESSION_MAX_CONNS_PER_HOST, DEFAULT_MAX_CONNECTIONS_PER_HOST,
+	              SOUP_SESSION_IDLE_TIMEOUT, DEFAULT_IDLE_TIMEOUT,
+	              NULL);
+}
+
+static void
+dispose (GObject *object)
+{
+	GDataConnectionPoolPrivate *priv = GDATA_CONNECTION_POOL (object)->priv;
+
+	if (priv->session != NULL)
+		g_object_unref (priv->session);
+	priv->session = NULL;
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_connection_pool_parent_class)->dispose (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataConnectionPool *self = GDATA_CONNECTION_POOL (object);
+
+	switch (property_id) {
+		case PROP_MAX_CONNECTIONS:
+			g_value_set_uint (value, gdata_connection_pool_get_max_connections (self));
+			break;
+		case PROP_MAX_CONNECTIONS_PER_HOST:
+			g_value_set_uint (value, gdata_connection_pool_get_max_connections_per_host (self));
+			break;
+		case PROP_IDLE_TIMEOUT:
+			g_value_set_uint (value, gdata_connection_pool_get_idle_timeout (self));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataConnectionPool *self = GDATA_CONNECTION_POOL (object);
+
+	switch (property_id) {
+		case PROP_MAX_CONNECTIONS:
+			gdata_connection_pool_set_max_connections (self, g_value_get_uint (value));
+			break;
+		case PROP_MAX_CONNECTIONS_PER_HOST:
+			gdata_connection_pool_set_max_connections_per_host (self, g_value_get_uint (value));
+			break;
+		case PROP_IDLE_TIMEOUT:
+			gdata_connection_pool_set_idle_timeout (self, g_value_get_uint (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/**
+ * gdata_connection_pool_new:
+ *
+ * Creates a new #GDataConnectionPool with the default limits, ready to be shared between services and authorizers.
+ *
+ * Return value: (transfer full): a new #GDataConnectionPool; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataConnectionPool *
+gdata_connection_pool_new (void)
+{
+	return g_object_new (GDATA_TYPE_CONNECTION_POOL, NULL);
+}
+
+/**
+ * gdata_connection_pool_get_max_connections:
+ * @self: a #GDataConnectionPool
+ *
+ * Gets the #GDataConnectionPool:max-connections property.
+ *
+ * Return value: the maximum number of connections open at once, to all hosts
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_connection_pool_get_max_connections (GDataConnectionPool *self)
+{
+	guint max_connections;
+
+	g_return_val_if_fail (GDATA_IS_CONNECTION_POOL (self), 0);
+
+	g_object_get (self->priv->session, SOUP_SESSION_MAX_CONNS, &max_connections, NULL);
+
+	return max_connections;
+}
+
+/**
+ * gdata_connection_pool_set_max_connections:
+ * @self: a #GDataConnectionPool
+ * @max_connections: the maximum number of connections open at once, to all hosts
+ *
+ * Sets the #GDataConnectionPool:max-connections property. This doesn't close any connections which are already open.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_connection_pool_set_max_connections (GDataConnectionPool *self, guint max_connections)
+{
+	g_return_if_fail (GDATA_IS_CONNECTION_POOL (self));
+	g_return_if_fail (max_connections > 0);
+
+	g_object_set (self->priv->session, SOUP_SESSION_MAX_CONNS, max_connections, NULL);
+	g_object_notify (G_OBJECT (self), "max-connections");
+}
+
+/**
+ * gdata_connection_pool_get_max_connections_per_host:
+ * @self: a #GDataConnectionPool
+ *
+ * Gets the #GDataConnectionPool:max-connections-per-host property.
+ *
+ * Return value: the maximum number of connections open at once to a host
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_connection_pool_get_max_connections_per_host (GDataConnectionPool *self)
+{
+	guint max_connections_per_host;
+
+	g_return_val_if_fail (GDATA_IS_CONNECTION_POOL (self), 0);
+
+	g_object_get (self->priv->session, SOUP_SESSION_MAX_CONNS_PER_HOST, &max_connections_per_host, NULL);
+
+	return max_connections_per_host;
+}
+
+/**
+ * gdata_connection_pool_set_max_connections_per_host:
+ * @self: a #GDataConnectionPool
+ * @max_connections_per_host: the maximum number of connections open at once to a host
+ *
+ * Sets the #GDataConnectionPool:max-connections-per-host property. This doesn't close any connections which are already open.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_connection_pool_set_max_connections_per_host (GDataConnectionPool *self, guint max_connections_per_host)
+{
+	g_return_if_fail (GDATA_IS_CONNECTION_POOL (self));
+	g_return_if_fail (max_connections_per_host > 0);
+
+	g_object_set (self->priv->session, SOUP_SESSION_MAX_CONNS_PER_HOST, max_connections_per_host, NULL);
+	g_object_notify (G_OBJECT (self), "max-connections-per-host");
+}
+
+/**
+ * gdata_connection_pool_get_idle_timeout:
+ * @self: a #GDataConnectionPool
+ *
+ * Gets the #GDataConnectionPool:idle-timeout property.
+ *
+ * Return value: the idle timeout, in seconds, or <code class="literal">0</code>
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_connection_pool_get_idle_timeout (GDataConnectionPool *self)
+{
+	guint idle_timeout;
+
+	g_return_val_if_fail (GDATA_IS_CONNECTION_POOL (self), 0);
+
+	g_object_get (self->priv->session, SOUP_SESSION_IDLE_TIMEOUT, &idle_timeout, NULL);
+
+	return idle_timeout;
+}
+
+/**
+ * gdata_connection_pool_set_idle_timeout:
+ * @self: a #GDataConnectionPool
+ * @idle_timeout: the idle timeout, in seconds, or <code class="literal">0</code>
+ *
+ * Sets the #GDataConnectionPool:idle-timeout property. It only takes effect for connections opened after it's changed.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_connection_pool_set_idle_timeout (GDataConnectionPool *self, guint idle_timeout)
+{
+	g_return_if_fail (GDATA_IS_CONNECTION_POOL (self));
+
+	g_object_set (self->priv->session, SOUP_SESSION_IDLE_TIMEOUT, idle_timeout, NULL);
+	g_object_notify (G_OBJECT (self), "idle-timeout");
+}
+
+/*
+ * _gdata_connection_pool_get_session:
+ * @self: a #GDataConnectionPool
+ *
+ * Gets the #SoupSession which holds the pool's connections. Services and authorizers should send all their messages using this session.
+ *
+ * Return value: (transfer none): the pool's #SoupSession
+ *
+ * Since: 0.15.0
+ */
+SoupSession *
+_gdata_connection_pool_get_session (GDataConnectionPool *self)
+{
+	g_return_val_if_fail (GDATA_IS_CONNECTION_POOL (self), NULL);
+
+	return self->priv->session;
+}
@@ -0,0 +1,77 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_CONNECTION_POOL_H
+#define GDATA_CONNECTION_POOL_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_CONNECTION_POOL		(gdata_connection_pool_get_type ())
+#define GDATA_CONNECTION_POOL(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_CONNECTION_POOL, GDataConnectionPool))
+#define GDATA_CONNECTION_POOL_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_CONNECTION_POOL, GDataConnectionPoolClass))
+#define GDATA_IS_CONNECTION_POOL(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_CONNECTION_POOL))
+#define GDATA_IS_CONNECTION_POOL_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_CONNECTION_POOL))
+#define GDATA_CONNECTION_POOL_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_CONNECTION_POOL, GDataConnectionPoolClass))
+
+typedef struct _GDataConnectionPoolPrivate	GDataConnectionPoolPrivate;
+
+/**
+ * GDataConnectionPool:
+ *
+ * All the fields in the #GDataConnectionPool structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataConnectionPoolPrivate *priv;
+} GDataConnectionPool;
+
+/**
+ * GDataConnectionPoolClass:
+ *
+ * All the fields in the #GDataConnectionPoolClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataConnectionPoolClass;
+
+GType gdata_connection_pool_get_type (void) G_GNUC_CONST;
+
+GDataConnectionPool *gdata_connection_pool_new (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+guint gdata_connection_pool_get_max_connections (GDataConnectionPool *self);
+void gdata_connection_pool_set_max_connections (GDataConnectionPool *self, guint max_connections);
+
+guint gdata_connection_pool_get_max_connections_per_host (GDataConnectionPool *self);
+void gdata_connection_pool_set_max_connections_per_host (GDataConnectionPool *self, guint max_connections_per_host);
+
+guint gdata_connection_pool_get_idle_timeout (GDataConnectionPool *self);
+void gdata_connection_pool_set_idle_timeout (GDataConnectionPool *self, guint idle_timeout);
+
+G_END_DECLS
+
+#endif /* !GDATA_CONNECTION_POOL_H */
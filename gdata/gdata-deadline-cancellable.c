@@ -0,0 +1,355 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-deadline-cancellable
+ * @short_description: GData cancellable with a deadline
+ * @stability: Unstable
+ * @include: gdata/gdata-deadline-cancellable.h
+ *
+ * #GDataDeadlineCancellable is a #GCancellable which cancels itself once its deadline has passed. It bounds the total time taken by a logical
+ * operation, rather than the time taken by each of its network requests (which is all #GDataService:timeout bounds).
+ *
+ * Pass the same #GDataDeadlineCancellable to every call which makes up the operation, such as each page of a paged query, or the creation of a
+ * #GDataUploadStream and each write to it. All of the requests made for those calls share the deadline: waits for retries
+ * (#GDataService:retry-policy), the rate limiter (#GDataService:rate-limiter) and the request scheduler (#GDataService:request-scheduler) are
+ * bounded by it, retries are skipped if the deadline would pass before they could be sent, and any request which is in progress when the deadline
+ * passes is cancelled straight away.
+ *
+ * Requests made by a #GDataService which are stopped because the deadline has passed fail with %G_IO_ERROR_TIMED_OUT rather than
+ * %G_IO_ERROR_CANCELLED. If a parent #GCancellable is given, cancelling it cancels the #GDataDeadlineCancellable too, so that the operation can
+ * still be cancelled by the user before its deadline.
+ *
+ * <example>
+ * 	<title>Bounding the Time Taken to Load All Pages of a Feed</title>
+ * 	<programlisting>
+ *	GCancellable *cancellable;
+ *	GDataFeed *feed;
+ *	gboolean more_pages;
+ *	GError *error = NULL;
+ *
+ *	/<!-- -->* The whole query, however many pages it has, must finish within 30 seconds *<!-- -->/
+ *	cancellable = gdata_deadline_cancellable_new (30000, user_cancellable);
+ *
+ *	do {
+ *		feed = gdata_service_query (service, domain, feed_uri, query, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, &error);
+ *		if (feed == NULL)
+ *			break;
+ *
+ *		/<!-- -->* ... *<!-- -->/
+ *
+ *		more_pages = (gdata_feed_look_up_link (feed, GDATA_LINK_NEXT) != NULL);
+ *		g_object_unref (feed);
+ *		gdata_query_next_page (query);
+ *	} while (more_pages == TRUE);
+ *
+ *	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT) == TRUE) {
+ *		/<!-- -->* The deadline passed *<!-- -->/
+ *	}
+ *
+ *	g_object_unref (cancellable);
+ * 	</programlisting>
+ * </example>
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+#include <gio/gio.h>
+
+#include "gdata-deadline-cancellable.h"
+#include "gdata-private.h"
+
+/* Shared between a GDataDeadlineCancellable and its timeout source, since the source may be dispatched in the deadline thread while the cancellable
+ * is being disposed of in another thread. */
+typedef struct {
+	volatile gint ref_count;
+	GMutex mutex;
+	GCancellable *cancellable; /* unowned; NULL once the cancellable has been disposed of */
+} DeadlineTimer;
+
+static void gdata_deadline_cancellable_dispose (GObject *object);
+
+struct _GDataDeadlineCancellablePrivate {
+	gint64 deadline; /* monotonic time, in microseconds */
+	DeadlineTimer *timer;
+	GSource *timeout_source; /* attached to the deadline context */
+
+	GCancellable *parent;
+	gulong parent_cancelled_id;
+};
+
+G_DEFINE_TYPE (GDataDeadlineCancellable, gdata_deadline_cancellable, G_TYPE_CANCELLABLE)
+
+static void
+gdata_deadline_cancellable_class_init (GDataDeadlineCancellableClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataDeadlineCancellablePrivate));
+
+	gobject_class->dispose = gdata_deadline_cancellable_dispose;
+}
+
+static void
+gdata_deadline_cancellable_init (GDataDeadlineCancellable *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_DEADLINE_CANCELLABLE, GDataDeadlineCancellablePrivate);
+}
+
+static void
+deadline_timer_unref (DeadlineTimer *timer)
+{
+	if (g_atomic_int_dec_and_test (&(timer->ref_count)) == TRUE) {
+		g_mutex_clear (&(timer->mutex));
+		g_slice_free (DeadlineTimer, timer);
+	}
+}
+
+static void
+gdata_deadline_cancellable_dispose (GObject *object)
+{
+	GDataDeadlineCancellablePrivate *priv = GDATA_DEADLINE_CANCELLABLE (object)->priv;
+
+	/* This waits for parent_cancelled_cb() to finish if it's running in another thread */
+	if (priv->parent != NULL) {
+		g_cancellable_disconnect (priv->parent, priv->parent_cancelled_id);
+		g_object_unref (priv->parent);
+	}
+	priv->parent = NULL;
+
+	if (priv->timeout_source != NULL) {
+		g_mutex_lock (&(priv->timer->mutex));
+		priv->timer->cancellable = NULL;
+		g_mutex_unlock (&(priv->timer->mutex));
+
+		g_source_destroy (priv->timeout_source);
+		g_source_unref (priv->timeout_source);
+		deadline_timer_unref (priv->timer);
+	}
+	priv->timeout_source = NULL;
+	priv->timer = NULL;
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_deadline_cancellable_parent_class)->dispose (object);
+}
+
+static gpointer
+deadline_thread_cb (GMainContext *context)
+{
+	GMainLoop *loop;
+
+	loop = g_main_loop_new (context, FALSE);
+	g_main_loop_run (loop);
+	g_main_loop_unref (loop);
+
+	return NULL;
+}
+
+static gpointer
+deadline_context_new (gpointer data)
+{
+	GMainContext *context;
+
+	/* Deadlines are timed in a thread of their own, so that they're enforced whether or not the application is running a main loop */
+	context = g_main_context_new ();
+	g_thread_unref (g_thread_new ("gdata-deadlines", (GThreadFunc) deadline_thread_cb, context));
+
+	return context;
+}
+
+static GMainContext *
+get_deadline_context (void)
+{
+	static GOnce deadline_context_once = G_ONCE_INIT;
+
+	g_once (&deadline_context_once, deadline_context_new, NULL);
+
+	return deadline_context_once.retval;
+}
+
+/* Called in the deadline thread */
+static gboolean
+deadline_expired_cb (DeadlineTimer *timer)
+{
+	GCancellable *cancellable = NULL;
+
+	g_mutex_lock (&(timer->mutex));
+	if (timer->cancellable != NULL)
+		cancellable = g_object_ref (timer->cancellable);
+	g_mutex_unlock (&(timer->mutex));
+
+	if (cancellable != NULL) {
+		g_cancellable_cancel (cancellable);
+		g_object_unref (cancellable);
+	}
+
+	return FALSE;
+}
+
+static void
+parent_cancelled_cb (GCancellable *parent, GCancellable *self)
+{
+	g_cancellable_cancel (self);
+}
+
+/**
+ * gdata_deadline_cancellable_new:
+ * @timeout: the time until the deadline, in milliseconds
+ * @parent: (allow-none): a #GCancellable which cancels the new cancellable when it's cancelled, or %NULL
+ *
+ * Creates a new #GDataDeadlineCancellable whose deadline is @timeout milliseconds from now. Once the deadline has passed, the cancellable is
+ * cancelled.
+ *
+ * Return value: (transfer full): a new #GDataDeadlineCancellable; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GCancellable *
+gdata_deadline_cancellable_new (guint timeout, GCancellable *parent)
+{
+	GDataDeadlineCancellable *self;
+	GDataDeadlineCancellablePrivate *priv;
+
+	g_return_val_if_fail (parent == NULL || G_IS_CANCELLABLE (parent), NULL);
+
+	self = g_object_new (GDATA_TYPE_DEADLINE_CANCELLABLE, NULL);
+	priv = self->priv;
+
+	priv->deadline = g_get_monotonic_time () + (gint64) timeout * 1000;
+
+	priv->timer = g_slice_new0 (DeadlineTimer);
+	priv->timer->ref_count = 2; /* one for us, one for the source */
+	g_mutex_init (&(priv->timer->mutex));
+	priv->timer->cancellable = G_CANCELLABLE (self);
+
+	priv->timeout_source = g_timeout_source_new (timeout);
+	g_source_set_callback (priv->timeout_source, (GSourceFunc) deadline_expired_cb, priv->timer, (GDestroyNotify) deadline_timer_unref);
+	g_source_attach (priv->timeout_source, get_deadline_context ());
+
+	/* This cancels us straight away if @parent has already been cancelled */
+	if (parent != NULL) {
+		priv->parent = g_object_ref (parent);
+		priv->parent_cancelled_id = g_cancellable_connect (parent, (GCallback) parent_cancelled_cb, self, NULL);
+	}
+
+	return G_CANCELLABLE (self);
+}
+
+/**
+ * gdata_deadline_cancellable_get_deadline:
+ * @self: a #GDataDeadlineCancellable
+ *
+ * Gets the deadline of the cancellable, in the same units and time base as g_get_monotonic_time().
+ *
+ * Return value: the deadline, in microseconds of monotonic time
+ *
+ * Since: 0.15.0
+ */
+gint64
+gdata_deadline_cancellable_get_deadline (GDataDeadlineCancellable *self)
+{
+	g_return_val_if_fail (GDATA_IS_DEADLINE_CANCELLABLE (self), 0);
+	return self->priv->deadline;
+}
+
+/**
+ * gdata_deadline_cancellable_get_remaining_time:
+ * @self: a #GDataDeadlineCancellable
+ *
+ * Gets the time remaining until the deadline.
+ *
+ * Return value: the time remaining until the deadline in milliseconds, or <code class="literal">0</code> if it has passed
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_deadline_cancellable_get_remaining_time (GDataDeadlineCancellable *self)
+{
+	gint64 remaining;
+
+	g_return_val_if_fail (GDATA_IS_DEADLINE_CANCELLABLE (self), 0);
+
+	remaining = self->priv->deadline - g_get_monotonic_time ();
+
+	return (remaining > 0) ? (guint) MIN ((remaining + 999) / 1000, G_MAXUINT) : 0;
+}
+
+/**
+ * gdata_deadline_cancellable_has_expired:
+ * @self: a #GDataDeadlineCancellable
+ *
+ * Gets whether the deadline has passed. Note that the cancellable may also have been cancelled before its deadline, using its parent
+ * #GCancellable or g_cancellable_cancel().
+ *
+ * Return value: %TRUE if the deadline has passed, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_deadline_cancellable_has_expired (GDataDeadlineCancellable *self)
+{
+	g_return_val_if_fail (GDATA_IS_DEADLINE_CANCELLABLE (self), FALSE);
+	return (g_get_monotonic_time () >= self->priv->deadline) ? TRUE : FALSE;
+}
+
+/*
+ * _gdata_deadline_cancellable_get_remaining_time:
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ *
+ * Gets the time remaining until the deadline of @cancellable, if it's a #GDataDeadlineCancellable.
+ *
+ * Return value: the time remaining in milliseconds, or <code class="literal">-1</code> if @cancellable has no deadline
+ *
+ * Since: 0.15.0
+ */
+gint64
+_gdata_deadline_cancellable_get_remaining_time (GCancellable *cancellable)
+{
+	if (cancellable == NULL || GDATA_IS_DEADLINE_CANCELLABLE (cancellable) == FALSE)
+		return -1;
+
+	return gdata_deadline_cancellable_get_remaining_time (GDATA_DEADLINE_CANCELLABLE (cancellable));
+}
+
+/*
+ * _gdata_deadline_cancellable_set_error_if_expired:
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * If @cancellable is a #GDataDeadlineCancellable which has been cancelled because its deadline has passed, sets a %G_IO_ERROR_TIMED_OUT error.
+ *
+ * Return value: %TRUE if @error was set, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+_gdata_deadline_cancellable_set_error_if_expired (GCancellable *cancellable, GError **error)
+{
+	if (cancellable == NULL || GDATA_IS_DEADLINE_CANCELLABLE (cancellable) == FALSE || g_cancellable_is_cancelled (cancellable) == FALSE ||
+	    gdata_deadline_cancellable_has_expired (GDATA_DEADLINE_CANCELLABLE (cancellable)) == FALSE) {
+		return FALSE;
+	}
+
+	g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, _("The operation's deadline passed."));
+
+	return TRUE;
+}
@@ -0,0 +1,73 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_DEADLINE_CANCELLABLE_H
+#define GDATA_DEADLINE_CANCELLABLE_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_DEADLINE_CANCELLABLE		(gdata_deadline_cancellable_get_type ())
+#define GDATA_DEADLINE_CANCELLABLE(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_DEADLINE_CANCELLABLE, GDataDeadlineCancellable))
+#define GDATA_DEADLINE_CANCELLABLE_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_DEADLINE_CANCELLABLE, GDataDeadlineCancellableClass))
+#define GDATA_IS_DEADLINE_CANCELLABLE(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_DEADLINE_CANCELLABLE))
+#define GDATA_IS_DEADLINE_CANCELLABLE_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_DEADLINE_CANCELLABLE))
+#define GDATA_DEADLINE_CANCELLABLE_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_DEADLINE_CANCELLABLE, GDataDeadlineCancellableClass))
+
+typedef struct _GDataDeadlineCancellablePrivate	GDataDeadlineCancellablePrivate;
+
+/**
+ * GDataDeadlineCancellable:
+ *
+ * All the fields in the #GDataDeadlineCancellable structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GCancellable parent;
+	GDataDeadlineCancellablePrivate *priv;
+} GDataDeadlineCancellable;
+
+/**
+ * GDataDeadlineCancellableClass:
+ *
+ * All the fields in the #GDataDeadlineCancellableClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GCancellableClass parent;
+} GDataDeadlineCancellableClass;
+
+GType gdata_deadline_cancellable_get_type (void) G_GNUC_CONST;
+
+GCancellable *gdata_deadline_cancellable_new (guint timeout, GCancellable *parent) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+gint64 gdata_deadline_cancellable_get_deadline (GDataDeadlineCancellable *self) G_GNUC_PURE;
+guint gdata_deadline_cancellable_get_remaining_time (GDataDeadlineCancellable *self);
+gboolean gdata_deadline_cancellable_has_expired (GDataDeadlineCancellable *self);
+
+G_END_DECLS
+
+#endif /* !GDATA_DEADLINE_CANCELLABLE_H */
@@ -54,6 +54,40 @@
  * If the server returns an error message (for example, if the user is not correctly authenticated/authorized or doesn't have suitable permissions to
  * download from the given URI), it will be returned as a #GDataServiceError by the first call to g_input_stream_read().
  *
+ * The asynchronous #GInputStream methods, such as g_input_stream_read_async(), use GIO's default implementations, which run the synchronous
+ * methods in a thread from GIO's worker pool. Unlike the asynchronous #GDataService operations, each of them blocks a thread while it waits for the
+ * network.
+ *
+ * If the #GDataService:retry-policy of the #GDataDownloadStream:service allows it, a download which fails transiently part-way through (for
+ * example, because the connection was dropped) is resumed from the last byte received, without the failure being seen by the reader. The resumed
+ * request asks only for the rest of the file using a <literal>Range</literal> header, and uses an <literal>If-Range</literal> header with the
+ * file's ETag (or modification date) to make sure the file hasn't changed on the server in the meantime. If it has, or if the server doesn't give
+ * the file an ETag or modification date, the download isn't resumed and the error is returned from g_input_stream_read() once the data received
+ * before the failure has been read. Each resumption counts as an attempt against #GDataRetryPolicy:max-attempts.
+ *
+ * Seeking forwards in the stream skips over the intervening data as it's downloaded, and seeking backwards normally restarts the download from the
+ * new position using a <literal>Range</literal> request. To avoid a round trip to the server when an application seeks back a short distance (for
+ * example, to re-read a file header), the most recently read #GDataDownloadStream:seek-window-size bytes are kept in memory, and backwards seeks
+ * into them are served from there. Seeking relative to the end of the stream (%G_SEEK_END) requires the length of the file; if the server hasn't
+ * yet reported it, a <literal>HEAD</literal> request is made to find it out.
+ *
+ * To stop large downloads from filling up memory when the application reads from the stream more slowly than the data arrives from the network, at
+ * most #GDataDownloadStream:buffer-size bytes of data are held in memory at once. Once this many bytes are waiting to be read, the download is
+ * paused until half of them have been read. The amount of data read ahead starts off smaller than this, and is doubled (up to
+ * #GDataDownloadStream:buffer-size) each time the application catches up with the network and finds no data waiting to be read, so that a stream
+ * which is read quickly gets a large read-ahead, and one which is read slowly or only partially doesn't use much memory.
+ *
+ * Network activity normally begins with the first call to g_input_stream_read(). To start it earlier, for example so that many small files can be
+ * downloaded in parallel before any of them are needed, call gdata_download_stream_prefetch(). This can also be called after a seek, to start
+ * downloading from the new position straight away.
+ *
+ * Alternatively, the whole file can be saved to disk using gdata_download_stream_download_to_file(), which can download different parts of the file
+ * over several connections at once. This can be much faster than reading the stream for large files on connections with a high bandwidth-delay
+ * product.
+ *
+ * Data read using g_input_stream_read() has to be copied into the caller's buffer. For large downloads, gdata_download_stream_read_buffer() can be
+ * used instead: it returns the data as a #SoupBuffer which references the memory it was received into from the network, without copying it.
+ *
  * <example>
  * 	<title>Downloading to a File</title>
  * 	<programlisting>
@@ -103,6 +137,7 @@
 #include <config.h>
 #include <glib.h>
 #include <glib/gi18n-lib.h>
+#include <string.h>
 
 #include "gdata-download-stream.h"
 #include "gdata-buffer.h"
@@ -131,13 +166,14 @@ static void reset_network_thread (GDataDownloadStream *self);
  * The GDataDownloadStream can be in one of several states:
  *  1. Pre-network activity. This is the state that the stream is created in. @network_thread and @cancellable are both %NULL, and @finished is %FALSE.
  *     The stream will remain in this state until gdata_download_stream_read() or gdata_download_stream_seek() are called for the first time.
- *     @content_type and @content_length are at their default values (NULL and -1, respectively).
+ *     @content_type and @content_length are at their default values (NULL and -1, respectively), although @content_length may be set by a
+ *     HEAD request if gdata_download_stream_seek() is called with %G_SEEK_END.
  *  2. Network activity. This state is entered when gdata_download_stream_read() is called for the first time.
  *     @network_thread, @buffer and @cancellable are created, while @finished remains %FALSE.
  *     As soon as the headers are downloaded, which is guaranteed to be before the first call to gdata_download_stream_read() returns, @content_type
  *     and @content_length are set from the headers. From this point onwards, they are immutable.
- *  3. Reset network activity. This state is entered only if case 3 is encountered in a call to gdata_download_stream_seek(): a seek to an offset which
- *     has already been read out of the buffer. In this state, @buffer is freed and set to %NULL, @network_thread is cancelled (then set to %NULL),
+ *  3. Reset network activity. This state is entered only if case 4 is encountered in a call to gdata_download_stream_seek(): a seek to an offset which
+ *     has already been read out of the buffer and isn't in the seek window. In this state, @buffer is freed and set to %NULL, @network_thread is cancelled (then set to %NULL),
  *     and @offset is set to the seeked-to offset. @finished remains at %FALSE.
  *     When the next call to gdata_download_stream_read() is made, the download stream will go back to state 2 as if this was the first call to
  *     gdata_download_stream_read().
@@ -155,12 +191,26 @@ struct _GDataDownloadStreamPrivate {
 	SoupSession *session;
 	SoupMessage *message;
 	GDataBuffer *buffer;
+	gsize buffer_size;
+	gsize read_ahead; /* current read-ahead limit, which grows up to @buffer_size; only modified by read() calls */
 	goffset offset; /* current position in the stream */
+	goffset buffer_offset; /* position in the stream of the next byte to be popped off @buffer; greater than @offset while re-reading @seek_window */
+
+	/* Data which has been read from @buffer, kept for backwards seeks; it covers the @seek_window_length bytes of the stream before @buffer_offset.
+	 * Only accessed from read() and seek() calls, which are serialised by #GInputStream. */
+	GQueue seek_window; /* SoupBuffer */
+	gsize seek_window_length;
+	gsize seek_window_size;
 
 	GThread *network_thread;
 	GCancellable *cancellable;
 	GCancellable *network_cancellable; /* see the comment in gdata_download_stream_constructor() about the relationship between these two */
 
+	/* Only accessed from the network thread */
+	goffset network_offset; /* offset of the next byte to be received from the network */
+	goffset resume_offset; /* offset the current request is resuming the download from, or -1 */
+	gchar *validator; /* strong ETag or Last-Modified date of the file, for resuming the download with If-Range */
+
 	gboolean finished;
 	GCond finished_cond;
 	GMutex finished_mutex; /* mutex for ->finished, protected by ->finished_cond */
@@ -178,11 +228,58 @@ enum {
 	PROP_CONTENT_LENGTH,
 	PROP_CANCELLABLE,
 	PROP_AUTHORIZATION_DOMAIN,
+	PROP_BUFFER_SIZE,
+	PROP_SEEK_WINDOW_SIZE,
 };
 
+#define DEFAULT_BUFFER_SIZE (1024 * 1024) /* bytes */
+#define DEFAULT_SEEK_WINDOW_SIZE (64 * 1024) /* bytes */
+#define INITIAL_READ_AHEAD (64 * 1024) /* bytes */
+#define MIN_RANGE_SIZE (512 * 1024) /* bytes; gdata_download_stream_download_to_file() doesn't split files into ranges smaller than this */
+
 G_DEFINE_TYPE_WITH_CODE (GDataDownloadStream, gdata_download_stream, G_TYPE_INPUT_STREAM,
                          G_IMPLEMENT_INTERFACE (G_TYPE_SEEKABLE, gdata_download_stream_seekable_iface_init))
 
+static SoupMessage *
+build_message (GDataDownloadStream *self, const gchar *method)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+	GDataServiceClass *klass;
+	SoupMessage *message;
+	SoupURI *_uri;
+
+	/* Build the message */
+	_uri = soup_uri_new (priv->download_uri);
+	soup_uri_set_port (_uri, _gdata_service_get_https_port ());
+	message = soup_message_new_from_uri (method, _uri);
+	soup_uri_free (_uri);
+
+	/* Make sure the headers are set */
+	klass = GDATA_SERVICE_GET_CLASS (priv->service);
+	if (klass->append_query_headers != NULL) {
+		klass->append_query_headers (priv->service, priv->authorization_domain, message);
+	}
+
+	/* We don't want to accumulate chunks, since they're passed on elsewhere */
+	soup_message_body_set_accumulate (message->response_body, FALSE);
+
+	return message;
+}
+
+/* Send a HEAD request for the file. The returned message must be checked for an unsuccessful status if @error isn't set. */
+static SoupMessage *
+send_head_request (GDataDownloadStream *self, GCancellable *cancellable, GError **error)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+	SoupMessage *message;
+
+	message = build_message (self, SOUP_METHOD_HEAD);
+	_gdata_service_track_request (priv->service, message);
+	_gdata_service_actually_send_message (priv->session, message, cancellable, error);
+
+	return message;
+}
+
 static void
 gdata_download_stream_class_init (GDataDownloadStreamClass *klass)
 {
@@ -298,6 +395,42 @@ gdata_download_stream_class_init (GDataDownloadStreamClass *klass)
 	                                                      "Cancellable", "An optional cancellable used to cancel the entire download operation.",
 	                                                      G_TYPE_CANCELLABLE,
 	                                                      G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataDownloadStream:buffer-size:
+	 *
+	 * The maximum number of bytes of downloaded data to hold in memory while waiting for them to be read from the stream. Once this many bytes
+	 * have been buffered, reading from the network is paused until half of them have been read, which bounds the memory used by the download
+	 * however slowly the stream is read. If a single read requests more data than this, the buffer grows to accommodate it.
+	 *
+	 * To begin with, less data than this is read ahead; the read-ahead doubles up to this size whenever the stream is read faster than it can
+	 * be refilled from the network.
+	 *
+	 * If this is <code class="literal">0</code>, the amount of buffered data is unbounded, so the entire file could end up held in memory.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
+	                                 g_param_spec_ulong ("buffer-size",
+	                                                     "Buffer size", "The maximum number of bytes of downloaded data to hold in memory.",
+	                                                     0, G_MAXULONG, DEFAULT_BUFFER_SIZE,
+	                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataDownloadStream:seek-window-size:
+	 *
+	 * The number of bytes of already-read data to keep in memory so that seeking backwards into them doesn't require the download to be
+	 * restarted. Slightly more than this may be kept, as data is only discarded in whole chunks as received from the network.
+	 *
+	 * If this is <code class="literal">0</code>, no data is kept, and every backwards seek restarts the download.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_SEEK_WINDOW_SIZE,
+	                                 g_param_spec_ulong ("seek-window-size",
+	                                                     "Seek window size", "The number of bytes of already-read data to keep for backwards seeks.",
+	                                                     0, G_MAXULONG, DEFAULT_SEEK_WINDOW_SIZE,
+	                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -315,6 +448,10 @@ gdata_download_stream_init (GDataDownloadStream *self)
 {
 	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_DOWNLOAD_STREAM, GDataDownloadStreamPrivate);
 	self->priv->buffer = NULL; /* created when the network thread is started and destroyed when the stream is closed */
+	self->priv->buffer_size = DEFAULT_BUFFER_SIZE;
+	self->priv->read_ahead = INITIAL_READ_AHEAD;
+	g_queue_init (&(self->priv->seek_window));
+	self->priv->seek_window_size = DEFAULT_SEEK_WINDOW_SIZE;
 
 	self->priv->finished = FALSE;
 	g_cond_init (&(self->priv->finished_cond));
@@ -335,9 +472,7 @@ static GObject *
 gdata_download_stream_constructor (GType type, guint n_construct_params, GObjectConstructParam *construct_params)
 {
 	GDataDownloadStreamPrivate *priv;
-	GDataServiceClass *klass;
 	GObject *object;
-	SoupURI *_uri;
 
 	/* Chain up to the parent class */
 	object = G_OBJECT_CLASS (gdata_download_stream_parent_class)->constructor (type, n_construct_params, construct_params);
@@ -355,19 +490,10 @@ gdata_download_stream_constructor (GType type, guint n_construct_params, GObject
 	g_cancellable_connect (priv->cancellable, (GCallback) cancellable_cancel_cb, priv->network_cancellable, NULL);
 
 	/* Build the message */
-	_uri = soup_uri_new (priv->download_uri);
-	soup_uri_set_port (_uri, _gdata_service_get_https_port ());
-	priv->message = soup_message_new_from_uri (SOUP_METHOD_GET, _uri);
-	soup_uri_free (_uri);
+	priv->message = build_message (GDATA_DOWNLOAD_STREAM (object), SOUP_METHOD_GET);
 
-	/* Make sure the headers are set */
-	klass = GDATA_SERVICE_GET_CLASS (priv->service);
-	if (klass->append_query_headers != NULL) {
-		klass->append_query_headers (priv->service, priv->authorization_domain, priv->message);
-	}
-
-	/* We don't want to accumulate chunks */
-	soup_message_body_set_accumulate (priv->message->request_body, FALSE);
+	/* Downloads are idempotent, so slow ones can be hedged */
+	_gdata_service_hedge_message (priv->service, priv->message);
 
 	/* Downloading doesn't actually start until the first call to read() */
 
@@ -418,6 +544,7 @@ gdata_download_stream_finalize (GObject *object)
 
 	g_mutex_clear (&(priv->content_mutex));
 
+	g_free (priv->validator);
 	g_free (priv->download_uri);
 	g_free (priv->content_type);
 
@@ -453,6 +580,12 @@ gdata_download_stream_get_property (GObject *object, guint property_id, GValue *
 		case PROP_CANCELLABLE:
 			g_value_set_object (value, priv->cancellable);
 			break;
+		case PROP_BUFFER_SIZE:
+			g_value_set_ulong (value, priv->buffer_size);
+			break;
+		case PROP_SEEK_WINDOW_SIZE:
+			g_value_set_ulong (value, priv->seek_window_size);
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -480,6 +613,12 @@ gdata_download_stream_set_property (GObject *object, guint property_id, const GV
 			/* Construction only */
 			priv->cancellable = g_value_dup_object (value);
 			break;
+		case PROP_BUFFER_SIZE:
+			gdata_download_stream_set_buffer_size (GDATA_DOWNLOAD_STREAM (object), g_value_get_ulong (value));
+			break;
+		case PROP_SEEK_WINDOW_SIZE:
+			gdata_download_stream_set_seek_window_size (GDATA_DOWNLOAD_STREAM (object), g_value_get_ulong (value));
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -493,10 +632,124 @@ read_cancelled_cb (GCancellable *cancellable, GCancellable *child_cancellable)
 	g_cancellable_cancel (child_cancellable);
 }
 
+/* Drop all the data in the seek window */
+static void
+seek_window_clear (GDataDownloadStream *self)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+	SoupBuffer *buffer;
+
+	while ((buffer = g_queue_pop_head (&(priv->seek_window))) != NULL)
+		soup_buffer_free (buffer);
+
+	priv->seek_window_length = 0;
+}
+
+/* Add data which has just been read from the network buffer to the seek window. If @soup_buffer is non-%NULL, it's referenced rather than copying
+ * @data. */
+static void
+seek_window_append (GDataDownloadStream *self, SoupBuffer *soup_buffer, const guint8 *data, gsize length)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+	SoupBuffer *buffer;
+
+	if (priv->seek_window_size == 0) {
+		seek_window_clear (self);
+		return;
+	}
+
+	if (soup_buffer != NULL) {
+		buffer = soup_buffer_copy (soup_buffer);
+	} else {
+		/* Don't copy more than will be kept */
+		if (length >= priv->seek_window_size) {
+			seek_window_clear (self);
+			data += length - priv->seek_window_size;
+			length = priv->seek_window_size;
+		}
+
+		buffer = soup_buffer_new (SOUP_MEMORY_COPY, data, length);
+	}
+
+	g_queue_push_tail (&(priv->seek_window), buffer);
+	priv->seek_window_length += buffer->length;
+
+	/* Drop the oldest buffers which are no longer needed to cover the window */
+	while ((buffer = g_queue_peek_head (&(priv->seek_window))) != NULL && priv->seek_window_length - buffer->length >= priv->seek_window_size) {
+		priv->seek_window_length -= buffer->length;
+		soup_buffer_free (g_queue_pop_head (&(priv->seek_window)));
+	}
+}
+
+/* Read up to @count bytes from the seek window, starting at the current offset, which must be inside it. If @soup_buffer is non-%NULL, the data is
+ * returned in it without copying (and may be shorter than the data available); otherwise it's copied into @data. */
+static gsize
+seek_window_read (GDataDownloadStream *self, guint8 *data, SoupBuffer **soup_buffer, gsize count)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+	goffset position;
+	gsize length_read = 0;
+	GList *i;
+
+	g_assert (priv->offset >= priv->buffer_offset - (goffset) priv->seek_window_length && priv->offset < priv->buffer_offset);
+
+	/* @position is the offset of the start of the current buffer in the stream */
+	position = priv->buffer_offset - priv->seek_window_length;
+
+	for (i = priv->seek_window.head; i != NULL && length_read < count; i = i->next) {
+		SoupBuffer *buffer = i->data;
+		gsize buffer_offset, length;
+
+		if (position + (goffset) buffer->length <= priv->offset + (goffset) length_read) {
+			position += buffer->length;
+			continue;
+		}
+
+		buffer_offset = priv->offset + length_read - position;
+		length = MIN (buffer->length - buffer_offset, count - length_read);
+
+		if (soup_buffer != NULL) {
+			*soup_buffer = soup_buffer_new_subbuffer (buffer, buffer_offset, length);
+			return length;
+		}
+
+		memcpy (data + length_read, buffer->data + buffer_offset, length);
+		length_read += length;
+		position += buffer->length;
+	}
+
+	return length_read;
+}
+
+/* The high water mark to use for the buffer */
+static gsize
+get_read_ahead (GDataDownloadStream *self)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+
+	return (priv->buffer_size == 0) ? 0 : MIN (priv->read_ahead, priv->buffer_size);
+}
+
+/* Grow the read-ahead if the buffer's been drained, which means data's being read faster than the buffer is being refilled. If the network's too
+ * slow to fill the buffer anyway, this does no harm. */
+static void
+update_read_ahead (GDataDownloadStream *self)
+{
+	GDataDownloadStreamPrivate *priv = self->priv;
+
+	if (priv->buffer_size == 0 || priv->read_ahead >= priv->buffer_size || gdata_buffer_get_length (priv->buffer) > 0)
+		return;
+
+	priv->read_ahead = (priv->read_ahead > G_MAXSIZE / 2) ? G_MAXSIZE : priv->read_ahead * 2;
+	gdata_buffer_set_high_water_mark (priv->buffer, get_read_ahead (self));
+}
+
+/* Read up to @count bytes from the stream. If @soup_buffer is %NULL, exactly @count bytes are copied into @buffer unless EOF is reached or the read is
+ * cancelled. Otherwise, a #SoupBuffer referencing up to @count bytes is returned in @soup_buffer without copying them, and @buffer is ignored. */
 static gssize
-gdata_download_stream_read (GInputStream *stream, void *buffer, gsize count, GCancellable *cancellable, GError **error)
+read_internal (GDataDownloadStream *self, void *buffer, SoupBuffer **soup_buffer, gsize count, GCancellable *cancellable, GError **error)
 {
-	GDataDownloadStreamPrivate *priv = GDATA_DOWNLOAD_STREAM (stream)->priv;
+	GDataDownloadStreamPrivate *priv = self->priv;
 	gssize length_read = -1;
 	gboolean reached_eof = FALSE;
 	gulong cancelled_signal = 0, global_cancelled_signal = 0;
@@ -521,26 +774,44 @@ gdata_download_stream_read (GInputStream *stream, void *buffer, gsize count, GCa
 		}
 
 		/* Create the network thread */
-		create_network_thread (GDATA_DOWNLOAD_STREAM (stream), &child_error);
+		create_network_thread (self, &child_error);
 		if (priv->network_thread == NULL) {
 			length_read = -1;
 			goto done;
 		}
+	} else if (priv->offset >= priv->buffer_offset) {
+		/* If we've caught up with the network, it's not reading far enough ahead */
+		update_read_ahead (self);
+	}
+
+	/* If we've seeked backwards into the seek window, re-read the data from there rather than the network */
+	if (priv->offset < priv->buffer_offset) {
+		length_read = (gssize) seek_window_read (self, buffer, soup_buffer, count);
+		goto done;
 	}
 
 	/* Read the data off the buffer. If the operation is cancelled, it'll probably still return a positive number of bytes read — if it does, we
 	 * can return without error. Iff it returns a non-positive number of bytes should we return an error. */
 	g_assert (priv->buffer != NULL);
-	length_read = (gssize) gdata_buffer_pop_data (priv->buffer, buffer, count, &reached_eof, child_cancellable);
+
+	if (soup_buffer != NULL) {
+		*soup_buffer = gdata_buffer_pop_buffer (priv->buffer, count, &reached_eof, child_cancellable);
+		length_read = (*soup_buffer != NULL) ? (gssize) (*soup_buffer)->length : 0;
+	} else {
+		length_read = (gssize) gdata_buffer_pop_data (priv->buffer, buffer, count, &reached_eof, child_cancellable);
+	}
 
 	if (length_read < 1 && g_cancellable_set_error_if_cancelled (child_cancellable, &child_error) == TRUE) {
 		/* Handle cancellation */
 		length_read = -1;
 
 		goto done;
-	} else if (SOUP_STATUS_IS_SUCCESSFUL (priv->message->status_code) == FALSE) {
+	} else if (length_read < 1 && SOUP_STATUS_IS_SUCCESSFUL (priv->message->status_code) == FALSE) {
 		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (priv->service);
 
+		/* Only check the status once we've reached EOF: the network thread's finished with the message then, rather than resuming the
+		 * download. Any data received before a failure is returned first. */
+
 		/* Set an appropriate error */
 		g_assert (klass->parse_error_response != NULL);
 		klass->parse_error_response (priv->service, GDATA_OPERATION_DOWNLOAD, priv->message->status_code, priv->message->reason_phrase,
@@ -550,6 +821,12 @@ gdata_download_stream_read (GInputStream *stream, void *buffer, gsize count, GCa
 		goto done;
 	}
 
+	/* Keep the data in case we seek back to it */
+	if (length_read > 0) {
+		priv->buffer_offset += length_read;
+		seek_window_append (self, (soup_buffer != NULL) ? *soup_buffer : NULL, buffer, length_read);
+	}
+
 done:
 	/* Disconnect from the cancelled signals. */
 	if (cancelled_signal != 0)
@@ -563,9 +840,15 @@ done:
 	          (reached_eof == TRUE && length_read >= 0 && length_read <= (gssize) count && child_error == NULL) ||
 	          (length_read == -1 && child_error != NULL));
 
-	if (child_error != NULL)
+	if (child_error != NULL) {
 		g_propagate_error (error, child_error);
 
+		if (soup_buffer != NULL && *soup_buffer != NULL) {
+			soup_buffer_free (*soup_buffer);
+			*soup_buffer = NULL;
+		}
+	}
+
 	/* Update our internal offset */
 	if (length_read > 0) {
 		priv->offset += length_read;
@@ -574,6 +857,12 @@ done:
 	return length_read;
 }
 
+static gssize
+gdata_download_stream_read (GInputStream *stream, void *buffer, gsize count, GCancellable *cancellable, GError **error)
+{
+	return read_internal (GDATA_DOWNLOAD_STREAM (stream), buffer, NULL, count, cancellable, error);
+}
+
 typedef struct {
 	GDataDownloadStream *download_stream;
 	gboolean *cancelled;
@@ -688,23 +977,59 @@ gdata_download_stream_can_seek (GSeekable *seekable)
 	return TRUE;
 }
 
+/* Find the length of the file using a HEAD request, and store it as the #GDataDownloadStream:content-length */
 static gboolean
-gdata_download_stream_seek (GSeekable *seekable, goffset offset, GSeekType type, GCancellable *cancellable, GError **error)
+get_content_length (GDataDownloadStream *self, GCancellable *cancellable, GError **error)
 {
-	GDataDownloadStreamPrivate *priv = GDATA_DOWNLOAD_STREAM (seekable)->priv;
+	GDataDownloadStreamPrivate *priv = self->priv;
+	SoupMessage *message;
 	GError *child_error = NULL;
 
-	if (type == G_SEEK_END && priv->content_length == -1) {
-		/* If we don't have the Content-Length, we can't calculate the offset from the start of the stream properly, so just give up.
-		 * We could technically use a HEAD request to get the Content-Length, but this hasn't been tried yet (FIXME). */
-		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "G_SEEK_END not currently supported");
+	message = send_head_request (self, cancellable, &child_error);
+
+	if (child_error == NULL && SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == FALSE) {
+		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (priv->service);
+
+		g_assert (klass->parse_error_response != NULL);
+		klass->parse_error_response (priv->service, GDATA_OPERATION_DOWNLOAD, message->status_code, message->reason_phrase, NULL, 0,
+		                             &child_error);
+	} else if (child_error == NULL && soup_message_headers_get_encoding (message->response_headers) != SOUP_ENCODING_CONTENT_LENGTH) {
+		/* The server doesn't know the length either, so we can't calculate the offset from the start of the stream */
+		g_set_error_literal (&child_error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "G_SEEK_END not supported without a Content-Length");
+	} else if (child_error == NULL) {
+		g_mutex_lock (&(priv->content_mutex));
+		priv->content_length = soup_message_headers_get_content_length (message->response_headers);
+		g_mutex_unlock (&(priv->content_mutex));
+
+		g_object_notify (G_OBJECT (self), "content-length");
+	}
+
+	g_object_unref (message);
+
+	if (child_error != NULL) {
+		g_propagate_error (error, child_error);
 		return FALSE;
 	}
 
+	return TRUE;
+}
+
+static gboolean
+gdata_download_stream_seek (GSeekable *seekable, goffset offset, GSeekType type, GCancellable *cancellable, GError **error)
+{
+	GDataDownloadStreamPrivate *priv = GDATA_DOWNLOAD_STREAM (seekable)->priv;
+	GError *child_error = NULL;
+
 	if (g_input_stream_set_pending (G_INPUT_STREAM (seekable), error) == FALSE) {
 		return FALSE;
 	}
 
+	/* If we don't have the Content-Length yet, we need it to calculate the offset from the start of the stream, so ask the server for it */
+	if (type == G_SEEK_END && priv->content_length == -1 &&
+	    get_content_length (GDATA_DOWNLOAD_STREAM (seekable), cancellable, &child_error) == FALSE) {
+		goto done;
+	}
+
 	/* Ensure that offset is relative to the start of the stream. */
 	switch (type) {
 		case G_SEEK_CUR:
@@ -720,15 +1045,18 @@ gdata_download_stream_seek (GSeekable *seekable, goffset offset, GSeekType type,
 			g_assert_not_reached ();
 	}
 
-	/* There are three cases to consider:
+	/* There are four cases to consider:
 	 *  1. The network thread hasn't been started. In this case, we need to set the offset and do nothing. When the network thread is started
 	 *     (in the next read() call), a Range header will be set on it which will give the correct seek.
-	 *  2. The network thread has been started and the seek is to a position greater than our current position (i.e. one which already does, or
-	 *     will soon, exist in the buffer). In this case, we need to pop the intervening bytes off the buffer (which may block) and update the
-	 *     offset.
-	 *  3. The network thread has been started and the seek is to a position which has already been popped off the buffer. In this case, we need
-	 *     to set the offset and cancel the network thread. When the network thread is restarted (in the next read() call), a Range header will
-	 *     be set on it which will give the correct seek.
+	 *  2. The network thread has been started and the seek is to a position which is in the seek window, or is the next position to be popped
+	 *     off the buffer. In this case, we just need to update the offset; reads will come from the seek window until the offset catches up
+	 *     with the buffer again.
+	 *  3. The network thread has been started and the seek is to a position after the next position to be popped off the buffer (i.e. one which
+	 *     already does, or will soon, exist in the buffer). In this case, we need to pop the intervening bytes off the buffer (which may block)
+	 *     and update the offset.
+	 *  4. The network thread has been started and the seek is to a position which has already been popped off the buffer and isn't in the seek
+	 *     window. In this case, we need to set the offset and cancel the network thread. When the network thread is restarted (in the next
+	 *     read() call), a Range header will be set on it which will give the correct seek.
 	 */
 
 	if (priv->network_thread == NULL) {
@@ -738,13 +1066,19 @@ gdata_download_stream_seek (GSeekable *seekable, goffset offset, GSeekType type,
 		goto done;
 	}
 
-	/* Cases 2 and 3. The network thread has already been started. */
-	if (offset >= priv->offset) {
+	/* Cases 2, 3 and 4. The network thread has already been started. */
+	if (offset >= priv->buffer_offset - (goffset) priv->seek_window_length && offset <= priv->buffer_offset) {
+		/* Case 2. Update the offset and we're done. */
+		priv->offset = offset;
+
+		goto done;
+	} else if (offset > priv->buffer_offset) {
 		goffset num_intervening_bytes;
 		gssize length_read;
 
-		/* Case 2. Pop off the intervening bytes and update the offset. If we can't pop enough bytes off, we throw an error. */
-		num_intervening_bytes = offset - priv->offset;
+		/* Case 3. Pop off the intervening bytes and update the offset. If we can't pop enough bytes off, we throw an error. The skipped bytes
+		 * aren't kept in the seek window, so it has to be emptied to keep it contiguous with the buffer. */
+		num_intervening_bytes = offset - priv->buffer_offset;
 		g_assert (priv->buffer != NULL);
 		length_read = (gssize) gdata_buffer_pop_data (priv->buffer, NULL, num_intervening_bytes, NULL, cancellable);
 
@@ -758,11 +1092,13 @@ gdata_download_stream_seek (GSeekable *seekable, goffset offset, GSeekType type,
 		}
 
 		/* Update the offset */
+		seek_window_clear (GDATA_DOWNLOAD_STREAM (seekable));
 		priv->offset = offset;
+		priv->buffer_offset = offset;
 
 		goto done;
 	} else {
-		/* Case 3. Cancel the current network thread. Note that we don't allow cancellation of this call, as we depend on it waiting for
+		/* Case 4. Cancel the current network thread. Note that we don't allow cancellation of this call, as we depend on it waiting for
 		 * the network thread to join. */
 		if (gdata_download_stream_close (G_INPUT_STREAM (seekable), NULL, &child_error) == FALSE) {
 			goto done;
@@ -806,14 +1142,52 @@ gdata_download_stream_truncate (GSeekable *seekable, goffset offset, GCancellabl
 static void
 got_headers_cb (SoupMessage *message, GDataDownloadStream *self)
 {
+	GDataDownloadStreamPrivate *priv = self->priv;
+
+	if (priv->resume_offset > 0) {
+		goffset start, end, total_length;
+
+		/* Check that the server's resuming the download from where it failed. If the file's changed since, it'll send the whole of the
+		 * new file instead, which mustn't be appended to the data which has already been received. */
+		if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == TRUE &&
+		    (message->status_code != SOUP_STATUS_PARTIAL_CONTENT ||
+		     soup_message_headers_get_content_range (message->response_headers, &start, &end, &total_length) == FALSE ||
+		     start != priv->resume_offset)) {
+			soup_session_cancel_message (priv->session, message, SOUP_STATUS_PRECONDITION_FAILED);
+		}
+
+		/* The content type and length are already known */
+		return;
+	}
+
 	/* Don't get the client's hopes up by setting the Content-Type or -Length if the response
 	 * is actually unsuccessful. */
 	if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == FALSE)
 		return;
 
+	/* Note a strong validator for the file, so the download can be resumed from the same version of it if it fails */
+	if (priv->validator == NULL) {
+		const gchar *etag = soup_message_headers_get_one (message->response_headers, "ETag");
+
+		if (etag != NULL && g_str_has_prefix (etag, "W/") == FALSE)
+			priv->validator = g_strdup (etag);
+		else
+			priv->validator = g_strdup (soup_message_headers_get_one (message->response_headers, "Last-Modified"));
+	}
+
 	g_mutex_lock (&(self->priv->content_mutex));
 	self->priv->content_type = g_strdup (soup_message_headers_get_content_type (message->response_headers, NULL));
-	self->priv->content_length = soup_message_headers_get_content_length (message->response_headers);
+
+	/* If we seeked, the Content-Length is only that of the requested range; the length of the whole file is in the Content-Range instead */
+	if (message->status_code == SOUP_STATUS_PARTIAL_CONTENT) {
+		goffset start, end, total_length;
+
+		if (soup_message_headers_get_content_range (message->response_headers, &start, &end, &total_length) == TRUE)
+			self->priv->content_length = total_length;
+	} else {
+		self->priv->content_length = soup_message_headers_get_content_length (message->response_headers);
+	}
+
 	g_mutex_unlock (&(self->priv->content_mutex));
 
 	/* Emit the notifications for the Content-Length and -Type properties */
@@ -830,15 +1204,18 @@ got_chunk_cb (SoupMessage *message, SoupBuffer *buffer, GDataDownloadStream *sel
 	if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == FALSE || buffer->length == 0)
 		return;
 
-	/* Push the data onto the buffer immediately */
+	/* Push the data onto the buffer immediately. This only takes a reference to the data, rather than copying it. If the buffer is full, this
+	 * blocks until it's been drained, which stops libsoup reading from the socket and so lets TCP flow control throttle the server. */
 	g_assert (self->priv->buffer != NULL);
-	gdata_buffer_push_data (self->priv->buffer, (const guint8*) buffer->data, buffer->length);
+	if (gdata_buffer_push_buffer (self->priv->buffer, buffer, self->priv->network_cancellable) == TRUE)
+		self->priv->network_offset += buffer->length;
 }
 
 static gpointer
 download_thread (GDataDownloadStream *self)
 {
 	GDataDownloadStreamPrivate *priv = self->priv;
+	guint attempt;
 
 	g_object_ref (self);
 
@@ -855,7 +1232,32 @@ download_thread (GDataDownloadStream *self)
 		soup_message_headers_remove (priv->message->request_headers, "Range");
 	}
 
-	_gdata_service_actually_send_message (priv->session, priv->message, priv->network_cancellable, NULL);
+	soup_message_headers_remove (priv->message->request_headers, "If-Range");
+
+	priv->network_offset = priv->offset;
+	priv->resume_offset = -1;
+	g_free (priv->validator);
+	priv->validator = NULL;
+
+	for (attempt = 1; ; attempt++) {
+		goffset start_offset = priv->network_offset;
+
+		_gdata_service_track_request (priv->service, priv->message);
+		_gdata_service_actually_send_message (priv->session, priv->message, priv->network_cancellable, NULL);
+
+		/* If the download failed transiently, resume it from the last byte received. This can only be done safely if no data was received,
+		 * or if we have a validator to check that the rest of the file is from the same version of it. */
+		if ((priv->network_offset > start_offset && priv->validator == NULL) ||
+		    _gdata_service_wait_to_retry (priv->service, priv->message, attempt, priv->network_cancellable) == FALSE) {
+			break;
+		}
+
+		if (priv->network_offset > start_offset) {
+			soup_message_headers_set_range (priv->message->request_headers, priv->network_offset, -1);
+			soup_message_headers_replace (priv->message->request_headers, "If-Range", priv->validator);
+			priv->resume_offset = priv->network_offset;
+		}
+	}
 
 	/* Mark the buffer as having reached EOF */
 	g_assert (priv->buffer != NULL);
@@ -879,6 +1281,8 @@ create_network_thread (GDataDownloadStream *self, GError **error)
 
 	g_assert (priv->buffer == NULL);
 	priv->buffer = gdata_buffer_new ();
+	gdata_buffer_set_high_water_mark (priv->buffer, get_read_ahead (self));
+	priv->buffer_offset = priv->offset;
 
 	g_assert (priv->network_thread == NULL);
 	priv->network_thread = g_thread_try_new ("download-thread", (GThreadFunc) download_thread, self, error);
@@ -897,10 +1301,12 @@ reset_network_thread (GDataDownloadStream *self)
 	}
 
 	if (priv->message != NULL) {
-		soup_session_cancel_message (priv->session, priv->message, SOUP_STATUS_CANCELLED);
+		_gdata_hedging_policy_cancel_message (priv->session, priv->message);
 	}
 
+	seek_window_clear (self);
 	priv->offset = 0;
+	priv->buffer_offset = 0;
 
 	if (priv->network_cancellable != NULL) {
 		g_cancellable_reset (priv->network_cancellable);
@@ -1067,3 +1473,556 @@ gdata_download_stream_get_cancellable (GDataDownloadStream *self)
 	g_assert (self->priv->cancellable != NULL);
 	return self->priv->cancellable;
 }
+
+/**
+ * gdata_download_stream_read_buffer:
+ * @self: a #GDataDownloadStream
+ * @count: the maximum number of bytes to read
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Reads up to @count bytes from the stream, like g_input_stream_read(), but returns them in a #SoupBuffer which references the memory the data was
+ * received into from the network, rather than copying them into a buffer provided by the caller. The returned #SoupBuffer may contain fewer than
+ * @count bytes even if the end of the stream hasn't been reached.
+ *
+ * If the end of the stream has been reached, %NULL is returned and @error is not set. Errors and cancellation are handled in the same way as by
+ * g_input_stream_read(); see the documentation for #GDataDownloadStream.
+ *
+ * Return value: (transfer full) (allow-none): a #SoupBuffer containing at least one byte of data, or %NULL; free with soup_buffer_free()
+ *
+ * Since: 0.15.0
+ **/
+SoupBuffer *
+gdata_download_stream_read_buffer (GDataDownloadStream *self, gsize count, GCancellable *cancellable, GError **error)
+{
+	SoupBuffer *buffer = NULL;
+
+	g_return_val_if_fail (GDATA_IS_DOWNLOAD_STREAM (self), NULL);
+	g_return_val_if_fail (count > 0, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* Check the stream isn't closed or in use by another operation, as g_input_stream_read() does */
+	if (g_input_stream_set_pending (G_INPUT_STREAM (self), error) == FALSE)
+		return NULL;
+
+	read_internal (self, NULL, &buffer, count, cancellable, error);
+
+	g_input_stream_clear_pending (G_INPUT_STREAM (self));
+
+	return buffer;
+}
+
+/**
+ * gdata_download_stream_get_buffer_size:
+ * @self: a #GDataDownloadStream
+ *
+ * Gets the value of #GDataDownloadStream:buffer-size.
+ *
+ * Return value: the maximum number of bytes of downloaded data to hold in memory, or <code class="literal">0</code> for no limit
+ *
+ * Since: 0.15.0
+ **/
+gsize
+gdata_download_stream_get_buffer_size (GDataDownloadStream *self)
+{
+	g_return_val_if_fail (GDATA_IS_DOWNLOAD_STREAM (self), 0);
+	return self->priv->buffer_size;
+}
+
+/**
+ * gdata_download_stream_set_buffer_size:
+ * @self: a #GDataDownloadStream
+ * @buffer_size: the maximum number of bytes of downloaded data to hold in memory, or <code class="literal">0</code> for no limit
+ *
+ * Sets the value of #GDataDownloadStream:buffer-size. This takes effect immediately, even if the download is in progress.
+ *
+ * Since: 0.15.0
+ **/
+void
+gdata_download_stream_set_buffer_size (GDataDownloadStream *self, gsize buffer_size)
+{
+	g_return_if_fail (GDATA_IS_DOWNLOAD_STREAM (self));
+
+	self->priv->buffer_size = buffer_size;
+
+	if (self->priv->buffer != NULL)
+		gdata_buffer_set_high_water_mark (self->priv->buffer, get_read_ahead (self));
+
+	g_object_notify (G_OBJECT (self), "buffer-size");
+}
+
+/**
+ * gdata_download_stream_get_seek_window_size:
+ * @self: a #GDataDownloadStream
+ *
+ * Gets the number of bytes of already-read data kept for backwards seeks. See #GDataDownloadStream:seek-window-size for more details.
+ *
+ * Return value: the size of the seek window, in bytes, or <code class="literal">0</code> if no data is kept
+ *
+ * Since: 0.15.0
+ **/
+gsize
+gdata_download_stream_get_seek_window_size (GDataDownloadStream *self)
+{
+	g_return_val_if_fail (GDATA_IS_DOWNLOAD_STREAM (self), 0);
+	return self->priv->seek_window_size;
+}
+
+/**
+ * gdata_download_stream_set_seek_window_size:
+ * @self: a #GDataDownloadStream
+ * @seek_window_size: the number of bytes of already-read data to keep for backwards seeks, or <code class="literal">0</code> to keep none
+ *
+ * Sets the value of #GDataDownloadStream:seek-window-size. Data which has already been read is only discarded from the window the next time the
+ * stream is read from.
+ *
+ * Since: 0.15.0
+ **/
+void
+gdata_download_stream_set_seek_window_size (GDataDownloadStream *self, gsize seek_window_size)
+{
+	g_return_if_fail (GDATA_IS_DOWNLOAD_STREAM (self));
+
+	self->priv->seek_window_size = seek_window_size;
+	g_object_notify (G_OBJECT (self), "seek-window-size");
+}
+
+/**
+ * gdata_download_stream_prefetch:
+ * @self: a #GDataDownloadStream
+ * @error: a #GError, or %NULL
+ *
+ * Starts downloading the file from the current position in the stream in the background, if that hasn't already started, so that data is
+ * available as soon as possible when the stream is read. This doesn't block. Data is only downloaded until the read-ahead limit is reached (see
+ * #GDataDownloadStream:buffer-size); the download is then paused until the stream is read.
+ *
+ * If the stream is closed, the download has been cancelled, or there's a read or seek pending on the stream, an error is returned.
+ *
+ * Return value: %TRUE if the download was started or had already started, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ **/
+gboolean
+gdata_download_stream_prefetch (GDataDownloadStream *self, GError **error)
+{
+	GDataDownloadStreamPrivate *priv;
+	GError *child_error = NULL;
+
+	g_return_val_if_fail (GDATA_IS_DOWNLOAD_STREAM (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	priv = self->priv;
+
+	if (g_input_stream_set_pending (G_INPUT_STREAM (self), error) == FALSE)
+		return FALSE;
+
+	if (priv->network_thread == NULL && g_cancellable_set_error_if_cancelled (priv->cancellable, &child_error) == FALSE)
+		create_network_thread (self, &child_error);
+
+	g_input_stream_clear_pending (G_INPUT_STREAM (self));
+
+	if (child_error != NULL) {
+		g_propagate_error (error, child_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* State shared between all the ranges of a gdata_download_stream_download_to_file() operation */
+typedef struct {
+	GOutputStream *output_stream;
+	gboolean seekable;
+	GMutex mutex; /* protects output_stream and error */
+	GError *error; /* the first error to occur, if any */
+	GCancellable *cancellable; /* cancelled if any range fails, or if the operation as a whole is cancelled */
+	gchar *validator; /* strong ETag or Last-Modified date of the file, sent with If-Range so that all the ranges come from the same version of it */
+} DownloadToFileData;
+
+/* A single range of a gdata_download_stream_download_to_file() operation */
+typedef struct {
+	GDataDownloadStream *download_stream;
+	DownloadToFileData *data;
+	goffset start;
+	goffset end; /* inclusive, or -1 to download the whole file without a Range header */
+	goffset position; /* offset of the next byte to be written */
+	gboolean writing; /* whether the response is the one we asked for, and so should be written out */
+	GThread *thread;
+} DownloadRange;
+
+static void
+download_to_file_set_error (DownloadToFileData *data, GError *error)
+{
+	g_mutex_lock (&(data->mutex));
+
+	if (data->error == NULL)
+		data->error = error;
+	else
+		g_error_free (error);
+
+	g_mutex_unlock (&(data->mutex));
+
+	/* Stop the other ranges */
+	g_cancellable_cancel (data->cancellable);
+}
+
+static void
+range_got_headers_cb (SoupMessage *message, DownloadRange *range)
+{
+	goffset start, end, total_length;
+
+	/* Only write out the response if it's the range we asked for. If the server ignored the Range header or returned the whole file because it's
+	 * changed since we found its length, writing it at our offset would corrupt the output; the error's picked up once the message has finished. */
+	if (range->end == -1) {
+		range->writing = SOUP_STATUS_IS_SUCCESSFUL (message->status_code);
+	} else {
+		range->writing = (message->status_code == SOUP_STATUS_PARTIAL_CONTENT &&
+		                  soup_message_headers_get_content_range (message->response_headers, &start, &end, &total_length) == TRUE &&
+		                  start == range->start && end == range->end) ? TRUE : FALSE;
+	}
+}
+
+static void
+range_got_chunk_cb (SoupMessage *message, SoupBuffer *buffer, DownloadRange *range)
+{
+	DownloadToFileData *data = range->data;
+	GError *error = NULL;
+
+	if (range->writing == FALSE || buffer->length == 0)
+		return;
+
+	/* Don't write past the end of the range, in case the server sent more than we asked for */
+	if (range->end != -1 && range->position + (goffset) buffer->length > range->end + 1) {
+		range->writing = FALSE;
+		return;
+	}
+
+	/* Write the chunk at the right position in the file. The output stream's shared with the other ranges, so seeking and writing has to be
+	 * done atomically. */
+	g_mutex_lock (&(data->mutex));
+
+	if ((data->seekable == FALSE ||
+	     g_seekable_seek (G_SEEKABLE (data->output_stream), range->position, G_SEEK_SET, data->cancellable, &error) == TRUE) &&
+	    g_output_stream_write_all (data->output_stream, buffer->data, buffer->length, NULL, data->cancellable, &error) == TRUE) {
+		range->position += buffer->length;
+	}
+
+	g_mutex_unlock (&(data->mutex));
+
+	if (error != NULL) {
+		range->writing = FALSE;
+		download_to_file_set_error (data, error);
+	}
+}
+
+static gpointer
+download_range_thread (DownloadRange *range)
+{
+	GDataDownloadStreamPrivate *priv = range->download_stream->priv;
+	DownloadToFileData *data = range->data;
+	SoupMessage *message;
+	GError *error = NULL;
+
+	message = build_message (range->download_stream, SOUP_METHOD_GET);
+
+	if (range->end != -1) {
+		soup_message_headers_set_range (message->request_headers, range->start, range->end);
+		soup_message_headers_replace (message->request_headers, "If-Range", data->validator);
+	}
+
+	g_signal_connect (message, "got-headers", (GCallback) range_got_headers_cb, range);
+	g_signal_connect (message, "got-chunk", (GCallback) range_got_chunk_cb, range);
+
+	_gdata_service_track_request (priv->service, message);
+	_gdata_service_actually_send_message (priv->session, message, data->cancellable, &error);
+
+	if (error != NULL) {
+		/* Cancelled or otherwise failed before a response was received */
+	} else if (range->end != -1 &&
+	           (message->status_code == SOUP_STATUS_OK || message->status_code == SOUP_STATUS_PRECONDITION_FAILED)) {
+		/* The file no longer matches the validator, so this range would come from a different version of it than the others */
+		g_set_error (&error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_CONFLICT,
+		             /* Translators: the parameter is the URI of the file being downloaded. */
+		             _("The file %s changed on the server while it was being downloaded."), priv->download_uri);
+	} else if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == FALSE) {
+		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (priv->service);
+
+		g_assert (klass->parse_error_response != NULL);
+		klass->parse_error_response (priv->service, GDATA_OPERATION_DOWNLOAD, message->status_code, message->reason_phrase, NULL, 0, &error);
+	} else if ((range->end == -1 && range->writing == FALSE) ||
+	           (range->end != -1 && (message->status_code != SOUP_STATUS_PARTIAL_CONTENT || range->position != range->end + 1))) {
+		/* The server didn't return the range we asked for, or the response was cut short. (A failed write will already have set an error.) */
+		g_set_error (&error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR,
+		             /* Translators: the parameter is the URI of the file being downloaded. */
+		             _("The server returned an incomplete response when downloading %s."), priv->download_uri);
+	}
+
+	if (error != NULL)
+		download_to_file_set_error (data, error);
+
+	g_object_unref (message);
+
+	return NULL;
+}
+
+/* Find the length of the file and whether the server supports Range requests, using a HEAD request. The ranges also need a strong validator (the
+ * file's ETag or modification date) for If-Range, so that they all come from the same version of the file; it's returned in @validator. Returns -1
+ * if any of these can't be determined. */
+static goffset
+get_rangeable_length (GDataDownloadStream *self, GCancellable *cancellable, gchar **validator)
+{
+	SoupMessage *message;
+	const gchar *etag, *last_modified;
+	goffset length = -1;
+
+	*validator = NULL;
+
+	message = send_head_request (self, cancellable, NULL);
+
+	etag = soup_message_headers_get_one (message->response_headers, "ETag");
+	last_modified = soup_message_headers_get_one (message->response_headers, "Last-Modified");
+
+	if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == TRUE &&
+	    soup_message_headers_get_encoding (message->response_headers) == SOUP_ENCODING_CONTENT_LENGTH &&
+	    soup_message_headers_header_contains (message->response_headers, "Accept-Ranges", "bytes") == TRUE) {
+		if (etag != NULL && g_str_has_prefix (etag, "W/") == FALSE)
+			*validator = g_strdup (etag);
+		else if (last_modified != NULL)
+			*validator = g_strdup (last_modified);
+
+		if (*validator != NULL)
+			length = soup_message_headers_get_content_length (message->response_headers);
+	}
+
+	g_object_unref (message);
+
+	return length;
+}
+
+/**
+ * gdata_download_stream_download_to_file:
+ * @self: a #GDataDownloadStream
+ * @destination: the file to save the download to
+ * @n_connections: the maximum number of connections to download over in parallel, or <code class="literal">0</code> for the default
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Downloads the whole of the file at #GDataDownloadStream:download-uri to @destination, replacing it if it already exists. This doesn't affect
+ * the position of @self as a stream, and @self doesn't have to have been read from.
+ *
+ * If the server reports the file's length and a strong validator for it (its ETag or modification date), and supports <literal>Range</literal>
+ * requests, the file is split into up to @n_connections ranges (but none smaller than 512KiB) which are downloaded in parallel over separate
+ * connections, and written straight to their places in @destination. This can greatly increase the download speed for large files on connections
+ * with a high bandwidth-delay product. Otherwise, the file is downloaded over a single connection. If @n_connections is
+ * <code class="literal">0</code>, four connections are used.
+ *
+ * Every range is requested with an <literal>If-Range</literal> header giving the file's validator, so if the file changes on the server part-way
+ * through the download, the operation fails with %GDATA_SERVICE_ERROR_CONFLICT rather than writing parts of two versions of the file to
+ * @destination.
+ *
+ * Note that the number of connections made to a host at once is limited by the #GDataService:connection-pool of the #GDataDownloadStream:service,
+ * or by libsoup's default limit of two if it doesn't have one, so the limit may need raising for @n_connections to take effect.
+ *
+ * If any part of the download fails, the whole operation fails and the error is returned; if @destination already existed, it's left unchanged
+ * where possible. The operation can be cancelled using @cancellable or #GDataDownloadStream:cancellable.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ **/
+gboolean
+gdata_download_stream_download_to_file (GDataDownloadStream *self, GFile *destination, guint n_connections, GCancellable *cancellable,
+                                        GError **error)
+{
+	GDataDownloadStreamPrivate *priv;
+	DownloadToFileData data;
+	DownloadRange *ranges;
+	GFileOutputStream *output_stream;
+	gulong cancelled_signal = 0, global_cancelled_signal = 0;
+	goffset length, range_size;
+	guint n_ranges, i;
+	gboolean success;
+
+	g_return_val_if_fail (GDATA_IS_DOWNLOAD_STREAM (self), FALSE);
+	g_return_val_if_fail (G_IS_FILE (destination), FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	priv = self->priv;
+
+	if (n_connections == 0)
+		n_connections = 4;
+
+	/* Multiplex cancellation from @cancellable and the whole stream's cancellable, as in gdata_download_stream_read() */
+	data.cancellable = g_cancellable_new ();
+	data.error = NULL;
+	data.validator = NULL;
+	g_mutex_init (&(data.mutex));
+
+	global_cancelled_signal = g_cancellable_connect (priv->cancellable, (GCallback) cancellable_cancel_cb, data.cancellable, NULL);
+	if (cancellable != NULL)
+		cancelled_signal = g_cancellable_connect (cancellable, (GCallback) cancellable_cancel_cb, data.cancellable, NULL);
+
+	output_stream = g_file_replace (destination, NULL, FALSE, G_FILE_CREATE_NONE, data.cancellable, &(data.error));
+	if (output_stream == NULL)
+		goto done;
+
+	data.output_stream = G_OUTPUT_STREAM (output_stream);
+	data.seekable = g_seekable_can_seek (G_SEEKABLE (output_stream));
+
+	/* Work out how to split up the file. Only bother asking the server if we can make use of the answer. */
+	length = (n_connections > 1 && data.seekable == TRUE) ? get_rangeable_length (self, data.cancellable, &(data.validator)) : -1;
+
+	if (length > 0) {
+		n_ranges = (guint) CLAMP ((length + MIN_RANGE_SIZE - 1) / MIN_RANGE_SIZE, 1, n_connections);
+		range_size = (length + n_ranges - 1) / n_ranges;
+	} else {
+		n_ranges = 1;
+		range_size = -1;
+	}
+
+	/* Download the ranges in parallel */
+	ranges = g_new0 (DownloadRange, n_ranges);
+
+	for (i = 0; i < n_ranges; i++) {
+		DownloadRange *range = &(ranges[i]);
+
+		range->download_stream = self;
+		range->data = &data;
+		range->start = (range_size == -1) ? 0 : i * range_size;
+		range->end = (range_size == -1) ? -1 : MIN (range->start + range_size, length) - 1;
+		range->position = range->start;
+
+		if (i == n_ranges - 1) {
+			/* Download the last range in this thread */
+			download_range_thread (range);
+		} else {
+			GError *child_error = NULL;
+
+			range->thread = g_thread_try_new ("download-range-thread", (GThreadFunc) download_range_thread, range, &child_error);
+			if (range->thread == NULL)
+				download_to_file_set_error (&data, child_error);
+		}
+	}
+
+	for (i = 0; i < n_ranges; i++) {
+		if (ranges[i].thread != NULL)
+			g_thread_join (ranges[i].thread);
+	}
+
+	g_free (ranges);
+
+	/* If there was an error, close the file with the (cancelled) cancellable so that it's abandoned, rather than replacing the original. */
+	g_output_stream_close (G_OUTPUT_STREAM (output_stream), data.cancellable, (data.error == NULL) ? &(data.error) : NULL);
+	g_object_unref (output_stream);
+
+done:
+	if (cancelled_signal != 0)
+		g_cancellable_disconnect (cancellable, cancelled_signal);
+	if (global_cancelled_signal != 0)
+		g_cancellable_disconnect (priv->cancellable, global_cancelled_signal);
+
+	g_object_unref (data.cancellable);
+	g_free (data.validator);
+	g_mutex_clear (&(data.mutex));
+
+	success = (data.error == NULL) ? TRUE : FALSE;
+
+	if (data.error != NULL)
+		g_propagate_error (error, data.error);
+
+	return success;
+}
+
+typedef struct {
+	GFile *destination;
+	guint n_connections;
+} DownloadToFileAsyncData;
+
+static void
+download_to_file_async_data_free (DownloadToFileAsyncData *data)
+{
+	g_object_unref (data->destination);
+	g_slice_free (DownloadToFileAsyncData, data);
+}
+
+static void
+download_to_file_thread (GSimpleAsyncResult *result, GDataDownloadStream *self, GCancellable *cancellable)
+{
+	DownloadToFileAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+	GError *error = NULL;
+
+	if (gdata_download_stream_download_to_file (self, data->destination, data->n_connections, cancellable, &error) == FALSE) {
+		g_simple_async_result_set_from_error (result, error);
+		g_error_free (error);
+	}
+}
+
+/**
+ * gdata_download_stream_download_to_file_async:
+ * @self: a #GDataDownloadStream
+ * @destination: the file to save the download to
+ * @n_connections: the maximum number of connections to download over in parallel, or <code class="literal">0</code> for the default
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the download is finished
+ * @user_data: (closure): data to pass to the @callback function
+ *
+ * Downloads the file to @destination asynchronously. @self and @destination are reffed when this function is called, so can safely be unreffed
+ * after this function returns.
+ *
+ * For more details, see gdata_download_stream_download_to_file(), which is the synchronous version of this function. It's run in a thread from
+ * GIO's worker pool, which is blocked for the duration of the download.
+ *
+ * When the operation is finished, @callback will be called. You can then call gdata_download_stream_download_to_file_finish() to get the results
+ * of the operation.
+ *
+ * Since: 0.15.0
+ **/
+void
+gdata_download_stream_download_to_file_async (GDataDownloadStream *self, GFile *destination, guint n_connections, GCancellable *cancellable,
+                                              GAsyncReadyCallback callback, gpointer user_data)
+{
+	GSimpleAsyncResult *result;
+	DownloadToFileAsyncData *data;
+
+	g_return_if_fail (GDATA_IS_DOWNLOAD_STREAM (self));
+	g_return_if_fail (G_IS_FILE (destination));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	data = g_slice_new (DownloadToFileAsyncData);
+	data->destination = g_object_ref (destination);
+	data->n_connections = n_connections;
+
+	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_download_stream_download_to_file_async);
+	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) download_to_file_async_data_free);
+	g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) download_to_file_thread, G_PRIORITY_DEFAULT, cancellable);
+	g_object_unref (result);
+}
+
+/**
+ * gdata_download_stream_download_to_file_finish:
+ * @self: a #GDataDownloadStream
+ * @async_result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Finishes an asynchronous download to a file started with gdata_download_stream_download_to_file_async().
+ *
+ * Return value: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ **/
+gboolean
+gdata_download_stream_download_to_file_finish (GDataDownloadStream *self, GAsyncResult *async_result, GError **error)
+{
+	g_return_val_if_fail (GDATA_IS_DOWNLOAD_STREAM (self), FALSE);
+	g_return_val_if_fail (G_IS_ASYNC_RESULT (async_result), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	g_warn_if_fail (g_simple_async_result_get_source_tag (G_SIMPLE_ASYNC_RESULT (async_result)) == gdata_download_stream_download_to_file_async);
+
+	if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (async_result), error) == TRUE)
+		return FALSE;
+
+	return TRUE;
+}
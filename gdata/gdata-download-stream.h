@@ -73,6 +73,22 @@ const gchar *gdata_download_stream_get_content_type (GDataDownloadStream *self)
 gssize gdata_download_stream_get_content_length (GDataDownloadStream *self) G_GNUC_PURE;
 GCancellable *gdata_download_stream_get_cancellable (GDataDownloadStream *self) G_GNUC_PURE;
 
+gsize gdata_download_stream_get_buffer_size (GDataDownloadStream *self) G_GNUC_PURE;
+void gdata_download_stream_set_buffer_size (GDataDownloadStream *self, gsize buffer_size);
+gsize gdata_download_stream_get_seek_window_size (GDataDownloadStream *self) G_GNUC_PURE;
+void gdata_download_stream_set_seek_window_size (GDataDownloadStream *self, gsize seek_window_size);
+
+gboolean gdata_download_stream_prefetch (GDataDownloadStream *self, GError **error);
+
+gboolean gdata_download_stream_download_to_file (GDataDownloadStream *self, GFile *destination, guint n_connections, GCancellable *cancellable,
+                                                 GError **error);
+void gdata_download_stream_download_to_file_async (GDataDownloadStream *self, GFile *destination, guint n_connections, GCancellable *cancellable,
+                                                   GAsyncReadyCallback callback, gpointer user_data);
+gboolean gdata_download_stream_download_to_file_finish (GDataDownloadStream *self, GAsyncResult *async_result, GError **error);
+
+SoupBuffer *gdata_download_stream_read_buffer (GDataDownloadStream *self, gsize count, GCancellable *cancellable,
+                                               GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
 G_END_DECLS
 
 #endif /* !GDATA_DOWNLOAD_STREAM_H */
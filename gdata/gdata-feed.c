@@ -44,6 +44,7 @@
 #include "gdata-private.h"
 #include "gdata-service.h"
 #include "gdata-parsable.h"
+#include "gdata-trace.h"
 
 static void gdata_feed_dispose (GObject *object);
 static void gdata_feed_finalize (GObject *object);
@@ -409,11 +410,20 @@ gdata_feed_get_property (GObject *object, guint property_id, GValue *value, GPar
 }
 
 typedef struct {
+	volatile gint ref_count;
 	GType entry_type;
 	GDataQueryProgressCallback progress_callback;
+	GDataQueryBatchProgressCallback batch_progress_callback;
 	gpointer progress_user_data;
 	guint entry_i;
-	gboolean is_async;
+
+	/* Progress callbacks waiting to be dispatched in @context, when running asynchronously. They're dispatched in batches by a single idle
+	 * source, rather than one idle source per entry, so that large feeds don't flood the main context. The source holds its own reference to the
+	 * ParseData, so the parser never has to wait for it to be dispatched. */
+	GMainContext *context; /* or NULL to call the progress callbacks directly, when running synchronously */
+	GMutex pending_mutex;
+	GQueue pending; /* ProgressCallbackData */
+	GSource *pending_source; /* owned by @context; or NULL if no idle source is scheduled */
 } ParseData;
 
 static gboolean
@@ -425,8 +435,6 @@ pre_parse_xml (GDataParsable *parsable, xmlDoc *doc, xmlNode *root_node, gpointe
 }
 
 typedef struct {
-	GDataQueryProgressCallback progress_callback;
-	gpointer progress_user_data;
 	GDataEntry *entry;
 	guint entry_i;
 	guint total_results;
@@ -448,11 +456,13 @@ parse_xml (GDataParsable *parsable, xmlDoc *doc, xmlNode *node, gpointer user_da
 			/* Allow @data to be %NULL, and assume we're parsing a vanilla feed, so that we can test #GDataFeed in tests/general.c.
 			 * A little hacky, but not too much so, and valuable for testing. */
 			entry_type = (data != NULL) ? data->entry_type : GDATA_TYPE_ENTRY;
+			GDATA_TRACE_ENTRY_PARSE_START (entry_type);
 			entry = GDATA_ENTRY (_gdata_parsable_new_from_xml_node (entry_type, doc, node, NULL, error));
+			GDATA_TRACE_ENTRY_PARSE_END (entry_type, entry);
 			if (entry == NULL)
 				return FALSE;
 
-			/* Calls the callbacks in the main thread */
+			/* Calls the callbacks in the caller's main context */
 			if (data != NULL)
 				_gdata_feed_call_progress_callback (self, data, entry);
 			_gdata_feed_add_entry (self, entry);
@@ -612,11 +622,13 @@ parse_json (GDataParsable *parsable, JsonReader *reader, gpointer user_data, GEr
 			entry_type = (data != NULL) ? data->entry_type : GDATA_TYPE_ENTRY;
 
 			/* Parse the node, passing it the reader cursor. */
+			GDATA_TRACE_ENTRY_PARSE_START (entry_type);
 			entry = GDATA_ENTRY (_gdata_parsable_new_from_json_node (entry_type, reader, NULL, error));
+			GDATA_TRACE_ENTRY_PARSE_END (entry_type, entry);
 			if (entry == NULL)
 				return FALSE;
 
-			/* Calls the callbacks in the main thread */
+			/* Calls the callbacks in the caller's main context */
 			if (data != NULL)
 				_gdata_feed_call_progress_callback (self, data, entry);
 			_gdata_feed_add_entry (self, entry);
@@ -673,7 +685,8 @@ _gdata_feed_new (const gchar *title, const gchar *id, gint64 updated)
 
 GDataFeed *
 _gdata_feed_new_from_xml (GType feed_type, const gchar *xml, gint length, GType entry_type,
-                          GDataQueryProgressCallback progress_callback, gpointer progress_user_data, gboolean is_async, GError **error)
+                          GDataQueryProgressCallback progress_callback, GDataQueryBatchProgressCallback batch_progress_callback,
+                          gpointer progress_user_data, GMainContext *progress_context, GError **error)
 {
 	ParseData *data;
 	GDataFeed *feed;
@@ -683,7 +696,7 @@ _gdata_feed_new_from_xml (GType feed_type, const gchar *xml, gint length, GType
 	g_return_val_if_fail (g_type_is_a (entry_type, GDATA_TYPE_ENTRY), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	data = _gdata_feed_parse_data_new (entry_type, progress_callback, progress_user_data, is_async);
+	data = _gdata_feed_parse_data_new (entry_type, progress_callback, batch_progress_callback, progress_user_data, progress_context);
 	feed = GDATA_FEED (_gdata_parsable_new_from_xml (feed_type, xml, length, data, error));
 	_gdata_feed_parse_data_free (data);
 
@@ -692,7 +705,8 @@ _gdata_feed_new_from_xml (GType feed_type, const gchar *xml, gint length, GType
 
 GDataFeed *
 _gdata_feed_new_from_json (GType feed_type, const gchar *json, gint length, GType entry_type,
-                          GDataQueryProgressCallback progress_callback, gpointer progress_user_data, gboolean is_async, GError **error)
+                           GDataQueryProgressCallback progress_callback, GDataQueryBatchProgressCallback batch_progress_callback,
+                           gpointer progress_user_data, GMainContext *progress_context, GError **error)
 {
 	ParseData *data;
 	GDataFeed *feed;
@@ -702,7 +716,7 @@ _gdata_feed_new_from_json (GType feed_type, const gchar *json, gint length, GTyp
 	g_return_val_if_fail (g_type_is_a (entry_type, GDATA_TYPE_ENTRY), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	data = _gdata_feed_parse_data_new (entry_type, progress_callback, progress_user_data, is_async);
+	data = _gdata_feed_parse_data_new (entry_type, progress_callback, batch_progress_callback, progress_user_data, progress_context);
 	feed = GDATA_FEED (_gdata_parsable_new_from_json (feed_type, json, length, data, error));
 	_gdata_feed_parse_data_free (data);
 
@@ -1045,31 +1059,157 @@ _gdata_feed_add_entry (GDataFeed *self, GDataEntry *entry)
 }
 
 gpointer
-_gdata_feed_parse_data_new (GType entry_type, GDataQueryProgressCallback progress_callback, gpointer progress_user_data, gboolean is_async)
+_gdata_feed_parse_data_new (GType entry_type, GDataQueryProgressCallback progress_callback, GDataQueryBatchProgressCallback batch_progress_callback,
+                            gpointer progress_user_data, GMainContext *progress_context)
 {
 	ParseData *data;
 	data = g_slice_new (ParseData);
+	data->ref_count = 1;
 	data->entry_type = entry_type;
 	data->progress_callback = progress_callback;
+	data->batch_progress_callback = batch_progress_callback;
 	data->progress_user_data = progress_user_data;
 	data->entry_i = 0;
-	data->is_async = is_async;
+
+	data->context = (progress_context != NULL) ? g_main_context_ref (progress_context) : NULL;
+	g_mutex_init (&(data->pending_mutex));
+	g_queue_init (&(data->pending));
+	data->pending_source = NULL;
 
 	return data;
 }
 
+static ParseData *
+parse_data_ref (ParseData *data)
+{
+	g_atomic_int_inc (&(data->ref_count));
+	return data;
+}
+
+static void
+parse_data_unref (ParseData *data)
+{
+	if (g_atomic_int_dec_and_test (&(data->ref_count)) == FALSE)
+		return;
+
+	g_assert (g_queue_is_empty (&(data->pending)) == TRUE);
+
+	if (data->context != NULL)
+		g_main_context_unref (data->context);
+
+	g_mutex_clear (&(data->pending_mutex));
+	g_slice_free (ParseData, data);
+}
+
 void
 _gdata_feed_parse_data_free (gpointer data)
 {
-	g_slice_free (ParseData, data);
+	ParseData *parse_data = data;
+
+	/* Parsing has finished, so the operation's GAsyncReadyCallback is about to be scheduled in the same main context as any pending progress
+	 * callbacks, at G_PRIORITY_DEFAULT. Raise the priority of the idle source dispatching them so that they're all still called before the
+	 * GAsyncReadyCallback, a time budget's worth per main loop iteration. We mustn't wait for them here, since the main context might not be
+	 * iterated until we return. The idle source's @pending_source is only cleared under the lock as it returns %FALSE, so the source can't
+	 * have been destroyed if it's still set. */
+	g_mutex_lock (&(parse_data->pending_mutex));
+	if (parse_data->pending_source != NULL)
+		g_source_set_priority (parse_data->pending_source, G_PRIORITY_HIGH);
+	g_mutex_unlock (&(parse_data->pending_mutex));
+
+	parse_data_unref (parse_data);
+}
+
+static void
+progress_callback_data_free (ProgressCallbackData *progress_data)
+{
+	g_object_unref (progress_data->entry);
+	g_slice_free (ProgressCallbackData, progress_data);
+}
+
+/* Maximum time to spend dispatching progress callbacks in one main loop iteration, in microseconds. Long enough to make good progress through
+ * large feeds; short enough to keep the UI responsive. */
+#define PROGRESS_CALLBACK_TIME_BUDGET (G_USEC_PER_SEC / 200)
+
+/* Maximum number of entries to pass to a batch progress callback at once, so that the time budget can be checked between batches */
+#define PROGRESS_CALLBACK_MAX_BATCH_SIZE 50
+
+static void
+call_progress_callback (ParseData *data, ProgressCallbackData *progress_data)
+{
+	if (data->batch_progress_callback != NULL) {
+		GDataEntry *entries[1] = { progress_data->entry, };
+		data->batch_progress_callback (entries, 1, progress_data->entry_i, progress_data->total_results, data->progress_user_data);
+	} else {
+		data->progress_callback (progress_data->entry, progress_data->entry_i, progress_data->total_results, data->progress_user_data);
+	}
+}
+
+static void
+call_batch_progress_callback (ParseData *data, ProgressCallbackData **batch, guint n_entries)
+{
+	GDataEntry *entries[PROGRESS_CALLBACK_MAX_BATCH_SIZE];
+	guint i;
+
+	for (i = 0; i < n_entries; i++)
+		entries[i] = batch[i]->entry;
+
+	data->batch_progress_callback (entries, n_entries, batch[0]->entry_i, batch[0]->total_results, data->progress_user_data);
 }
 
 static gboolean
-progress_callback_idle (ProgressCallbackData *data)
+progress_callback_idle (ParseData *data)
 {
-	data->progress_callback (data->entry, data->entry_i, data->total_results, data->progress_user_data);
-	g_object_unref (data->entry);
-	g_slice_free (ProgressCallbackData, data);
+	gint64 deadline;
+	ProgressCallbackData *progress_data;
+
+	deadline = g_get_monotonic_time () + PROGRESS_CALLBACK_TIME_BUDGET;
+
+	if (data->batch_progress_callback != NULL) {
+		/* Hand the pending entries to the batch callback a batch at a time, until we run out of time or pending entries */
+		do {
+			ProgressCallbackData *batch[PROGRESS_CALLBACK_MAX_BATCH_SIZE];
+			guint n_entries = 0, i;
+
+			g_mutex_lock (&(data->pending_mutex));
+			while (n_entries < G_N_ELEMENTS (batch) && (progress_data = g_queue_pop_head (&(data->pending))) != NULL)
+				batch[n_entries++] = progress_data;
+			g_mutex_unlock (&(data->pending_mutex));
+
+			if (n_entries == 0)
+				break;
+
+			call_batch_progress_callback (data, batch, n_entries);
+
+			for (i = 0; i < n_entries; i++)
+				progress_callback_data_free (batch[i]);
+		} while (g_get_monotonic_time () < deadline);
+	} else {
+		/* Call the callbacks one at a time until we run out of time or pending entries */
+		do {
+			g_mutex_lock (&(data->pending_mutex));
+			progress_data = g_queue_pop_head (&(data->pending));
+			g_mutex_unlock (&(data->pending_mutex));
+
+			if (progress_data == NULL)
+				break;
+
+			call_progress_callback (data, progress_data);
+			progress_callback_data_free (progress_data);
+		} while (g_get_monotonic_time () < deadline);
+	}
+
+	/* If we ran out of time, or more entries have been queued in the meantime, keep the source around to dispatch them in the next main loop
+	 * iteration. Otherwise, the source is destroyed, which drops its reference to @data. */
+	g_mutex_lock (&(data->pending_mutex));
+
+	if (g_queue_is_empty (&(data->pending)) == FALSE) {
+		g_mutex_unlock (&(data->pending_mutex));
+		return TRUE;
+	}
+
+	data->pending_source = NULL;
+	g_mutex_unlock (&(data->pending_mutex));
+
 	return FALSE;
 }
 
@@ -1078,24 +1218,37 @@ _gdata_feed_call_progress_callback (GDataFeed *self, gpointer user_data, GDataEn
 {
 	ParseData *data = user_data;
 
-	if (data->progress_callback != NULL) {
+	if (data->progress_callback != NULL || data->batch_progress_callback != NULL) {
 		ProgressCallbackData *progress_data;
 
 		/* Build the data for the callback */
 		progress_data = g_slice_new (ProgressCallbackData);
-		progress_data->progress_callback = data->progress_callback;
-		progress_data->progress_user_data = data->progress_user_data;
 		progress_data->entry = g_object_ref (entry);
 		progress_data->entry_i = data->entry_i;
 		progress_data->total_results = MIN (self->priv->items_per_page, self->priv->total_results);
 
-		if (data->is_async == TRUE) {
-			/* Send the callback; use G_PRIORITY_DEFAULT rather than G_PRIORITY_DEFAULT_IDLE
-			* to contend with the priorities used by the callback functions in GAsyncResult */
-			g_idle_add_full (G_PRIORITY_DEFAULT, (GSourceFunc) progress_callback_idle, progress_data, NULL);
+		if (data->context != NULL) {
+			/* Queue the callback, and schedule an idle source in the caller's main context to dispatch the queue if there isn't one already.
+			 * Use G_PRIORITY_DEFAULT rather than G_PRIORITY_DEFAULT_IDLE to contend with the priorities used by the callback functions in
+			 * GAsyncResult. */
+			g_mutex_lock (&(data->pending_mutex));
+
+			g_queue_push_tail (&(data->pending), progress_data);
+
+			if (data->pending_source == NULL) {
+				data->pending_source = g_idle_source_new ();
+				g_source_set_priority (data->pending_source, G_PRIORITY_DEFAULT);
+				g_source_set_callback (data->pending_source, (GSourceFunc) progress_callback_idle, parse_data_ref (data),
+				                       (GDestroyNotify) parse_data_unref);
+				g_source_attach (data->pending_source, data->context);
+				g_source_unref (data->pending_source);
+			}
+
+			g_mutex_unlock (&(data->pending_mutex));
 		} else {
 			/* If we're running synchronously, just call the callbacks directly */
-			progress_callback_idle (progress_data);
+			call_progress_callback (data, progress_data);
+			progress_callback_data_free (progress_data);
 		}
 	}
 	data->entry_i++;
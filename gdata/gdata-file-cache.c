@@ -0,0 +1,407 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-file-cache
+ * @short_description: GData on-disk response cache
+ * @stability: Unstable
+ * @include: gdata/gdata-file-cache.h
+ *
+ * #GDataFileCache is an implementation of #GDataCache which stores responses as files in a directory on disk, so that they persist between runs of
+ * the application. The directory is given by #GDataFileCache:directory, and will be created if it doesn't already exist. It should be private to the
+ * cache; a subdirectory of g_get_user_cache_dir() is a good choice.
+ *
+ * Each response is stored as a pair of files: a small key file containing the URI, ETag and content type of the response, and a file containing the
+ * response body. Bodies are memory-mapped when they're looked up, so looking up a large cached feed doesn't copy it.
+ *
+ * Errors writing to the cache directory are not fatal: the response simply isn't cached.
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gdata-file-cache.h"
+
+#define META_SUFFIX ".meta"
+#define BODY_SUFFIX ".body"
+#define META_GROUP "Response"
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+static gboolean look_up (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body);
+static void store (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body);
+static void remove_ (GDataCache *self, const gchar *uri);
+static void clear (GDataCache *self);
+
+struct _GDataFileCachePrivate {
+	gchar *directory;
+	GMutex mutex; /* serialises modifications to the files in the directory */
+};
+
+enum {
+	PROP_DIRECTORY = 1,
+};
+
+G_DEFINE_TYPE (GDataFileCache, gdata_file_cache, GDATA_TYPE_CACHE)
+
+static void
+gdata_file_cache_class_init (GDataFileCacheClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GDataCacheClass *cache_class = GDATA_CACHE_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataFileCachePrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	cache_class->look_up = look_up;
+	cache_class->store = store;
+	cache_class->remove = remove_;
+	cache_class->clear = clear;
+
+	/**
+	 * GDataFileCache:directory:
+	 *
+	 * The path of the directory to store the cached responses in. It will be created if it doesn't exist.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_DIRECTORY,
+	                                 g_param_spec_string ("directory",
+	                                                      "Directory", "The path of the directory to store the cached responses in.",
+	                                                      NULL,
+	                                                      G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdata_file_cache_init (GDataFileCache *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_FILE_CACHE, GDataFileCachePrivate);
+	g_mutex_init (&(self->priv->mutex));
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (object)->priv;
+
+	g_free (priv->directory);
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_file_cache_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (object)->priv;
+
+	switch (property_id) {
+		case PROP_DIRECTORY:
+			g_value_set_string (value, priv->directory);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (object)->priv;
+
+	switch (property_id) {
+		case PROP_DIRECTORY:
+			/* Construct only */
+			priv->directory = g_value_dup_string (value);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/* Build the path of the key file holding the metadata for @uri. */
+static gchar *
+build_meta_path (GDataFileCachePrivate *priv, const gchar *uri)
+{
+	gchar *checksum, *filename, *path;
+
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+	filename = g_strconcat (checksum, META_SUFFIX, NULL);
+	path = g_build_filename (priv->directory, filename, NULL);
+	g_free (filename);
+	g_free (checksum);
+
+	return path;
+}
+
+/* Load the key file holding the metadata for @uri, checking that it's actually for @uri (rather than a hash collision). */
+static GKeyFile *
+load_meta (GDataFileCachePrivate *priv, const gchar *uri, gchar **meta_path)
+{
+	GKeyFile *key_file;
+	gchar *stored_uri;
+
+	*meta_path = build_meta_path (priv, uri);
+
+	key_file = g_key_file_new ();
+	if (g_key_file_load_from_file (key_file, *meta_path, G_KEY_FILE_NONE, NULL) == FALSE) {
+		g_key_file_free (key_file);
+		return NULL;
+	}
+
+	stored_uri = g_key_file_get_string (key_file, META_GROUP, "URI", NULL);
+	if (g_strcmp0 (stored_uri, uri) != 0) {
+		g_free (stored_uri);
+		g_key_file_free (key_file);
+		return NULL;
+	}
+
+	g_free (stored_uri);
+
+	return key_file;
+}
+
+static gboolean
+look_up (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (self)->priv;
+	GKeyFile *key_file;
+	GMappedFile *mapped_file;
+	gchar *meta_path, *body_filename, *body_path;
+
+	key_file = load_meta (priv, uri, &meta_path);
+	g_free (meta_path);
+
+	if (key_file == NULL) {
+		return FALSE;
+	}
+
+	body_filename = g_key_file_get_string (key_file, META_GROUP, "Body", NULL);
+	if (body_filename == NULL) {
+		g_key_file_free (key_file);
+		return FALSE;
+	}
+
+	/* Map the body. Each body file is only ever written once, under a unique name, so we can't race with store() here: if it's replaced the
+	 * body between us loading the key file and mapping the body, the mapping will fail and we'll treat it as a cache miss. */
+	body_path = g_build_filename (priv->directory, body_filename, NULL);
+	mapped_file = g_mapped_file_new (body_path, FALSE, NULL);
+	g_free (body_path);
+	g_free (body_filename);
+
+	if (mapped_file == NULL) {
+		g_key_file_free (key_file);
+		return FALSE;
+	}
+
+	*etag = g_key_file_get_string (key_file, META_GROUP, "ETag", NULL);
+	*content_type = g_key_file_get_string (key_file, META_GROUP, "ContentType", NULL);
+	*body = soup_buffer_new_with_owner (g_mapped_file_get_contents (mapped_file), g_mapped_file_get_length (mapped_file),
+	                                    mapped_file, (GDestroyNotify) g_mapped_file_unref);
+
+	g_key_file_free (key_file);
+
+	if (*etag == NULL) {
+		g_free (*content_type);
+		soup_buffer_free (*body);
+
+		*content_type = NULL;
+		*body = NULL;
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Remove the files stored for @uri. Must be called with priv->mutex held. */
+static void
+remove_files (GDataFileCachePrivate *priv, const gchar *uri)
+{
+	GKeyFile *key_file;
+	gchar *meta_path, *body_filename;
+
+	key_file = load_meta (priv, uri, &meta_path);
+
+	if (key_file != NULL) {
+		body_filename = g_key_file_get_string (key_file, META_GROUP, "Body", NULL);
+
+		/* Remove the key file first, so that concurrent look ups can't find a key file pointing to a missing body */
+		g_unlink (meta_path);
+
+		if (body_filename != NULL) {
+			gchar *body_path = g_build_filename (priv->directory, body_filename, NULL);
+			g_unlink (body_path);
+			g_free (body_path);
+		}
+
+		g_free (body_filename);
+		g_key_file_free (key_file);
+	}
+
+	g_free (meta_path);
+}
+
+static void
+store (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (self)->priv;
+	GKeyFile *key_file;
+	gchar *meta_path, *meta_data, *body_filename, *body_path, *uri_checksum, *etag_checksum;
+	gsize meta_length;
+	GError *error = NULL;
+
+	g_mutex_lock (&(priv->mutex));
+
+	if (g_mkdir_with_parents (priv->directory, 0700) != 0) {
+		g_debug ("Error creating cache directory ‘%s’.", priv->directory);
+		g_mutex_unlock (&(priv->mutex));
+		return;
+	}
+
+	/* Remove the old response (if any) before writing the new one */
+	remove_files (priv, uri);
+
+	/* Write the body under a name unique to this URI and ETag */
+	meta_path = build_meta_path (priv, uri);
+	uri_checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+	etag_checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, etag, -1);
+	body_filename = g_strconcat (uri_checksum, "-", etag_checksum, BODY_SUFFIX, NULL);
+	g_free (etag_checksum);
+	g_free (uri_checksum);
+
+	body_path = g_build_filename (priv->directory, body_filename, NULL);
+
+	if (g_file_set_contents (body_path, body->data, body->length, &error) == FALSE) {
+		g_debug ("Error writing cached response body ‘%s’: %s", body_path, error->message);
+		g_error_free (error);
+		goto done;
+	}
+
+	/* Write the key file */
+	key_file = g_key_file_new ();
+	g_key_file_set_string (key_file, META_GROUP, "URI", uri);
+	g_key_file_set_string (key_file, META_GROUP, "ETag", etag);
+	g_key_file_set_string (key_file, META_GROUP, "Body", body_filename);
+	if (content_type != NULL) {
+		g_key_file_set_string (key_file, META_GROUP, "ContentType", content_type);
+	}
+
+	meta_data = g_key_file_to_data (key_file, &meta_length, NULL);
+	g_key_file_free (key_file);
+
+	if (g_file_set_contents (meta_path, meta_data, meta_length, &error) == FALSE) {
+		g_debug ("Error writing cached response metadata ‘%s’: %s", meta_path, error->message);
+		g_error_free (error);
+		g_unlink (body_path);
+	}
+
+	g_free (meta_data);
+
+done:
+	g_free (body_path);
+	g_free (body_filename);
+	g_free (meta_path);
+
+	g_mutex_unlock (&(priv->mutex));
+}
+
+static void
+remove_ (GDataCache *self, const gchar *uri)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (self)->priv;
+
+	g_mutex_lock (&(priv->mutex));
+	remove_files (priv, uri);
+	g_mutex_unlock (&(priv->mutex));
+}
+
+static void
+clear (GDataCache *self)
+{
+	GDataFileCachePrivate *priv = GDATA_FILE_CACHE (self)->priv;
+	GDir *dir;
+	const gchar *filename;
+
+	g_mutex_lock (&(priv->mutex));
+
+	dir = g_dir_open (priv->directory, 0, NULL);
+
+	if (dir != NULL) {
+		while ((filename = g_dir_read_name (dir)) != NULL) {
+			if (g_str_has_suffix (filename, META_SUFFIX) == TRUE || g_str_has_suffix (filename, BODY_SUFFIX) == TRUE) {
+				gchar *path = g_build_filename (priv->directory, filename, NULL);
+				g_unlink (path);
+				g_free (path);
+			}
+		}
+
+		g_dir_close (dir);
+	}
+
+	g_mutex_unlock (&(priv->mutex));
+}
+
+/**
+ * gdata_file_cache_new:
+ * @directory: the path of the directory to store cached responses in
+ *
+ * Creates a new #GDataFileCache which stores responses in @directory. Any responses already stored in @directory (by a previous #GDataFileCache)
+ * are available immediately.
+ *
+ * Return value: (transfer full): a new #GDataFileCache; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataFileCache *
+gdata_file_cache_new (const gchar *directory)
+{
+	g_return_val_if_fail (directory != NULL && *directory != '\0', NULL);
+
+	return g_object_new (GDATA_TYPE_FILE_CACHE, "directory", directory, NULL);
+}
+
+/**
+ * gdata_file_cache_get_directory:
+ * @self: a #GDataFileCache
+ *
+ * Gets the #GDataFileCache:directory property.
+ *
+ * Return value: the path of the directory responses are stored in
+ *
+ * Since: 0.15.0
+ */
+const gchar *
+gdata_file_cache_get_directory (GDataFileCache *self)
+{
+	g_return_val_if_fail (GDATA_IS_FILE_CACHE (self), NULL);
+	return self->priv->directory;
+}
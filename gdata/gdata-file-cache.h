@@ -0,0 +1,72 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_FILE_CACHE_H
+#define GDATA_FILE_CACHE_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <gdata/gdata-cache.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_FILE_CACHE			(gdata_file_cache_get_type ())
+#define GDATA_FILE_CACHE(o)			(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_FILE_CACHE, GDataFileCache))
+#define GDATA_FILE_CACHE_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_FILE_CACHE, GDataFileCacheClass))
+#define GDATA_IS_FILE_CACHE(o)			(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_FILE_CACHE))
+#define GDATA_IS_FILE_CACHE_CLASS(k)		(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_FILE_CACHE))
+#define GDATA_FILE_CACHE_GET_CLASS(o)		(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_FILE_CACHE, GDataFileCacheClass))
+
+typedef struct _GDataFileCachePrivate	GDataFileCachePrivate;
+
+/**
+ * GDataFileCache:
+ *
+ * All the fields in the #GDataFileCache structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GDataCache parent;
+	GDataFileCachePrivate *priv;
+} GDataFileCache;
+
+/**
+ * GDataFileCacheClass:
+ *
+ * All the fields in the #GDataFileCacheClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GDataCacheClass parent;
+} GDataFileCacheClass;
+
+GType gdata_file_cache_get_type (void) G_GNUC_CONST;
+
+GDataFileCache *gdata_file_cache_new (const gchar *directory) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+const gchar *gdata_file_cache_get_directory (GDataFileCache *self) G_GNUC_PURE;
+
+G_END_DECLS
+
+#endif /* !GDATA_FILE_CACHE_H */
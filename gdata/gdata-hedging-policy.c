@@ -0,0 +1,1056 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-hedging-policy
+ * @short_description: GData request hedging policy
+ * @stability: Unstable
+ * @include: gdata/gdata-hedging-policy.h
+ *
+ * #GDataHedgingPolicy describes how a #GDataService should hedge its idempotent <literal>GET</literal> requests to reduce their tail latency. If a
+ * request hasn't received the headers of its response after a delay, a duplicate of it is sent (which libsoup sends on another connection, since
+ * the first is still busy). Whichever of the two receives its response headers first is used, and the other is cancelled. A slow response from
+ * one overloaded server therefore only delays the request by the hedging delay plus the time taken by a second server.
+ *
+ * Only the requests made by the gdata_service_query() family of functions (including gdata_service_query_single_entry()) and by
+ * #GDataDownloadStream are hedged; requests which modify data on the server are never sent twice.
+ *
+ * A duplicate is sent straight to the network, as part of the request it duplicates: it doesn't wait for the service's #GDataService:rate-limiter
+ * or #GDataService:request-scheduler, isn't refused by an open #GDataService:circuit-breaker, and isn't itself retried by the
+ * #GDataService:retry-policy. Its response is only reported to them as the response to the original request, if it wins. The
+ * #GDataHedgingPolicy:budget is what bounds the extra load caused by duplicates.
+ *
+ * The hedging delay is the #GDataHedgingPolicy:percentile<!-- -->th percentile of the time taken to receive response headers for recent requests,
+ * but at least #GDataHedgingPolicy:min-delay milliseconds. No requests are hedged until enough requests have been made to estimate the
+ * percentile. So that hedging can't noticeably increase the load on the server (or a struggling server's load can't be multiplied by clients all
+ * hedging their requests), at most a #GDataHedgingPolicy:budget proportion of requests are hedged, averaged over time.
+ *
+ * Requests are not hedged by default: a #GDataHedgingPolicy has to be set as the #GDataService:hedging-policy of each service whose requests should
+ * be hedged. A single policy can be shared between several services, in which case its latency estimate and budget are shared between all of
+ * them.
+ *
+ * <example>
+ * 	<title>Hedging Requests</title>
+ * 	<programlisting>
+ *	GDataHedgingPolicy *policy;
+ *
+ *	/<!-- -->* Hedge requests which are slower than 90% of recent requests, but never more than 2% of requests *<!-- -->/
+ *	policy = gdata_hedging_policy_new ();
+ *	gdata_hedging_policy_set_percentile (policy, 90);
+ *	gdata_hedging_policy_set_budget (policy, 0.02);
+ *
+ *	gdata_service_set_hedging_policy (service, policy);
+ *	g_object_unref (policy);
+ * 	</programlisting>
+ * </example>
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsoup/soup.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gdata-hedging-policy.h"
+#include "gdata-private.h"
+
+#define DEFAULT_PERCENTILE 95
+#define DEFAULT_MIN_DELAY 50 /* ms */
+#define DEFAULT_BUDGET 0.05
+
+#define N_SAMPLES 100 /* number of recent latencies to estimate the percentile from */
+#define MIN_SAMPLES 20 /* number of latencies needed before hedging any requests */
+#define MAX_TOKENS 10.0 /* maximum number of hedges which can be saved up by an idle policy */
+#define MAX_SEND_THREADS 8 /* maximum number of threads sending the duplicates of synchronous requests */
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataHedgingPolicyPrivate {
+	guint percentile;
+	guint min_delay;
+	gdouble budget;
+
+	GMutex mutex; /* protects the following, since the policy may be shared between services used from several threads */
+	gint64 samples[N_SAMPLES]; /* ring buffer of recent times taken to receive response headers, in milliseconds */
+	guint n_samples;
+	guint next_sample;
+	gdouble tokens; /* number of requests which may be hedged without exceeding the budget */
+	guint n_hedged_requests;
+};
+
+enum {
+	PROP_PERCENTILE = 1,
+	PROP_MIN_DELAY,
+	PROP_BUDGET,
+};
+
+G_DEFINE_TYPE (GDataHedgingPolicy, gdata_hedging_policy, G_TYPE_OBJECT)
+
+static void
+gdata_hedging_policy_class_init (GDataHedgingPolicyClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataHedgingPolicyPrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	/**
+	 * GDataHedgingPolicy:percentile:
+	 *
+	 * The percentile of recent response header latencies after which a request is hedged. For example, if this is
+	 * <code class="literal">95</code>, a request is hedged if it's taking longer to receive its response headers than 95% of recent requests.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_PERCENTILE,
+	                                 g_param_spec_uint ("percentile",
+	                                                    "Percentile", "The percentile of recent latencies after which a request is hedged.",
+	                                                    1, 99, DEFAULT_PERCENTILE,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataHedgingPolicy:min-delay:
+	 *
+	 * The minimum delay, in milliseconds, before a request is hedged, however fast recent requests have been.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MIN_DELAY,
+	                                 g_param_spec_uint ("min-delay",
+	                                                    "Minimum delay", "The minimum delay, in milliseconds, before a request is hedged.",
+	                                                    0, G_MAXUINT, DEFAULT_MIN_DELAY,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataHedgingPolicy:budget:
+	 *
+	 * The maximum proportion of requests which are hedged, averaged over time. This bounds the extra load put on the server by hedging: for
+	 * example, if this is <code class="literal">0.05</code>, at most 5% more requests are sent than would be without hedging. If it's
+	 * <code class="literal">0</code>, no requests are hedged.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_BUDGET,
+	                                 g_param_spec_double ("budget",
+	                                                      "Budget", "The maximum proportion of requests which are hedged.",
+	                                                      0.0, 1.0, DEFAULT_BUDGET,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdata_hedging_policy_init (GDataHedgingPolicy *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_HEDGING_POLICY, GDataHedgingPolicyPrivate);
+
+	self->priv->percentile = DEFAULT_PERCENTILE;
+	self->priv->min_delay = DEFAULT_MIN_DELAY;
+	self->priv->budget = DEFAULT_BUDGET;
+
+	g_mutex_init (&(self->priv->mutex));
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataHedgingPolicyPrivate *priv = GDATA_HEDGING_POLICY (object)->priv;
+
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_hedging_policy_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataHedgingPolicyPrivate *priv = GDATA_HEDGING_POLICY (object)->priv;
+
+	switch (property_id) {
+		case PROP_PERCENTILE:
+			g_value_set_uint (value, priv->percentile);
+			break;
+		case PROP_MIN_DELAY:
+			g_value_set_uint (value, priv->min_delay);
+			break;
+		case PROP_BUDGET:
+			g_value_set_double (value, priv->budget);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataHedgingPolicy *self = GDATA_HEDGING_POLICY (object);
+
+	switch (property_id) {
+		case PROP_PERCENTILE:
+			gdata_hedging_policy_set_percentile (self, g_value_get_uint (value));
+			break;
+		case PROP_MIN_DELAY:
+			gdata_hedging_policy_set_min_delay (self, g_value_get_uint (value));
+			break;
+		case PROP_BUDGET:
+			gdata_hedging_policy_set_budget (self, g_value_get_double (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/**
+ * gdata_hedging_policy_new:
+ *
+ * Creates a new #GDataHedgingPolicy with the default settings.
+ *
+ * Return value: (transfer full): a new #GDataHedgingPolicy; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataHedgingPolicy *
+gdata_hedging_policy_new (void)
+{
+	return g_object_new (GDATA_TYPE_HEDGING_POLICY, NULL);
+}
+
+/**
+ * gdata_hedging_policy_get_percentile:
+ * @self: a #GDataHedgingPolicy
+ *
+ * Gets the #GDataHedgingPolicy:percentile property.
+ *
+ * Return value: the percentile of recent latencies after which a request is hedged
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_hedging_policy_get_percentile (GDataHedgingPolicy *self)
+{
+	g_return_val_if_fail (GDATA_IS_HEDGING_POLICY (self), DEFAULT_PERCENTILE);
+	return self->priv->percentile;
+}
+
+/**
+ * gdata_hedging_policy_set_percentile:
+ * @self: a #GDataHedgingPolicy
+ * @percentile: the percentile of recent latencies after which a request is hedged; between <code class="literal">1</code> and
+ * <code class="literal">99</code>
+ *
+ * Sets the #GDataHedgingPolicy:percentile property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_hedging_policy_set_percentile (GDataHedgingPolicy *self, guint percentile)
+{
+	g_return_if_fail (GDATA_IS_HEDGING_POLICY (self));
+	g_return_if_fail (percentile >= 1 && percentile <= 99);
+
+	self->priv->percentile = percentile;
+	g_object_notify (G_OBJECT (self), "percentile");
+}
+
+/**
+ * gdata_hedging_policy_get_min_delay:
+ * @self: a #GDataHedgingPolicy
+ *
+ * Gets the #GDataHedgingPolicy:min-delay property.
+ *
+ * Return value: the minimum delay before a request is hedged, in milliseconds
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_hedging_policy_get_min_delay (GDataHedgingPolicy *self)
+{
+	g_return_val_if_fail (GDATA_IS_HEDGING_POLICY (self), 0);
+	return self->priv->min_delay;
+}
+
+/**
+ * gdata_hedging_policy_set_min_delay:
+ * @self: a #GDataHedgingPolicy
+ * @min_delay: the minimum delay before a request is hedged, in milliseconds
+ *
+ * Sets the #GDataHedgingPolicy:min-delay property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_hedging_policy_set_min_delay (GDataHedgingPolicy *self, guint min_delay)
+{
+	g_return_if_fail (GDATA_IS_HEDGING_POLICY (self));
+
+	self->priv->min_delay = min_delay;
+	g_object_notify (G_OBJECT (self), "min-delay");
+}
+
+/**
+ * gdata_hedging_policy_get_budget:
+ * @self: a #GDataHedgingPolicy
+ *
+ * Gets the #GDataHedgingPolicy:budget property.
+ *
+ * Return value: the maximum proportion of requests which are hedged
+ *
+ * Since: 0.15.0
+ */
+gdouble
+gdata_hedging_policy_get_budget (GDataHedgingPolicy *self)
+{
+	g_return_val_if_fail (GDATA_IS_HEDGING_POLICY (self), 0.0);
+	return self->priv->budget;
+}
+
+/**
+ * gdata_hedging_policy_set_budget:
+ * @self: a #GDataHedgingPolicy
+ * @budget: the maximum proportion of requests which are hedged; between <code class="literal">0</code> and <code class="literal">1</code>
+ *
+ * Sets the #GDataHedgingPolicy:budget property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_hedging_policy_set_budget (GDataHedgingPolicy *self, gdouble budget)
+{
+	g_return_if_fail (GDATA_IS_HEDGING_POLICY (self));
+	g_return_if_fail (budget >= 0.0 && budget <= 1.0);
+
+	self->priv->budget = budget;
+	g_object_notify (G_OBJECT (self), "budget");
+}
+
+/**
+ * gdata_hedging_policy_get_n_hedged_requests:
+ * @self: a #GDataHedgingPolicy
+ *
+ * Gets the number of requests which have been hedged (i.e. had a duplicate sent) using this policy.
+ *
+ * Return value: the number of hedged requests
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_hedging_policy_get_n_hedged_requests (GDataHedgingPolicy *self)
+{
+	guint n_hedged_requests;
+
+	g_return_val_if_fail (GDATA_IS_HEDGING_POLICY (self), 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	n_hedged_requests = self->priv->n_hedged_requests;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return n_hedged_requests;
+}
+
+static gint
+compare_samples (const gint64 *a, const gint64 *b)
+{
+	return (*a < *b) ? -1 : (*a > *b) ? 1 : 0;
+}
+
+/* Account for a new request, and return the delay (in milliseconds) after which it should be hedged, or -1 if it shouldn't be. A hedge still has to
+ * be paid for with hedging_policy_spend() once the delay has passed, since other requests may have used up the budget in the meantime. */
+static gint64
+hedging_policy_begin (GDataHedgingPolicy *self)
+{
+	GDataHedgingPolicyPrivate *priv = self->priv;
+	gint64 samples[N_SAMPLES];
+	gint64 delay = -1;
+	guint n_samples;
+
+	g_mutex_lock (&(priv->mutex));
+
+	/* Each request earns a fraction of a hedge; each hedge spends a whole one */
+	priv->tokens = MIN (priv->tokens + priv->budget, MAX_TOKENS);
+
+	n_samples = priv->n_samples;
+	memcpy (samples, priv->samples, n_samples * sizeof (*samples));
+
+	/* Don't bother timing a hedge if there's no budget left to send it with */
+	if (n_samples >= MIN_SAMPLES && priv->budget > 0.0 && priv->tokens >= 1.0) {
+		qsort (samples, n_samples, sizeof (*samples), (GCompareFunc) compare_samples);
+		delay = MAX (samples[(n_samples * priv->percentile + 99) / 100 - 1], (gint64) priv->min_delay);
+	}
+
+	g_mutex_unlock (&(priv->mutex));
+
+	return delay;
+}
+
+/* Spend a hedge from the budget, returning %FALSE if there are none left. */
+static gboolean
+hedging_policy_spend (GDataHedgingPolicy *self)
+{
+	GDataHedgingPolicyPrivate *priv = self->priv;
+	gboolean can_hedge = FALSE;
+
+	g_mutex_lock (&(priv->mutex));
+
+	if (priv->tokens >= 1.0) {
+		priv->tokens -= 1.0;
+		priv->n_hedged_requests++;
+		can_hedge = TRUE;
+	}
+
+	g_mutex_unlock (&(priv->mutex));
+
+	return can_hedge;
+}
+
+/* Record that a request took @latency microseconds to receive its response headers. */
+static void
+hedging_policy_add_sample (GDataHedgingPolicy *self, gint64 latency)
+{
+	GDataHedgingPolicyPrivate *priv = self->priv;
+
+	g_mutex_lock (&(priv->mutex));
+
+	priv->samples[priv->next_sample] = latency / 1000;
+	priv->next_sample = (priv->next_sample + 1) % N_SAMPLES;
+	priv->n_samples = MIN (priv->n_samples + 1, N_SAMPLES);
+
+	g_mutex_unlock (&(priv->mutex));
+}
+
+typedef enum {
+	HEDGE_WINNER_NONE = 0,
+	HEDGE_WINNER_PRIMARY,
+	HEDGE_WINNER_DUPLICATE,
+} HedgeWinner;
+
+/* The state of a single (possibly) hedged request. The caller's message is the primary; the duplicate (if any) is a copy of it which is sent after
+ * the hedging delay. Whichever receives its response headers first wins; if that's the duplicate, its response is copied to the primary as it
+ * arrives, so the caller only ever sees the primary. */
+typedef struct {
+	volatile gint ref_count;
+	GDataHedgingPolicy *policy;
+	SoupSession *session;
+	gint64 delay; /* in milliseconds; -1 if the request isn't to be hedged */
+	gulong request_queued_id;
+	gulong got_headers_id;
+
+	GMutex mutex; /* protects everything below */
+	GCond cond;
+	SoupMessage *primary;
+	SoupMessage *duplicate; /* NULL unless the request has been hedged */
+	HedgeWinner winner;
+	gint64 primary_start; /* monotonic time, in microseconds */
+	gint64 duplicate_start;
+	gboolean primary_queued;
+	gboolean primary_finished;
+	gboolean duplicate_queued;
+	gboolean duplicate_finished;
+	GSource *timeout_source; /* non-NULL while waiting to hedge; owned by its main context for asynchronous hedges, and by us for synchronous ones */
+
+	/* Only used by synchronous hedges */
+	gboolean is_sync;
+
+	/* Only used by asynchronous hedges */
+	SoupSessionCallback callback;
+	gpointer user_data;
+	gboolean completed;
+} Hedge;
+
+/* Protects the "gdata-hedge" data on primary messages, since they may be cancelled from any thread */
+static GMutex hedge_data_mutex;
+
+static void hedge_start_sync_timeout (Hedge *hedge);
+
+static Hedge *
+hedge_ref (Hedge *hedge)
+{
+	g_atomic_int_inc (&(hedge->ref_count));
+	return hedge;
+}
+
+static void
+hedge_unref (Hedge *hedge)
+{
+	if (g_atomic_int_dec_and_test (&(hedge->ref_count)) == FALSE)
+		return;
+
+	if (hedge->duplicate != NULL)
+		g_object_unref (hedge->duplicate);
+	g_object_unref (hedge->primary);
+	g_object_unref (hedge->session);
+	g_object_unref (hedge->policy);
+
+	g_cond_clear (&(hedge->cond));
+	g_mutex_clear (&(hedge->mutex));
+
+	g_slice_free (Hedge, hedge);
+}
+
+static Hedge *
+hedge_lookup (SoupMessage *message)
+{
+	Hedge *hedge;
+
+	g_mutex_lock (&hedge_data_mutex);
+	hedge = g_object_get_data (G_OBJECT (message), "gdata-hedge");
+	if (hedge != NULL)
+		hedge_ref (hedge);
+	g_mutex_unlock (&hedge_data_mutex);
+
+	return hedge;
+}
+
+static void
+hedge_request_queued_cb (SoupSession *session, SoupMessage *message, Hedge *hedge)
+{
+	gboolean cancel = FALSE;
+
+	if (message != hedge->primary && message != hedge->duplicate)
+		return;
+
+	g_mutex_lock (&(hedge->mutex));
+
+	if (message == hedge->primary) {
+		hedge->primary_queued = TRUE;
+
+		/* Start timing a synchronous hedge now the primary can be cancelled if the duplicate wins */
+		if (hedge->is_sync == TRUE && hedge->delay >= 0 && hedge->timeout_source == NULL)
+			hedge_start_sync_timeout (hedge);
+	} else {
+		hedge->duplicate_queued = TRUE;
+
+		/* The primary may have won between us deciding to send the duplicate and it being queued */
+		cancel = (hedge->winner == HEDGE_WINNER_PRIMARY) ? TRUE : FALSE;
+	}
+
+	g_cond_broadcast (&(hedge->cond));
+	g_mutex_unlock (&(hedge->mutex));
+
+	if (cancel == TRUE)
+		soup_session_cancel_message (session, message, SOUP_STATUS_CANCELLED);
+}
+
+/* Decide that the primary has won (if nothing has won yet), returning a new reference to the duplicate if it needs cancelling. Must be called with
+ * the hedge's mutex held. */
+static SoupMessage *
+hedge_primary_wins (Hedge *hedge)
+{
+	if (hedge->winner == HEDGE_WINNER_NONE) {
+		hedge->winner = HEDGE_WINNER_PRIMARY;
+		g_cond_broadcast (&(hedge->cond));
+	}
+
+	if (hedge->winner == HEDGE_WINNER_PRIMARY && hedge->duplicate_queued == TRUE && hedge->duplicate_finished == FALSE)
+		return g_object_ref (hedge->duplicate);
+
+	return NULL;
+}
+
+static void
+hedge_cancel_duplicate (Hedge *hedge, SoupMessage *duplicate)
+{
+	if (duplicate != NULL) {
+		soup_session_cancel_message (hedge->session, duplicate, SOUP_STATUS_CANCELLED);
+		g_object_unref (duplicate);
+	}
+}
+
+static void
+primary_got_headers_cb (SoupMessage *message, Hedge *hedge)
+{
+	SoupMessage *duplicate;
+
+	g_mutex_lock (&(hedge->mutex));
+
+	if (hedge->winner == HEDGE_WINNER_NONE)
+		hedging_policy_add_sample (hedge->policy, g_get_monotonic_time () - hedge->primary_start);
+
+	duplicate = hedge_primary_wins (hedge);
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	hedge_cancel_duplicate (hedge, duplicate);
+}
+
+static void
+append_header_cb (const gchar *name, const gchar *value, SoupMessageHeaders *headers)
+{
+	soup_message_headers_append (headers, name, value);
+}
+
+static void
+duplicate_got_headers_cb (SoupMessage *message, Hedge *hedge)
+{
+	HedgeWinner winner;
+	gboolean won = FALSE;
+
+	g_mutex_lock (&(hedge->mutex));
+
+	if (hedge->winner == HEDGE_WINNER_NONE) {
+		hedging_policy_add_sample (hedge->policy, g_get_monotonic_time () - hedge->duplicate_start);
+		hedge->winner = HEDGE_WINNER_DUPLICATE;
+		g_cond_broadcast (&(hedge->cond));
+		won = TRUE;
+	}
+
+	winner = hedge->winner;
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	if (winner == HEDGE_WINNER_PRIMARY) {
+		/* Lost the race */
+		soup_session_cancel_message (hedge->session, message, SOUP_STATUS_CANCELLED);
+		return;
+	} else if (won == FALSE) {
+		/* Already won on an earlier set of headers */
+		return;
+	}
+
+	g_debug ("Hedged %s request won after %" G_GINT64_FORMAT " ms.", message->method, (g_get_monotonic_time () - hedge->primary_start) / 1000);
+
+	/* Stop the primary, then make it look as if it received the duplicate's response (the primary's final status is fixed up once the duplicate
+	 * has finished, in case cancelling the primary overwrites it). The primary was queued before the duplicate was created, so it can be
+	 * cancelled. */
+	soup_session_cancel_message (hedge->session, hedge->primary, SOUP_STATUS_CANCELLED);
+
+	soup_message_set_status_full (hedge->primary, message->status_code, message->reason_phrase);
+	soup_message_headers_clear (hedge->primary->response_headers);
+	soup_message_headers_foreach (message->response_headers, (SoupMessageHeadersForeachFunc) append_header_cb, hedge->primary->response_headers);
+
+	g_signal_emit_by_name (hedge->primary, "got-headers");
+}
+
+static void
+duplicate_got_chunk_cb (SoupMessage *message, SoupBuffer *buffer, Hedge *hedge)
+{
+	/* The winner is only ever set once, and was set to the duplicate in this thread (in duplicate_got_headers_cb()) if at all */
+	if (hedge->winner != HEDGE_WINNER_DUPLICATE)
+		return;
+
+	if (soup_message_body_get_accumulate (hedge->primary->response_body) == TRUE)
+		soup_message_body_append_buffer (hedge->primary->response_body, buffer);
+
+	g_signal_emit_by_name (hedge->primary, "got-chunk", buffer);
+}
+
+/* Build the duplicate of the primary message. Must be called with the hedge's mutex held. */
+static SoupMessage *
+hedge_build_duplicate (Hedge *hedge)
+{
+	SoupMessage *duplicate;
+
+	g_debug ("Hedging %s request after %" G_GINT64_FORMAT " ms.", hedge->primary->method, hedge->delay);
+
+	duplicate = soup_message_new_from_uri (hedge->primary->method, soup_message_get_uri (hedge->primary));
+	soup_message_headers_foreach (hedge->primary->request_headers, (SoupMessageHeadersForeachFunc) append_header_cb, duplicate->request_headers);
+	soup_message_set_flags (duplicate, soup_message_get_flags (hedge->primary));
+
+	/* The duplicate's response is appended to the primary's body, if anywhere */
+	soup_message_body_set_accumulate (duplicate->response_body, FALSE);
+
+	g_signal_connect (duplicate, "got-headers", (GCallback) duplicate_got_headers_cb, hedge);
+	g_signal_connect (duplicate, "got-chunk", (GCallback) duplicate_got_chunk_cb, hedge);
+
+	hedge->duplicate = g_object_ref (duplicate);
+	hedge->duplicate_start = g_get_monotonic_time ();
+
+	return duplicate;
+}
+
+static Hedge *
+hedge_new (GDataHedgingPolicy *policy, SoupSession *session, SoupMessage *message)
+{
+	Hedge *hedge;
+
+	hedge = g_slice_new0 (Hedge);
+	hedge->ref_count = 1;
+	hedge->policy = g_object_ref (policy);
+	hedge->session = g_object_ref (session);
+	hedge->primary = g_object_ref (message);
+	hedge->delay = hedging_policy_begin (policy);
+	hedge->primary_start = g_get_monotonic_time ();
+	g_mutex_init (&(hedge->mutex));
+	g_cond_init (&(hedge->cond));
+
+	hedge->request_queued_id = g_signal_connect (session, "request-queued", (GCallback) hedge_request_queued_cb, hedge);
+	hedge->got_headers_id = g_signal_connect (message, "got-headers", (GCallback) primary_got_headers_cb, hedge);
+
+	/* Allow the request to be cancelled using _gdata_hedging_policy_cancel_message() */
+	g_mutex_lock (&hedge_data_mutex);
+	g_object_set_data (G_OBJECT (message), "gdata-hedge", hedge);
+	g_mutex_unlock (&hedge_data_mutex);
+
+	return hedge;
+}
+
+/* Disconnect the hedge from the primary once the request has finished, and fix up the primary's status if the duplicate won. */
+static void
+hedge_finish (Hedge *hedge)
+{
+	g_mutex_lock (&hedge_data_mutex);
+	g_object_set_data (G_OBJECT (hedge->primary), "gdata-hedge", NULL);
+	g_mutex_unlock (&hedge_data_mutex);
+
+	g_signal_handler_disconnect (hedge->session, hedge->request_queued_id);
+	g_signal_handler_disconnect (hedge->primary, hedge->got_headers_id);
+
+	if (hedge->winner == HEDGE_WINNER_DUPLICATE)
+		soup_message_set_status_full (hedge->primary, hedge->duplicate->status_code, hedge->duplicate->reason_phrase);
+}
+
+static gpointer
+hedge_thread_cb (GMainContext *context)
+{
+	GMainLoop *loop;
+
+	loop = g_main_loop_new (context, FALSE);
+	g_main_loop_run (loop);
+	g_main_loop_unref (loop);
+
+	return NULL;
+}
+
+static gpointer
+hedge_context_new (gpointer data)
+{
+	GMainContext *context;
+
+	/* The hedging delays of synchronous requests are all timed in one thread of their own, since their own threads are blocked sending them */
+	context = g_main_context_new ();
+	g_thread_unref (g_thread_new ("gdata-hedges", (GThreadFunc) hedge_thread_cb, context));
+
+	return context;
+}
+
+static GMainContext *
+get_hedge_context (void)
+{
+	static GOnce hedge_context_once = G_ONCE_INIT;
+
+	g_once (&hedge_context_once, hedge_context_new, NULL);
+
+	return hedge_context_once.retval;
+}
+
+/* In a thread from the send pool; sends the duplicate of a synchronous request, unless the primary won while it was waiting for a thread */
+static void
+hedge_send_duplicate_cb (Hedge *hedge, gpointer user_data)
+{
+	gboolean send;
+
+	g_mutex_lock (&(hedge->mutex));
+	send = (hedge->winner != HEDGE_WINNER_PRIMARY) ? TRUE : FALSE;
+	g_mutex_unlock (&(hedge->mutex));
+
+	if (send == TRUE)
+		soup_session_send_message (hedge->session, hedge->duplicate);
+
+	g_mutex_lock (&(hedge->mutex));
+	hedge->duplicate_finished = TRUE;
+	g_cond_broadcast (&(hedge->cond));
+	g_mutex_unlock (&(hedge->mutex));
+
+	hedge_unref (hedge);
+}
+
+static gpointer
+hedge_send_pool_new (gpointer data)
+{
+	return g_thread_pool_new ((GFunc) hedge_send_duplicate_cb, NULL, MAX_SEND_THREADS, FALSE, NULL);
+}
+
+static GThreadPool *
+get_hedge_send_pool (void)
+{
+	static GOnce hedge_send_pool_once = G_ONCE_INIT;
+
+	g_once (&hedge_send_pool_once, hedge_send_pool_new, NULL);
+
+	return hedge_send_pool_once.retval;
+}
+
+/* In the hedge thread, once the hedging delay of a synchronous request has passed */
+static gboolean
+hedge_sync_timeout_cb (Hedge *hedge)
+{
+	gboolean send = FALSE;
+
+	g_mutex_lock (&(hedge->mutex));
+
+	/* The source's reference to @hedge is dropped when it's destroyed */
+	if (hedge->timeout_source != NULL) {
+		g_source_unref (hedge->timeout_source);
+		hedge->timeout_source = NULL;
+	}
+
+	if (hedge->winner == HEDGE_WINNER_NONE && hedge->primary_finished == FALSE && hedging_policy_spend (hedge->policy) == TRUE) {
+		/* The hedge keeps its own reference to the duplicate */
+		g_object_unref (hedge_build_duplicate (hedge));
+		send = TRUE;
+	}
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	/* Only requests which are actually hedged need a thread, and the budget keeps those few */
+	if (send == TRUE)
+		g_thread_pool_push (get_hedge_send_pool (), hedge_ref (hedge), NULL);
+
+	return FALSE;
+}
+
+/* Start timing the hedging delay of a synchronous request. Must be called with the hedge's mutex held. */
+static void
+hedge_start_sync_timeout (Hedge *hedge)
+{
+	gint64 remaining;
+
+	remaining = hedge->primary_start + hedge->delay * 1000 - g_get_monotonic_time ();
+
+	hedge->timeout_source = g_timeout_source_new ((remaining > 0) ? (guint) MIN ((remaining + 999) / 1000, G_MAXUINT) : 0);
+	g_source_set_callback (hedge->timeout_source, (GSourceFunc) hedge_sync_timeout_cb, hedge_ref (hedge), (GDestroyNotify) hedge_unref);
+	g_source_attach (hedge->timeout_source, get_hedge_context ());
+}
+
+/*
+ * _gdata_hedging_policy_send_message:
+ * @self: a #GDataHedgingPolicy
+ * @session: the #SoupSession to send @message on
+ * @message: the idempotent #SoupMessage to send
+ *
+ * Synchronously sends @message on @session, as soup_session_send_message() does, but hedges it according to the policy. The hedging delay is timed
+ * in a thread shared by all policies, and if @message is hedged, the duplicate is sent from a small pool of threads; no thread is used for requests
+ * which aren't hedged. In any case, once this returns, @message has the response of whichever request won.
+ *
+ * To cancel @message while it's being sent, _gdata_hedging_policy_cancel_message() must be used rather than soup_session_cancel_message().
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_hedging_policy_send_message (GDataHedgingPolicy *self, SoupSession *session, SoupMessage *message)
+{
+	Hedge *hedge;
+	GSource *timeout_source = NULL;
+	SoupMessage *duplicate;
+
+	hedge = hedge_new (self, session, message);
+	hedge->is_sync = TRUE;
+
+	/* The hedging delay starts being timed once the message has been queued; see hedge_request_queued_cb() */
+	soup_session_send_message (session, message);
+
+	/* If the primary finished without receiving any headers (e.g. because of a network error), it wins by default */
+	g_mutex_lock (&(hedge->mutex));
+
+	hedge->primary_finished = TRUE;
+	duplicate = hedge_primary_wins (hedge);
+
+	timeout_source = hedge->timeout_source;
+	hedge->timeout_source = NULL;
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	if (timeout_source != NULL) {
+		g_source_destroy (timeout_source);
+		g_source_unref (timeout_source);
+	}
+
+	hedge_cancel_duplicate (hedge, duplicate);
+
+	/* Wait for the duplicate (if any) to finish; either it lost and has been cancelled, or it won and the primary's response is still coming in */
+	g_mutex_lock (&(hedge->mutex));
+	while (hedge->duplicate != NULL && hedge->duplicate_finished == FALSE)
+		g_cond_wait (&(hedge->cond), &(hedge->mutex));
+	g_mutex_unlock (&(hedge->mutex));
+
+	hedge_finish (hedge);
+	hedge_unref (hedge);
+}
+
+static void
+hedge_maybe_complete (Hedge *hedge)
+{
+	g_mutex_lock (&(hedge->mutex));
+
+	if (hedge->completed == TRUE || hedge->primary_finished == FALSE ||
+	    (hedge->winner == HEDGE_WINNER_DUPLICATE && hedge->duplicate_finished == FALSE)) {
+		g_mutex_unlock (&(hedge->mutex));
+		return;
+	}
+
+	hedge->completed = TRUE;
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	hedge_finish (hedge);
+	hedge->callback (hedge->session, hedge->primary, hedge->user_data);
+}
+
+static void
+hedge_primary_finished_cb (SoupSession *session, SoupMessage *message, Hedge *hedge)
+{
+	SoupMessage *duplicate;
+
+	g_mutex_lock (&(hedge->mutex));
+
+	hedge->primary_finished = TRUE;
+
+	if (hedge->timeout_source != NULL) {
+		g_source_destroy (hedge->timeout_source);
+		hedge->timeout_source = NULL;
+	}
+
+	duplicate = hedge_primary_wins (hedge);
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	hedge_cancel_duplicate (hedge, duplicate);
+	hedge_maybe_complete (hedge);
+	hedge_unref (hedge);
+}
+
+static void
+hedge_duplicate_finished_cb (SoupSession *session, SoupMessage *message, Hedge *hedge)
+{
+	g_mutex_lock (&(hedge->mutex));
+	hedge->duplicate_finished = TRUE;
+	g_mutex_unlock (&(hedge->mutex));
+
+	hedge_maybe_complete (hedge);
+	hedge_unref (hedge);
+}
+
+static gboolean
+hedge_timeout_cb (Hedge *hedge)
+{
+	SoupMessage *duplicate = NULL;
+
+	g_mutex_lock (&(hedge->mutex));
+
+	/* The source's reference to @hedge is dropped when it's destroyed */
+	hedge->timeout_source = NULL;
+
+	if (hedge->winner == HEDGE_WINNER_NONE && hedge->primary_finished == FALSE && hedging_policy_spend (hedge->policy) == TRUE)
+		duplicate = hedge_build_duplicate (hedge);
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	/* soup_session_queue_message() steals our reference to the duplicate */
+	if (duplicate != NULL)
+		soup_session_queue_message (hedge->session, duplicate, (SoupSessionCallback) hedge_duplicate_finished_cb, hedge_ref (hedge));
+
+	return FALSE;
+}
+
+/*
+ * _gdata_hedging_policy_queue_message:
+ * @self: a #GDataHedgingPolicy
+ * @session: the #SoupSession to queue @message on
+ * @message: (transfer full): the idempotent #SoupMessage to queue
+ * @callback: a #SoupSessionCallback to call once @message has finished
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronously sends @message on @session, as soup_session_queue_message() does (including stealing the reference to @message), but hedges it
+ * according to the policy. The hedging delay is timed in the thread-default main context. @callback is called once, for @message, once it has the
+ * response of whichever request won.
+ *
+ * To cancel @message while it's being sent, _gdata_hedging_policy_cancel_message() must be used rather than soup_session_cancel_message().
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_hedging_policy_queue_message (GDataHedgingPolicy *self, SoupSession *session, SoupMessage *message, SoupSessionCallback callback,
+                                     gpointer user_data)
+{
+	Hedge *hedge;
+
+	hedge = hedge_new (self, session, message);
+	hedge->callback = callback;
+	hedge->user_data = user_data;
+
+	if (hedge->delay >= 0) {
+		hedge->timeout_source = g_timeout_source_new ((guint) MIN (hedge->delay, G_MAXUINT));
+		g_source_set_callback (hedge->timeout_source, (GSourceFunc) hedge_timeout_cb, hedge_ref (hedge), (GDestroyNotify) hedge_unref);
+		g_source_attach (hedge->timeout_source, g_main_context_get_thread_default ());
+		g_source_unref (hedge->timeout_source);
+	}
+
+	/* This steals the caller's reference to @message; the hedge's own reference belongs to the callback */
+	soup_session_queue_message (session, message, (SoupSessionCallback) hedge_primary_finished_cb, hedge);
+}
+
+/*
+ * _gdata_hedging_policy_cancel_message:
+ * @session: the #SoupSession @message was sent on
+ * @message: the #SoupMessage to cancel
+ *
+ * Cancels @message with %SOUP_STATUS_CANCELLED, as soup_session_cancel_message() does. If @message is being sent with
+ * _gdata_hedging_policy_send_message() or _gdata_hedging_policy_queue_message(), its duplicate (if any) is cancelled too.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_hedging_policy_cancel_message (SoupSession *session, SoupMessage *message)
+{
+	Hedge *hedge;
+	SoupMessage *duplicate = NULL;
+	gboolean cancel_primary;
+
+	hedge = hedge_lookup (message);
+
+	if (hedge == NULL) {
+		soup_session_cancel_message (session, message, SOUP_STATUS_CANCELLED);
+		return;
+	}
+
+	g_mutex_lock (&(hedge->mutex));
+
+	/* If the duplicate's already won, the primary has already been cancelled and the duplicate's status will be copied to it; otherwise, make sure
+	 * the duplicate doesn't win (or get sent) from now on. */
+	if (hedge->winner == HEDGE_WINNER_DUPLICATE) {
+		if (hedge->duplicate_finished == FALSE)
+			duplicate = g_object_ref (hedge->duplicate);
+		cancel_primary = FALSE;
+	} else {
+		duplicate = hedge_primary_wins (hedge);
+		cancel_primary = (hedge->primary_finished == FALSE) ? TRUE : FALSE;
+	}
+
+	g_mutex_unlock (&(hedge->mutex));
+
+	if (cancel_primary == TRUE)
+		soup_session_cancel_message (session, message, SOUP_STATUS_CANCELLED);
+
+	if (duplicate != NULL) {
+		soup_session_cancel_message (session, duplicate, SOUP_STATUS_CANCELLED);
+		g_object_unref (duplicate);
+	}
+
+	hedge_unref (hedge);
+}
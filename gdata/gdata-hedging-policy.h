@@ -0,0 +1,79 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_HEDGING_POLICY_H
+#define GDATA_HEDGING_POLICY_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_HEDGING_POLICY		(gdata_hedging_policy_get_type ())
+#define GDATA_HEDGING_POLICY(o)			(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_HEDGING_POLICY, GDataHedgingPolicy))
+#define GDATA_HEDGING_POLICY_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_HEDGING_POLICY, GDataHedgingPolicyClass))
+#define GDATA_IS_HEDGING_POLICY(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_HEDGING_POLICY))
+#define GDATA_IS_HEDGING_POLICY_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_HEDGING_POLICY))
+#define GDATA_HEDGING_POLICY_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_HEDGING_POLICY, GDataHedgingPolicyClass))
+
+typedef struct _GDataHedgingPolicyPrivate	GDataHedgingPolicyPrivate;
+
+/**
+ * GDataHedgingPolicy:
+ *
+ * All the fields in the #GDataHedgingPolicy structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataHedgingPolicyPrivate *priv;
+} GDataHedgingPolicy;
+
+/**
+ * GDataHedgingPolicyClass:
+ *
+ * All the fields in the #GDataHedgingPolicyClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataHedgingPolicyClass;
+
+GType gdata_hedging_policy_get_type (void) G_GNUC_CONST;
+
+GDataHedgingPolicy *gdata_hedging_policy_new (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+guint gdata_hedging_policy_get_percentile (GDataHedgingPolicy *self) G_GNUC_PURE;
+void gdata_hedging_policy_set_percentile (GDataHedgingPolicy *self, guint percentile);
+
+guint gdata_hedging_policy_get_min_delay (GDataHedgingPolicy *self) G_GNUC_PURE;
+void gdata_hedging_policy_set_min_delay (GDataHedgingPolicy *self, guint min_delay);
+
+gdouble gdata_hedging_policy_get_budget (GDataHedgingPolicy *self) G_GNUC_PURE;
+void gdata_hedging_policy_set_budget (GDataHedgingPolicy *self, gdouble budget);
+
+guint gdata_hedging_policy_get_n_hedged_requests (GDataHedgingPolicy *self);
+
+G_END_DECLS
+
+#endif /* !GDATA_HEDGING_POLICY_H */
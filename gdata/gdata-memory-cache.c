@@ -0,0 +1,370 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-memory-cache
+ * @short_description: GData in-memory response cache
+ * @stability: Unstable
+ * @include: gdata/gdata-memory-cache.h
+ *
+ * #GDataMemoryCache is an implementation of #GDataCache which stores responses in memory. Its contents are lost when it's finalized.
+ *
+ * The total size of the response bodies held by the cache can be bounded by setting #GDataMemoryCache:max-size. Once the bound is reached, the
+ * least recently used responses are evicted to make room for new ones.
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+
+#include "gdata-memory-cache.h"
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+static gboolean look_up (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body);
+static void store (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body);
+static void remove_ (GDataCache *self, const gchar *uri);
+static void clear (GDataCache *self);
+
+typedef struct {
+	gchar *uri; /* owned by the hash table as its key */
+	gchar *etag;
+	gchar *content_type;
+	SoupBuffer *body;
+	GList *lru_link; /* link in GDataMemoryCachePrivate->lru; its data is the CacheEntry */
+} CacheEntry;
+
+struct _GDataMemoryCachePrivate {
+	GMutex mutex; /* protects all the fields below */
+	GHashTable *entries; /* URI → owned CacheEntry */
+	GQueue lru; /* CacheEntry, with the most recently used at the head */
+	guint64 size; /* total length of all the cached bodies */
+	guint64 max_size; /* or 0 for unbounded */
+};
+
+enum {
+	PROP_MAX_SIZE = 1,
+};
+
+G_DEFINE_TYPE (GDataMemoryCache, gdata_memory_cache, GDATA_TYPE_CACHE)
+
+static void
+gdata_memory_cache_class_init (GDataMemoryCacheClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GDataCacheClass *cache_class = GDATA_CACHE_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataMemoryCachePrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	cache_class->look_up = look_up;
+	cache_class->store = store;
+	cache_class->remove = remove_;
+	cache_class->clear = clear;
+
+	/**
+	 * GDataMemoryCache:max-size:
+	 *
+	 * The maximum total size, in bytes, of the response bodies held by the cache. If storing a new response would exceed this, the least
+	 * recently used responses are evicted until it fits. Responses which are bigger than this on their own are never stored.
+	 *
+	 * If this is <code class="literal">0</code>, the size of the cache is unbounded.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MAX_SIZE,
+	                                 g_param_spec_uint64 ("max-size",
+	                                                      "Maximum size", "The maximum total size, in bytes, of the response bodies held.",
+	                                                      0, G_MAXUINT64, 0,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+	g_free (entry->uri);
+	g_free (entry->etag);
+	g_free (entry->content_type);
+	soup_buffer_free (entry->body);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+gdata_memory_cache_init (GDataMemoryCache *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_MEMORY_CACHE, GDataMemoryCachePrivate);
+
+	g_mutex_init (&(self->priv->mutex));
+	self->priv->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) cache_entry_free);
+	g_queue_init (&(self->priv->lru));
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataMemoryCachePrivate *priv = GDATA_MEMORY_CACHE (object)->priv;
+
+	g_queue_clear (&(priv->lru));
+	g_hash_table_destroy (priv->entries);
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_memory_cache_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataMemoryCache *self = GDATA_MEMORY_CACHE (object);
+
+	switch (property_id) {
+		case PROP_MAX_SIZE:
+			g_value_set_uint64 (value, gdata_memory_cache_get_max_size (self));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataMemoryCache *self = GDATA_MEMORY_CACHE (object);
+
+	switch (property_id) {
+		case PROP_MAX_SIZE:
+			gdata_memory_cache_set_max_size (self, g_value_get_uint64 (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/* Must be called with priv->mutex held. */
+static void
+remove_entry (GDataMemoryCachePrivate *priv, CacheEntry *entry)
+{
+	g_queue_delete_link (&(priv->lru), entry->lru_link);
+	priv->size -= entry->body->length;
+	g_hash_table_remove (priv->entries, entry->uri); /* frees the entry */
+}
+
+/* Evict least recently used entries until the cache has room for @extra_size more bytes. Must be called with priv->mutex held. */
+static void
+evict_entries (GDataMemoryCachePrivate *priv, guint64 extra_size)
+{
+	if (priv->max_size == 0) {
+		return;
+	}
+
+	while (priv->size + extra_size > priv->max_size && g_queue_is_empty (&(priv->lru)) == FALSE) {
+		remove_entry (priv, g_queue_peek_tail (&(priv->lru)));
+	}
+}
+
+static gboolean
+look_up (GDataCache *self, const gchar *uri, gchar **etag, gchar **content_type, SoupBuffer **body)
+{
+	GDataMemoryCachePrivate *priv = GDATA_MEMORY_CACHE (self)->priv;
+	CacheEntry *entry;
+
+	g_mutex_lock (&(priv->mutex));
+
+	entry = g_hash_table_lookup (priv->entries, uri);
+
+	if (entry == NULL) {
+		g_mutex_unlock (&(priv->mutex));
+		return FALSE;
+	}
+
+	/* Mark the entry as most recently used */
+	g_queue_unlink (&(priv->lru), entry->lru_link);
+	g_queue_push_head_link (&(priv->lru), entry->lru_link);
+
+	*etag = g_strdup (entry->etag);
+	*content_type = g_strdup (entry->content_type);
+	*body = soup_buffer_copy (entry->body); /* just a ref, since the body isn't SOUP_MEMORY_TEMPORARY */
+
+	g_mutex_unlock (&(priv->mutex));
+
+	return TRUE;
+}
+
+static void
+store (GDataCache *self, const gchar *uri, const gchar *etag, const gchar *content_type, SoupBuffer *body)
+{
+	GDataMemoryCachePrivate *priv = GDATA_MEMORY_CACHE (self)->priv;
+	CacheEntry *entry;
+
+	g_mutex_lock (&(priv->mutex));
+
+	/* Remove any existing entry first, so it doesn't count towards the size when evicting */
+	entry = g_hash_table_lookup (priv->entries, uri);
+	if (entry != NULL) {
+		remove_entry (priv, entry);
+	}
+
+	/* Don't bother storing responses which could never fit */
+	if (priv->max_size != 0 && body->length > priv->max_size) {
+		g_mutex_unlock (&(priv->mutex));
+		return;
+	}
+
+	evict_entries (priv, body->length);
+
+	entry = g_slice_new (CacheEntry);
+	entry->uri = g_strdup (uri);
+	entry->etag = g_strdup (etag);
+	entry->content_type = g_strdup (content_type);
+	entry->body = soup_buffer_copy (body);
+
+	g_queue_push_head (&(priv->lru), entry);
+	entry->lru_link = g_queue_peek_head_link (&(priv->lru));
+
+	g_hash_table_insert (priv->entries, entry->uri, entry);
+	priv->size += body->length;
+
+	g_mutex_unlock (&(priv->mutex));
+}
+
+static void
+remove_ (GDataCache *self, const gchar *uri)
+{
+	GDataMemoryCachePrivate *priv = GDATA_MEMORY_CACHE (self)->priv;
+	CacheEntry *entry;
+
+	g_mutex_lock (&(priv->mutex));
+
+	entry = g_hash_table_lookup (priv->entries, uri);
+	if (entry != NULL) {
+		remove_entry (priv, entry);
+	}
+
+	g_mutex_unlock (&(priv->mutex));
+}
+
+static void
+clear (GDataCache *self)
+{
+	GDataMemoryCachePrivate *priv = GDATA_MEMORY_CACHE (self)->priv;
+
+	g_mutex_lock (&(priv->mutex));
+
+	g_queue_clear (&(priv->lru));
+	g_hash_table_remove_all (priv->entries);
+	priv->size = 0;
+
+	g_mutex_unlock (&(priv->mutex));
+}
+
+/**
+ * gdata_memory_cache_new:
+ * @max_size: the maximum total size of the cached response bodies, in bytes, or <code class="literal">0</code> for no limit
+ *
+ * Creates a new, empty #GDataMemoryCache. See #GDataMemoryCache:max-size for details of @max_size.
+ *
+ * Return value: (transfer full): a new #GDataMemoryCache; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataMemoryCache *
+gdata_memory_cache_new (guint64 max_size)
+{
+	return g_object_new (GDATA_TYPE_MEMORY_CACHE, "max-size", max_size, NULL);
+}
+
+/**
+ * gdata_memory_cache_get_max_size:
+ * @self: a #GDataMemoryCache
+ *
+ * Gets the #GDataMemoryCache:max-size property.
+ *
+ * Return value: the maximum size of the cache, in bytes, or <code class="literal">0</code>
+ *
+ * Since: 0.15.0
+ */
+guint64
+gdata_memory_cache_get_max_size (GDataMemoryCache *self)
+{
+	guint64 max_size;
+
+	g_return_val_if_fail (GDATA_IS_MEMORY_CACHE (self), 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	max_size = self->priv->max_size;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return max_size;
+}
+
+/**
+ * gdata_memory_cache_set_max_size:
+ * @self: a #GDataMemoryCache
+ * @max_size: the new maximum size of the cache, in bytes, or <code class="literal">0</code>
+ *
+ * Sets the #GDataMemoryCache:max-size property. If the cache currently holds more than @max_size bytes, the least recently used responses are evicted
+ * immediately.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_memory_cache_set_max_size (GDataMemoryCache *self, guint64 max_size)
+{
+	g_return_if_fail (GDATA_IS_MEMORY_CACHE (self));
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->max_size = max_size;
+	evict_entries (self->priv, 0);
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "max-size");
+}
+
+/**
+ * gdata_memory_cache_get_size:
+ * @self: a #GDataMemoryCache
+ *
+ * Gets the total size of the response bodies currently held by the cache, in bytes.
+ *
+ * Return value: the current size of the cache, in bytes
+ *
+ * Since: 0.15.0
+ */
+guint64
+gdata_memory_cache_get_size (GDataMemoryCache *self)
+{
+	guint64 size;
+
+	g_return_val_if_fail (GDATA_IS_MEMORY_CACHE (self), 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	size = self->priv->size;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return size;
+}
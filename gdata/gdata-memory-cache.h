@@ -0,0 +1,75 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_MEMORY_CACHE_H
+#define GDATA_MEMORY_CACHE_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <gdata/gdata-cache.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_MEMORY_CACHE			(gdata_memory_cache_get_type ())
+#define GDATA_MEMORY_CACHE(o)			(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_MEMORY_CACHE, GDataMemoryCache))
+#define GDATA_MEMORY_CACHE_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_MEMORY_CACHE, GDataMemoryCacheClass))
+#define GDATA_IS_MEMORY_CACHE(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_MEMORY_CACHE))
+#define GDATA_IS_MEMORY_CACHE_CLASS(k)		(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_MEMORY_CACHE))
+#define GDATA_MEMORY_CACHE_GET_CLASS(o)		(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_MEMORY_CACHE, GDataMemoryCacheClass))
+
+typedef struct _GDataMemoryCachePrivate	GDataMemoryCachePrivate;
+
+/**
+ * GDataMemoryCache:
+ *
+ * All the fields in the #GDataMemoryCache structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GDataCache parent;
+	GDataMemoryCachePrivate *priv;
+} GDataMemoryCache;
+
+/**
+ * GDataMemoryCacheClass:
+ *
+ * All the fields in the #GDataMemoryCacheClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GDataCacheClass parent;
+} GDataMemoryCacheClass;
+
+GType gdata_memory_cache_get_type (void) G_GNUC_CONST;
+
+GDataMemoryCache *gdata_memory_cache_new (guint64 max_size) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+guint64 gdata_memory_cache_get_max_size (GDataMemoryCache *self);
+void gdata_memory_cache_set_max_size (GDataMemoryCache *self, guint64 max_size);
+
+guint64 gdata_memory_cache_get_size (GDataMemoryCache *self);
+
+G_END_DECLS
+
+#endif /* !GDATA_MEMORY_CACHE_H */
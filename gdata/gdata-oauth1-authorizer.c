@@ -149,6 +149,7 @@
 #define HMAC_SHA1_LEN 20 /* bytes, raw */
 
 static void authorizer_init (GDataAuthorizerInterface *iface);
+static void constructed (GObject *object);
 static void dispose (GObject *object);
 static void finalize (GObject *object);
 static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
@@ -163,6 +164,7 @@ static void notify_proxy_uri_cb (GObject *object, GParamSpec *pspec, GDataOAuth1
 static void notify_timeout_cb (GObject *gobject, GParamSpec *pspec, GObject *self);
 
 struct _GDataOAuth1AuthorizerPrivate {
+	GDataConnectionPool *connection_pool;
 	SoupSession *session;
 	SoupURI *proxy_uri; /* cached version only set if gdata_oauth1_authorizer_get_proxy_uri() is called */
 
@@ -185,6 +187,7 @@ enum {
 	PROP_LOCALE,
 	PROP_PROXY_URI,
 	PROP_TIMEOUT,
+	PROP_CONNECTION_POOL,
 };
 
 G_DEFINE_TYPE_WITH_CODE (GDataOAuth1Authorizer, gdata_oauth1_authorizer, G_TYPE_OBJECT,
@@ -199,6 +202,7 @@ gdata_oauth1_authorizer_class_init (GDataOAuth1AuthorizerClass *klass)
 
 	gobject_class->get_property = get_property;
 	gobject_class->set_property = set_property;
+	gobject_class->constructed = constructed;
 	gobject_class->dispose = dispose;
 	gobject_class->finalize = finalize;
 
@@ -266,6 +270,22 @@ gdata_oauth1_authorizer_class_init (GDataOAuth1AuthorizerClass *klass)
 	                                                    "Timeout", "A timeout, in seconds, for network operations.",
 	                                                    0, G_MAXUINT, 0,
 	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataOAuth1Authorizer:connection-pool:
+	 *
+	 * The #GDataConnectionPool which the authorizer's network requests are made through. This can be shared with the #GDataService<!-- -->s
+	 * which use the authorizer, so that authentication and data requests re-use the same connections.
+	 *
+	 * If this isn't set at construction time, the authorizer creates its own private connection pool.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_CONNECTION_POOL,
+	                                 g_param_spec_object ("connection-pool",
+	                                                      "Connection pool", "The connection pool which network requests are made through.",
+	                                                      GDATA_TYPE_CONNECTION_POOL,
+	                                                      G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -283,13 +303,26 @@ gdata_oauth1_authorizer_init (GDataOAuth1Authorizer *self)
 	/* Set up the authorizer's mutex */
 	g_mutex_init (&(self->priv->mutex));
 	self->priv->authorization_domains = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+}
+
+static void
+constructed (GObject *object)
+{
+	GDataOAuth1AuthorizerPrivate *priv = GDATA_OAUTH1_AUTHORIZER (object)->priv;
+
+	/* Create a private connection pool if we haven't been given one to share */
+	if (priv->connection_pool == NULL)
+		priv->connection_pool = gdata_connection_pool_new ();
 
 	/* Set up the session */
-	self->priv->session = _gdata_service_build_session ();
+	priv->session = g_object_ref (_gdata_connection_pool_get_session (priv->connection_pool));
 
 	/* Proxy the SoupSession's proxy-uri and timeout properties */
-	g_signal_connect (self->priv->session, "notify::proxy-uri", (GCallback) notify_proxy_uri_cb, self);
-	g_signal_connect (self->priv->session, "notify::timeout", (GCallback) notify_timeout_cb, self);
+	g_signal_connect (priv->session, "notify::proxy-uri", (GCallback) notify_proxy_uri_cb, object);
+	g_signal_connect (priv->session, "notify::timeout", (GCallback) notify_timeout_cb, object);
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_oauth1_authorizer_parent_class)->constructed (object);
 }
 
 static void
@@ -297,10 +330,17 @@ dispose (GObject *object)
 {
 	GDataOAuth1AuthorizerPrivate *priv = GDATA_OAUTH1_AUTHORIZER (object)->priv;
 
-	if (priv->session != NULL)
+	/* The session may outlive us if its connection pool is shared */
+	if (priv->session != NULL) {
+		g_signal_handlers_disconnect_by_data (priv->session, object);
 		g_object_unref (priv->session);
+	}
 	priv->session = NULL;
 
+	if (priv->connection_pool != NULL)
+		g_object_unref (priv->connection_pool);
+	priv->connection_pool = NULL;
+
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS (gdata_oauth1_authorizer_parent_class)->dispose (object);
 }
@@ -345,6 +385,9 @@ get_property (GObject *object, guint property_id, GValue *value, GParamSpec *psp
 		case PROP_TIMEOUT:
 			g_value_set_uint (value, gdata_oauth1_authorizer_get_timeout (GDATA_OAUTH1_AUTHORIZER (object)));
 			break;
+		case PROP_CONNECTION_POOL:
+			g_value_set_object (value, priv->connection_pool);
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -378,6 +421,10 @@ set_property (GObject *object, guint property_id, const GValue *value, GParamSpe
 		case PROP_TIMEOUT:
 			gdata_oauth1_authorizer_set_timeout (GDATA_OAUTH1_AUTHORIZER (object), g_value_get_uint (value));
 			break;
+		/* Construct only */
+		case PROP_CONNECTION_POOL:
+			priv->connection_pool = g_value_dup_object (value);
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -1394,3 +1441,20 @@ gdata_oauth1_authorizer_set_timeout (GDataOAuth1Authorizer *self, guint timeout)
 
 	/* Notification is handled in notify_timeout_cb() which is called as a result of setting the property on the session */
 }
+
+/**
+ * gdata_oauth1_authorizer_get_connection_pool:
+ * @self: a #GDataOAuth1Authorizer
+ *
+ * Gets the #GDataOAuth1Authorizer:connection-pool property; the #GDataConnectionPool which the authorizer's network requests are made through.
+ *
+ * Return value: (transfer none): the #GDataConnectionPool used by the authorizer
+ *
+ * Since: 0.15.0
+ */
+GDataConnectionPool *
+gdata_oauth1_authorizer_get_connection_pool (GDataOAuth1Authorizer *self)
+{
+	g_return_val_if_fail (GDATA_IS_OAUTH1_AUTHORIZER (self), NULL);
+	return self->priv->connection_pool;
+}
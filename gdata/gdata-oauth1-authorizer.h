@@ -24,6 +24,7 @@
 #include <glib-object.h>
 
 #include "gdata-authorizer.h"
+#include "gdata-connection-pool.h"
 
 G_BEGIN_DECLS
 
@@ -92,6 +93,8 @@ void gdata_oauth1_authorizer_set_proxy_uri (GDataOAuth1Authorizer *self, SoupURI
 guint gdata_oauth1_authorizer_get_timeout (GDataOAuth1Authorizer *self) G_GNUC_PURE;
 void gdata_oauth1_authorizer_set_timeout (GDataOAuth1Authorizer *self, guint timeout);
 
+GDataConnectionPool *gdata_oauth1_authorizer_get_connection_pool (GDataOAuth1Authorizer *self) G_GNUC_PURE;
+
 G_END_DECLS
 
 #endif /* !GDATA_OAUTH1_AUTHORIZER_H */
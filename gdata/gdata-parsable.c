@@ -41,6 +41,7 @@
 #include "gdata-parsable.h"
 #include "gdata-private.h"
 #include "gdata-parser.h"
+#include "gdata-trace.h"
 
 GQuark
 gdata_parser_error_quark (void)
@@ -339,6 +340,8 @@ _gdata_parsable_new_from_xml (GType parsable_type, const gchar *xml, gint length
 	if (length == -1)
 		length = strlen (xml);
 
+	GDATA_TRACE_PARSE_START (parsable_type, length);
+
 	/* Parse the XML */
 	doc = xmlReadMemory (xml, length, "/dev/null", NULL, 0);
 	if (doc == NULL) {
@@ -347,6 +350,7 @@ _gdata_parsable_new_from_xml (GType parsable_type, const gchar *xml, gint length
 		             /* Translators: the parameter is an error message */
 		             _("Error parsing XML: %s"),
 		             (xml_error != NULL) ? xml_error->message : NULL);
+		GDATA_TRACE_PARSE_END (parsable_type, NULL);
 		return NULL;
 	}
 
@@ -359,12 +363,15 @@ _gdata_parsable_new_from_xml (GType parsable_type, const gchar *xml, gint length
 		             _("Error parsing XML: %s"),
 		             /* Translators: this is a dummy error message to be substituted into "Error parsing XML: %s". */
 		             _("Empty document."));
+		GDATA_TRACE_PARSE_END (parsable_type, NULL);
 		return NULL;
 	}
 
 	parsable = _gdata_parsable_new_from_xml_node (parsable_type, doc, node, user_data, error);
 	xmlFreeDoc (doc);
 
+	GDATA_TRACE_PARSE_END (parsable_type, parsable);
+
 	return parsable;
 }
 
@@ -472,6 +479,8 @@ _gdata_parsable_new_from_json (GType parsable_type, const gchar *json, gint leng
 	if (length == -1)
 		length = strlen (json);
 
+	GDATA_TRACE_PARSE_START (parsable_type, length);
+
 	parser = json_parser_new ();
 	if (!json_parser_load_from_data (parser, json, length, &child_error)) {
 		g_set_error (error, GDATA_PARSER_ERROR, GDATA_PARSER_ERROR_PARSING_STRING,
@@ -480,6 +489,8 @@ _gdata_parsable_new_from_json (GType parsable_type, const gchar *json, gint leng
 		g_error_free (child_error);
 		g_object_unref (parser);
 
+		GDATA_TRACE_PARSE_END (parsable_type, NULL);
+
 		return NULL;
 	}
 
@@ -489,6 +500,8 @@ _gdata_parsable_new_from_json (GType parsable_type, const gchar *json, gint leng
 	g_object_unref (reader);
 	g_object_unref (parser);
 
+	GDATA_TRACE_PARSE_END (parsable_type, parsable);
+
 	return parsable;
 }
 
@@ -53,7 +53,17 @@ G_GNUC_INTERNAL SoupSession *_gdata_service_get_session (GDataService *self) G_G
 G_GNUC_INTERNAL SoupMessage *_gdata_service_build_message (GDataService *self, GDataAuthorizationDomain *domain, const gchar *method, const gchar *uri,
                                                            const gchar *etag, gboolean etag_if_match);
 G_GNUC_INTERNAL void _gdata_service_actually_send_message (SoupSession *session, SoupMessage *message, GCancellable *cancellable, GError **error);
+G_GNUC_INTERNAL void _gdata_service_track_request (GDataService *self, SoupMessage *message);
+G_GNUC_INTERNAL void _gdata_service_hedge_message (GDataService *self, SoupMessage *message);
+G_GNUC_INTERNAL void _gdata_service_attach_circuit_breaker (GDataService *self, SoupMessage *message);
+G_GNUC_INTERNAL void _gdata_service_set_request_body (GDataService *self, SoupMessage *message, const gchar *content_type, gchar *data, gsize length);
+G_GNUC_INTERNAL void _gdata_service_set_request_parse_stats (SoupMessage *message, gint64 parse_duration, guint n_entries);
 G_GNUC_INTERNAL guint _gdata_service_send_message (GDataService *self, SoupMessage *message, GCancellable *cancellable, GError **error);
+G_GNUC_INTERNAL gboolean _gdata_service_wait_to_retry (GDataService *self, SoupMessage *message, guint attempt, GCancellable *cancellable);
+G_GNUC_INTERNAL void _gdata_service_send_message_async (GDataService *self, SoupMessage *message, GCancellable *cancellable,
+                                                        GAsyncReadyCallback callback, gpointer user_data);
+G_GNUC_INTERNAL guint _gdata_service_send_message_finish (GDataService *self, GAsyncResult *async_result, GError **error);
+G_GNUC_INTERNAL void _gdata_service_run_in_parse_pool (GSimpleAsyncResult *result, GSimpleAsyncThreadFunc func, GCancellable *cancellable);
 G_GNUC_INTERNAL SoupMessage *_gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query,
                                                    GCancellable *cancellable, GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
 G_GNUC_INTERNAL const gchar *_gdata_service_get_scheme (void) G_GNUC_CONST;
@@ -63,6 +73,37 @@ G_GNUC_INTERNAL gchar *_gdata_service_fix_uri_scheme (const gchar *uri) G_GNUC_W
 G_GNUC_INTERNAL GDataLogLevel _gdata_service_get_log_level (void) G_GNUC_CONST;
 G_GNUC_INTERNAL SoupSession *_gdata_service_build_session (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
 
+#include "gdata-connection-pool.h"
+G_GNUC_INTERNAL SoupSession *_gdata_connection_pool_get_session (GDataConnectionPool *self) G_GNUC_PURE;
+
+#include "gdata-retry-policy.h"
+G_GNUC_INTERNAL gint64 _gdata_retry_policy_get_retry_delay (GDataRetryPolicy *self, SoupMessage *message, guint attempt);
+
+#include "gdata-rate-limiter.h"
+G_GNUC_INTERNAL gint64 _gdata_rate_limiter_acquire (GDataRateLimiter *self, GDataAuthorizationDomain *domain);
+G_GNUC_INTERNAL void _gdata_rate_limiter_report (GDataRateLimiter *self, GDataAuthorizationDomain *domain, SoupMessage *message);
+
+#include "gdata-request-scheduler.h"
+G_GNUC_INTERNAL gboolean _gdata_request_scheduler_acquire (GDataRequestScheduler *self, GDataRequestPriority priority, GCancellable *cancellable);
+G_GNUC_INTERNAL gpointer _gdata_request_scheduler_acquire_async (GDataRequestScheduler *self, GDataRequestPriority priority, GSourceFunc callback,
+                                                                 gpointer user_data, GDestroyNotify notify);
+G_GNUC_INTERNAL gboolean _gdata_request_scheduler_withdraw (GDataRequestScheduler *self, gpointer ticket);
+G_GNUC_INTERNAL void _gdata_request_scheduler_release (GDataRequestScheduler *self, GDataRequestPriority priority);
+
+#include "gdata-hedging-policy.h"
+G_GNUC_INTERNAL void _gdata_hedging_policy_send_message (GDataHedgingPolicy *self, SoupSession *session, SoupMessage *message);
+G_GNUC_INTERNAL void _gdata_hedging_policy_queue_message (GDataHedgingPolicy *self, SoupSession *session, SoupMessage *message,
+                                                          SoupSessionCallback callback, gpointer user_data);
+G_GNUC_INTERNAL void _gdata_hedging_policy_cancel_message (SoupSession *session, SoupMessage *message);
+
+#include "gdata-circuit-breaker.h"
+G_GNUC_INTERNAL gboolean _gdata_circuit_breaker_allow (GDataCircuitBreaker *self, const gchar *host);
+G_GNUC_INTERNAL void _gdata_circuit_breaker_report (GDataCircuitBreaker *self, const gchar *host, guint status);
+
+#include "gdata-deadline-cancellable.h"
+G_GNUC_INTERNAL gint64 _gdata_deadline_cancellable_get_remaining_time (GCancellable *cancellable);
+G_GNUC_INTERNAL gboolean _gdata_deadline_cancellable_set_error_if_expired (GCancellable *cancellable, GError **error);
+
 typedef gchar *GDataSecureString;
 typedef const gchar *GDataConstSecureString;
 
@@ -91,14 +132,17 @@ G_GNUC_INTERNAL gboolean _gdata_parsable_is_constructed_from_xml (GDataParsable
 #include "gdata-feed.h"
 G_GNUC_INTERNAL GDataFeed *_gdata_feed_new (const gchar *title, const gchar *id, gint64 updated) G_GNUC_WARN_UNUSED_RESULT;
 G_GNUC_INTERNAL GDataFeed *_gdata_feed_new_from_xml (GType feed_type, const gchar *xml, gint length, GType entry_type,
-                                                     GDataQueryProgressCallback progress_callback, gpointer progress_user_data, gboolean is_async,
-                                                     GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+                                                     GDataQueryProgressCallback progress_callback,
+                                                     GDataQueryBatchProgressCallback batch_progress_callback, gpointer progress_user_data,
+                                                     GMainContext *progress_context, GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
 G_GNUC_INTERNAL GDataFeed *_gdata_feed_new_from_json (GType feed_type, const gchar *json, gint length, GType entry_type,
-                                                     GDataQueryProgressCallback progress_callback, gpointer progress_user_data, gboolean is_async,
-                                                     GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+                                                      GDataQueryProgressCallback progress_callback,
+                                                      GDataQueryBatchProgressCallback batch_progress_callback, gpointer progress_user_data,
+                                                      GMainContext *progress_context, GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
 G_GNUC_INTERNAL void _gdata_feed_add_entry (GDataFeed *self, GDataEntry *entry);
-G_GNUC_INTERNAL gpointer _gdata_feed_parse_data_new (GType entry_type, GDataQueryProgressCallback progress_callback, gpointer progress_user_data,
-                                                     gboolean is_async);
+G_GNUC_INTERNAL gpointer _gdata_feed_parse_data_new (GType entry_type, GDataQueryProgressCallback progress_callback,
+                                                     GDataQueryBatchProgressCallback batch_progress_callback, gpointer progress_user_data,
+                                                     GMainContext *progress_context);
 G_GNUC_INTERNAL void _gdata_feed_parse_data_free (gpointer data);
 G_GNUC_INTERNAL void _gdata_feed_call_progress_callback (GDataFeed *self, gpointer user_data, GDataEntry *entry);
 
@@ -47,6 +47,7 @@
 #include "gdata-query.h"
 #include "gdata-private.h"
 #include "gdata-types.h"
+#include "gdata-enums.h"
 
 static void gdata_query_finalize (GObject *object);
 static void gdata_query_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
@@ -72,6 +73,7 @@ struct _GDataQueryPrivate {
 	gboolean use_previous_uri;
 
 	gchar *etag;
+	GDataRequestPriority priority;
 };
 
 enum {
@@ -85,7 +87,8 @@ enum {
 	PROP_START_INDEX,
 	PROP_IS_STRICT,
 	PROP_MAX_RESULTS,
-	PROP_ETAG
+	PROP_ETAG,
+	PROP_PRIORITY
 };
 
 G_DEFINE_TYPE (GDataQuery, gdata_query, G_TYPE_OBJECT)
@@ -271,6 +274,21 @@ gdata_query_class_init (GDataQueryClass *klass)
 	                                                      "ETag", "An ETag against which to check.",
 	                                                      NULL,
 	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataQuery:priority:
+	 *
+	 * The priority of the requests made for the query, used to decide which requests to send first if #GDataService:request-scheduler is set.
+	 *
+	 * Unlike the other properties, this doesn't affect the query URI, so setting it doesn't unset #GDataQuery:etag.
+	 *
+	 * Since: 0.15.0
+	 **/
+	g_object_class_install_property (gobject_class, PROP_PRIORITY,
+	                                 g_param_spec_enum ("priority",
+	                                                    "Priority", "The priority of the requests made for the query.",
+	                                                    GDATA_TYPE_REQUEST_PRIORITY, GDATA_REQUEST_PRIORITY_NORMAL,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -281,6 +299,7 @@ gdata_query_init (GDataQuery *self)
 	self->priv->updated_max = -1;
 	self->priv->published_min = -1;
 	self->priv->published_max = -1;
+	self->priv->priority = GDATA_REQUEST_PRIORITY_NORMAL;
 }
 
 static void
@@ -338,6 +357,9 @@ gdata_query_get_property (GObject *object, guint property_id, GValue *value, GPa
 		case PROP_ETAG:
 			g_value_set_string (value, priv->etag);
 			break;
+		case PROP_PRIORITY:
+			g_value_set_enum (value, priv->priority);
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -384,6 +406,9 @@ gdata_query_set_property (GObject *object, guint property_id, const GValue *valu
 		case PROP_ETAG:
 			gdata_query_set_etag (self, g_value_get_string (value));
 			break;
+		case PROP_PRIORITY:
+			gdata_query_set_priority (self, g_value_get_enum (value));
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -956,6 +981,41 @@ gdata_query_set_etag (GDataQuery *self, const gchar *etag)
 	g_object_notify (G_OBJECT (self), "etag");
 }
 
+/**
+ * gdata_query_get_priority:
+ * @self: a #GDataQuery
+ *
+ * Gets the #GDataQuery:priority property.
+ *
+ * Return value: the priority of the requests made for the query
+ *
+ * Since: 0.15.0
+ **/
+GDataRequestPriority
+gdata_query_get_priority (GDataQuery *self)
+{
+	g_return_val_if_fail (GDATA_IS_QUERY (self), GDATA_REQUEST_PRIORITY_NORMAL);
+	return self->priv->priority;
+}
+
+/**
+ * gdata_query_set_priority:
+ * @self: a #GDataQuery
+ * @priority: the new priority
+ *
+ * Sets the #GDataQuery:priority property of the #GDataQuery to @priority.
+ *
+ * Since: 0.15.0
+ **/
+void
+gdata_query_set_priority (GDataQuery *self, GDataRequestPriority priority)
+{
+	g_return_if_fail (GDATA_IS_QUERY (self));
+
+	self->priv->priority = priority;
+	g_object_notify (G_OBJECT (self), "priority");
+}
+
 void
 _gdata_query_set_next_uri (GDataQuery *self, const gchar *next_uri)
 {
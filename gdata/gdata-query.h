@@ -23,6 +23,8 @@
 #include <glib.h>
 #include <glib-object.h>
 
+#include <gdata/gdata-request-scheduler.h>
+
 G_BEGIN_DECLS
 
 #define GDATA_TYPE_QUERY		(gdata_query_get_type ())
@@ -88,6 +90,9 @@ void gdata_query_set_max_results (GDataQuery *self, guint max_results);
 const gchar *gdata_query_get_etag (GDataQuery *self) G_GNUC_PURE;
 void gdata_query_set_etag (GDataQuery *self, const gchar *etag);
 
+GDataRequestPriority gdata_query_get_priority (GDataQuery *self) G_GNUC_PURE;
+void gdata_query_set_priority (GDataQuery *self, GDataRequestPriority priority);
+
 G_END_DECLS
 
 #endif /* !GDATA_QUERY_H */
@@ -0,0 +1,657 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-rate-limiter
+ * @short_description: GData client-side request rate limiter
+ * @stability: Unstable
+ * @include: gdata/gdata-rate-limiter.h
+ *
+ * #GDataRateLimiter limits the rate at which a #GDataService sends requests, so that the application stays within the server's quotas rather than
+ * exceeding them and wasting round trips on throttled (<literal>403</literal>, <literal>429</literal> or <literal>503</literal>) responses.
+ *
+ * Google's quotas apply per user and per API, so requests are limited separately for each #GDataAuthorizationDomain, using a token bucket: a
+ * domain may make up to #GDataRateLimiter:burst requests in quick succession, after which its requests are spaced out to
+ * #GDataRateLimiter:requests-per-second on average. Those limits apply to every domain by default; different limits can be set for individual
+ * domains using gdata_rate_limiter_set_domain_limit(). Requests which are over their domain's budget wait until they can be sent: synchronous
+ * requests block, and asynchronous ones are queued without blocking a thread.
+ *
+ * If #GDataRateLimiter:adaptive is %TRUE, the limiter also adapts to the server: each throttled response halves the rate for its domain, and the
+ * rate then recovers gradually towards the configured limit with each successful response.
+ *
+ * A rate limiter is set on a service using #GDataService:rate-limiter. To have a quota which is shared between several services apply to all of them,
+ * set the same rate limiter on each.
+ *
+ * <example>
+ * 	<title>Limiting the Rate of Requests</title>
+ * 	<programlisting>
+ *	GDataRateLimiter *limiter;
+ *
+ *	/<!-- -->* Allow bursts of 20 requests, then 5 requests per second *<!-- -->/
+ *	limiter = gdata_rate_limiter_new (5.0, 20);
+ *
+ *	gdata_service_set_rate_limiter (service, limiter);
+ *	g_object_unref (limiter);
+ * 	</programlisting>
+ * </example>
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsoup/soup.h>
+
+#include "gdata-rate-limiter.h"
+#include "gdata-private.h"
+
+#define DEFAULT_REQUESTS_PER_SECOND 10.0
+#define DEFAULT_BURST 10
+
+/* When adapting, the rate is never reduced below this fraction of the configured rate, and recovers by this fraction of it with each success */
+#define MIN_RATE_FRACTION (1.0 / 64.0)
+#define RECOVERY_FRACTION (1.0 / 16.0)
+
+/* libsoup doesn't define a status code for this */
+#define STATUS_TOO_MANY_REQUESTS 429
+
+typedef struct {
+	gboolean has_own_limit; /* FALSE if the limiter's defaults apply */
+	gdouble requests_per_second; /* configured rate; 0 means unlimited */
+	guint burst;
+
+	gdouble current_rate; /* adapted rate; never greater than requests_per_second */
+	gdouble tokens; /* may be negative if requests have reserved future tokens */
+	gint64 last_refill; /* monotonic time, in microseconds */
+} Bucket;
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataRateLimiterPrivate {
+	gdouble requests_per_second;
+	guint burst;
+	gboolean adaptive;
+
+	GMutex mutex; /* protects everything, since the limiter may be shared between services used from several threads */
+	GHashTable *buckets; /* GDataAuthorizationDomain (or NULL) → owned Bucket */
+};
+
+enum {
+	PROP_REQUESTS_PER_SECOND = 1,
+	PROP_BURST,
+	PROP_ADAPTIVE,
+};
+
+G_DEFINE_TYPE (GDataRateLimiter, gdata_rate_limiter, G_TYPE_OBJECT)
+
+static void
+gdata_rate_limiter_class_init (GDataRateLimiterClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataRateLimiterPrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	/**
+	 * GDataRateLimiter:requests-per-second:
+	 *
+	 * The average number of requests per second which may be made for each #GDataAuthorizationDomain which doesn't have its own limit set
+	 * using gdata_rate_limiter_set_domain_limit().
+	 *
+	 * If this is <code class="literal">0</code>, the number of requests isn't limited.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_REQUESTS_PER_SECOND,
+	                                 g_param_spec_double ("requests-per-second",
+	                                                      "Requests per second", "The average number of requests per second for each domain.",
+	                                                      0.0, G_MAXDOUBLE, DEFAULT_REQUESTS_PER_SECOND,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRateLimiter:burst:
+	 *
+	 * The number of requests which may be made in quick succession for each #GDataAuthorizationDomain which doesn't have its own limit set
+	 * using gdata_rate_limiter_set_domain_limit(), before they start to be spaced out to #GDataRateLimiter:requests-per-second.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_BURST,
+	                                 g_param_spec_uint ("burst",
+	                                                    "Burst", "The number of requests which may be made in quick succession for each domain.",
+	                                                    1, G_MAXUINT, DEFAULT_BURST,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRateLimiter:adaptive:
+	 *
+	 * Whether to reduce the rate of requests for a #GDataAuthorizationDomain when the server throttles them, and let it recover gradually
+	 * afterwards.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_ADAPTIVE,
+	                                 g_param_spec_boolean ("adaptive",
+	                                                       "Adaptive?", "Whether to adapt the rate of requests when the server throttles them.",
+	                                                       TRUE,
+	                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+domain_unref (GDataAuthorizationDomain *domain)
+{
+	if (domain != NULL)
+		g_object_unref (domain);
+}
+
+static void
+bucket_free (Bucket *bucket)
+{
+	g_slice_free (Bucket, bucket);
+}
+
+static void
+gdata_rate_limiter_init (GDataRateLimiter *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_RATE_LIMITER, GDataRateLimiterPrivate);
+
+	self->priv->requests_per_second = DEFAULT_REQUESTS_PER_SECOND;
+	self->priv->burst = DEFAULT_BURST;
+	self->priv->adaptive = TRUE;
+
+	g_mutex_init (&(self->priv->mutex));
+	self->priv->buckets = g_hash_table_new_full (g_direct_hash, g_direct_equal, (GDestroyNotify) domain_unref, (GDestroyNotify) bucket_free);
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataRateLimiterPrivate *priv = GDATA_RATE_LIMITER (object)->priv;
+
+	g_hash_table_destroy (priv->buckets);
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_rate_limiter_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataRateLimiterPrivate *priv = GDATA_RATE_LIMITER (object)->priv;
+
+	switch (property_id) {
+		case PROP_REQUESTS_PER_SECOND:
+			g_value_set_double (value, priv->requests_per_second);
+			break;
+		case PROP_BURST:
+			g_value_set_uint (value, priv->burst);
+			break;
+		case PROP_ADAPTIVE:
+			g_value_set_boolean (value, priv->adaptive);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataRateLimiter *self = GDATA_RATE_LIMITER (object);
+
+	switch (property_id) {
+		case PROP_REQUESTS_PER_SECOND:
+			gdata_rate_limiter_set_requests_per_second (self, g_value_get_double (value));
+			break;
+		case PROP_BURST:
+			gdata_rate_limiter_set_burst (self, g_value_get_uint (value));
+			break;
+		case PROP_ADAPTIVE:
+			gdata_rate_limiter_set_adaptive (self, g_value_get_boolean (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/* (Re-)configure @bucket with the given limit, resetting any adaptation and refilling it. Must be called with the mutex held. */
+static void
+bucket_set_limit (Bucket *bucket, gdouble requests_per_second, guint burst)
+{
+	bucket->requests_per_second = requests_per_second;
+	bucket->burst = burst;
+	bucket->current_rate = requests_per_second;
+	bucket->tokens = burst;
+	bucket->last_refill = g_get_monotonic_time ();
+}
+
+/* Must be called with the mutex held. */
+static Bucket *
+get_bucket (GDataRateLimiter *self, GDataAuthorizationDomain *domain)
+{
+	Bucket *bucket;
+
+	bucket = g_hash_table_lookup (self->priv->buckets, domain);
+
+	if (bucket == NULL) {
+		bucket = g_slice_new0 (Bucket);
+		bucket_set_limit (bucket, self->priv->requests_per_second, self->priv->burst);
+
+		g_hash_table_insert (self->priv->buckets, (domain != NULL) ? g_object_ref (domain) : NULL, bucket);
+	}
+
+	return bucket;
+}
+
+/* Apply changed defaults to all the buckets which use them. */
+static void
+update_default_buckets (GDataRateLimiter *self)
+{
+	GHashTableIter iter;
+	Bucket *bucket;
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	g_hash_table_iter_init (&iter, self->priv->buckets);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &bucket) == TRUE) {
+		if (bucket->has_own_limit == FALSE)
+			bucket_set_limit (bucket, self->priv->requests_per_second, self->priv->burst);
+	}
+
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/**
+ * gdata_rate_limiter_new:
+ * @requests_per_second: the average number of requests per second for each domain, or <code class="literal">0</code> for no limit
+ * @burst: the number of requests which may be made in quick succession for each domain; at least <code class="literal">1</code>
+ *
+ * Creates a new #GDataRateLimiter which applies the given limit to each #GDataAuthorizationDomain.
+ *
+ * Return value: (transfer full): a new #GDataRateLimiter; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataRateLimiter *
+gdata_rate_limiter_new (gdouble requests_per_second, guint burst)
+{
+	g_return_val_if_fail (requests_per_second >= 0.0, NULL);
+	g_return_val_if_fail (burst > 0, NULL);
+
+	return g_object_new (GDATA_TYPE_RATE_LIMITER, "requests-per-second", requests_per_second, "burst", burst, NULL);
+}
+
+/**
+ * gdata_rate_limiter_get_requests_per_second:
+ * @self: a #GDataRateLimiter
+ *
+ * Gets the #GDataRateLimiter:requests-per-second property.
+ *
+ * Return value: the default average number of requests per second for each domain, or <code class="literal">0</code> for no limit
+ *
+ * Since: 0.15.0
+ */
+gdouble
+gdata_rate_limiter_get_requests_per_second (GDataRateLimiter *self)
+{
+	g_return_val_if_fail (GDATA_IS_RATE_LIMITER (self), 0.0);
+	return self->priv->requests_per_second;
+}
+
+/**
+ * gdata_rate_limiter_set_requests_per_second:
+ * @self: a #GDataRateLimiter
+ * @requests_per_second: the default average number of requests per second for each domain, or <code class="literal">0</code> for no limit
+ *
+ * Sets the #GDataRateLimiter:requests-per-second property. Any adaptation of the rate for domains without their own limits is reset.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_rate_limiter_set_requests_per_second (GDataRateLimiter *self, gdouble requests_per_second)
+{
+	g_return_if_fail (GDATA_IS_RATE_LIMITER (self));
+	g_return_if_fail (requests_per_second >= 0.0);
+
+	self->priv->requests_per_second = requests_per_second;
+	update_default_buckets (self);
+
+	g_object_notify (G_OBJECT (self), "requests-per-second");
+}
+
+/**
+ * gdata_rate_limiter_get_burst:
+ * @self: a #GDataRateLimiter
+ *
+ * Gets the #GDataRateLimiter:burst property.
+ *
+ * Return value: the default number of requests which may be made in quick succession for each domain
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_rate_limiter_get_burst (GDataRateLimiter *self)
+{
+	g_return_val_if_fail (GDATA_IS_RATE_LIMITER (self), 1);
+	return self->priv->burst;
+}
+
+/**
+ * gdata_rate_limiter_set_burst:
+ * @self: a #GDataRateLimiter
+ * @burst: the default number of requests which may be made in quick succession for each domain; at least <code class="literal">1</code>
+ *
+ * Sets the #GDataRateLimiter:burst property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_rate_limiter_set_burst (GDataRateLimiter *self, guint burst)
+{
+	g_return_if_fail (GDATA_IS_RATE_LIMITER (self));
+	g_return_if_fail (burst > 0);
+
+	self->priv->burst = burst;
+	update_default_buckets (self);
+
+	g_object_notify (G_OBJECT (self), "burst");
+}
+
+/**
+ * gdata_rate_limiter_get_adaptive:
+ * @self: a #GDataRateLimiter
+ *
+ * Gets the #GDataRateLimiter:adaptive property.
+ *
+ * Return value: %TRUE if the rate of requests is adapted when the server throttles them, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_rate_limiter_get_adaptive (GDataRateLimiter *self)
+{
+	g_return_val_if_fail (GDATA_IS_RATE_LIMITER (self), FALSE);
+	return self->priv->adaptive;
+}
+
+/**
+ * gdata_rate_limiter_set_adaptive:
+ * @self: a #GDataRateLimiter
+ * @adaptive: %TRUE to adapt the rate of requests when the server throttles them, %FALSE otherwise
+ *
+ * Sets the #GDataRateLimiter:adaptive property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_rate_limiter_set_adaptive (GDataRateLimiter *self, gboolean adaptive)
+{
+	g_return_if_fail (GDATA_IS_RATE_LIMITER (self));
+
+	self->priv->adaptive = adaptive;
+	g_object_notify (G_OBJECT (self), "adaptive");
+}
+
+/**
+ * gdata_rate_limiter_set_domain_limit:
+ * @self: a #GDataRateLimiter
+ * @domain: (allow-none): the #GDataAuthorizationDomain to set the limit for, or %NULL for requests which don't have a domain
+ * @requests_per_second: the average number of requests per second for @domain, or <code class="literal">0</code> for no limit
+ * @burst: the number of requests which may be made in quick succession for @domain; at least <code class="literal">1</code>
+ *
+ * Sets a limit for requests in @domain which overrides the #GDataRateLimiter:requests-per-second and #GDataRateLimiter:burst defaults. Any
+ * adaptation of the rate for @domain is reset.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_rate_limiter_set_domain_limit (GDataRateLimiter *self, GDataAuthorizationDomain *domain, gdouble requests_per_second, guint burst)
+{
+	Bucket *bucket;
+
+	g_return_if_fail (GDATA_IS_RATE_LIMITER (self));
+	g_return_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
+	g_return_if_fail (requests_per_second >= 0.0);
+	g_return_if_fail (burst > 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	bucket = get_bucket (self, domain);
+	bucket->has_own_limit = TRUE;
+	bucket_set_limit (bucket, requests_per_second, burst);
+
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/**
+ * gdata_rate_limiter_get_domain_limit:
+ * @self: a #GDataRateLimiter
+ * @domain: (allow-none): the #GDataAuthorizationDomain to get the limit for, or %NULL for requests which don't have a domain
+ * @requests_per_second: (out caller-allocates) (allow-none): return location for the average number of requests per second, or %NULL
+ * @burst: (out caller-allocates) (allow-none): return location for the number of requests which may be made in quick succession, or %NULL
+ *
+ * Gets the limit which applies to requests in @domain. This is the limit set with gdata_rate_limiter_set_domain_limit() if there is one, or the
+ * #GDataRateLimiter:requests-per-second and #GDataRateLimiter:burst defaults otherwise.
+ *
+ * Return value: %TRUE if @domain has its own limit, %FALSE if the defaults apply to it
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_rate_limiter_get_domain_limit (GDataRateLimiter *self, GDataAuthorizationDomain *domain, gdouble *requests_per_second, guint *burst)
+{
+	Bucket *bucket;
+	gboolean has_own_limit;
+
+	g_return_val_if_fail (GDATA_IS_RATE_LIMITER (self), FALSE);
+	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), FALSE);
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	bucket = g_hash_table_lookup (self->priv->buckets, domain);
+	has_own_limit = (bucket != NULL && bucket->has_own_limit == TRUE) ? TRUE : FALSE;
+
+	if (requests_per_second != NULL)
+		*requests_per_second = (has_own_limit == TRUE) ? bucket->requests_per_second : self->priv->requests_per_second;
+	if (burst != NULL)
+		*burst = (has_own_limit == TRUE) ? bucket->burst : self->priv->burst;
+
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return has_own_limit;
+}
+
+/**
+ * gdata_rate_limiter_unset_domain_limit:
+ * @self: a #GDataRateLimiter
+ * @domain: (allow-none): the #GDataAuthorizationDomain to unset the limit for, or %NULL for requests which don't have a domain
+ *
+ * Removes any limit set for @domain with gdata_rate_limiter_set_domain_limit(), so that the #GDataRateLimiter:requests-per-second and
+ * #GDataRateLimiter:burst defaults apply to it again.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_rate_limiter_unset_domain_limit (GDataRateLimiter *self, GDataAuthorizationDomain *domain)
+{
+	Bucket *bucket;
+
+	g_return_if_fail (GDATA_IS_RATE_LIMITER (self));
+	g_return_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	bucket = g_hash_table_lookup (self->priv->buckets, domain);
+	if (bucket != NULL && bucket->has_own_limit == TRUE) {
+		bucket->has_own_limit = FALSE;
+		bucket_set_limit (bucket, self->priv->requests_per_second, self->priv->burst);
+	}
+
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/**
+ * gdata_rate_limiter_get_current_rate:
+ * @self: a #GDataRateLimiter
+ * @domain: (allow-none): a #GDataAuthorizationDomain, or %NULL for requests which don't have a domain
+ *
+ * Gets the rate at which requests in @domain are currently allowed to be made. This is the configured limit for @domain, unless
+ * #GDataRateLimiter:adaptive is %TRUE and the server has recently throttled requests in @domain, in which case it's lower.
+ *
+ * Return value: the current average number of requests per second for @domain, or <code class="literal">0</code> if it's not limited
+ *
+ * Since: 0.15.0
+ */
+gdouble
+gdata_rate_limiter_get_current_rate (GDataRateLimiter *self, GDataAuthorizationDomain *domain)
+{
+	Bucket *bucket;
+	gdouble current_rate;
+
+	g_return_val_if_fail (GDATA_IS_RATE_LIMITER (self), 0.0);
+	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), 0.0);
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	bucket = g_hash_table_lookup (self->priv->buckets, domain);
+	current_rate = (bucket != NULL) ? bucket->current_rate : self->priv->requests_per_second;
+
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return current_rate;
+}
+
+/*
+ * _gdata_rate_limiter_acquire:
+ * @self: a #GDataRateLimiter
+ * @domain: (allow-none): the #GDataAuthorizationDomain of the request which is about to be sent, or %NULL
+ *
+ * Takes a token from @domain's bucket for a request which is about to be sent. If the bucket is empty, the token is reserved from the future, and
+ * the caller must wait for the returned delay before sending the request. Reserving tokens means that concurrent requests are spaced out in the
+ * order they called this function.
+ *
+ * Return value: the time to wait before sending the request, in milliseconds; <code class="literal">0</code> if it may be sent immediately
+ *
+ * Since: 0.15.0
+ */
+gint64
+_gdata_rate_limiter_acquire (GDataRateLimiter *self, GDataAuthorizationDomain *domain)
+{
+	Bucket *bucket;
+	gint64 now, delay = 0;
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	bucket = get_bucket (self, domain);
+
+	if (bucket->current_rate > 0.0) {
+		/* Refill the bucket */
+		now = g_get_monotonic_time ();
+		bucket->tokens = MIN (bucket->tokens + (now - bucket->last_refill) * bucket->current_rate / G_USEC_PER_SEC, (gdouble) bucket->burst);
+		bucket->last_refill = now;
+
+		/* Take a token, and wait until it would have been available if there wasn't one */
+		bucket->tokens -= 1.0;
+
+		if (bucket->tokens < 0.0)
+			delay = (gint64) (-bucket->tokens * 1000.0 / bucket->current_rate) + 1;
+	}
+
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return delay;
+}
+
+static gboolean
+is_throttled (SoupMessage *message)
+{
+	SoupBuffer *body;
+	gboolean throttled;
+
+	if (message->status_code == STATUS_TOO_MANY_REQUESTS || message->status_code == SOUP_STATUS_SERVICE_UNAVAILABLE)
+		return TRUE;
+	else if (message->status_code != SOUP_STATUS_FORBIDDEN)
+		return FALSE;
+
+	/* A 403 response may either mean the user isn't allowed to do something, or that they've exceeded a quota; the latter is indicated in the
+	 * response body. */
+	body = soup_message_body_flatten (message->response_body);
+	throttled = (body->length > 0 &&
+	             (g_strstr_len (body->data, body->length, "rateLimitExceeded") != NULL ||
+	              g_strstr_len (body->data, body->length, "quotaExceeded") != NULL)) ? TRUE : FALSE;
+	soup_buffer_free (body);
+
+	return throttled;
+}
+
+/*
+ * _gdata_rate_limiter_report:
+ * @self: a #GDataRateLimiter
+ * @domain: (allow-none): the #GDataAuthorizationDomain of the request which has just been sent, or %NULL
+ * @message: the #SoupMessage which has just been sent and had its response received
+ *
+ * Adapts the rate for @domain to the response to @message, if #GDataRateLimiter:adaptive is %TRUE: the rate is halved if the server throttled the
+ * request, and increased towards the configured limit if the request succeeded.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_rate_limiter_report (GDataRateLimiter *self, GDataAuthorizationDomain *domain, SoupMessage *message)
+{
+	Bucket *bucket;
+	gboolean throttled;
+
+	if (self->priv->adaptive == FALSE)
+		return;
+
+	throttled = is_throttled (message);
+
+	if (throttled == FALSE && SOUP_STATUS_IS_SUCCESSFUL (message->status_code) == FALSE && message->status_code != SOUP_STATUS_NOT_MODIFIED)
+		return;
+
+	g_mutex_lock (&(self->priv->mutex));
+
+	bucket = get_bucket (self, domain);
+
+	/* Unlimited buckets have nothing to adapt */
+	if (bucket->requests_per_second > 0.0) {
+		if (throttled == TRUE) {
+			/* Multiplicative decrease, and stop any burst which is in progress */
+			bucket->current_rate = MAX (bucket->current_rate / 2.0, bucket->requests_per_second * MIN_RATE_FRACTION);
+			bucket->tokens = MIN (bucket->tokens, 0.0);
+
+			g_debug ("Throttled by server; reducing request rate to %f requests per second.", bucket->current_rate);
+		} else {
+			/* Additive increase */
+			bucket->current_rate = MIN (bucket->current_rate + bucket->requests_per_second * RECOVERY_FRACTION, bucket->requests_per_second);
+		}
+	}
+
+	g_mutex_unlock (&(self->priv->mutex));
+}
@@ -0,0 +1,85 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_RATE_LIMITER_H
+#define GDATA_RATE_LIMITER_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <gdata/gdata-authorization-domain.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_RATE_LIMITER		(gdata_rate_limiter_get_type ())
+#define GDATA_RATE_LIMITER(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_RATE_LIMITER, GDataRateLimiter))
+#define GDATA_RATE_LIMITER_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_RATE_LIMITER, GDataRateLimiterClass))
+#define GDATA_IS_RATE_LIMITER(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_RATE_LIMITER))
+#define GDATA_IS_RATE_LIMITER_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_RATE_LIMITER))
+#define GDATA_RATE_LIMITER_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_RATE_LIMITER, GDataRateLimiterClass))
+
+typedef struct _GDataRateLimiterPrivate	GDataRateLimiterPrivate;
+
+/**
+ * GDataRateLimiter:
+ *
+ * All the fields in the #GDataRateLimiter structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataRateLimiterPrivate *priv;
+} GDataRateLimiter;
+
+/**
+ * GDataRateLimiterClass:
+ *
+ * All the fields in the #GDataRateLimiterClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataRateLimiterClass;
+
+GType gdata_rate_limiter_get_type (void) G_GNUC_CONST;
+
+GDataRateLimiter *gdata_rate_limiter_new (gdouble requests_per_second, guint burst) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+gdouble gdata_rate_limiter_get_requests_per_second (GDataRateLimiter *self) G_GNUC_PURE;
+void gdata_rate_limiter_set_requests_per_second (GDataRateLimiter *self, gdouble requests_per_second);
+
+guint gdata_rate_limiter_get_burst (GDataRateLimiter *self) G_GNUC_PURE;
+void gdata_rate_limiter_set_burst (GDataRateLimiter *self, guint burst);
+
+gboolean gdata_rate_limiter_get_adaptive (GDataRateLimiter *self) G_GNUC_PURE;
+void gdata_rate_limiter_set_adaptive (GDataRateLimiter *self, gboolean adaptive);
+
+void gdata_rate_limiter_set_domain_limit (GDataRateLimiter *self, GDataAuthorizationDomain *domain, gdouble requests_per_second, guint burst);
+gboolean gdata_rate_limiter_get_domain_limit (GDataRateLimiter *self, GDataAuthorizationDomain *domain, gdouble *requests_per_second, guint *burst);
+void gdata_rate_limiter_unset_domain_limit (GDataRateLimiter *self, GDataAuthorizationDomain *domain);
+
+gdouble gdata_rate_limiter_get_current_rate (GDataRateLimiter *self, GDataAuthorizationDomain *domain);
+
+G_END_DECLS
+
+#endif /* !GDATA_RATE_LIMITER_H */
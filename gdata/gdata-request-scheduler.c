@@ -0,0 +1,556 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-request-scheduler
+ * @short_description: GData priority-aware request scheduler
+ * @stability: Unstable
+ * @include: gdata/gdata-request-scheduler.h
+ *
+ * #GDataRequestScheduler bounds the number of requests a #GDataService has in progress at once, and decides which of the waiting requests to send
+ * next by their #GDataRequestPriority. This stops interactive requests, such as opening a single entry, from waiting behind hundreds of queued page
+ * fetches from a background synchronisation.
+ *
+ * At most #GDataRequestScheduler:max-requests requests may be in progress at once. Each priority also has its own limit, set with
+ * gdata_request_scheduler_set_max_requests_for_priority(), so that a lower priority can be prevented from taking all of the slots. When a slot
+ * becomes free, it goes to the oldest waiting request of the highest priority which is under its own limit; requests of the same priority are sent
+ * in the order they were made.
+ *
+ * The priority of a query is set using #GDataQuery:priority. Requests which aren't made using a #GDataQuery, such as insertions, updates and
+ * deletions, have %GDATA_REQUEST_PRIORITY_NORMAL.
+ *
+ * A scheduler is set on a service using #GDataService:request-scheduler, and may be shared between several services. Requests which are waiting for
+ * a slot don't block a thread if they're asynchronous. Since requests beyond the #GDataConnectionPool's limits are queued by libsoup in the order
+ * they were sent, #GDataRequestScheduler:max-requests should be no greater than #GDataConnectionPool:max-connections-per-host for priorities to
+ * take full effect.
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+
+#include "gdata-request-scheduler.h"
+#include "gdata-private.h"
+
+#define N_PRIORITIES (GDATA_REQUEST_PRIORITY_BULK + 1)
+
+/* These match the default limits of GDataConnectionPool, and leave a slot free for interactive and normal requests during bulk operations */
+#define DEFAULT_MAX_REQUESTS 2
+static const guint default_max_requests_for_priority[N_PRIORITIES] = { 2, 2, 1 };
+
+typedef struct {
+	GDataRequestPriority priority;
+	gboolean granted;
+
+	/* Asynchronous tickets only; these are NULL for synchronous tickets */
+	GSourceFunc callback;
+	gpointer user_data;
+	GDestroyNotify notify;
+	GMainContext *context;
+} Ticket;
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataRequestSchedulerPrivate {
+	guint max_requests;
+	guint max_requests_for_priority[N_PRIORITIES];
+
+	GMutex mutex; /* protects everything, since the scheduler may be shared between services used from several threads */
+	GCond cond; /* signalled when synchronous tickets are granted, or when their cancellables are cancelled */
+	guint n_active; /* total of n_active_for_priority */
+	guint n_active_for_priority[N_PRIORITIES];
+	GQueue queued[N_PRIORITIES]; /* Ticket, oldest first */
+};
+
+enum {
+	PROP_MAX_REQUESTS = 1,
+};
+
+G_DEFINE_TYPE (GDataRequestScheduler, gdata_request_scheduler, G_TYPE_OBJECT)
+
+static void
+gdata_request_scheduler_class_init (GDataRequestSchedulerClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataRequestSchedulerPrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	/**
+	 * GDataRequestScheduler:max-requests:
+	 *
+	 * The maximum number of requests, of all priorities, which may be in progress at once.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MAX_REQUESTS,
+	                                 g_param_spec_uint ("max-requests",
+	                                                    "Maximum requests", "The maximum number of requests in progress at once.",
+	                                                    1, G_MAXUINT, DEFAULT_MAX_REQUESTS,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdata_request_scheduler_init (GDataRequestScheduler *self)
+{
+	guint i;
+
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_REQUEST_SCHEDULER, GDataRequestSchedulerPrivate);
+
+	self->priv->max_requests = DEFAULT_MAX_REQUESTS;
+
+	for (i = 0; i < N_PRIORITIES; i++) {
+		self->priv->max_requests_for_priority[i] = default_max_requests_for_priority[i];
+		g_queue_init (&(self->priv->queued[i]));
+	}
+
+	g_mutex_init (&(self->priv->mutex));
+	g_cond_init (&(self->priv->cond));
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataRequestSchedulerPrivate *priv = GDATA_REQUEST_SCHEDULER (object)->priv;
+	guint i;
+
+	/* Every waiting request holds a reference to the service, which holds a reference to us */
+	for (i = 0; i < N_PRIORITIES; i++)
+		g_assert (g_queue_is_empty (&(priv->queued[i])) == TRUE);
+
+	g_cond_clear (&(priv->cond));
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_request_scheduler_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataRequestSchedulerPrivate *priv = GDATA_REQUEST_SCHEDULER (object)->priv;
+
+	switch (property_id) {
+		case PROP_MAX_REQUESTS:
+			g_value_set_uint (value, priv->max_requests);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataRequestScheduler *self = GDATA_REQUEST_SCHEDULER (object);
+
+	switch (property_id) {
+		case PROP_MAX_REQUESTS:
+			gdata_request_scheduler_set_max_requests (self, g_value_get_uint (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+ticket_free (Ticket *ticket)
+{
+	if (ticket->notify != NULL)
+		ticket->notify (ticket->user_data);
+	if (ticket->context != NULL)
+		g_main_context_unref (ticket->context);
+
+	g_slice_free (Ticket, ticket);
+}
+
+/* Must be called with the mutex held. */
+static gboolean
+can_start (GDataRequestScheduler *self, GDataRequestPriority priority)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+
+	return (priv->n_active < priv->max_requests && priv->n_active_for_priority[priority] < priv->max_requests_for_priority[priority]) ?
+	       TRUE : FALSE;
+}
+
+/* Must be called with the mutex held. Asynchronous tickets are freed once their callback has been called in their main context. */
+static void
+grant_ticket (GDataRequestScheduler *self, Ticket *ticket)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+
+	priv->n_active++;
+	priv->n_active_for_priority[ticket->priority]++;
+	ticket->granted = TRUE;
+
+	if (ticket->callback != NULL) {
+		GSource *source;
+
+		source = g_idle_source_new ();
+		g_source_set_priority (source, G_PRIORITY_DEFAULT);
+		g_source_set_callback (source, ticket->callback, ticket, (GDestroyNotify) ticket_free);
+		g_source_attach (source, ticket->context);
+		g_source_unref (source);
+	} else {
+		g_cond_broadcast (&(priv->cond));
+	}
+}
+
+/* Hand out as many free slots as possible, highest priority first. Must be called with the mutex held. */
+static void
+dispatch (GDataRequestScheduler *self)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+	guint i;
+
+	for (i = 0; i < N_PRIORITIES && priv->n_active < priv->max_requests; i++) {
+		while (g_queue_is_empty (&(priv->queued[i])) == FALSE && can_start (self, i) == TRUE)
+			grant_ticket (self, g_queue_pop_head (&(priv->queued[i])));
+	}
+}
+
+/**
+ * gdata_request_scheduler_new:
+ *
+ * Creates a new #GDataRequestScheduler with the default limits.
+ *
+ * Return value: (transfer full): a new #GDataRequestScheduler; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataRequestScheduler *
+gdata_request_scheduler_new (void)
+{
+	return g_object_new (GDATA_TYPE_REQUEST_SCHEDULER, NULL);
+}
+
+/**
+ * gdata_request_scheduler_get_max_requests:
+ * @self: a #GDataRequestScheduler
+ *
+ * Gets the #GDataRequestScheduler:max-requests property.
+ *
+ * Return value: the maximum number of requests in progress at once
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_request_scheduler_get_max_requests (GDataRequestScheduler *self)
+{
+	g_return_val_if_fail (GDATA_IS_REQUEST_SCHEDULER (self), 1);
+	return self->priv->max_requests;
+}
+
+/**
+ * gdata_request_scheduler_set_max_requests:
+ * @self: a #GDataRequestScheduler
+ * @max_requests: the maximum number of requests in progress at once; at least <code class="literal">1</code>
+ *
+ * Sets the #GDataRequestScheduler:max-requests property. If the limit is lowered, requests which are already in progress are unaffected.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_request_scheduler_set_max_requests (GDataRequestScheduler *self, guint max_requests)
+{
+	g_return_if_fail (GDATA_IS_REQUEST_SCHEDULER (self));
+	g_return_if_fail (max_requests > 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->max_requests = max_requests;
+	dispatch (self);
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "max-requests");
+}
+
+/**
+ * gdata_request_scheduler_get_max_requests_for_priority:
+ * @self: a #GDataRequestScheduler
+ * @priority: a #GDataRequestPriority
+ *
+ * Gets the maximum number of requests with the given @priority which may be in progress at once.
+ *
+ * Return value: the maximum number of requests with @priority in progress at once
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_request_scheduler_get_max_requests_for_priority (GDataRequestScheduler *self, GDataRequestPriority priority)
+{
+	g_return_val_if_fail (GDATA_IS_REQUEST_SCHEDULER (self), 1);
+	g_return_val_if_fail (priority < N_PRIORITIES, 1);
+
+	return self->priv->max_requests_for_priority[priority];
+}
+
+/**
+ * gdata_request_scheduler_set_max_requests_for_priority:
+ * @self: a #GDataRequestScheduler
+ * @priority: a #GDataRequestPriority
+ * @max_requests: the maximum number of requests with @priority in progress at once; at least <code class="literal">1</code>
+ *
+ * Sets the maximum number of requests with the given @priority which may be in progress at once. This is in addition to the overall limit set
+ * by #GDataRequestScheduler:max-requests. By default, up to <code class="literal">2</code> requests of each priority may be in progress at once,
+ * except for %GDATA_REQUEST_PRIORITY_BULK, which is limited to <code class="literal">1</code> so that other requests don't have to wait for a slot
+ * during bulk operations.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_request_scheduler_set_max_requests_for_priority (GDataRequestScheduler *self, GDataRequestPriority priority, guint max_requests)
+{
+	g_return_if_fail (GDATA_IS_REQUEST_SCHEDULER (self));
+	g_return_if_fail (priority < N_PRIORITIES);
+	g_return_if_fail (max_requests > 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->max_requests_for_priority[priority] = max_requests;
+	dispatch (self);
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/**
+ * gdata_request_scheduler_get_n_active_requests:
+ * @self: a #GDataRequestScheduler
+ * @priority: a #GDataRequestPriority
+ *
+ * Gets the number of requests with the given @priority which are currently in progress.
+ *
+ * Return value: the number of requests with @priority in progress
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_request_scheduler_get_n_active_requests (GDataRequestScheduler *self, GDataRequestPriority priority)
+{
+	guint n_active;
+
+	g_return_val_if_fail (GDATA_IS_REQUEST_SCHEDULER (self), 0);
+	g_return_val_if_fail (priority < N_PRIORITIES, 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	n_active = self->priv->n_active_for_priority[priority];
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return n_active;
+}
+
+/**
+ * gdata_request_scheduler_get_n_queued_requests:
+ * @self: a #GDataRequestScheduler
+ * @priority: a #GDataRequestPriority
+ *
+ * Gets the number of requests with the given @priority which are waiting to be sent.
+ *
+ * Return value: the number of requests with @priority waiting to be sent
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_request_scheduler_get_n_queued_requests (GDataRequestScheduler *self, GDataRequestPriority priority)
+{
+	guint n_queued;
+
+	g_return_val_if_fail (GDATA_IS_REQUEST_SCHEDULER (self), 0);
+	g_return_val_if_fail (priority < N_PRIORITIES, 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	n_queued = g_queue_get_length (&(self->priv->queued[priority]));
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return n_queued;
+}
+
+static void
+acquire_cancelled_cb (GCancellable *cancellable, GDataRequestScheduler *self)
+{
+	/* Wake up the waiting thread so it notices the cancellation */
+	g_mutex_lock (&(self->priv->mutex));
+	g_cond_broadcast (&(self->priv->cond));
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/*
+ * _gdata_request_scheduler_acquire:
+ * @self: a #GDataRequestScheduler
+ * @priority: the priority of the request
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ *
+ * Blocks until a request with the given @priority may be sent. If this returns %TRUE, the slot must be returned with
+ * _gdata_request_scheduler_release() once the request has finished. If @cancellable is cancelled while waiting, %FALSE is returned and no slot is
+ * taken; the request should then be sent anyway, so that its cancellation is handled as normal.
+ *
+ * Return value: %TRUE if a slot was taken, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+_gdata_request_scheduler_acquire (GDataRequestScheduler *self, GDataRequestPriority priority, GCancellable *cancellable)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+	Ticket ticket = { 0, };
+	gulong cancelled_id = 0;
+
+	/* This calls acquire_cancelled_cb() immediately if @cancellable has already been cancelled, so the mutex mustn't be held */
+	if (cancellable != NULL)
+		cancelled_id = g_cancellable_connect (cancellable, (GCallback) acquire_cancelled_cb, self, NULL);
+
+	g_mutex_lock (&(priv->mutex));
+
+	ticket.priority = priority;
+
+	/* Only jump straight in if no older requests of the same priority are waiting */
+	if (g_queue_is_empty (&(priv->queued[priority])) == TRUE && can_start (self, priority) == TRUE) {
+		grant_ticket (self, &ticket);
+	} else {
+		g_queue_push_tail (&(priv->queued[priority]), &ticket);
+
+		while (ticket.granted == FALSE && g_cancellable_is_cancelled (cancellable) == FALSE)
+			g_cond_wait (&(priv->cond), &(priv->mutex));
+
+		if (ticket.granted == FALSE)
+			g_queue_remove (&(priv->queued[priority]), &ticket);
+	}
+
+	g_mutex_unlock (&(priv->mutex));
+
+	if (cancellable != NULL)
+		g_cancellable_disconnect (cancellable, cancelled_id);
+
+	return ticket.granted;
+}
+
+/*
+ * _gdata_request_scheduler_acquire_async:
+ * @self: a #GDataRequestScheduler
+ * @priority: the priority of the request
+ * @callback: function to call once a slot has been taken
+ * @user_data: data to pass to @callback
+ * @notify: (allow-none): function to free @user_data, or %NULL
+ *
+ * Asynchronous version of _gdata_request_scheduler_acquire(). If a slot can be taken straight away, %NULL is returned and @callback is never called.
+ * Otherwise, a ticket is returned, and @callback is called in the thread-default main context of the calling thread once a slot has been taken for
+ * it. Either way, the slot must be returned with _gdata_request_scheduler_release() once the request has finished.
+ *
+ * A ticket may be withdrawn before @callback is called using _gdata_request_scheduler_withdraw().
+ *
+ * Return value: (transfer none): a ticket for the waiting request, or %NULL if a slot has been taken
+ *
+ * Since: 0.15.0
+ */
+gpointer
+_gdata_request_scheduler_acquire_async (GDataRequestScheduler *self, GDataRequestPriority priority, GSourceFunc callback, gpointer user_data,
+                                        GDestroyNotify notify)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+	GMainContext *context;
+	Ticket *ticket = NULL;
+
+	g_mutex_lock (&(priv->mutex));
+
+	if (g_queue_is_empty (&(priv->queued[priority])) == TRUE && can_start (self, priority) == TRUE) {
+		priv->n_active++;
+		priv->n_active_for_priority[priority]++;
+
+		if (notify != NULL)
+			notify (user_data);
+	} else {
+		context = g_main_context_get_thread_default ();
+
+		ticket = g_slice_new0 (Ticket);
+		ticket->priority = priority;
+		ticket->callback = callback;
+		ticket->user_data = user_data;
+		ticket->notify = notify;
+		ticket->context = g_main_context_ref ((context != NULL) ? context : g_main_context_default ());
+
+		g_queue_push_tail (&(priv->queued[priority]), ticket);
+	}
+
+	g_mutex_unlock (&(priv->mutex));
+
+	return ticket;
+}
+
+/*
+ * _gdata_request_scheduler_withdraw:
+ * @self: a #GDataRequestScheduler
+ * @ticket: a ticket returned by _gdata_request_scheduler_acquire_async()
+ *
+ * Withdraws a waiting request, so that it won't be given a slot. This must be called in the main context the ticket was created in, before its
+ * callback has been called. If a slot has already been taken for the ticket, its callback will still be called, and %FALSE is returned.
+ *
+ * Return value: %TRUE if the ticket was withdrawn, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+_gdata_request_scheduler_withdraw (GDataRequestScheduler *self, gpointer ticket)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+	Ticket *_ticket = ticket;
+	gboolean withdrawn;
+
+	g_mutex_lock (&(priv->mutex));
+	withdrawn = (_ticket->granted == FALSE) ? TRUE : FALSE;
+	if (withdrawn == TRUE)
+		g_queue_remove (&(priv->queued[_ticket->priority]), _ticket);
+	g_mutex_unlock (&(priv->mutex));
+
+	if (withdrawn == TRUE)
+		ticket_free (_ticket);
+
+	return withdrawn;
+}
+
+/*
+ * _gdata_request_scheduler_release:
+ * @self: a #GDataRequestScheduler
+ * @priority: the priority the slot was taken with
+ *
+ * Returns a slot taken by _gdata_request_scheduler_acquire() or _gdata_request_scheduler_acquire_async(), and gives it to the next waiting request.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_request_scheduler_release (GDataRequestScheduler *self, GDataRequestPriority priority)
+{
+	GDataRequestSchedulerPrivate *priv = self->priv;
+
+	g_mutex_lock (&(priv->mutex));
+
+	g_assert (priv->n_active_for_priority[priority] > 0);
+	priv->n_active--;
+	priv->n_active_for_priority[priority]--;
+	dispatch (self);
+
+	g_mutex_unlock (&(priv->mutex));
+}
@@ -0,0 +1,93 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_REQUEST_SCHEDULER_H
+#define GDATA_REQUEST_SCHEDULER_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GDataRequestPriority:
+ * @GDATA_REQUEST_PRIORITY_INTERACTIVE: the request is needed for the user to continue what they're doing, such as opening a single entry
+ * @GDATA_REQUEST_PRIORITY_NORMAL: the request has no particular urgency; this is the default
+ * @GDATA_REQUEST_PRIORITY_BULK: the request is part of a large background operation, such as an initial synchronisation
+ *
+ * The priority class of a request, used by #GDataRequestScheduler to decide which of the waiting requests to send first.
+ *
+ * Since: 0.15.0
+ */
+typedef enum {
+	GDATA_REQUEST_PRIORITY_INTERACTIVE = 0,
+	GDATA_REQUEST_PRIORITY_NORMAL,
+	GDATA_REQUEST_PRIORITY_BULK
+} GDataRequestPriority;
+
+#define GDATA_TYPE_REQUEST_SCHEDULER		(gdata_request_scheduler_get_type ())
+#define GDATA_REQUEST_SCHEDULER(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_REQUEST_SCHEDULER, GDataRequestScheduler))
+#define GDATA_REQUEST_SCHEDULER_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_REQUEST_SCHEDULER, GDataRequestSchedulerClass))
+#define GDATA_IS_REQUEST_SCHEDULER(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_REQUEST_SCHEDULER))
+#define GDATA_IS_REQUEST_SCHEDULER_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_REQUEST_SCHEDULER))
+#define GDATA_REQUEST_SCHEDULER_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_REQUEST_SCHEDULER, GDataRequestSchedulerClass))
+
+typedef struct _GDataRequestSchedulerPrivate	GDataRequestSchedulerPrivate;
+
+/**
+ * GDataRequestScheduler:
+ *
+ * All the fields in the #GDataRequestScheduler structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataRequestSchedulerPrivate *priv;
+} GDataRequestScheduler;
+
+/**
+ * GDataRequestSchedulerClass:
+ *
+ * All the fields in the #GDataRequestSchedulerClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataRequestSchedulerClass;
+
+GType gdata_request_scheduler_get_type (void) G_GNUC_CONST;
+
+GDataRequestScheduler *gdata_request_scheduler_new (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+guint gdata_request_scheduler_get_max_requests (GDataRequestScheduler *self) G_GNUC_PURE;
+void gdata_request_scheduler_set_max_requests (GDataRequestScheduler *self, guint max_requests);
+
+guint gdata_request_scheduler_get_max_requests_for_priority (GDataRequestScheduler *self, GDataRequestPriority priority);
+void gdata_request_scheduler_set_max_requests_for_priority (GDataRequestScheduler *self, GDataRequestPriority priority, guint max_requests);
+
+guint gdata_request_scheduler_get_n_active_requests (GDataRequestScheduler *self, GDataRequestPriority priority);
+guint gdata_request_scheduler_get_n_queued_requests (GDataRequestScheduler *self, GDataRequestPriority priority);
+
+G_END_DECLS
+
+#endif /* !GDATA_REQUEST_SCHEDULER_H */
@@ -0,0 +1,758 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-retry-policy
+ * @short_description: GData request retry policy
+ * @stability: Unstable
+ * @include: gdata/gdata-retry-policy.h
+ *
+ * #GDataRetryPolicy describes how a #GDataService should retry requests which fail transiently: for example, because the server is temporarily
+ * overloaded (<literal>503 Service Unavailable</literal>), the client has exceeded its quota (<literal>429 Too Many Requests</literal>) or a
+ * connection couldn't be made. It applies to all the requests the service makes, including queries, insertions, updates, deletions and batch
+ * operations. #GDataDownloadStream also uses it to decide whether to resume downloads which fail part-way through.
+ *
+ * A request is attempted at most #GDataRetryPolicy:max-attempts times. Between attempts, the service waits for an exponentially increasing delay,
+ * starting at #GDataRetryPolicy:initial-delay and doubling after each attempt up to #GDataRetryPolicy:max-delay. A random proportion of up to
+ * #GDataRetryPolicy:jitter of each delay is subtracted from it, so that many clients which failed at the same time don't all retry at the same
+ * time. If the server gives a <literal>Retry-After</literal> header in its response and #GDataRetryPolicy:honour-retry-after is %TRUE, the service
+ * waits for at least that long instead; if that's longer than #GDataRetryPolicy:max-delay, the request isn't retried at all.
+ *
+ * Only responses with one of the policy's retryable status codes are retried. By default these are <literal>429</literal>,
+ * <literal>500</literal>, <literal>502</literal>, <literal>503</literal> and <literal>504</literal>, plus %SOUP_STATUS_CANT_CONNECT and
+ * %SOUP_STATUS_IO_ERROR. The set can be changed using gdata_retry_policy_add_retryable_status() and
+ * gdata_retry_policy_remove_retryable_status().
+ *
+ * Requests which aren't idempotent (i.e. <literal>POST</literal> requests, which are used for insertions and batch operations) could be applied
+ * twice by the server if they were retried after it had started processing them. Unless #GDataRetryPolicy:retry-non-idempotent is %TRUE, they are
+ * therefore only retried if the server definitely didn't process them: if a connection couldn't be made to it (%SOUP_STATUS_CANT_CONNECT), or if it
+ * explicitly rejected them (<literal>429 Too Many Requests</literal>).
+ *
+ * Requests are not retried by default: a #GDataRetryPolicy has to be set as the #GDataService:retry-policy of each service which should retry
+ * requests. A single policy can be shared between several services.
+ *
+ * <example>
+ * 	<title>Retrying Requests</title>
+ * 	<programlisting>
+ *	GDataRetryPolicy *policy;
+ *
+ *	policy = gdata_retry_policy_new ();
+ *	gdata_retry_policy_set_max_attempts (policy, 5);
+ *
+ *	gdata_service_set_retry_policy (service, policy);
+ *	g_object_unref (policy);
+ * 	</programlisting>
+ * </example>
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsoup/soup.h>
+#include <string.h>
+#include <time.h>
+
+#include "gdata-retry-policy.h"
+#include "gdata-private.h"
+
+#define DEFAULT_MAX_ATTEMPTS 4
+#define DEFAULT_INITIAL_DELAY 500 /* ms */
+#define DEFAULT_MAX_DELAY 32000 /* ms */
+#define DEFAULT_JITTER 0.5
+
+/* libsoup doesn't define a status code for this */
+#define STATUS_TOO_MANY_REQUESTS 429
+
+static void finalize (GObject *object);
+static void get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataRetryPolicyPrivate {
+	guint max_attempts;
+	guint initial_delay;
+	guint max_delay;
+	gdouble jitter;
+	gboolean honour_retry_after;
+	gboolean retry_non_idempotent;
+
+	GMutex mutex; /* protects all the above and retryable_statuses, since the policy may be shared between services used from several threads */
+	GHashTable *retryable_statuses; /* set of status codes */
+};
+
+enum {
+	PROP_MAX_ATTEMPTS = 1,
+	PROP_INITIAL_DELAY,
+	PROP_MAX_DELAY,
+	PROP_JITTER,
+	PROP_HONOUR_RETRY_AFTER,
+	PROP_RETRY_NON_IDEMPOTENT,
+};
+
+G_DEFINE_TYPE (GDataRetryPolicy, gdata_retry_policy, G_TYPE_OBJECT)
+
+static void
+gdata_retry_policy_class_init (GDataRetryPolicyClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataRetryPolicyPrivate));
+
+	gobject_class->get_property = get_property;
+	gobject_class->set_property = set_property;
+	gobject_class->finalize = finalize;
+
+	/**
+	 * GDataRetryPolicy:max-attempts:
+	 *
+	 * The maximum number of times a request is attempted, including the first attempt. If this is <code class="literal">1</code>, requests are
+	 * never retried.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MAX_ATTEMPTS,
+	                                 g_param_spec_uint ("max-attempts",
+	                                                    "Maximum attempts", "The maximum number of times a request is attempted.",
+	                                                    1, G_MAXUINT, DEFAULT_MAX_ATTEMPTS,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRetryPolicy:initial-delay:
+	 *
+	 * The delay, in milliseconds, before the first retry of a request. The delay doubles for each subsequent retry, up to
+	 * #GDataRetryPolicy:max-delay.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_INITIAL_DELAY,
+	                                 g_param_spec_uint ("initial-delay",
+	                                                    "Initial delay", "The delay, in milliseconds, before the first retry of a request.",
+	                                                    0, G_MAXUINT, DEFAULT_INITIAL_DELAY,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRetryPolicy:max-delay:
+	 *
+	 * The maximum delay, in milliseconds, between two attempts of a request. If the server asks for a longer delay using a
+	 * <literal>Retry-After</literal> header, the request isn't retried.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_MAX_DELAY,
+	                                 g_param_spec_uint ("max-delay",
+	                                                    "Maximum delay", "The maximum delay, in milliseconds, between two attempts of a request.",
+	                                                    0, G_MAXUINT, DEFAULT_MAX_DELAY,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRetryPolicy:jitter:
+	 *
+	 * The maximum proportion of each delay which is randomly subtracted from it. If this is <code class="literal">0</code>, delays aren't
+	 * randomised at all; if it's <code class="literal">1</code>, each delay is chosen uniformly between zero and its full length.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_JITTER,
+	                                 g_param_spec_double ("jitter",
+	                                                      "Jitter", "The maximum proportion of each delay which is randomly subtracted from it.",
+	                                                      0.0, 1.0, DEFAULT_JITTER,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRetryPolicy:honour-retry-after:
+	 *
+	 * Whether to wait for at least as long as the server requests in the <literal>Retry-After</literal> header of a response before retrying
+	 * the request.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_HONOUR_RETRY_AFTER,
+	                                 g_param_spec_boolean ("honour-retry-after",
+	                                                       "Honour Retry-After?", "Whether to honour the Retry-After header of responses.",
+	                                                       TRUE,
+	                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataRetryPolicy:retry-non-idempotent:
+	 *
+	 * Whether to retry non-idempotent (<literal>POST</literal>) requests on any retryable status, rather than only when the server definitely
+	 * didn't process them. Enabling this may result in entries being inserted twice.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_RETRY_NON_IDEMPOTENT,
+	                                 g_param_spec_boolean ("retry-non-idempotent",
+	                                                       "Retry non-idempotent?", "Whether to retry non-idempotent requests on any retryable status.",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdata_retry_policy_init (GDataRetryPolicy *self)
+{
+	static const guint default_statuses[] = {
+		SOUP_STATUS_CANT_CONNECT,
+		SOUP_STATUS_IO_ERROR,
+		STATUS_TOO_MANY_REQUESTS,
+		SOUP_STATUS_INTERNAL_SERVER_ERROR,
+		SOUP_STATUS_BAD_GATEWAY,
+		SOUP_STATUS_SERVICE_UNAVAILABLE,
+		SOUP_STATUS_GATEWAY_TIMEOUT,
+	};
+	guint i;
+
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_RETRY_POLICY, GDataRetryPolicyPrivate);
+
+	self->priv->max_attempts = DEFAULT_MAX_ATTEMPTS;
+	self->priv->initial_delay = DEFAULT_INITIAL_DELAY;
+	self->priv->max_delay = DEFAULT_MAX_DELAY;
+	self->priv->jitter = DEFAULT_JITTER;
+	self->priv->honour_retry_after = TRUE;
+	self->priv->retry_non_idempotent = FALSE;
+
+	g_mutex_init (&(self->priv->mutex));
+	self->priv->retryable_statuses = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	for (i = 0; i < G_N_ELEMENTS (default_statuses); i++)
+		g_hash_table_insert (self->priv->retryable_statuses, GUINT_TO_POINTER (default_statuses[i]), GUINT_TO_POINTER (default_statuses[i]));
+}
+
+static void
+finalize (GObject *object)
+{
+	GDataRetryPolicyPrivate *priv = GDATA_RETRY_POLICY (object)->priv;
+
+	g_hash_table_destroy (priv->retryable_statuses);
+	g_mutex_clear (&(priv->mutex));
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_retry_policy_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataRetryPolicy *self = GDATA_RETRY_POLICY (object);
+
+	switch (property_id) {
+		case PROP_MAX_ATTEMPTS:
+			g_value_set_uint (value, gdata_retry_policy_get_max_attempts (self));
+			break;
+		case PROP_INITIAL_DELAY:
+			g_value_set_uint (value, gdata_retry_policy_get_initial_delay (self));
+			break;
+		case PROP_MAX_DELAY:
+			g_value_set_uint (value, gdata_retry_policy_get_max_delay (self));
+			break;
+		case PROP_JITTER:
+			g_value_set_double (value, gdata_retry_policy_get_jitter (self));
+			break;
+		case PROP_HONOUR_RETRY_AFTER:
+			g_value_set_boolean (value, gdata_retry_policy_get_honour_retry_after (self));
+			break;
+		case PROP_RETRY_NON_IDEMPOTENT:
+			g_value_set_boolean (value, gdata_retry_policy_get_retry_non_idempotent (self));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataRetryPolicy *self = GDATA_RETRY_POLICY (object);
+
+	switch (property_id) {
+		case PROP_MAX_ATTEMPTS:
+			gdata_retry_policy_set_max_attempts (self, g_value_get_uint (value));
+			break;
+		case PROP_INITIAL_DELAY:
+			gdata_retry_policy_set_initial_delay (self, g_value_get_uint (value));
+			break;
+		case PROP_MAX_DELAY:
+			gdata_retry_policy_set_max_delay (self, g_value_get_uint (value));
+			break;
+		case PROP_JITTER:
+			gdata_retry_policy_set_jitter (self, g_value_get_double (value));
+			break;
+		case PROP_HONOUR_RETRY_AFTER:
+			gdata_retry_policy_set_honour_retry_after (self, g_value_get_boolean (value));
+			break;
+		case PROP_RETRY_NON_IDEMPOTENT:
+			gdata_retry_policy_set_retry_non_idempotent (self, g_value_get_boolean (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/**
+ * gdata_retry_policy_new:
+ *
+ * Creates a new #GDataRetryPolicy with the default settings.
+ *
+ * Return value: (transfer full): a new #GDataRetryPolicy; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataRetryPolicy *
+gdata_retry_policy_new (void)
+{
+	return g_object_new (GDATA_TYPE_RETRY_POLICY, NULL);
+}
+
+/**
+ * gdata_retry_policy_get_max_attempts:
+ * @self: a #GDataRetryPolicy
+ *
+ * Gets the #GDataRetryPolicy:max-attempts property.
+ *
+ * Return value: the maximum number of times a request is attempted
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_retry_policy_get_max_attempts (GDataRetryPolicy *self)
+{
+	guint max_attempts;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), 1);
+
+	g_mutex_lock (&(self->priv->mutex));
+	max_attempts = self->priv->max_attempts;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return max_attempts;
+}
+
+/**
+ * gdata_retry_policy_set_max_attempts:
+ * @self: a #GDataRetryPolicy
+ * @max_attempts: the maximum number of times a request is attempted; at least <code class="literal">1</code>
+ *
+ * Sets the #GDataRetryPolicy:max-attempts property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_set_max_attempts (GDataRetryPolicy *self, guint max_attempts)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+	g_return_if_fail (max_attempts > 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->max_attempts = max_attempts;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "max-attempts");
+}
+
+/**
+ * gdata_retry_policy_get_initial_delay:
+ * @self: a #GDataRetryPolicy
+ *
+ * Gets the #GDataRetryPolicy:initial-delay property.
+ *
+ * Return value: the delay before the first retry of a request, in milliseconds
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_retry_policy_get_initial_delay (GDataRetryPolicy *self)
+{
+	guint initial_delay;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	initial_delay = self->priv->initial_delay;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return initial_delay;
+}
+
+/**
+ * gdata_retry_policy_set_initial_delay:
+ * @self: a #GDataRetryPolicy
+ * @initial_delay: the delay before the first retry of a request, in milliseconds
+ *
+ * Sets the #GDataRetryPolicy:initial-delay property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_set_initial_delay (GDataRetryPolicy *self, guint initial_delay)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->initial_delay = initial_delay;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "initial-delay");
+}
+
+/**
+ * gdata_retry_policy_get_max_delay:
+ * @self: a #GDataRetryPolicy
+ *
+ * Gets the #GDataRetryPolicy:max-delay property.
+ *
+ * Return value: the maximum delay between two attempts of a request, in milliseconds
+ *
+ * Since: 0.15.0
+ */
+guint
+gdata_retry_policy_get_max_delay (GDataRetryPolicy *self)
+{
+	guint max_delay;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), 0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	max_delay = self->priv->max_delay;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return max_delay;
+}
+
+/**
+ * gdata_retry_policy_set_max_delay:
+ * @self: a #GDataRetryPolicy
+ * @max_delay: the maximum delay between two attempts of a request, in milliseconds
+ *
+ * Sets the #GDataRetryPolicy:max-delay property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_set_max_delay (GDataRetryPolicy *self, guint max_delay)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->max_delay = max_delay;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "max-delay");
+}
+
+/**
+ * gdata_retry_policy_get_jitter:
+ * @self: a #GDataRetryPolicy
+ *
+ * Gets the #GDataRetryPolicy:jitter property.
+ *
+ * Return value: the maximum proportion of each delay which is randomly subtracted from it
+ *
+ * Since: 0.15.0
+ */
+gdouble
+gdata_retry_policy_get_jitter (GDataRetryPolicy *self)
+{
+	gdouble jitter;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), 0.0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	jitter = self->priv->jitter;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return jitter;
+}
+
+/**
+ * gdata_retry_policy_set_jitter:
+ * @self: a #GDataRetryPolicy
+ * @jitter: the maximum proportion of each delay which is randomly subtracted from it, between <code class="literal">0</code> and
+ * <code class="literal">1</code>
+ *
+ * Sets the #GDataRetryPolicy:jitter property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_set_jitter (GDataRetryPolicy *self, gdouble jitter)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+	g_return_if_fail (jitter >= 0.0 && jitter <= 1.0);
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->jitter = jitter;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "jitter");
+}
+
+/**
+ * gdata_retry_policy_get_honour_retry_after:
+ * @self: a #GDataRetryPolicy
+ *
+ * Gets the #GDataRetryPolicy:honour-retry-after property.
+ *
+ * Return value: %TRUE if <literal>Retry-After</literal> headers are honoured, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_retry_policy_get_honour_retry_after (GDataRetryPolicy *self)
+{
+	gboolean honour_retry_after;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), FALSE);
+
+	g_mutex_lock (&(self->priv->mutex));
+	honour_retry_after = self->priv->honour_retry_after;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return honour_retry_after;
+}
+
+/**
+ * gdata_retry_policy_set_honour_retry_after:
+ * @self: a #GDataRetryPolicy
+ * @honour_retry_after: %TRUE to honour <literal>Retry-After</literal> headers, %FALSE otherwise
+ *
+ * Sets the #GDataRetryPolicy:honour-retry-after property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_set_honour_retry_after (GDataRetryPolicy *self, gboolean honour_retry_after)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->honour_retry_after = honour_retry_after;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "honour-retry-after");
+}
+
+/**
+ * gdata_retry_policy_get_retry_non_idempotent:
+ * @self: a #GDataRetryPolicy
+ *
+ * Gets the #GDataRetryPolicy:retry-non-idempotent property.
+ *
+ * Return value: %TRUE if non-idempotent requests are retried on any retryable status, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_retry_policy_get_retry_non_idempotent (GDataRetryPolicy *self)
+{
+	gboolean retry_non_idempotent;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), FALSE);
+
+	g_mutex_lock (&(self->priv->mutex));
+	retry_non_idempotent = self->priv->retry_non_idempotent;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return retry_non_idempotent;
+}
+
+/**
+ * gdata_retry_policy_set_retry_non_idempotent:
+ * @self: a #GDataRetryPolicy
+ * @retry_non_idempotent: %TRUE to retry non-idempotent requests on any retryable status, %FALSE otherwise
+ *
+ * Sets the #GDataRetryPolicy:retry-non-idempotent property.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_set_retry_non_idempotent (GDataRetryPolicy *self, gboolean retry_non_idempotent)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+
+	g_mutex_lock (&(self->priv->mutex));
+	self->priv->retry_non_idempotent = retry_non_idempotent;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	g_object_notify (G_OBJECT (self), "retry-non-idempotent");
+}
+
+/**
+ * gdata_retry_policy_add_retryable_status:
+ * @self: a #GDataRetryPolicy
+ * @status: an HTTP or #SoupKnownStatusCode status code
+ *
+ * Adds @status to the set of status codes for which requests are retried. If it's already in the set, this does nothing.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_add_retryable_status (GDataRetryPolicy *self, guint status)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+	g_return_if_fail (status != SOUP_STATUS_NONE && status != SOUP_STATUS_CANCELLED);
+
+	g_mutex_lock (&(self->priv->mutex));
+	g_hash_table_insert (self->priv->retryable_statuses, GUINT_TO_POINTER (status), GUINT_TO_POINTER (status));
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/**
+ * gdata_retry_policy_remove_retryable_status:
+ * @self: a #GDataRetryPolicy
+ * @status: an HTTP or #SoupKnownStatusCode status code
+ *
+ * Removes @status from the set of status codes for which requests are retried. If it isn't in the set, this does nothing.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_retry_policy_remove_retryable_status (GDataRetryPolicy *self, guint status)
+{
+	g_return_if_fail (GDATA_IS_RETRY_POLICY (self));
+
+	g_mutex_lock (&(self->priv->mutex));
+	g_hash_table_remove (self->priv->retryable_statuses, GUINT_TO_POINTER (status));
+	g_mutex_unlock (&(self->priv->mutex));
+}
+
+/**
+ * gdata_retry_policy_is_retryable_status:
+ * @self: a #GDataRetryPolicy
+ * @status: an HTTP or #SoupKnownStatusCode status code
+ *
+ * Checks whether @status is in the set of status codes for which requests are retried.
+ *
+ * Return value: %TRUE if requests which fail with @status are retried, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_retry_policy_is_retryable_status (GDataRetryPolicy *self, guint status)
+{
+	gboolean retryable;
+
+	g_return_val_if_fail (GDATA_IS_RETRY_POLICY (self), FALSE);
+
+	g_mutex_lock (&(self->priv->mutex));
+	retryable = (g_hash_table_lookup (self->priv->retryable_statuses, GUINT_TO_POINTER (status)) != NULL) ? TRUE : FALSE;
+	g_mutex_unlock (&(self->priv->mutex));
+
+	return retryable;
+}
+
+/* Parse the Retry-After header of @message's response, which may be either a number of seconds or an HTTP date. Returns the requested delay in
+ * milliseconds, or -1 if there's no (valid) header. */
+static gint64
+get_retry_after (SoupMessage *message)
+{
+	const gchar *retry_after;
+	gchar *end;
+	guint64 seconds;
+	SoupDate *date;
+	gint64 delay;
+
+	retry_after = soup_message_headers_get_one (message->response_headers, "Retry-After");
+	if (retry_after == NULL)
+		return -1;
+
+	/* Delta seconds */
+	seconds = g_ascii_strtoull (retry_after, &end, 10);
+	if (end != retry_after && *end == '\0')
+		return (gint64) MIN (seconds, G_MAXINT64 / 1000) * 1000;
+
+	/* HTTP date */
+	date = soup_date_new_from_string (retry_after);
+	if (date == NULL)
+		return -1;
+
+	delay = ((gint64) soup_date_to_time_t (date) - (gint64) time (NULL)) * 1000;
+	soup_date_free (date);
+
+	return MAX (delay, 0);
+}
+
+static gboolean
+is_idempotent (SoupMessage *message)
+{
+	return (strcmp (message->method, SOUP_METHOD_GET) == 0 || strcmp (message->method, SOUP_METHOD_HEAD) == 0 ||
+	        strcmp (message->method, SOUP_METHOD_PUT) == 0 || strcmp (message->method, SOUP_METHOD_DELETE) == 0 ||
+	        strcmp (message->method, SOUP_METHOD_OPTIONS) == 0) ? TRUE : FALSE;
+}
+
+/*
+ * _gdata_retry_policy_get_retry_delay:
+ * @self: a #GDataRetryPolicy
+ * @message: a #SoupMessage which has just been sent and had its response received
+ * @attempt: the number of times @message has been sent so far
+ *
+ * Decides whether @message should be sent again according to the policy, based on its response, and if so, how long to wait before doing so.
+ *
+ * Return value: the delay before sending @message again, in milliseconds, or <code class="literal">-1</code> if it shouldn't be retried
+ *
+ * Since: 0.15.0
+ */
+gint64
+_gdata_retry_policy_get_retry_delay (GDataRetryPolicy *self, SoupMessage *message, guint attempt)
+{
+	GDataRetryPolicyPrivate *priv = self->priv;
+	guint max_attempts, initial_delay, max_delay;
+	gdouble jitter;
+	gboolean honour_retry_after, retry_non_idempotent;
+	gint64 delay, retry_after;
+	guint status = message->status_code;
+
+	/* Take a consistent snapshot of the settings, since they may be changed from another thread */
+	g_mutex_lock (&(priv->mutex));
+	max_attempts = priv->max_attempts;
+	initial_delay = priv->initial_delay;
+	max_delay = priv->max_delay;
+	jitter = priv->jitter;
+	honour_retry_after = priv->honour_retry_after;
+	retry_non_idempotent = priv->retry_non_idempotent;
+	g_mutex_unlock (&(priv->mutex));
+
+	if (attempt >= max_attempts || gdata_retry_policy_is_retryable_status (self, status) == FALSE)
+		return -1;
+
+	/* Don't replay a request which the server may already have acted upon */
+	if (retry_non_idempotent == FALSE && is_idempotent (message) == FALSE &&
+	    status != SOUP_STATUS_CANT_CONNECT && status != STATUS_TOO_MANY_REQUESTS) {
+		return -1;
+	}
+
+	/* Exponential backoff, with a random proportion of up to the jitter subtracted */
+	delay = (attempt - 1 < 31) ? (gint64) initial_delay << (attempt - 1) : G_MAXINT64;
+	delay = CLAMP (delay, 0, (gint64) max_delay);
+	delay -= (gint64) (delay * jitter * g_random_double ());
+
+	/* Honour any delay requested by the server, but not if it's unreasonably long */
+	if (honour_retry_after == TRUE) {
+		retry_after = get_retry_after (message);
+
+		if (retry_after > max_delay)
+			return -1;
+		else if (retry_after > delay)
+			delay = retry_after;
+	}
+
+	return delay;
+}
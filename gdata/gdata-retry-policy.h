@@ -0,0 +1,90 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_RETRY_POLICY_H
+#define GDATA_RETRY_POLICY_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_RETRY_POLICY		(gdata_retry_policy_get_type ())
+#define GDATA_RETRY_POLICY(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_RETRY_POLICY, GDataRetryPolicy))
+#define GDATA_RETRY_POLICY_CLASS(k)	(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_RETRY_POLICY, GDataRetryPolicyClass))
+#define GDATA_IS_RETRY_POLICY(o)	(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_RETRY_POLICY))
+#define GDATA_IS_RETRY_POLICY_CLASS(k)	(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_RETRY_POLICY))
+#define GDATA_RETRY_POLICY_GET_CLASS(o)	(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_RETRY_POLICY, GDataRetryPolicyClass))
+
+typedef struct _GDataRetryPolicyPrivate	GDataRetryPolicyPrivate;
+
+/**
+ * GDataRetryPolicy:
+ *
+ * All the fields in the #GDataRetryPolicy structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataRetryPolicyPrivate *priv;
+} GDataRetryPolicy;
+
+/**
+ * GDataRetryPolicyClass:
+ *
+ * All the fields in the #GDataRetryPolicyClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataRetryPolicyClass;
+
+GType gdata_retry_policy_get_type (void) G_GNUC_CONST;
+
+GDataRetryPolicy *gdata_retry_policy_new (void) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+guint gdata_retry_policy_get_max_attempts (GDataRetryPolicy *self) G_GNUC_PURE;
+void gdata_retry_policy_set_max_attempts (GDataRetryPolicy *self, guint max_attempts);
+
+guint gdata_retry_policy_get_initial_delay (GDataRetryPolicy *self) G_GNUC_PURE;
+void gdata_retry_policy_set_initial_delay (GDataRetryPolicy *self, guint initial_delay);
+
+guint gdata_retry_policy_get_max_delay (GDataRetryPolicy *self) G_GNUC_PURE;
+void gdata_retry_policy_set_max_delay (GDataRetryPolicy *self, guint max_delay);
+
+gdouble gdata_retry_policy_get_jitter (GDataRetryPolicy *self) G_GNUC_PURE;
+void gdata_retry_policy_set_jitter (GDataRetryPolicy *self, gdouble jitter);
+
+gboolean gdata_retry_policy_get_honour_retry_after (GDataRetryPolicy *self) G_GNUC_PURE;
+void gdata_retry_policy_set_honour_retry_after (GDataRetryPolicy *self, gboolean honour_retry_after);
+
+gboolean gdata_retry_policy_get_retry_non_idempotent (GDataRetryPolicy *self) G_GNUC_PURE;
+void gdata_retry_policy_set_retry_non_idempotent (GDataRetryPolicy *self, gboolean retry_non_idempotent);
+
+void gdata_retry_policy_add_retryable_status (GDataRetryPolicy *self, guint status);
+void gdata_retry_policy_remove_retryable_status (GDataRetryPolicy *self, guint status);
+gboolean gdata_retry_policy_is_retryable_status (GDataRetryPolicy *self, guint status);
+
+G_END_DECLS
+
+#endif /* !GDATA_RETRY_POLICY_H */
@@ -35,6 +35,11 @@
  * Note that it's not always necessary to supply a #GDataAuthorizer instance to a #GDataService. If the only operations to be performed on the
  * #GDataService don't need authorization (e.g. they only query public information), setting up a #GDataAuthorizer is just extra overhead. See the
  * documentation for the operations on individual #GDataService subclasses to see which need authorization and which don't.
+ *
+ * The asynchronous versions of the query, insertion, update and deletion operations don't tie up a thread while waiting for the network: requests
+ * are queued on the service's #SoupSession in the thread-default main context of the calling thread, and only the parsing of responses is done in
+ * a thread, taken from a small pool which is shared by all services. Their callbacks are invoked in the thread-default main context of the thread
+ * which started the operation. Consequently, that main context must be running for the operations to make progress.
  */
 
 #include <config.h>
@@ -55,6 +60,10 @@
 #include "gdata-client-login-authorizer.h"
 #include "gdata-marshal.h"
 #include "gdata-types.h"
+#include "gdata-trace.h"
+
+#define DEFAULT_COMPRESSION_THRESHOLD 4096 /* bytes */
+#define COMPRESSION_CHUNK_SIZE 16384 /* bytes */
 
 GQuark
 gdata_service_error_quark (void)
@@ -62,6 +71,63 @@ gdata_service_error_quark (void)
 	return g_quark_from_static_string ("gdata-service-error-quark");
 }
 
+GType
+gdata_request_stats_get_type (void)
+{
+	static GType type_id = 0;
+
+	if (type_id == 0) {
+		type_id = g_boxed_type_register_static (g_intern_static_string ("GDataRequestStats"),
+		                                        (GBoxedCopyFunc) gdata_request_stats_copy,
+		                                        (GBoxedFreeFunc) gdata_request_stats_free);
+	}
+
+	return type_id;
+}
+
+/**
+ * gdata_request_stats_copy:
+ * @self: a #GDataRequestStats
+ *
+ * Copies @self, so that it can be kept after the #GDataService::request-finished signal handler it was passed to has returned.
+ *
+ * Return value: (transfer full): a copy of @self; free with gdata_request_stats_free()
+ *
+ * Since: 0.15.0
+ */
+GDataRequestStats *
+gdata_request_stats_copy (const GDataRequestStats *self)
+{
+	GDataRequestStats *copy;
+
+	g_return_val_if_fail (self != NULL, NULL);
+
+	copy = g_slice_dup (GDataRequestStats, self);
+	copy->method = g_strdup (self->method);
+	copy->uri = g_strdup (self->uri);
+
+	return copy;
+}
+
+/**
+ * gdata_request_stats_free:
+ * @self: a #GDataRequestStats
+ *
+ * Frees a #GDataRequestStats returned by gdata_request_stats_copy().
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_request_stats_free (GDataRequestStats *self)
+{
+	g_return_if_fail (self != NULL);
+
+	g_free (self->method);
+	g_free (self->uri);
+	g_slice_free (GDataRequestStats, self);
+}
+
+static void gdata_service_constructed (GObject *object);
 static void gdata_service_dispose (GObject *object);
 static void gdata_service_finalize (GObject *object);
 static void gdata_service_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
@@ -74,14 +140,26 @@ static void notify_timeout_cb (GObject *gobject, GParamSpec *pspec, GObject *sel
 static void debug_handler (const char *log_domain, GLogLevelFlags log_level, const char *message, gpointer user_data);
 static void soup_log_printer (SoupLogger *logger, SoupLoggerLogLevel level, char direction, const char *data, gpointer user_data);
 
-static GDataFeed *__gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query,
-                                         GType entry_type, GCancellable *cancellable, GDataQueryProgressCallback progress_callback,
-                                         gpointer progress_user_data, GError **error, gboolean is_async);
+typedef struct _QueryFlight QueryFlight;
+static void query_flight_unref (QueryFlight *self);
 
 struct _GDataServicePrivate {
 	SoupSession *session;
 	gchar *locale;
 	GDataAuthorizer *authorizer;
+	GDataCache *cache;
+	GDataConnectionPool *connection_pool;
+	GDataRetryPolicy *retry_policy;
+	GDataRateLimiter *rate_limiter;
+	GDataRequestScheduler *request_scheduler;
+	GDataHedgingPolicy *hedging_policy;
+	gboolean compress_requests;
+	guint compression_threshold;
+	GDataCircuitBreaker *circuit_breaker;
+
+	gboolean coalesce_queries;
+	GMutex flights_mutex; /* protects flights and the state of the QueryFlights in it */
+	GHashTable *flights; /* string key → owned QueryFlight */
 };
 
 enum {
@@ -89,8 +167,25 @@ enum {
 	PROP_TIMEOUT,
 	PROP_LOCALE,
 	PROP_AUTHORIZER,
+	PROP_CACHE,
+	PROP_CONNECTION_POOL,
+	PROP_RETRY_POLICY,
+	PROP_RATE_LIMITER,
+	PROP_COALESCE_QUERIES,
+	PROP_REQUEST_SCHEDULER,
+	PROP_HEDGING_POLICY,
+	PROP_COMPRESS_REQUESTS,
+	PROP_COMPRESSION_THRESHOLD,
+	PROP_CIRCUIT_BREAKER,
 };
 
+enum {
+	SIGNAL_REQUEST_FINISHED,
+	LAST_SIGNAL
+};
+
+static guint service_signals[LAST_SIGNAL] = { 0, };
+
 G_DEFINE_TYPE (GDataService, gdata_service, G_TYPE_OBJECT)
 
 static void
@@ -102,6 +197,7 @@ gdata_service_class_init (GDataServiceClass *klass)
 
 	gobject_class->set_property = gdata_service_set_property;
 	gobject_class->get_property = gdata_service_get_property;
+	gobject_class->constructed = gdata_service_constructed;
 	gobject_class->dispose = gdata_service_dispose;
 	gobject_class->finalize = gdata_service_finalize;
 
@@ -136,6 +232,10 @@ gdata_service_class_init (GDataServiceClass *klass)
 	 *
 	 * Note that if a #GDataAuthorizer is being used with this #GDataService, the authorizer might also need its timeout setting.
 	 *
+	 * The timeout applies to each network request separately, and is shared by all the operations using the service. To bound the total time
+	 * taken by a single operation (including any retries, and all the requests needed to page through a feed or upload a file), pass a
+	 * #GDataDeadlineCancellable to it instead.
+	 *
 	 * Since: 0.7.0
 	 **/
 	g_object_class_install_property (gobject_class, PROP_TIMEOUT,
@@ -186,20 +286,243 @@ gdata_service_class_init (GDataServiceClass *klass)
 	                                                      "Authorizer", "An authorizer object to provide an authorization token for each request.",
 	                                                      GDATA_TYPE_AUTHORIZER,
 	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:cache:
+	 *
+	 * A #GDataCache to store query responses in, or %NULL to not cache responses.
+	 *
+	 * If a cache is set, responses to queries are stored in it (as long as the server gives them an ETag), and subsequent queries for the same
+	 * URI are sent as conditional requests using the cached ETag. If the server replies that the response hasn't been modified, the cached
+	 * response is returned instead of %NULL. See the documentation for #GDataCache for more details.
+	 *
+	 * The cache for a service can be changed at runtime for a different #GDataCache object or %NULL without affecting ongoing queries.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_CACHE,
+	                                 g_param_spec_object ("cache",
+	                                                      "Cache", "A cache to store query responses in.",
+	                                                      GDATA_TYPE_CACHE,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:connection-pool:
+	 *
+	 * The #GDataConnectionPool which the service's network requests are made through. Several services and authorizers can share a connection
+	 * pool so that they re-use each other's connections to the same hosts.
+	 *
+	 * If this isn't set at construction time, the service creates its own private connection pool. Note that #GDataService:proxy-uri and
+	 * #GDataService:timeout are properties of the connection pool, so setting them affects everything which shares it.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_CONNECTION_POOL,
+	                                 g_param_spec_object ("connection-pool",
+	                                                      "Connection pool", "The connection pool which network requests are made through.",
+	                                                      GDATA_TYPE_CONNECTION_POOL,
+	                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:retry-policy:
+	 *
+	 * A #GDataRetryPolicy describing how to retry requests which fail transiently, or %NULL to never retry requests.
+	 *
+	 * The policy applies to all the requests made by the service, including queries, insertions, updates, deletions and batch operations. See the
+	 * documentation for #GDataRetryPolicy for more details.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_RETRY_POLICY,
+	                                 g_param_spec_object ("retry-policy",
+	                                                      "Retry policy", "A policy describing how to retry requests which fail transiently.",
+	                                                      GDATA_TYPE_RETRY_POLICY,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:rate-limiter:
+	 *
+	 * A #GDataRateLimiter to limit the rate at which the service sends requests, or %NULL to send requests as soon as they're made.
+	 *
+	 * Requests which are over their #GDataAuthorizationDomain's budget wait until the limiter lets them through before being sent. The same
+	 * limiter can be set on several services so that they share a quota. See the documentation for #GDataRateLimiter for more details.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_RATE_LIMITER,
+	                                 g_param_spec_object ("rate-limiter",
+	                                                      "Rate limiter", "A limiter for the rate at which requests are sent.",
+	                                                      GDATA_TYPE_RATE_LIMITER,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:coalesce-queries:
+	 *
+	 * Whether identical queries which are made while one of them is still in progress should share its network request.
+	 *
+	 * If this is %TRUE, a query made with gdata_service_query(), gdata_service_query_async(), gdata_service_query_batched_async(),
+	 * gdata_service_query_single_entry() or gdata_service_query_single_entry_async() which has the same URI, #GDataAuthorizationDomain, ETag and
+	 * entry type as a query which is already in progress doesn't send a request of its own. Instead, it waits for the in-progress query's
+	 * response, and parses its own #GDataFeed or #GDataEntry from it, so the results of coalesced queries are never shared. Their progress
+	 * callbacks are called in the same way as for queries which aren't coalesced.
+	 *
+	 * Any of the coalesced queries (including the first one to be made) can be cancelled without affecting the others, and returns promptly if it
+	 * is; the shared request is only cancelled once all the queries waiting on it have been cancelled. A coalesced query whose
+	 * #GDataDeadlineCancellable's deadline passes fails with %G_IO_ERROR_TIMED_OUT, as an uncoalesced one would. A query is only coalesced with an
+	 * in-progress query whose deadline (if it has one) is no earlier than its own, since the shared request is bounded by that deadline.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_COALESCE_QUERIES,
+	                                 g_param_spec_boolean ("coalesce-queries",
+	                                                       "Coalesce queries?", "Whether identical concurrent queries should share a request.",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:request-scheduler:
+	 *
+	 * A #GDataRequestScheduler to bound the number of requests the service has in progress at once and order them by priority, or %NULL to send
+	 * requests as soon as they're made.
+	 *
+	 * The priority of a query is set using #GDataQuery:priority; all other requests have %GDATA_REQUEST_PRIORITY_NORMAL. The same scheduler can be
+	 * set on several services so that they share its limits. See the documentation for #GDataRequestScheduler for more details.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_REQUEST_SCHEDULER,
+	                                 g_param_spec_object ("request-scheduler",
+	                                                      "Request scheduler", "A scheduler to order and bound the requests in progress.",
+	                                                      GDATA_TYPE_REQUEST_SCHEDULER,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:hedging-policy:
+	 *
+	 * A #GDataHedgingPolicy to reduce the tail latency of queries and downloads by sending a duplicate of any request which is slow to receive a
+	 * response, or %NULL to never send duplicate requests.
+	 *
+	 * Only the idempotent <literal>GET</literal> requests made by the gdata_service_query() family of functions and by #GDataDownloadStream are
+	 * hedged. The same policy can be set on several services so that they share its latency estimate and budget. See the documentation for
+	 * #GDataHedgingPolicy for more details.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_HEDGING_POLICY,
+	                                 g_param_spec_object ("hedging-policy",
+	                                                      "Hedging policy", "The policy for hedging slow idempotent requests.",
+	                                                      GDATA_TYPE_HEDGING_POLICY,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:compress-requests:
+	 *
+	 * Whether to compress the bodies of requests which upload entries, using gzip (<literal>Content-Encoding: gzip</literal>). This applies to
+	 * gdata_service_insert_entry(), gdata_service_update_entry(), their asynchronous versions, and gdata_batch_operation_run(). Only bodies of at
+	 * least #GDataService:compression-threshold bytes are compressed.
+	 *
+	 * Entry XML and JSON typically compresses to a fraction of its size, so this can significantly reduce upload times on slow connections, at
+	 * the cost of a little CPU time. Compression is disabled by default, since not all servers accept compressed request bodies.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_COMPRESS_REQUESTS,
+	                                 g_param_spec_boolean ("compress-requests",
+	                                                       "Compress requests?", "Whether to gzip the bodies of requests which upload entries.",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:compression-threshold:
+	 *
+	 * The size, in bytes, below which request bodies are sent uncompressed even if #GDataService:compress-requests is %TRUE. Small bodies barely
+	 * shrink when compressed, so compressing them isn't worth the effort.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_COMPRESSION_THRESHOLD,
+	                                 g_param_spec_uint ("compression-threshold",
+	                                                    "Compression threshold", "The size, in bytes, below which request bodies aren't compressed.",
+	                                                    0, G_MAXUINT, DEFAULT_COMPRESSION_THRESHOLD,
+	                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService:circuit-breaker:
+	 *
+	 * A #GDataCircuitBreaker to make requests fail immediately with %GDATA_SERVICE_ERROR_CIRCUIT_OPEN while the host they're for appears to be
+	 * down, or %NULL to always send requests.
+	 *
+	 * The breaker is consulted before each attempt at sending a request, so retries made according to #GDataService:retry-policy also fail
+	 * immediately once a host's circuit has opened. Requests made by #GDataDownloadStream and #GDataUploadStream, and by a #GDataAuthorizer to log
+	 * in, are not affected. See the documentation for #GDataCircuitBreaker for more details.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_CIRCUIT_BREAKER,
+	                                 g_param_spec_object ("circuit-breaker",
+	                                                      "Circuit breaker", "A circuit breaker to fail requests to unavailable hosts quickly.",
+	                                                      GDATA_TYPE_CIRCUIT_BREAKER,
+	                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataService::request-finished:
+	 * @service: the #GDataService which made the request
+	 * @stats: timings and sizes for the request
+	 *
+	 * The #GDataService::request-finished signal is emitted after each network request made by the service has finished, and its response has
+	 * been parsed (if applicable). @stats gives a breakdown of where the time was spent on the request, and how much data was transferred; it is
+	 * only valid for the duration of the signal emission, so must be copied with gdata_request_stats_copy() if it's needed afterwards.
+	 *
+	 * The signal is emitted from an idle callback in the thread-default main context of the thread which made the request (the global default
+	 * main context if the thread has none), so it's emitted in the same context as the callbacks of asynchronous operations. Handlers for
+	 * requests made by synchronous operations are only called once that main context is next iterated, so a synchronous caller which never
+	 * iterates it will never receive the signal. Until the signal has been emitted, the pending emission holds a reference to the service.
+	 * #GDataDownloadStream and #GDataUploadStream make their requests in threads of their own, so they're reported in the global default main
+	 * context.
+	 *
+	 * Requests are only instrumented while the signal has at least one handler connected, so there is no overhead if it's not used.
+	 *
+	 * Since: 0.15.0
+	 */
+	service_signals[SIGNAL_REQUEST_FINISHED] = g_signal_new ("request-finished",
+	                                                         G_TYPE_FROM_CLASS (klass),
+	                                                         G_SIGNAL_RUN_LAST,
+	                                                         0, NULL, NULL,
+	                                                         g_cclosure_marshal_VOID__BOXED,
+	                                                         G_TYPE_NONE, 1, GDATA_TYPE_REQUEST_STATS | G_SIGNAL_TYPE_STATIC_SCOPE);
 }
 
 static void
 gdata_service_init (GDataService *self)
 {
 	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_SERVICE, GDataServicePrivate);
-	self->priv->session = _gdata_service_build_session ();
+
+	self->priv->compression_threshold = DEFAULT_COMPRESSION_THRESHOLD;
+
+	g_mutex_init (&(self->priv->flights_mutex));
+	self->priv->flights = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) query_flight_unref);
 
 	/* Log handling for all message types except debug */
 	g_log_set_handler (G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_ERROR | G_LOG_LEVEL_INFO | G_LOG_LEVEL_MESSAGE | G_LOG_LEVEL_WARNING, (GLogFunc) debug_handler, self);
+}
+
+static void
+gdata_service_constructed (GObject *object)
+{
+	GDataServicePrivate *priv = GDATA_SERVICE (object)->priv;
+
+	/* Create a private connection pool if we haven't been given one to share */
+	if (priv->connection_pool == NULL)
+		priv->connection_pool = gdata_connection_pool_new ();
+
+	priv->session = g_object_ref (_gdata_connection_pool_get_session (priv->connection_pool));
 
 	/* Proxy the SoupSession's proxy-uri and timeout properties */
-	g_signal_connect (self->priv->session, "notify::proxy-uri", (GCallback) notify_proxy_uri_cb, self);
-	g_signal_connect (self->priv->session, "notify::timeout", (GCallback) notify_timeout_cb, self);
+	g_signal_connect (priv->session, "notify::proxy-uri", (GCallback) notify_proxy_uri_cb, object);
+	g_signal_connect (priv->session, "notify::timeout", (GCallback) notify_timeout_cb, object);
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_service_parent_class)->constructed (object);
 }
 
 static void
@@ -211,10 +534,41 @@ gdata_service_dispose (GObject *object)
 		g_object_unref (priv->authorizer);
 	priv->authorizer = NULL;
 
-	if (priv->session != NULL)
+	if (priv->cache != NULL)
+		g_object_unref (priv->cache);
+	priv->cache = NULL;
+
+	if (priv->retry_policy != NULL)
+		g_object_unref (priv->retry_policy);
+	priv->retry_policy = NULL;
+
+	if (priv->rate_limiter != NULL)
+		g_object_unref (priv->rate_limiter);
+	priv->rate_limiter = NULL;
+
+	if (priv->request_scheduler != NULL)
+		g_object_unref (priv->request_scheduler);
+	priv->request_scheduler = NULL;
+
+	if (priv->hedging_policy != NULL)
+		g_object_unref (priv->hedging_policy);
+	priv->hedging_policy = NULL;
+
+	if (priv->circuit_breaker != NULL)
+		g_object_unref (priv->circuit_breaker);
+	priv->circuit_breaker = NULL;
+
+	/* The session may outlive us if its connection pool is shared */
+	if (priv->session != NULL) {
+		g_signal_handlers_disconnect_by_data (priv->session, object);
 		g_object_unref (priv->session);
+	}
 	priv->session = NULL;
 
+	if (priv->connection_pool != NULL)
+		g_object_unref (priv->connection_pool);
+	priv->connection_pool = NULL;
+
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS (gdata_service_parent_class)->dispose (object);
 }
@@ -226,6 +580,10 @@ gdata_service_finalize (GObject *object)
 
 	g_free (priv->locale);
 
+	/* Every flight holds a reference to us, so there can't be any left */
+	g_hash_table_unref (priv->flights);
+	g_mutex_clear (&(priv->flights_mutex));
+
 	/* Chain up to the parent class */
 	G_OBJECT_CLASS (gdata_service_parent_class)->finalize (object);
 }
@@ -248,6 +606,36 @@ gdata_service_get_property (GObject *object, guint property_id, GValue *value, G
 		case PROP_AUTHORIZER:
 			g_value_set_object (value, priv->authorizer);
 			break;
+		case PROP_CACHE:
+			g_value_set_object (value, priv->cache);
+			break;
+		case PROP_CONNECTION_POOL:
+			g_value_set_object (value, priv->connection_pool);
+			break;
+		case PROP_RETRY_POLICY:
+			g_value_set_object (value, priv->retry_policy);
+			break;
+		case PROP_RATE_LIMITER:
+			g_value_set_object (value, priv->rate_limiter);
+			break;
+		case PROP_COALESCE_QUERIES:
+			g_value_set_boolean (value, priv->coalesce_queries);
+			break;
+		case PROP_REQUEST_SCHEDULER:
+			g_value_set_object (value, priv->request_scheduler);
+			break;
+		case PROP_HEDGING_POLICY:
+			g_value_set_object (value, priv->hedging_policy);
+			break;
+		case PROP_COMPRESS_REQUESTS:
+			g_value_set_boolean (value, priv->compress_requests);
+			break;
+		case PROP_COMPRESSION_THRESHOLD:
+			g_value_set_uint (value, priv->compression_threshold);
+			break;
+		case PROP_CIRCUIT_BREAKER:
+			g_value_set_object (value, priv->circuit_breaker);
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -271,6 +659,37 @@ gdata_service_set_property (GObject *object, guint property_id, const GValue *va
 		case PROP_AUTHORIZER:
 			gdata_service_set_authorizer (GDATA_SERVICE (object), g_value_get_object (value));
 			break;
+		case PROP_CACHE:
+			gdata_service_set_cache (GDATA_SERVICE (object), g_value_get_object (value));
+			break;
+		case PROP_CONNECTION_POOL:
+			/* Construct only */
+			GDATA_SERVICE (object)->priv->connection_pool = g_value_dup_object (value);
+			break;
+		case PROP_RETRY_POLICY:
+			gdata_service_set_retry_policy (GDATA_SERVICE (object), g_value_get_object (value));
+			break;
+		case PROP_RATE_LIMITER:
+			gdata_service_set_rate_limiter (GDATA_SERVICE (object), g_value_get_object (value));
+			break;
+		case PROP_COALESCE_QUERIES:
+			gdata_service_set_coalesce_queries (GDATA_SERVICE (object), g_value_get_boolean (value));
+			break;
+		case PROP_REQUEST_SCHEDULER:
+			gdata_service_set_request_scheduler (GDATA_SERVICE (object), g_value_get_object (value));
+			break;
+		case PROP_HEDGING_POLICY:
+			gdata_service_set_hedging_policy (GDATA_SERVICE (object), g_value_get_object (value));
+			break;
+		case PROP_COMPRESS_REQUESTS:
+			gdata_service_set_compress_requests (GDATA_SERVICE (object), g_value_get_boolean (value));
+			break;
+		case PROP_COMPRESSION_THRESHOLD:
+			gdata_service_set_compression_threshold (GDATA_SERVICE (object), g_value_get_uint (value));
+			break;
+		case PROP_CIRCUIT_BREAKER:
+			gdata_service_set_circuit_breaker (GDATA_SERVICE (object), g_value_get_object (value));
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -502,232 +921,2279 @@ gdata_service_set_authorizer (GDataService *self, GDataAuthorizer *authorizer)
 }
 
 /**
- * gdata_service_get_authorization_domains:
- * @service_type: the #GType of the #GDataService subclass to retrieve the authorization domains for
- *
- * Retrieves the full list of #GDataAuthorizationDomain<!-- -->s which relate to the specified @service_type. All the
- * #GDataAuthorizationDomain<!-- -->s are unique and interned, so can be compared with other domains by simple pointer comparison.
+ * gdata_service_get_cache:
+ * @self: a #GDataService
  *
- * Note that in addition to this method, #GDataService subclasses may expose some or all of their authorization domains individually by means of
- * individual accessor functions.
+ * Gets the #GDataCache object currently in use by the service. See the documentation for #GDataService:cache for more details.
  *
- * Return value: (transfer container) (element-type GDataAuthorizationDomain): an unordered list of #GDataAuthorizationDomain<!-- -->s; free with
- * g_list_free()
+ * Return value: (transfer none) (allow-none): the cache object for this service, or %NULL
  *
- * Since: 0.9.0
+ * Since: 0.15.0
  */
-GList *
-gdata_service_get_authorization_domains (GType service_type)
+GDataCache *
+gdata_service_get_cache (GDataService *self)
 {
-	GDataServiceClass *klass;
-	GList *domains = NULL;
-
-	g_return_val_if_fail (g_type_is_a (service_type, GDATA_TYPE_SERVICE), NULL);
-
-	klass = GDATA_SERVICE_CLASS (g_type_class_ref (service_type));
-	if (klass->get_authorization_domains != NULL) {
-		domains = klass->get_authorization_domains ();
-	}
-	g_type_class_unref (klass);
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
 
-	return domains;
+	return self->priv->cache;
 }
 
-SoupMessage *
-_gdata_service_build_message (GDataService *self, GDataAuthorizationDomain *domain, const gchar *method, const gchar *uri,
-                              const gchar *etag, gboolean etag_if_match)
+/**
+ * gdata_service_set_cache:
+ * @self: a #GDataService
+ * @cache: (allow-none): a new cache object for the service, or %NULL
+ *
+ * Sets #GDataService:cache to @cache. This may be %NULL if the service should no longer cache query responses. Queries which are already in
+ * progress continue to use the previous cache.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_cache (GDataService *self, GDataCache *cache)
 {
-	SoupMessage *message;
-	GDataServiceClass *klass;
-	SoupURI *_uri;
+	GDataServicePrivate *priv = self->priv;
 
-	/* Create the message. Allow changing the HTTPS port just for testing. */
-	_uri = soup_uri_new (uri);
-	soup_uri_set_port (_uri, _gdata_service_get_https_port ());
-	message = soup_message_new_from_uri (method, _uri);
-	soup_uri_free (_uri);
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (cache == NULL || GDATA_IS_CACHE (cache));
 
-	/* Make sure subclasses set their headers */
-	klass = GDATA_SERVICE_GET_CLASS (self);
-	if (klass->append_query_headers != NULL)
-		klass->append_query_headers (self, domain, message);
+	if (cache != NULL) {
+		g_object_ref (cache);
+	}
 
-	/* Append the ETag header if possible */
-	if (etag != NULL)
-		soup_message_headers_append (message->request_headers, (etag_if_match == TRUE) ? "If-Match" : "If-None-Match", etag);
+	if (priv->cache != NULL) {
+		g_object_unref (priv->cache);
+	}
 
-	return message;
-}
+	priv->cache = cache;
 
-typedef struct {
-	GMutex mutex; /* mutex to prevent cancellation before the message has been added to the session's message queue */
-	SoupSession *session;
-	SoupMessage *message;
-} MessageData;
+	g_object_notify (G_OBJECT (self), "cache");
+}
 
-static void
-message_cancel_cb (GCancellable *cancellable, MessageData *data)
+/**
+ * gdata_service_get_connection_pool:
+ * @self: a #GDataService
+ *
+ * Gets the #GDataConnectionPool which the service's network requests are made through. See #GDataService:connection-pool for more details.
+ *
+ * Return value: (transfer none): the #GDataConnectionPool used by the service
+ *
+ * Since: 0.15.0
+ */
+GDataConnectionPool *
+gdata_service_get_connection_pool (GDataService *self)
 {
-	g_mutex_lock (&(data->mutex));
-	soup_session_cancel_message (data->session, data->message, SOUP_STATUS_CANCELLED);
-	g_mutex_unlock (&(data->mutex));
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
+	return self->priv->connection_pool;
 }
 
-static void
-message_request_queued_cb (SoupSession *session, SoupMessage *message, MessageData *data)
+/**
+ * gdata_service_get_retry_policy:
+ * @self: a #GDataService
+ *
+ * Gets the #GDataRetryPolicy currently in use by the service. See the documentation for #GDataService:retry-policy for more details.
+ *
+ * Return value: (transfer none) (allow-none): the retry policy for this service, or %NULL
+ *
+ * Since: 0.15.0
+ */
+GDataRetryPolicy *
+gdata_service_get_retry_policy (GDataService *self)
 {
-	if (message == data->message) {
-		g_mutex_unlock (&(data->mutex));
-	}
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
+
+	return self->priv->retry_policy;
 }
 
-/* Synchronously send @message via @service, handling asynchronous cancellation as best we can. If @cancellable has been cancelled before we start
- * network activity, return without doing any network activity. Otherwise, if @cancellable is cancelled (from another thread) after network activity
- * has started, we wait until the message has been queued by the session, then cancel the network activity and return as soon as possible.
+/**
+ * gdata_service_set_retry_policy:
+ * @self: a #GDataService
+ * @retry_policy: (allow-none): a new retry policy for the service, or %NULL
  *
- * If cancellation has been handled, @error is guaranteed to be set to %G_IO_ERROR_CANCELLED. Otherwise, @error is guaranteed to be unset. */
+ * Sets #GDataService:retry-policy to @retry_policy. This may be %NULL if the service should no longer retry requests which fail transiently.
+ *
+ * Since: 0.15.0
+ */
 void
-_gdata_service_actually_send_message (SoupSession *session, SoupMessage *message, GCancellable *cancellable, GError **error)
+gdata_service_set_retry_policy (GDataService *self, GDataRetryPolicy *retry_policy)
 {
-	MessageData data;
-	gulong cancel_signal = 0, request_queued_signal = 0;
+	GDataServicePrivate *priv = self->priv;
 
-	/* Hold references to the session and message so they can't be freed by other threads. For example, if the SoupSession was freed by another
-	 * thread while we were making a request, the request would be unexpectedly cancelled. See bgo#650835 for an example of this breaking things.
-	 */
-	g_object_ref (session);
-	g_object_ref (message);
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (retry_policy == NULL || GDATA_IS_RETRY_POLICY (retry_policy));
 
-	/* Listen for cancellation */
-	if (cancellable != NULL) {
-		g_mutex_init (&(data.mutex));
-		data.session = session;
-		data.message = message;
+	if (retry_policy != NULL) {
+		g_object_ref (retry_policy);
+	}
 
-		cancel_signal = g_cancellable_connect (cancellable, (GCallback) message_cancel_cb, &data, NULL);
-		request_queued_signal = g_signal_connect (session, "request-queued", (GCallback) message_request_queued_cb, &data);
+	if (priv->retry_policy != NULL) {
+		g_object_unref (priv->retry_policy);
+	}
 
-		/* We lock this mutex until the message has been queued by the session (i.e. it's unlocked in the request-queued callback), and require
-		 * the mutex to be held to cancel the message. Consequently, if the message is cancelled (in another thread) any time between this lock
-		 * and the request being queued, the cancellation will wait until the request has been queued before taking effect.
-		 * This is a little ugly, but is the only way I can think of to avoid a race condition between calling soup_session_cancel_message()
-		 * and soup_session_send_message(), as the former doesn't have any effect until the request has been queued, and once the latter has
-		 * returned, all network activity has been finished so cancellation is pointless. */
-		g_mutex_lock (&(data.mutex));
+	priv->retry_policy = retry_policy;
+
+	g_object_notify (G_OBJECT (self), "retry-policy");
+}
+
+/**
+ * gdata_service_get_rate_limiter:
+ * @self: a #GDataService
+ *
+ * Gets the #GDataRateLimiter currently in use by the service. See the documentation for #GDataService:rate-limiter for more details.
+ *
+ * Return value: (transfer none) (allow-none): the rate limiter for this service, or %NULL
+ *
+ * Since: 0.15.0
+ */
+GDataRateLimiter *
+gdata_service_get_rate_limiter (GDataService *self)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
+
+	return self->priv->rate_limiter;
+}
+
+/**
+ * gdata_service_set_rate_limiter:
+ * @self: a #GDataService
+ * @rate_limiter: (allow-none): a new rate limiter for the service, or %NULL
+ *
+ * Sets #GDataService:rate-limiter to @rate_limiter. This may be %NULL if the service should no longer limit the rate at which it sends requests.
+ * Requests which are already waiting for the old rate limiter continue to wait.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_rate_limiter (GDataService *self, GDataRateLimiter *rate_limiter)
+{
+	GDataServicePrivate *priv = self->priv;
+
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (rate_limiter == NULL || GDATA_IS_RATE_LIMITER (rate_limiter));
+
+	if (rate_limiter != NULL) {
+		g_object_ref (rate_limiter);
 	}
 
-	/* Only send the message if it hasn't already been cancelled. There is no race condition here for the above reasons: if the cancellable has
-	 * been cancelled, it's because it was cancelled before we called g_cancellable_connect().
-	 *
-	 * Otherwise, manually set the message's status code to SOUP_STATUS_CANCELLED, as the message was cancelled before even being queued to be
-	 * sent. */
-	if (cancellable == NULL || g_cancellable_is_cancelled (cancellable) == FALSE)
-		soup_session_send_message (session, message);
-	else
-		soup_message_set_status (message, SOUP_STATUS_CANCELLED);
+	if (priv->rate_limiter != NULL) {
+		g_object_unref (priv->rate_limiter);
+	}
 
-	/* Clean up the cancellation code */
-	if (cancellable != NULL) {
-		g_signal_handler_disconnect (session, request_queued_signal);
+	priv->rate_limiter = rate_limiter;
 
-		if (cancel_signal != 0)
-			g_cancellable_disconnect (cancellable, cancel_signal);
+	g_object_notify (G_OBJECT (self), "rate-limiter");
+}
 
-		g_mutex_clear (&(data.mutex));
+/**
+ * gdata_service_get_coalesce_queries:
+ * @self: a #GDataService
+ *
+ * Gets the value of #GDataService:coalesce-queries.
+ *
+ * Return value: %TRUE if identical concurrent queries share a request, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_service_get_coalesce_queries (GDataService *self)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), FALSE);
+
+	return self->priv->coalesce_queries;
+}
+
+/**
+ * gdata_service_set_coalesce_queries:
+ * @self: a #GDataService
+ * @coalesce_queries: %TRUE to make identical concurrent queries share a request, %FALSE otherwise
+ *
+ * Sets #GDataService:coalesce-queries to @coalesce_queries. Queries which are already in progress are unaffected.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_coalesce_queries (GDataService *self, gboolean coalesce_queries)
+{
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+
+	self->priv->coalesce_queries = coalesce_queries;
+	g_object_notify (G_OBJECT (self), "coalesce-queries");
+}
+
+/**
+ * gdata_service_get_request_scheduler:
+ * @self: a #GDataService
+ *
+ * Gets the #GDataRequestScheduler currently in use by the service. See the documentation for #GDataService:request-scheduler for more details.
+ *
+ * Return value: (transfer none) (allow-none): the request scheduler for this service, or %NULL
+ *
+ * Since: 0.15.0
+ */
+GDataRequestScheduler *
+gdata_service_get_request_scheduler (GDataService *self)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
+
+	return self->priv->request_scheduler;
+}
+
+/**
+ * gdata_service_set_request_scheduler:
+ * @self: a #GDataService
+ * @request_scheduler: (allow-none): a new request scheduler for the service, or %NULL
+ *
+ * Sets #GDataService:request-scheduler to @request_scheduler. This may be %NULL if the service should no longer schedule its requests. Requests
+ * which are already waiting for the old scheduler continue to wait.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_request_scheduler (GDataService *self, GDataRequestScheduler *request_scheduler)
+{
+	GDataServicePrivate *priv = self->priv;
+
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (request_scheduler == NULL || GDATA_IS_REQUEST_SCHEDULER (request_scheduler));
+
+	if (request_scheduler != NULL) {
+		g_object_ref (request_scheduler);
 	}
 
-	/* Set the cancellation error if applicable. We can't assume that our GCancellable has been cancelled just because the message has;
-	 * libsoup may internally cancel messages if, for example, the proxy URI of the SoupSession is changed.
-	 * libsoup also sometimes seems to return a SOUP_STATUS_IO_ERROR when we cancel a message, even though we've specified SOUP_STATUS_CANCELLED
-	 * at cancellation time. Ho Hum. */
-	g_assert (message->status_code != SOUP_STATUS_NONE);
+	if (priv->request_scheduler != NULL) {
+		g_object_unref (priv->request_scheduler);
+	}
 
-	if (message->status_code == SOUP_STATUS_CANCELLED ||
-	    ((message->status_code == SOUP_STATUS_IO_ERROR || message->status_code == SOUP_STATUS_SSL_FAILED ||
-	      message->status_code == SOUP_STATUS_CANT_CONNECT || message->status_code == SOUP_STATUS_CANT_RESOLVE) &&
-	     cancellable != NULL && g_cancellable_is_cancelled (cancellable) == TRUE)) {
-		/* We hackily create and cancel a new GCancellable so that we can set the error using it and therefore save ourselves a translatable
-		 * string and the associated maintenance. */
-		GCancellable *error_cancellable = g_cancellable_new ();
-		g_cancellable_cancel (error_cancellable);
-		g_assert (g_cancellable_set_error_if_cancelled (error_cancellable, error) == TRUE);
-		g_object_unref (error_cancellable);
+	priv->request_scheduler = request_scheduler;
 
-		/* As per the above comment, force the status to be SOUP_STATUS_CANCELLED. */
-		soup_message_set_status (message, SOUP_STATUS_CANCELLED);
+	g_object_notify (G_OBJECT (self), "request-scheduler");
+}
+
+/**
+ * gdata_service_get_hedging_policy:
+ * @self: a #GDataService
+ *
+ * Gets the #GDataHedgingPolicy currently in use by the service. See the documentation for #GDataService:hedging-policy for more details.
+ *
+ * Return value: (transfer none) (allow-none): the hedging policy for this service, or %NULL
+ *
+ * Since: 0.15.0
+ */
+GDataHedgingPolicy *
+gdata_service_get_hedging_policy (GDataService *self)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
+
+	return self->priv->hedging_policy;
+}
+
+/**
+ * gdata_service_set_hedging_policy:
+ * @self: a #GDataService
+ * @hedging_policy: (allow-none): a new hedging policy for the service, or %NULL
+ *
+ * Sets #GDataService:hedging-policy to @hedging_policy. This may be %NULL if the service should no longer hedge its requests. Requests which have
+ * already been sent continue to use the old policy.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_hedging_policy (GDataService *self, GDataHedgingPolicy *hedging_policy)
+{
+	GDataServicePrivate *priv = self->priv;
+
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (hedging_policy == NULL || GDATA_IS_HEDGING_POLICY (hedging_policy));
+
+	if (hedging_policy != NULL) {
+		g_object_ref (hedging_policy);
 	}
 
-	/* Free things */
-	g_object_unref (message);
-	g_object_unref (session);
+	if (priv->hedging_policy != NULL) {
+		g_object_unref (priv->hedging_policy);
+	}
+
+	priv->hedging_policy = hedging_policy;
+
+	g_object_notify (G_OBJECT (self), "hedging-policy");
+}
+
+/**
+ * gdata_service_get_compress_requests:
+ * @self: a #GDataService
+ *
+ * Gets the value of #GDataService:compress-requests.
+ *
+ * Return value: %TRUE if large request bodies are compressed, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_service_get_compress_requests (GDataService *self)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), FALSE);
+
+	return self->priv->compress_requests;
+}
+
+/**
+ * gdata_service_set_compress_requests:
+ * @self: a #GDataService
+ * @compress_requests: %TRUE to compress large request bodies, %FALSE otherwise
+ *
+ * Sets #GDataService:compress-requests to @compress_requests. Requests which have already been built are unaffected.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_compress_requests (GDataService *self, gboolean compress_requests)
+{
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+
+	self->priv->compress_requests = compress_requests;
+	g_object_notify (G_OBJECT (self), "compress-requests");
 }
 
+/**
+ * gdata_service_get_compression_threshold:
+ * @self: a #GDataService
+ *
+ * Gets the value of #GDataService:compression-threshold.
+ *
+ * Return value: the size, in bytes, below which request bodies aren't compressed
+ *
+ * Since: 0.15.0
+ */
 guint
-_gdata_service_send_message (GDataService *self, SoupMessage *message, GCancellable *cancellable, GError **error)
+gdata_service_get_compression_threshold (GDataService *self)
 {
-	/* Based on code from evolution-data-server's libgdata:
-	 *  Ebby Wiselyn <ebbywiselyn@gmail.com>
-	 *  Jason Willis <zenbrother@gmail.com>
-	 *
-	 * Copyright (C) 1999-2008 Novell, Inc. (www.novell.com)
-	 */
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), DEFAULT_COMPRESSION_THRESHOLD);
 
-	soup_message_set_flags (message, SOUP_MESSAGE_NO_REDIRECT);
-	_gdata_service_actually_send_message (self->priv->session, message, cancellable, error);
-	soup_message_set_flags (message, 0);
+	return self->priv->compression_threshold;
+}
 
-	/* Handle redirections specially so we don't lose our custom headers when making the second request */
-	if (SOUP_STATUS_IS_REDIRECTION (message->status_code)) {
-		SoupURI *new_uri;
-		const gchar *new_location;
+/**
+ * gdata_service_set_compression_threshold:
+ * @self: a #GDataService
+ * @compression_threshold: the size, in bytes, below which request bodies aren't compressed
+ *
+ * Sets #GDataService:compression-threshold to @compression_threshold.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_compression_threshold (GDataService *self, guint compression_threshold)
+{
+	g_return_if_fail (GDATA_IS_SERVICE (self));
 
-		new_location = soup_message_headers_get_one (message->response_headers, "Location");
-		g_return_val_if_fail (new_location != NULL, SOUP_STATUS_NONE);
+	self->priv->compression_threshold = compression_threshold;
+	g_object_notify (G_OBJECT (self), "compression-threshold");
+}
 
-		new_uri = soup_uri_new_with_base (soup_message_get_uri (message), new_location);
-		if (new_uri == NULL) {
-			gchar *uri_string = soup_uri_to_string (new_uri, FALSE);
-			g_set_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR,
-			             /* Translators: the parameter is the URI which is invalid. */
-			             _("Invalid redirect URI: %s"), uri_string);
-			g_free (uri_string);
-			return SOUP_STATUS_NONE;
-		}
+/**
+ * gdata_service_get_circuit_breaker:
+ * @self: a #GDataService
+ *
+ * Gets the #GDataCircuitBreaker currently in use by the service. See the documentation for #GDataService:circuit-breaker for more details.
+ *
+ * Return value: (transfer none) (allow-none): the circuit breaker for this service, or %NULL
+ *
+ * Since: 0.15.0
+ */
+GDataCircuitBreaker *
+gdata_service_get_circuit_breaker (GDataService *self)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
+
+	return self->priv->circuit_breaker;
+}
+
+/**
+ * gdata_service_set_circuit_breaker:
+ * @self: a #GDataService
+ * @circuit_breaker: (allow-none): a new circuit breaker for the service, or %NULL
+ *
+ * Sets #GDataService:circuit-breaker to @circuit_breaker. This may be %NULL if the service should no longer break circuits. Requests which have
+ * already been built continue to use the old circuit breaker.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_set_circuit_breaker (GDataService *self, GDataCircuitBreaker *circuit_breaker)
+{
+	GDataServicePrivate *priv = self->priv;
+
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (circuit_breaker == NULL || GDATA_IS_CIRCUIT_BREAKER (circuit_breaker));
+
+	if (circuit_breaker != NULL) {
+		g_object_ref (circuit_breaker);
+	}
+
+	if (priv->circuit_breaker != NULL) {
+		g_object_unref (priv->circuit_breaker);
+	}
+
+	priv->circuit_breaker = circuit_breaker;
+
+	g_object_notify (G_OBJECT (self), "circuit-breaker");
+}
+
+/**
+ * gdata_service_get_authorization_domains:
+ * @service_type: the #GType of the #GDataService subclass to retrieve the authorization domains for
+ *
+ * Retrieves the full list of #GDataAuthorizationDomain<!-- -->s which relate to the specified @service_type. All the
+ * #GDataAuthorizationDomain<!-- -->s are unique and interned, so can be compared with other domains by simple pointer comparison.
+ *
+ * Note that in addition to this method, #GDataService subclasses may expose some or all of their authorization domains individually by means of
+ * individual accessor functions.
+ *
+ * Return value: (transfer container) (element-type GDataAuthorizationDomain): an unordered list of #GDataAuthorizationDomain<!-- -->s; free with
+ * g_list_free()
+ *
+ * Since: 0.9.0
+ */
+GList *
+gdata_service_get_authorization_domains (GType service_type)
+{
+	GDataServiceClass *klass;
+	GList *domains = NULL;
+
+	g_return_val_if_fail (g_type_is_a (service_type, GDATA_TYPE_SERVICE), NULL);
+
+	klass = GDATA_SERVICE_CLASS (g_type_class_ref (service_type));
+	if (klass->get_authorization_domains != NULL) {
+		domains = klass->get_authorization_domains ();
+	}
+	g_type_class_unref (klass);
+
+	return domains;
+}
+
+SoupMessage *
+_gdata_service_build_message (GDataService *self, GDataAuthorizationDomain *domain, const gchar *method, const gchar *uri,
+                              const gchar *etag, gboolean etag_if_match)
+{
+	SoupMessage *message;
+	GDataServiceClass *klass;
+	SoupURI *_uri;
+
+	/* Create the message. Allow changing the HTTPS port just for testing. */
+	_uri = soup_uri_new (uri);
+	soup_uri_set_port (_uri, _gdata_service_get_https_port ());
+	message = soup_message_new_from_uri (method, _uri);
+	soup_uri_free (_uri);
+
+	/* Make sure subclasses set their headers */
+	klass = GDATA_SERVICE_GET_CLASS (self);
+	if (klass->append_query_headers != NULL)
+		klass->append_query_headers (self, domain, message);
+
+	/* Append the ETag header if possible */
+	if (etag != NULL)
+		soup_message_headers_append (message->request_headers, (etag_if_match == TRUE) ? "If-Match" : "If-None-Match", etag);
+
+	_gdata_service_attach_circuit_breaker (self, message);
+
+	return message;
+}
+
+/* Compress @length bytes of @data into @message's request body with gzip, a chunk at a time so that only the compressed data is duplicated. */
+static gboolean
+set_compressed_request_body (SoupMessage *message, const gchar *data, gsize length)
+{
+	GConverter *compressor;
+	GConverterResult result;
+	guint8 buffer[COMPRESSION_CHUNK_SIZE];
+	gsize bytes_read, bytes_written;
+	GError *error = NULL;
+
+	compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+
+	do {
+		result = g_converter_convert (compressor, data, length, buffer, sizeof (buffer), G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written,
+		                              &error);
+
+		if (result == G_CONVERTER_ERROR) {
+			g_debug ("Error compressing request body; sending it uncompressed: %s", error->message);
+			g_error_free (error);
+
+			soup_message_body_truncate (message->request_body);
+			g_object_unref (compressor);
+
+			return FALSE;
+		}
+
+		soup_message_body_append (message->request_body, SOUP_MEMORY_COPY, buffer, bytes_written);
+		data += bytes_read;
+		length -= bytes_read;
+	} while (result != G_CONVERTER_FINISHED);
+
+	g_object_unref (compressor);
+
+	return TRUE;
+}
+
+/*
+ * _gdata_service_set_request_body:
+ * @self: a #GDataService
+ * @message: a #SoupMessage
+ * @content_type: the MIME type of @data
+ * @data: (transfer full): the request body; freed with g_free()
+ * @length: the length of @data, in bytes
+ *
+ * Sets the request body of @message to @data, as soup_message_set_request() does. If #GDataService:compress-requests is %TRUE and @data is at least
+ * #GDataService:compression-threshold bytes long, it's compressed with gzip and the <literal>Content-Encoding</literal> header is set.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_service_set_request_body (GDataService *self, SoupMessage *message, const gchar *content_type, gchar *data, gsize length)
+{
+	if (self->priv->compress_requests == TRUE && length >= self->priv->compression_threshold &&
+	    set_compressed_request_body (message, data, length) == TRUE) {
+		soup_message_headers_replace (message->request_headers, "Content-Type", content_type);
+		soup_message_headers_replace (message->request_headers, "Content-Encoding", "gzip");
+		g_free (data);
+
+		return;
+	}
+
+	soup_message_set_request (message, content_type, SOUP_MEMORY_TAKE, data, length);
+}
+
+typedef struct {
+	GMutex mutex; /* mutex to prevent cancellation before the message has been added to the session's message queue */
+	SoupSession *session;
+	SoupMessage *message;
+} MessageData;
+
+static void
+message_cancel_cb (GCancellable *cancellable, MessageData *data)
+{
+	g_mutex_lock (&(data->mutex));
+	_gdata_hedging_policy_cancel_message (data->session, data->message);
+	g_mutex_unlock (&(data->mutex));
+}
+
+static void
+message_request_queued_cb (SoupSession *session, SoupMessage *message, MessageData *data)
+{
+	if (message == data->message) {
+		g_mutex_unlock (&(data->mutex));
+	}
+}
+
+/* Check whether @message's circuit breaker (if it has one) allows it to be sent to its host. If not, set @message's status to SOUP_STATUS_NONE and
+ * set @error to GDATA_SERVICE_ERROR_CIRCUIT_OPEN, as for other errors which are detected before a response is received. */
+static gboolean
+circuit_breaker_allows_message (SoupMessage *message, GError **error)
+{
+	GDataCircuitBreaker *circuit_breaker;
+	const gchar *host;
+
+	circuit_breaker = g_object_get_data (G_OBJECT (message), "gdata-circuit-breaker");
+	if (circuit_breaker == NULL)
+		return TRUE;
+
+	host = soup_message_get_uri (message)->host;
+	if (_gdata_circuit_breaker_allow (circuit_breaker, host) == TRUE)
+		return TRUE;
+
+	soup_message_set_status (message, SOUP_STATUS_NONE);
+	g_set_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_CIRCUIT_OPEN,
+	             /* Translators: the parameter is a host name, such as "www.google.com". */
+	             _("Not sending the request because %s is unavailable."), host);
+
+	return FALSE;
+}
+
+/* Report the outcome of sending @message to its circuit breaker (if it has one), counting it as cancelled if @cancellable has been cancelled. */
+static void
+circuit_breaker_report_message (SoupMessage *message, GCancellable *cancellable)
+{
+	GDataCircuitBreaker *circuit_breaker;
+	guint status;
+
+	circuit_breaker = g_object_get_data (G_OBJECT (message), "gdata-circuit-breaker");
+	if (circuit_breaker == NULL)
+		return;
+
+	status = (cancellable != NULL && g_cancellable_is_cancelled (cancellable) == TRUE) ? SOUP_STATUS_CANCELLED : message->status_code;
+	_gdata_circuit_breaker_report (circuit_breaker, soup_message_get_uri (message)->host, status);
+}
+
+/* Synchronously send @message via @service, handling asynchronous cancellation as best we can. If @cancellable has been cancelled before we start
+ * network activity, return without doing any network activity. Otherwise, if @cancellable is cancelled (from another thread) after network activity
+ * has started, we wait until the message has been queued by the session, then cancel the network activity and return as soon as possible.
+ *
+ * If cancellation has been handled, @error is guaranteed to be set to %G_IO_ERROR_CANCELLED. If @message's circuit breaker didn't allow it to be sent,
+ * its status is set to %SOUP_STATUS_NONE and @error is set to %GDATA_SERVICE_ERROR_CIRCUIT_OPEN. Otherwise, @error is guaranteed to be unset. */
+void
+_gdata_service_actually_send_message (SoupSession *session, SoupMessage *message, GCancellable *cancellable, GError **error)
+{
+	MessageData data;
+	gulong cancel_signal = 0, request_queued_signal = 0;
+
+	/* Fail fast if the message's host appears to be down */
+	if (circuit_breaker_allows_message (message, error) == FALSE)
+		return;
+
+	/* Hold references to the session and message so they can't be freed by other threads. For example, if the SoupSession was freed by another
+	 * thread while we were making a request, the request would be unexpectedly cancelled. See bgo#650835 for an example of this breaking things.
+	 */
+	g_object_ref (session);
+	g_object_ref (message);
+
+	/* Listen for cancellation */
+	if (cancellable != NULL) {
+		g_mutex_init (&(data.mutex));
+		data.session = session;
+		data.message = message;
+
+		cancel_signal = g_cancellable_connect (cancellable, (GCallback) message_cancel_cb, &data, NULL);
+		request_queued_signal = g_signal_connect (session, "request-queued", (GCallback) message_request_queued_cb, &data);
+
+		/* We lock this mutex until the message has been queued by the session (i.e. it's unlocked in the request-queued callback), and require
+		 * the mutex to be held to cancel the message. Consequently, if the message is cancelled (in another thread) any time between this lock
+		 * and the request being queued, the cancellation will wait until the request has been queued before taking effect.
+		 * This is a little ugly, but is the only way I can think of to avoid a race condition between calling soup_session_cancel_message()
+		 * and soup_session_send_message(), as the former doesn't have any effect until the request has been queued, and once the latter has
+		 * returned, all network activity has been finished so cancellation is pointless. */
+		g_mutex_lock (&(data.mutex));
+	}
+
+	/* Only send the message if it hasn't already been cancelled. There is no race condition here for the above reasons: if the cancellable has
+	 * been cancelled, it's because it was cancelled before we called g_cancellable_connect().
+	 *
+	 * Otherwise, manually set the message's status code to SOUP_STATUS_CANCELLED, as the message was cancelled before even being queued to be
+	 * sent. */
+	if (cancellable == NULL || g_cancellable_is_cancelled (cancellable) == FALSE) {
+		GDataHedgingPolicy *hedging_policy = g_object_get_data (G_OBJECT (message), "gdata-hedging-policy");
+
+		GDATA_TRACE_REQUEST_START (message);
+
+		if (hedging_policy != NULL)
+			_gdata_hedging_policy_send_message (hedging_policy, session, message);
+		else
+			soup_session_send_message (session, message);
+	} else
+		soup_message_set_status (message, SOUP_STATUS_CANCELLED);
+
+	/* Clean up the cancellation code */
+	if (cancellable != NULL) {
+		g_signal_handler_disconnect (session, request_queued_signal);
+
+		if (cancel_signal != 0)
+			g_cancellable_disconnect (cancellable, cancel_signal);
+
+		g_mutex_clear (&(data.mutex));
+	}
+
+	/* Set the cancellation error if applicable. We can't assume that our GCancellable has been cancelled just because the message has;
+	 * libsoup may internally cancel messages if, for example, the proxy URI of the SoupSession is changed.
+	 * libsoup also sometimes seems to return a SOUP_STATUS_IO_ERROR when we cancel a message, even though we've specified SOUP_STATUS_CANCELLED
+	 * at cancellation time. Ho Hum. */
+	g_assert (message->status_code != SOUP_STATUS_NONE);
+
+	if (message->status_code == SOUP_STATUS_CANCELLED ||
+	    ((message->status_code == SOUP_STATUS_IO_ERROR || message->status_code == SOUP_STATUS_SSL_FAILED ||
+	      message->status_code == SOUP_STATUS_CANT_CONNECT || message->status_code == SOUP_STATUS_CANT_RESOLVE) &&
+	     cancellable != NULL && g_cancellable_is_cancelled (cancellable) == TRUE)) {
+		/* If @cancellable was cancelled because its deadline passed, report a timeout. Otherwise, we hackily create and cancel a new
+		 * GCancellable so that we can set the error using it and therefore save ourselves a translatable string and the associated
+		 * maintenance. */
+		if (_gdata_deadline_cancellable_set_error_if_expired (cancellable, error) == FALSE) {
+			GCancellable *error_cancellable = g_cancellable_new ();
+			g_cancellable_cancel (error_cancellable);
+			g_assert (g_cancellable_set_error_if_cancelled (error_cancellable, error) == TRUE);
+			g_object_unref (error_cancellable);
+		}
+
+		/* As per the above comment, force the status to be SOUP_STATUS_CANCELLED. */
+		soup_message_set_status (message, SOUP_STATUS_CANCELLED);
+	}
+
+	circuit_breaker_report_message (message, cancellable);
+
+	GDATA_TRACE_REQUEST_END (message);
+
+	/* Free things */
+	g_object_unref (message);
+	g_object_unref (session);
+}
+
+/* Instrumentation state for a single request, attached to its SoupMessage while the GDataService::request-finished signal has handlers. The
+ * signal is emitted once the message is finalised, so that the time taken to parse the response can be included. Since that can happen in any
+ * thread, the emission is done in an idle source in the main context which was the thread default when the request was made. */
+typedef struct {
+	GDataService *service;
+	GMainContext *context;
+	GDataRequestStats stats;
+
+	/* Start times of the phases in progress */
+	gint64 resolving_time;
+	gint64 connecting_time;
+	gint64 tls_handshaking_time;
+	gint64 wrote_headers_time;
+	gint64 wrote_body_time;
+	gint64 got_headers_time;
+} RequestTracker;
+
+static void
+request_tracker_free (RequestTracker *tracker)
+{
+	g_main_context_unref (tracker->context);
+	g_object_unref (tracker->service);
+	g_free (tracker->stats.method);
+	g_free (tracker->stats.uri);
+	g_slice_free (RequestTracker, tracker);
+}
+
+static gboolean
+request_tracker_emit_idle (RequestTracker *tracker)
+{
+	g_signal_emit (tracker->service, service_signals[SIGNAL_REQUEST_FINISHED], 0, &(tracker->stats));
+
+	return FALSE;
+}
+
+/* Called when the tracker's message is finalised, which may be in any thread */
+static void
+request_tracker_finish (RequestTracker *tracker)
+{
+	GSource *source;
+
+	/* Fill in the encoded size if the response wasn't compressed */
+	if (tracker->stats.response_encoded_bytes == -2)
+		tracker->stats.response_encoded_bytes = tracker->stats.response_bytes;
+
+	source = g_idle_source_new ();
+	g_source_set_priority (source, G_PRIORITY_DEFAULT);
+	g_source_set_callback (source, (GSourceFunc) request_tracker_emit_idle, tracker, (GDestroyNotify) request_tracker_free);
+	g_source_attach (source, tracker->context);
+	g_source_unref (source);
+}
+
+static void
+request_tracker_network_event_cb (SoupMessage *message, GSocketClientEvent event, GIOStream *connection, RequestTracker *tracker)
+{
+	gint64 now = g_get_monotonic_time ();
+
+	switch (event) {
+		case G_SOCKET_CLIENT_RESOLVING:
+			tracker->resolving_time = now;
+			break;
+		case G_SOCKET_CLIENT_RESOLVED:
+			tracker->stats.dns_duration += now - tracker->resolving_time;
+			break;
+		case G_SOCKET_CLIENT_CONNECTING:
+			tracker->connecting_time = now;
+			break;
+		case G_SOCKET_CLIENT_CONNECTED:
+			tracker->stats.connect_duration += now - tracker->connecting_time;
+			break;
+		case G_SOCKET_CLIENT_TLS_HANDSHAKING:
+			tracker->tls_handshaking_time = now;
+			break;
+		case G_SOCKET_CLIENT_TLS_HANDSHAKED:
+			tracker->stats.tls_duration += now - tracker->tls_handshaking_time;
+			break;
+		default:
+			/* Not interested */
+			break;
+	}
+}
+
+static void
+request_tracker_wrote_headers_cb (SoupMessage *message, RequestTracker *tracker)
+{
+	tracker->wrote_headers_time = g_get_monotonic_time ();
+}
+
+static void
+request_tracker_wrote_body_cb (SoupMessage *message, RequestTracker *tracker)
+{
+	tracker->wrote_body_time = g_get_monotonic_time ();
+	tracker->stats.send_duration += tracker->wrote_body_time - tracker->wrote_headers_time;
+}
+
+static void
+request_tracker_got_headers_cb (SoupMessage *message, RequestTracker *tracker)
+{
+	tracker->got_headers_time = g_get_monotonic_time ();
+	tracker->stats.wait_duration += tracker->got_headers_time - tracker->wrote_body_time;
+
+	/* Start counting afresh, in case this is a repeat attempt */
+	tracker->stats.response_bytes = 0;
+
+	/* If the response is compressed, the Content-Length (if there is one) is its compressed length. Otherwise, the encoded and decoded lengths
+	 * are the same, which we signal with -2 so that it can be filled in once the whole body has been received. */
+	if (soup_message_headers_get_one (message->response_headers, "Content-Encoding") == NULL)
+		tracker->stats.response_encoded_bytes = -2;
+	else if (soup_message_headers_get_encoding (message->response_headers) == SOUP_ENCODING_CONTENT_LENGTH)
+		tracker->stats.response_encoded_bytes = soup_message_headers_get_content_length (message->response_headers);
+	else
+		tracker->stats.response_encoded_bytes = -1;
+}
+
+static void
+request_tracker_got_chunk_cb (SoupMessage *message, SoupBuffer *chunk, RequestTracker *tracker)
+{
+	tracker->stats.response_bytes += chunk->length;
+}
+
+static void
+request_tracker_got_body_cb (SoupMessage *message, RequestTracker *tracker)
+{
+	tracker->stats.receive_duration += g_get_monotonic_time () - tracker->got_headers_time;
+}
+
+static void
+request_tracker_finished_cb (SoupMessage *message, RequestTracker *tracker)
+{
+	tracker->stats.status_code = message->status_code;
+	tracker->stats.total_duration = g_get_monotonic_time () - tracker->stats.start_time;
+	tracker->stats.request_bytes = message->request_body->length;
+}
+
+/*
+ * _gdata_service_track_request:
+ * @self: a #GDataService
+ * @message: a #SoupMessage which is about to be sent for the first time
+ *
+ * Start instrumenting @message for the #GDataService::request-finished signal, if the signal has any handlers. The signal will be emitted in the
+ * current thread-default main context once @message is finalised, and @self is kept alive until it has been. This is called automatically by
+ * _gdata_service_send_message(), so only needs to be called explicitly by code which sends messages using _gdata_service_actually_send_message().
+ * It's safe to call it more than once for the same message.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_service_track_request (GDataService *self, SoupMessage *message)
+{
+	RequestTracker *tracker;
+	GMainContext *context;
+	SoupURI *uri;
+
+	if (g_signal_has_handler_pending (self, service_signals[SIGNAL_REQUEST_FINISHED], 0, FALSE) == FALSE ||
+	    g_object_get_data (G_OBJECT (message), "gdata-request-tracker") != NULL) {
+		return;
+	}
+
+	uri = soup_message_get_uri (message);
+
+	tracker = g_slice_new0 (RequestTracker);
+	tracker->service = g_object_ref (self);
+	context = g_main_context_get_thread_default ();
+	tracker->context = g_main_context_ref ((context != NULL) ? context : g_main_context_default ());
+	tracker->stats.method = g_strdup (message->method);
+	tracker->stats.uri = (uri != NULL) ? soup_uri_to_string (uri, FALSE) : NULL;
+	tracker->stats.start_time = g_get_monotonic_time ();
+	tracker->stats.response_encoded_bytes = -2;
+
+	/* Fallbacks in case the message fails before the relevant phase starts */
+	tracker->wrote_headers_time = tracker->stats.start_time;
+	tracker->wrote_body_time = tracker->stats.start_time;
+	tracker->got_headers_time = tracker->stats.start_time;
+
+	g_signal_connect (message, "network-event", (GCallback) request_tracker_network_event_cb, tracker);
+	g_signal_connect (message, "wrote-headers", (GCallback) request_tracker_wrote_headers_cb, tracker);
+	g_signal_connect (message, "wrote-body", (GCallback) request_tracker_wrote_body_cb, tracker);
+	g_signal_connect (message, "got-headers", (GCallback) request_tracker_got_headers_cb, tracker);
+	g_signal_connect (message, "got-chunk", (GCallback) request_tracker_got_chunk_cb, tracker);
+	g_signal_connect (message, "got-body", (GCallback) request_tracker_got_body_cb, tracker);
+	g_signal_connect (message, "finished", (GCallback) request_tracker_finished_cb, tracker);
+
+	g_object_set_data_full (G_OBJECT (message), "gdata-request-tracker", tracker, (GDestroyNotify) request_tracker_finish);
+}
+
+/*
+ * _gdata_service_hedge_message:
+ * @self: a #GDataService
+ * @message: an idempotent #SoupMessage which is about to be sent for the first time
+ *
+ * Mark @message to be hedged according to the service's #GDataService:hedging-policy, if it has one, when it's sent using
+ * _gdata_service_send_message() (or its asynchronous version) or _gdata_service_actually_send_message(). Only <literal>GET</literal> messages are
+ * ever hedged, and this should only be called for the messages made by queries and downloads.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_service_hedge_message (GDataService *self, SoupMessage *message)
+{
+	if (self->priv->hedging_policy == NULL || strcmp (message->method, SOUP_METHOD_GET) != 0)
+		return;
+
+	g_object_set_data_full (G_OBJECT (message), "gdata-hedging-policy", g_object_ref (self->priv->hedging_policy), g_object_unref);
+}
+
+/*
+ * _gdata_service_attach_circuit_breaker:
+ * @self: a #GDataService
+ * @message: a #SoupMessage which is about to be sent for the first time
+ *
+ * Make @message subject to the service's #GDataService:circuit-breaker, if it has one, when it's sent using _gdata_service_send_message() (or its
+ * asynchronous version) or _gdata_service_actually_send_message(). This is called automatically by _gdata_service_build_message(), so only needs
+ * to be called explicitly for messages which are built in other ways.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_service_attach_circuit_breaker (GDataService *self, SoupMessage *message)
+{
+	if (self->priv->circuit_breaker == NULL)
+		return;
+
+	g_object_set_data_full (G_OBJECT (message), "gdata-circuit-breaker", g_object_ref (self->priv->circuit_breaker), g_object_unref);
+}
+
+/*
+ * _gdata_service_set_request_parse_stats:
+ * @message: a #SoupMessage
+ * @parse_duration: the time taken to parse @message's response body, in microseconds
+ * @n_entries: the number of entries parsed from the response body
+ *
+ * Record how long it took to parse the response to @message, for reporting in the #GDataService::request-finished signal. If @message isn't being
+ * instrumented, this does nothing.
+ *
+ * Since: 0.15.0
+ */
+/* Coalesced queries parse the same response concurrently, so the stats may be updated from several threads at once */
+static GMutex parse_stats_mutex;
+
+void
+_gdata_service_set_request_parse_stats (SoupMessage *message, gint64 parse_duration, guint n_entries)
+{
+	RequestTracker *tracker;
+
+	tracker = g_object_get_data (G_OBJECT (message), "gdata-request-tracker");
+
+	if (tracker != NULL) {
+		g_mutex_lock (&parse_stats_mutex);
+		tracker->stats.parse_duration += parse_duration;
+		tracker->stats.n_entries += n_entries;
+		g_mutex_unlock (&parse_stats_mutex);
+	}
+}
+
+/* The priority is stored offset by one, so that messages without one get GDATA_REQUEST_PRIORITY_NORMAL */
+static void
+set_message_priority (SoupMessage *message, GDataRequestPriority priority)
+{
+	g_object_set_data (G_OBJECT (message), "gdata-request-priority", GUINT_TO_POINTER (priority + 1));
+}
+
+static GDataRequestPriority
+get_message_priority (SoupMessage *message)
+{
+	guint priority = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (message), "gdata-request-priority"));
+
+	return (priority > 0) ? priority - 1 : GDATA_REQUEST_PRIORITY_NORMAL;
+}
+
+static guint
+send_message_attempt (GDataService *self, SoupMessage *message, GCancellable *cancellable, GError **error)
+{
+	/* Based on code from evolution-data-server's libgdata:
+	 *  Ebby Wiselyn <ebbywiselyn@gmail.com>
+	 *  Jason Willis <zenbrother@gmail.com>
+	 *
+	 * Copyright (C) 1999-2008 Novell, Inc. (www.novell.com)
+	 */
+
+	soup_message_set_flags (message, SOUP_MESSAGE_NO_REDIRECT);
+	_gdata_service_actually_send_message (self->priv->session, message, cancellable, error);
+	soup_message_set_flags (message, 0);
+
+	/* Handle redirections specially so we don't lose our custom headers when making the second request */
+	if (SOUP_STATUS_IS_REDIRECTION (message->status_code)) {
+		SoupURI *new_uri;
+		const gchar *new_location;
+
+		new_location = soup_message_headers_get_one (message->response_headers, "Location");
+		g_return_val_if_fail (new_location != NULL, SOUP_STATUS_NONE);
+
+		new_uri = soup_uri_new_with_base (soup_message_get_uri (message), new_location);
+		if (new_uri == NULL) {
+			gchar *uri_string = soup_uri_to_string (new_uri, FALSE);
+			g_set_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR,
+			             /* Translators: the parameter is the URI which is invalid. */
+			             _("Invalid redirect URI: %s"), uri_string);
+			g_free (uri_string);
+			return SOUP_STATUS_NONE;
+		}
+
+		/* Allow overriding the URI for testing. */
+		soup_uri_set_port (new_uri, _gdata_service_get_https_port ());
+
+		soup_message_set_uri (message, new_uri);
+		soup_uri_free (new_uri);
+
+		/* Send the message again */
+		_gdata_service_actually_send_message (self->priv->session, message, cancellable, error);
+	}
+
+	/* Not authorised, or authorisation has expired. If we were authorised in the first place, attempt to refresh the authorisation and
+	 * try sending the message again (but only once, so we don't get caught in an infinite loop of denied authorisation errors).
+	 *
+	 * Note that we have to re-process the message with the authoriser so that its authorisation headers get updated after the refresh
+	 * (bgo#653535). */
+	if (message->status_code == SOUP_STATUS_UNAUTHORIZED) {
+		GDataAuthorizer *authorizer = self->priv->authorizer;
+
+		if (authorizer != NULL && gdata_authorizer_refresh_authorization (authorizer, cancellable, NULL) == TRUE) {
+			GDataAuthorizationDomain *domain;
+
+			/* Re-process the request */
+			domain = g_object_get_data (G_OBJECT (message), "gdata-authorization-domain");
+			g_assert (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
+
+			gdata_authorizer_process_request (authorizer, domain, message);
+
+			/* Send the message again */
+			g_clear_error (error);
+			_gdata_service_actually_send_message (self->priv->session, message, cancellable, error);
+		}
+	}
+
+	return message->status_code;
+}
+
+/* Whether there's time to wait @delay milliseconds and then retry a request before the deadline of @cancellable (if it has one) passes. */
+static gboolean
+deadline_allows_retry (GCancellable *cancellable, gint64 delay)
+{
+	gint64 remaining = _gdata_deadline_cancellable_get_remaining_time (cancellable);
+
+	return (remaining < 0 || delay < remaining) ? TRUE : FALSE;
+}
+
+/* Block for @delay milliseconds before (re-)sending a message, returning early if @cancellable is cancelled. */
+static void
+sleep_cancellable (gint64 delay, GCancellable *cancellable)
+{
+	GPollFD pollfd;
+
+	if (cancellable != NULL && g_cancellable_make_pollfd (cancellable, &pollfd) == TRUE) {
+		g_poll (&pollfd, 1, (gint) MIN (delay, G_MAXINT));
+		g_cancellable_release_fd (cancellable);
+	} else {
+		g_usleep (delay * 1000);
+	}
+}
+
+guint
+_gdata_service_send_message (GDataService *self, SoupMessage *message, GCancellable *cancellable, GError **error)
+{
+	GDataRetryPolicy *retry_policy;
+	GDataRateLimiter *rate_limiter;
+	GDataRequestScheduler *request_scheduler;
+	GDataAuthorizationDomain *domain;
+	GDataRequestPriority priority;
+	gboolean scheduled;
+	guint attempt;
+	gint64 delay;
+
+	_gdata_service_track_request (self, message);
+
+	/* Keep the policy, limiter and scheduler alive in case they're changed on the service while we're waiting */
+	retry_policy = (self->priv->retry_policy != NULL) ? g_object_ref (self->priv->retry_policy) : NULL;
+	rate_limiter = (self->priv->rate_limiter != NULL) ? g_object_ref (self->priv->rate_limiter) : NULL;
+	request_scheduler = (self->priv->request_scheduler != NULL) ? g_object_ref (self->priv->request_scheduler) : NULL;
+	domain = g_object_get_data (G_OBJECT (message), "gdata-authorization-domain");
+	priority = get_message_priority (message);
+
+	for (attempt = 1; ; attempt++) {
+		/* Wait until the rate limiter lets the message through. Any cancellation during the sleep is picked up when the message is sent. */
+		if (rate_limiter != NULL) {
+			delay = _gdata_rate_limiter_acquire (rate_limiter, domain);
+
+			if (delay > 0)
+				sleep_cancellable (delay, cancellable);
+		}
+
+		/* Wait for a slot from the scheduler. If we're cancelled while waiting, the message is sent without one so the cancellation is picked up. */
+		scheduled = (request_scheduler != NULL) ? _gdata_request_scheduler_acquire (request_scheduler, priority, cancellable) : FALSE;
+
+		send_message_attempt (self, message, cancellable, error);
+
+		if (scheduled == TRUE)
+			_gdata_request_scheduler_release (request_scheduler, priority);
+
+		if (rate_limiter != NULL)
+			_gdata_rate_limiter_report (rate_limiter, domain, message);
+
+		delay = (retry_policy != NULL) ? _gdata_retry_policy_get_retry_delay (retry_policy, message, attempt) : -1;
+		if (delay < 0 || deadline_allows_retry (cancellable, delay) == FALSE)
+			break;
+
+		g_debug ("Retrying %s request in %" G_GINT64_FORMAT " ms after status %u (attempt %u).", message->method, delay,
+		         message->status_code, attempt);
+
+		/* Any cancellation during the sleep is picked up when the message is next sent */
+		sleep_cancellable (delay, cancellable);
+		g_clear_error (error);
+	}
+
+	if (request_scheduler != NULL)
+		g_object_unref (request_scheduler);
+	if (rate_limiter != NULL)
+		g_object_unref (rate_limiter);
+	if (retry_policy != NULL)
+		g_object_unref (retry_policy);
+
+	return message->status_code;
+}
+
+/*
+ * _gdata_service_wait_to_retry:
+ * @self: a #GDataService
+ * @message: a #SoupMessage which has just been sent by the caller, rather than by _gdata_service_send_message()
+ * @attempt: the number of times @message has been sent so far
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ *
+ * Decides whether @message should be sent again according to the service's #GDataService:retry-policy, and if so, blocks until it's time to do so.
+ * This is for callers which send messages themselves, such as #GDataDownloadStream.
+ *
+ * Return value: %TRUE if @message should be sent again, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+_gdata_service_wait_to_retry (GDataService *self, SoupMessage *message, guint attempt, GCancellable *cancellable)
+{
+	GDataRetryPolicy *retry_policy;
+	gint64 delay;
+
+	retry_policy = (self->priv->retry_policy != NULL) ? g_object_ref (self->priv->retry_policy) : NULL;
+	delay = (retry_policy != NULL) ? _gdata_retry_policy_get_retry_delay (retry_policy, message, attempt) : -1;
+
+	if (retry_policy != NULL)
+		g_object_unref (retry_policy);
+
+	if (delay < 0 || message->status_code == SOUP_STATUS_CANCELLED || g_cancellable_is_cancelled (cancellable) == TRUE ||
+	    deadline_allows_retry (cancellable, delay) == FALSE) {
+		return FALSE;
+	}
+
+	g_debug ("Retrying %s request in %" G_GINT64_FORMAT " ms after status %u (attempt %u).", message->method, delay, message->status_code,
+	         attempt);
+
+	sleep_cancellable (delay, cancellable);
+
+	return (g_cancellable_is_cancelled (cancellable) == FALSE) ? TRUE : FALSE;
+}
+
+typedef struct {
+	SoupMessage *message;
+	GCancellable *cancellable;
+	GSource *cancellable_source;
+	gboolean queued;
+	gboolean followed_redirect;
+	gboolean refreshed_authorization;
+	guint attempt;
+	GSource *delay_source; /* owned by its main context; non-NULL while waiting to retry or for the rate limiter */
+	GDataRetryPolicy *retry_policy;
+	GDataRateLimiter *rate_limiter;
+	GDataRequestScheduler *request_scheduler;
+	GDataRequestPriority priority;
+	gpointer schedule_ticket; /* non-NULL while waiting for the request scheduler */
+	gboolean scheduled; /* TRUE while holding a slot from the request scheduler */
+} SendMessageAsyncData;
+
+static void
+send_message_async_data_free (SendMessageAsyncData *data)
+{
+	g_assert (data->queued == FALSE);
+	g_assert (data->delay_source == NULL);
+	g_assert (data->schedule_ticket == NULL && data->scheduled == FALSE);
+
+	if (data->request_scheduler != NULL)
+		g_object_unref (data->request_scheduler);
+
+	if (data->rate_limiter != NULL)
+		g_object_unref (data->rate_limiter);
+
+	if (data->retry_policy != NULL)
+		g_object_unref (data->retry_policy);
+
+	if (data->cancellable_source != NULL) {
+		g_source_destroy (data->cancellable_source);
+		g_source_unref (data->cancellable_source);
+	}
+
+	if (data->cancellable != NULL)
+		g_object_unref (data->cancellable);
+
+	g_object_unref (data->message);
+
+	g_slice_free (SendMessageAsyncData, data);
+}
+
+static void send_message_async_queue (GSimpleAsyncResult *result);
+
+static gboolean
+send_message_async_cancelled_cb (GCancellable *cancellable, GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	/* If the message isn't currently queued (e.g. because we're refreshing the authorisation), the cancellation will be picked up before it's
+	 * next queued. */
+	if (data->queued == TRUE) {
+		GDataService *self = GDATA_SERVICE (g_async_result_get_source_object (G_ASYNC_RESULT (result)));
+		_gdata_hedging_policy_cancel_message (self->priv->session, data->message);
+		g_object_unref (self);
+	} else if (data->delay_source != NULL) {
+		/* Stop waiting to send the message and requeue it straight away, so the cancellation is picked up. Destroying the source drops its
+		 * reference to @result, so hold our own until we're done. */
+		g_object_ref (result);
+
+		g_source_destroy (data->delay_source);
+		data->delay_source = NULL;
+
+		send_message_async_queue (result);
+		g_object_unref (result);
+	} else if (data->schedule_ticket != NULL) {
+		/* Stop waiting for a slot and requeue the message straight away, as above. If a slot has already been taken for us, the cancellation
+		 * is picked up by send_message_async_scheduled_cb() instead. Withdrawing the ticket drops its reference to @result. */
+		g_object_ref (result);
+
+		if (_gdata_request_scheduler_withdraw (data->request_scheduler, data->schedule_ticket) == TRUE) {
+			data->schedule_ticket = NULL;
+			send_message_async_queue (result);
+		}
+
+		g_object_unref (result);
+	}
+
+	return FALSE;
+}
+
+static void
+send_message_async_complete (GSimpleAsyncResult *result, gboolean in_idle)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+	SoupMessage *message = data->message;
+
+	/* As in _gdata_service_actually_send_message(), we can't assume that our GCancellable has been cancelled just because the message has, and
+	 * vice-versa. */
+	g_assert (message->status_code != SOUP_STATUS_NONE);
+
+	if (message->status_code == SOUP_STATUS_CANCELLED ||
+	    ((message->status_code == SOUP_STATUS_IO_ERROR || message->status_code == SOUP_STATUS_SSL_FAILED ||
+	      message->status_code == SOUP_STATUS_CANT_CONNECT || message->status_code == SOUP_STATUS_CANT_RESOLVE) &&
+	     data->cancellable != NULL && g_cancellable_is_cancelled (data->cancellable) == TRUE)) {
+		GError *error = NULL;
+
+		if (_gdata_deadline_cancellable_set_error_if_expired (data->cancellable, &error) == FALSE) {
+			GCancellable *error_cancellable = g_cancellable_new ();
+
+			g_cancellable_cancel (error_cancellable);
+			g_assert (g_cancellable_set_error_if_cancelled (error_cancellable, &error) == TRUE);
+			g_object_unref (error_cancellable);
+		}
+
+		g_simple_async_result_set_from_error (result, error);
+		g_error_free (error);
+
+		soup_message_set_status (message, SOUP_STATUS_CANCELLED);
+	}
+
+	if (in_idle == TRUE)
+		g_simple_async_result_complete_in_idle (result);
+	else
+		g_simple_async_result_complete (result);
+}
+
+static void
+send_message_async_refresh_authorization_cb (GDataAuthorizer *authorizer, GAsyncResult *async_result, GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	if (data->cancellable != NULL && g_cancellable_is_cancelled (data->cancellable) == TRUE) {
+		/* Cancelled (or the deadline passed) while refreshing the authorisation; report that rather than the stale 401 status */
+		gdata_authorizer_refresh_authorization_finish (authorizer, async_result, NULL);
+		soup_message_set_status (data->message, SOUP_STATUS_CANCELLED);
+		send_message_async_complete (result, FALSE);
+	} else if (gdata_authorizer_refresh_authorization_finish (authorizer, async_result, NULL) == TRUE) {
+		GDataAuthorizationDomain *domain;
+
+		/* Re-process the request and send it again, as in _gdata_service_send_message() */
+		domain = g_object_get_data (G_OBJECT (data->message), "gdata-authorization-domain");
+		g_assert (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
+
+		gdata_authorizer_process_request (authorizer, domain, data->message);
+		send_message_async_queue (result);
+	} else {
+		/* Return the original 401 status */
+		send_message_async_complete (result, FALSE);
+	}
+
+	g_object_unref (result);
+}
+
+static gboolean
+send_message_async_requeue_cb (GSimpleAsyncResult *result)
+{
+	send_message_async_queue (result);
+	g_object_unref (result);
+
+	return FALSE;
+}
+
+/* Call @func with @result after @delay milliseconds, unless the operation is cancelled first. */
+static void
+send_message_async_delay (GSimpleAsyncResult *result, gint64 delay, GSourceFunc func)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	g_assert (data->delay_source == NULL);
+
+	data->delay_source = g_timeout_source_new ((guint) MIN (delay, G_MAXUINT));
+	g_source_set_callback (data->delay_source, func, g_object_ref (result), g_object_unref);
+	g_source_attach (data->delay_source, g_main_context_get_thread_default ());
+	g_source_unref (data->delay_source);
+}
+
+static gboolean
+send_message_async_throttled_cb (GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	/* The source's reference to @result is dropped when it's destroyed */
+	data->delay_source = NULL;
+	send_message_async_queue (result);
+
+	return FALSE;
+}
+
+/* Queue the message once the rate limiter (if any) lets it through. */
+static void
+send_message_async_throttle (GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+	GDataAuthorizationDomain *domain;
+	gint64 delay = 0;
+
+	if (data->rate_limiter != NULL) {
+		domain = g_object_get_data (G_OBJECT (data->message), "gdata-authorization-domain");
+		delay = _gdata_rate_limiter_acquire (data->rate_limiter, domain);
+	}
+
+	if (delay > 0)
+		send_message_async_delay (result, delay, (GSourceFunc) send_message_async_throttled_cb);
+	else
+		send_message_async_queue (result);
+}
+
+static gboolean
+send_message_async_retry_cb (GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	/* The source's reference to @result is dropped when it's destroyed */
+	data->delay_source = NULL;
+	send_message_async_throttle (result);
+
+	return FALSE;
+}
+
+static void
+send_message_async_cb (SoupSession *session, SoupMessage *message, GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+	GDataService *self = GDATA_SERVICE (g_async_result_get_source_object (G_ASYNC_RESULT (result)));
+	gint64 delay;
+
+	GDATA_TRACE_REQUEST_END (message);
+
+	data->queued = FALSE;
+	soup_message_set_flags (message, 0);
+	circuit_breaker_report_message (message, data->cancellable);
+
+	if (data->scheduled == TRUE) {
+		_gdata_request_scheduler_release (data->request_scheduler, data->priority);
+		data->scheduled = FALSE;
+	}
+
+	if (data->rate_limiter != NULL)
+		_gdata_rate_limiter_report (data->rate_limiter, g_object_get_data (G_OBJECT (message), "gdata-authorization-domain"), message);
+
+	if (message->status_code == SOUP_STATUS_CANCELLED) {
+		/* Cancelled */
+		send_message_async_complete (result, FALSE);
+	} else if (SOUP_STATUS_IS_REDIRECTION (message->status_code) && data->followed_redirect == FALSE) {
+		/* Handle redirections specially so we don't lose our custom headers when making the second request */
+		SoupURI *new_uri;
+		const gchar *new_location;
+		GSource *source;
+
+		new_location = soup_message_headers_get_one (message->response_headers, "Location");
+		new_uri = (new_location != NULL) ? soup_uri_new_with_base (soup_message_get_uri (message), new_location) : NULL;
+
+		if (new_uri == NULL) {
+			g_simple_async_result_set_error (result, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR,
+			                                 /* Translators: the parameter is the URI which is invalid. */
+			                                 _("Invalid redirect URI: %s"), new_location);
+			g_simple_async_result_complete (result);
+		} else {
+			/* Allow overriding the URI for testing. */
+			soup_uri_set_port (new_uri, _gdata_service_get_https_port ());
+
+			soup_message_set_uri (message, new_uri);
+			soup_uri_free (new_uri);
+
+			/* Send the message again once libsoup has finished with this attempt */
+			data->followed_redirect = TRUE;
+
+			source = g_idle_source_new ();
+			g_source_set_callback (source, (GSourceFunc) send_message_async_requeue_cb, g_object_ref (result), NULL);
+			g_source_attach (source, g_main_context_get_thread_default ());
+			g_source_unref (source);
+		}
+	} else if (message->status_code == SOUP_STATUS_UNAUTHORIZED && data->refreshed_authorization == FALSE && self->priv->authorizer != NULL) {
+		/* Not authorised, or authorisation has expired. Attempt to refresh the authorisation and try sending the message again, but only once. */
+		data->refreshed_authorization = TRUE;
+		gdata_authorizer_refresh_authorization_async (self->priv->authorizer, data->cancellable,
+		                                              (GAsyncReadyCallback) send_message_async_refresh_authorization_cb, g_object_ref (result));
+	} else if (data->retry_policy != NULL && (delay = _gdata_retry_policy_get_retry_delay (data->retry_policy, message, data->attempt)) >= 0 &&
+	           deadline_allows_retry (data->cancellable, delay) == TRUE) {
+		/* Transient failure; try again after a delay, as in _gdata_service_send_message() */
+		g_debug ("Retrying %s request in %" G_GINT64_FORMAT " ms after status %u (attempt %u).", message->method, delay,
+		         message->status_code, data->attempt);
+
+		data->attempt++;
+		data->followed_redirect = FALSE;
+		data->refreshed_authorization = FALSE;
+
+		send_message_async_delay (result, delay, (GSourceFunc) send_message_async_retry_cb);
+	} else {
+		send_message_async_complete (result, FALSE);
+	}
+
+	g_object_unref (self);
+	g_object_unref (result);
+}
+
+static gboolean
+send_message_async_scheduled_cb (GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	/* The ticket's reference to @result is dropped after we return */
+	data->schedule_ticket = NULL;
+	data->scheduled = TRUE;
+	send_message_async_queue (result);
+
+	return FALSE;
+}
+
+static void
+send_message_async_queue (GSimpleAsyncResult *result)
+{
+	SendMessageAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+	GDataService *self;
+	GDataHedgingPolicy *hedging_policy;
+	GError *error = NULL;
+
+	/* Only send the message if it hasn't already been cancelled */
+	if (data->cancellable != NULL && g_cancellable_is_cancelled (data->cancellable) == TRUE) {
+		if (data->scheduled == TRUE) {
+			_gdata_request_scheduler_release (data->request_scheduler, data->priority);
+			data->scheduled = FALSE;
+		}
+
+		soup_message_set_status (data->message, SOUP_STATUS_CANCELLED);
+		send_message_async_complete (result, TRUE);
+		return;
+	}
+
+	/* Wait for a slot from the request scheduler (if any); send_message_async_scheduled_cb() calls us again once we've got one */
+	if (data->request_scheduler != NULL && data->scheduled == FALSE) {
+		data->schedule_ticket = _gdata_request_scheduler_acquire_async (data->request_scheduler, data->priority,
+		                                                                (GSourceFunc) send_message_async_scheduled_cb, g_object_ref (result),
+		                                                                g_object_unref);
+		if (data->schedule_ticket != NULL)
+			return;
+
+		data->scheduled = TRUE;
+	}
+
+	/* Fail fast if the message's host appears to be down. As with redirect errors, the status is left as SOUP_STATUS_NONE. */
+	if (circuit_breaker_allows_message (data->message, &error) == FALSE) {
+		if (data->scheduled == TRUE) {
+			_gdata_request_scheduler_release (data->request_scheduler, data->priority);
+			data->scheduled = FALSE;
+		}
+
+		g_simple_async_result_take_error (result, error);
+		g_simple_async_result_complete_in_idle (result);
+		return;
+	}
+
+	self = GDATA_SERVICE (g_async_result_get_source_object (G_ASYNC_RESULT (result)));
+
+	GDATA_TRACE_REQUEST_START (data->message);
+
+	/* soup_session_queue_message() and _gdata_hedging_policy_queue_message() steal a reference to the message */
+	data->queued = TRUE;
+	hedging_policy = g_object_get_data (G_OBJECT (data->message), "gdata-hedging-policy");
+
+	if (hedging_policy != NULL) {
+		_gdata_hedging_policy_queue_message (hedging_policy, self->priv->session, g_object_ref (data->message),
+		                                     (SoupSessionCallback) send_message_async_cb, g_object_ref (result));
+	} else {
+		soup_session_queue_message (self->priv->session, g_object_ref (data->message), (SoupSessionCallback) send_message_async_cb,
+		                            g_object_ref (result));
+	}
+
+	g_object_unref (self);
+}
+
+/*
+ * _gdata_service_send_message_async:
+ * @self: a #GDataService
+ * @message: the #SoupMessage to send
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the message has been sent and its response received
+ * @user_data: (closure): data to pass to the @callback function
+ *
+ * Asynchronous version of _gdata_service_send_message(). The message is queued on the service's #SoupSession, so no thread is blocked while the
+ * request is in flight; @callback is called in the thread-default main context of the thread which called this function. Redirections,
+ * authorisation refreshes, retries, rate limiting and scheduling are handled in the same way as by _gdata_service_send_message().
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_service_send_message_async (GDataService *self, SoupMessage *message, GCancellable *cancellable, GAsyncReadyCallback callback,
+                                   gpointer user_data)
+{
+	GSimpleAsyncResult *result;
+	SendMessageAsyncData *data;
+
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (SOUP_IS_MESSAGE (message));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	_gdata_service_track_request (self, message);
+	soup_message_set_flags (message, SOUP_MESSAGE_NO_REDIRECT);
+
+	data = g_slice_new0 (SendMessageAsyncData);
+	data->message = g_object_ref (message);
+	data->cancellable = (cancellable != NULL) ? g_object_ref (cancellable) : NULL;
+	data->attempt = 1;
+	data->retry_policy = (self->priv->retry_policy != NULL) ? g_object_ref (self->priv->retry_policy) : NULL;
+	data->rate_limiter = (self->priv->rate_limiter != NULL) ? g_object_ref (self->priv->rate_limiter) : NULL;
+	data->request_scheduler = (self->priv->request_scheduler != NULL) ? g_object_ref (self->priv->request_scheduler) : NULL;
+	data->priority = get_message_priority (message);
+
+	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, _gdata_service_send_message_async);
+	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) send_message_async_data_free);
+
+	/* Listen for cancellation in the same main context as libsoup will call us back in. The source only holds a weak pointer to @result; it's
+	 * destroyed along with @data. */
+	if (cancellable != NULL) {
+		data->cancellable_source = g_cancellable_source_new (cancellable);
+		g_source_set_callback (data->cancellable_source, (GSourceFunc) send_message_async_cancelled_cb, result, NULL);
+		g_source_attach (data->cancellable_source, g_main_context_get_thread_default ());
+	}
+
+	send_message_async_throttle (result);
+	g_object_unref (result);
+}
+
+/*
+ * _gdata_service_send_message_finish:
+ * @self: a #GDataService
+ * @async_result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Finishes an asynchronous message send operation started with _gdata_service_send_message_async().
+ *
+ * Return value: the message's final status code, as with _gdata_service_send_message()
+ *
+ * Since: 0.15.0
+ */
+guint
+_gdata_service_send_message_finish (GDataService *self, GAsyncResult *async_result, GError **error)
+{
+	GSimpleAsyncResult *result = G_SIMPLE_ASYNC_RESULT (async_result);
+	SendMessageAsyncData *data;
+
+	g_return_val_if_fail (GDATA_IS_SERVICE (self), SOUP_STATUS_NONE);
+	g_return_val_if_fail (G_IS_ASYNC_RESULT (async_result), SOUP_STATUS_NONE);
+	g_return_val_if_fail (error == NULL || *error == NULL, SOUP_STATUS_NONE);
+
+	g_warn_if_fail (g_simple_async_result_get_source_tag (result) == _gdata_service_send_message_async);
+
+	data = g_simple_async_result_get_op_res_gpointer (result);
+
+	if (g_simple_async_result_propagate_error (result, error) == TRUE &&
+	    data->message->status_code != SOUP_STATUS_CANCELLED) {
+		/* Redirect error */
+		return SOUP_STATUS_NONE;
+	}
+
+	return data->message->status_code;
+}
+
+/* Maximum number of threads used to parse responses to asynchronous requests. Parsing is CPU-bound, so there's no point in having more threads
+ * than cores; and there's no portable way to find out how many cores there are with the version of GLib we depend on. */
+#define PARSE_POOL_MAX_THREADS 4
+
+typedef struct {
+	GSimpleAsyncResult *result;
+	GSimpleAsyncThreadFunc func;
+	GCancellable *cancellable;
+} ParsePoolJob;
+
+static void
+parse_pool_job_cb (ParsePoolJob *job, gpointer user_data)
+{
+	GObject *source_object;
+
+	source_object = g_async_result_get_source_object (G_ASYNC_RESULT (job->result));
+	job->func (job->result, source_object, job->cancellable);
+	g_object_unref (source_object);
+
+	/* Complete in the main context which the operation was started in */
+	g_simple_async_result_complete_in_idle (job->result);
+
+	g_object_unref (job->result);
+	if (job->cancellable != NULL)
+		g_object_unref (job->cancellable);
+	g_slice_free (ParsePoolJob, job);
+}
+
+static gpointer
+parse_pool_new (gpointer user_data)
+{
+	return g_thread_pool_new ((GFunc) parse_pool_job_cb, NULL, PARSE_POOL_MAX_THREADS, FALSE, NULL);
+}
+
+/*
+ * _gdata_service_run_in_parse_pool:
+ * @result: a #GSimpleAsyncResult
+ * @func: a #GSimpleAsyncThreadFunc to parse the operation's response
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ *
+ * Equivalent to g_simple_async_result_run_in_thread(), but runs @func in a small pool of threads shared by all asynchronous operations, rather
+ * than the (much larger) GIO worker pool. This is intended for the CPU-bound parsing which follows a network request made using
+ * _gdata_service_send_message_async(), so that the number of threads in use is bounded regardless of how many requests are in flight.
+ *
+ * Since: 0.15.0
+ */
+void
+_gdata_service_run_in_parse_pool (GSimpleAsyncResult *result, GSimpleAsyncThreadFunc func, GCancellable *cancellable)
+{
+	static GOnce parse_pool_once = G_ONCE_INIT;
+	ParsePoolJob *job;
+
+	g_return_if_fail (G_IS_SIMPLE_ASYNC_RESULT (result));
+	g_return_if_fail (func != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	g_once (&parse_pool_once, parse_pool_new, NULL);
+
+	job = g_slice_new (ParsePoolJob);
+	job->result = g_object_ref (result);
+	job->func = func;
+	job->cancellable = (cancellable != NULL) ? g_object_ref (cancellable) : NULL;
+
+	g_thread_pool_push (parse_pool_once.retval, job, NULL);
+}
+
+/* The response may be processed in another thread, so the state holds its own reference to the service's cache (as it was when the message was
+ * built), in case the service's cache is changed in the meantime */
+typedef struct {
+	GDataCache *cache;
+	gchar *query_uri;
+	gchar *etag;
+	gchar *content_type;
+	SoupBuffer *body;
+	gboolean use_cache;
+} QueryCacheState;
+
+static void
+query_cache_state_clear (QueryCacheState *state)
+{
+	if (state->cache != NULL)
+		g_object_unref (state->cache);
+	g_free (state->query_uri);
+	g_free (state->etag);
+	g_free (state->content_type);
+	if (state->body != NULL)
+		soup_buffer_free (state->body);
+
+	memset (state, 0, sizeof (QueryCacheState));
+}
+
+/* Builds the message for a query, looking up any cached response for it in the service's cache. @state must be cleared with
+ * query_cache_state_clear() once the response has been processed with process_query_response(). */
+static SoupMessage *
+build_query_message (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query, QueryCacheState *state)
+{
+	SoupMessage *message;
+	const gchar *etag = NULL;
+
+	/* Append the ETag header if possible */
+	if (query != NULL)
+		etag = gdata_query_get_etag (query);
+
+	if (query != NULL)
+		state->query_uri = gdata_query_get_query_uri (query, feed_uri);
+	else
+		state->query_uri = g_strdup (feed_uri);
+
+	/* If we've got a cached response for the URI, revalidate it using its ETag. We can only do this if the query doesn't have an ETag of its own,
+	 * or has the same one; otherwise a 304 response would tell us nothing about whether the cached response is current. */
+	state->cache = (self->priv->cache != NULL) ? g_object_ref (self->priv->cache) : NULL;
+
+	if (state->cache != NULL &&
+	    gdata_cache_look_up (state->cache, state->query_uri, &(state->etag), &(state->content_type), &(state->body)) == TRUE &&
+	    (etag == NULL || strcmp (etag, state->etag) == 0)) {
+		etag = state->etag;
+		state->use_cache = TRUE;
+	}
+
+	/* Build the message, tagging it with the query's priority for the request scheduler */
+	message = _gdata_service_build_message (self, domain, SOUP_METHOD_GET, state->query_uri, etag, FALSE);
+	if (query != NULL)
+		set_message_priority (message, gdata_query_get_priority (query));
+
+	_gdata_service_hedge_message (self, message);
+
+	return message;
+}
+
+/* Handles the response to a message built by build_query_message(), returning @message if it has a response body to be parsed, or unreffing it
+ * and returning %NULL otherwise. */
+static SoupMessage *
+process_query_response (GDataService *self, SoupMessage *message, guint status, QueryCacheState *state, GError **error)
+{
+	if (status == SOUP_STATUS_NOT_MODIFIED && state->use_cache == TRUE) {
+		/* Not modified, and we've got the unmodified response in the cache: return that instead */
+		soup_message_body_truncate (message->response_body);
+		soup_message_body_append_buffer (message->response_body, state->body);
+		soup_buffer_free (soup_message_body_flatten (message->response_body));
+
+		soup_message_headers_replace (message->response_headers, "ETag", state->etag);
+		if (state->content_type != NULL)
+			soup_message_headers_replace (message->response_headers, "Content-Type", state->content_type);
+
+		soup_message_set_status (message, SOUP_STATUS_OK);
+	} else if (status == SOUP_STATUS_NOT_MODIFIED || status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
+		/* Not modified (ETag has worked), or not sent or cancelled (in which case the error has been set) */
+		g_object_unref (message);
+		message = NULL;
+	} else if (status != SOUP_STATUS_OK) {
+		/* Error */
+		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (self);
+		g_assert (klass->parse_error_response != NULL);
+		klass->parse_error_response (self, GDATA_OPERATION_QUERY, status, message->reason_phrase, message->response_body->data,
+		                             message->response_body->length, error);
+		g_object_unref (message);
+		message = NULL;
+	} else if (state->cache != NULL) {
+		/* Successful response; cache it if the server gave us an ETag to revalidate it with later */
+		const gchar *response_etag = soup_message_headers_get_one (message->response_headers, "ETag");
+
+		if (response_etag != NULL && *response_etag != '\0') {
+			SoupBuffer *body = soup_message_body_flatten (message->response_body);
+			gdata_cache_store (state->cache, state->query_uri, response_etag,
+			                   soup_message_headers_get_one (message->response_headers, "Content-Type"), body);
+			soup_buffer_free (body);
+		}
+	}
+
+	return message;
+}
+
+/* Updates @query (if non-%NULL) with the ETag and pagination URIs of the @feed returned for it */
+static void
+update_query_from_feed (GDataQuery *query, GDataFeed *feed)
+{
+	GDataLink *_link;
+
+	if (query == NULL)
+		return;
+
+	/* Update the query with the feed's ETag */
+	if (gdata_feed_get_etag (feed) != NULL)
+		gdata_query_set_etag (query, gdata_feed_get_etag (feed));
+
+	/* Update the query with the next and previous URIs from the feed */
+	_link = gdata_feed_look_up_link (feed, "next");
+	if (_link != NULL)
+		_gdata_query_set_next_uri (query, gdata_link_get_uri (_link));
+	_link = gdata_feed_look_up_link (feed, "previous");
+	if (_link != NULL)
+		_gdata_query_set_previous_uri (query, gdata_link_get_uri (_link));
+}
+
+/* Parses the feed from the response to a query, and updates @query from it. This may be called in any thread. If @progress_context is non-%NULL,
+ * the progress callbacks are dispatched in it; otherwise they're called directly. */
+static GDataFeed *
+parse_query_response (GDataService *self, SoupMessage *message, GDataQuery *query, GType entry_type, GDataQueryProgressCallback progress_callback,
+                      GDataQueryBatchProgressCallback batch_progress_callback, gpointer progress_user_data, GMainContext *progress_context,
+                      GError **error)
+{
+	GDataServiceClass *klass;
+	GDataFeed *feed = NULL;
+	SoupMessageHeaders *headers;
+	const gchar *content_type;
+	gint64 parse_start_time;
+
+	g_assert (message->response_body->data != NULL);
+	klass = GDATA_SERVICE_GET_CLASS (self);
+	parse_start_time = g_get_monotonic_time ();
+
+	headers = message->response_headers;
+	content_type = soup_message_headers_get_content_type (headers, NULL);
+
+	if (content_type != NULL && strcmp (content_type, "application/json") == 0) {
+		/* Definitely JSON. */
+		g_debug("JSON content type detected.");
+		feed = _gdata_feed_new_from_json (klass->feed_type, message->response_body->data, message->response_body->length, entry_type,
+		                                  progress_callback, batch_progress_callback, progress_user_data, progress_context, error);
+	} else {
+		/* Potentially XML. Don't bother checking the Content-Type, since the parser
+		 * will fail gracefully if the response body is not valid XML. */
+		g_debug("XML content type detected.");
+		feed = _gdata_feed_new_from_xml (klass->feed_type, message->response_body->data, message->response_body->length, entry_type,
+		                                 progress_callback, batch_progress_callback, progress_user_data, progress_context, error);
+	}
+
+	_gdata_service_set_request_parse_stats (message, g_get_monotonic_time () - parse_start_time,
+	                                        (feed != NULL) ? g_list_length (gdata_feed_get_entries (feed)) : 0);
+
+	if (feed == NULL)
+		return NULL;
+
+	update_query_from_feed (query, feed);
+
+	return feed;
+}
+
+/* Coalescing of identical queries (see GDataService:coalesce-queries). Identical queries which are made while one of them is in progress all become
+ * waiters on the same QueryFlight. The first of them (the leader) starts the flight's shared request, and every waiter is then handed a reference to
+ * its response, which each parses for itself. The shared request isn't tied to the leader: synchronous flights make it in a thread from a pool, and
+ * asynchronous flights make it without a thread. So any waiter (including the leader) can be cancelled promptly; a cancelled waiter is detached from
+ * the flight and completed straight away, and the shared request is only cancelled once all of the flight's waiters have been.
+ *
+ * The shared request is bounded by its leader's deadline (if its cancellable is a #GDataDeadlineCancellable), so that it isn't retried or kept
+ * waiting for the rate limiter once no waiter could use its response. A query only joins a flight if the flight's deadline is no earlier than its
+ * own, so the shared request is never cut short while a waiter could still use it; otherwise it's made without coalescing it. A waiter whose own
+ * deadline passes is detached like any other cancelled waiter, and fails with %G_IO_ERROR_TIMED_OUT. */
+typedef void (*QueryFlightDeliverFunc) (GSimpleAsyncResult *result, SoupMessage *message, const GError *error);
+
+typedef struct {
+	QueryFlight *flight;
+	GCancellable *cancellable;
+	gulong cancelled_id;
+
+	/* Asynchronous waiters only; these are NULL for synchronous waiters */
+	GSimpleAsyncResult *result;
+	GMainContext *context;
+	QueryFlightDeliverFunc deliver;
+
+	/* Protected by the service's flights_mutex */
+	gboolean detached;
+	gboolean cancelled;
+} QueryFlightWaiter;
+
+struct _QueryFlight {
+	volatile gint ref_count;
+	GDataService *service;
+	gchar *key;
+	gboolean is_async; /* whether the shared request is being made asynchronously */
+	gint64 deadline; /* monotonic time, in microseconds, or -1 if the shared request has no deadline */
+	GCancellable *cancellable; /* for the shared request; a #GDataDeadlineCancellable if it has a deadline */
+	GCond cond; /* signalled whenever a synchronous waiter is detached */
+
+	/* Protected by the service's flights_mutex */
+	GList *waiters; /* QueryFlightWaiter */
+	SoupMessage *message; /* the shared request, with a response to be parsed, once it's finished successfully */
+	GError *error;
+};
+
+static QueryFlight *
+query_flight_ref (QueryFlight *self)
+{
+	g_atomic_int_inc (&(self->ref_count));
+	return self;
+}
+
+static void
+query_flight_unref (QueryFlight *self)
+{
+	if (g_atomic_int_dec_and_test (&(self->ref_count)) == FALSE)
+		return;
+
+	g_assert (self->waiters == NULL);
+
+	if (self->message != NULL)
+		g_object_unref (self->message);
+	if (self->error != NULL)
+		g_error_free (self->error);
+
+	g_cond_clear (&(self->cond));
+	g_object_unref (self->cancellable);
+	g_free (self->key);
+	g_object_unref (self->service);
+
+	g_slice_free (QueryFlight, self);
+}
+
+/* Builds the key identifying a query in the service's table of flights. All queries are GETs, so the method doesn't need to be included. */
+static gchar *
+build_query_flight_key (const gchar *kind, GDataAuthorizationDomain *domain, const gchar *uri, GDataQuery *query, GType entry_type)
+{
+	gchar *query_uri, *key;
+	const gchar *etag = NULL;
+
+	if (query != NULL) {
+		query_uri = gdata_query_get_query_uri (query, uri);
+		etag = gdata_query_get_etag (query);
+	} else {
+		query_uri = g_strdup (uri);
+	}
+
+	key = g_strdup_printf ("%s %p %s %s %s", kind, domain, g_type_name (entry_type), (etag != NULL) ? etag : "", query_uri);
+	g_free (query_uri);
+
+	return key;
+}
+
+/* Gets the deadline of @cancellable, in microseconds of monotonic time, or -1 if it hasn't got one */
+static gint64
+get_cancellable_deadline (GCancellable *cancellable)
+{
+	if (cancellable == NULL || GDATA_IS_DEADLINE_CANCELLABLE (cancellable) == FALSE)
+		return -1;
+
+	return gdata_deadline_cancellable_get_deadline (GDATA_DEADLINE_CANCELLABLE (cancellable));
+}
+
+/* Sets the error for a waiter which was detached from its flight because its cancellable was cancelled (or its deadline passed) */
+static void
+query_flight_waiter_set_cancelled_error (QueryFlightWaiter *waiter, GError **error)
+{
+	if (_gdata_deadline_cancellable_set_error_if_expired (waiter->cancellable, error) == FALSE)
+		g_cancellable_set_error_if_cancelled (waiter->cancellable, error);
+}
+
+static void
+query_flight_waiter_free (QueryFlightWaiter *waiter)
+{
+	/* This waits for query_flight_waiter_cancelled_cb() to return if it's running in another thread */
+	if (waiter->cancellable != NULL) {
+		g_cancellable_disconnect (waiter->cancellable, waiter->cancelled_id);
+		g_object_unref (waiter->cancellable);
+	}
+
+	if (waiter->result != NULL)
+		g_object_unref (waiter->result);
+	if (waiter->context != NULL)
+		g_main_context_unref (waiter->context);
+
+	query_flight_unref (waiter->flight);
+	g_slice_free (QueryFlightWaiter, waiter);
+}
+
+static gboolean
+query_flight_waiter_complete_idle (QueryFlightWaiter *waiter)
+{
+	QueryFlight *flight = waiter->flight;
+
+	/* The waiter has been detached from the flight, so none of this can change any more. The deliver function completes the result. */
+	if (waiter->cancelled == TRUE) {
+		GError *error = NULL;
+
+		query_flight_waiter_set_cancelled_error (waiter, &error);
+		waiter->deliver (waiter->result, NULL, error);
+		g_error_free (error);
+	} else {
+		waiter->deliver (waiter->result, flight->message, flight->error);
+	}
+
+	query_flight_waiter_free (waiter);
+
+	return FALSE;
+}
+
+/* Completes an asynchronous waiter in the main context it was created in. The waiter must have been detached from its flight. */
+static void
+query_flight_waiter_complete_in_idle (QueryFlightWaiter *waiter)
+{
+	GSource *source;
+
+	source = g_idle_source_new ();
+	g_source_set_priority (source, G_PRIORITY_DEFAULT);
+	g_source_set_callback (source, (GSourceFunc) query_flight_waiter_complete_idle, waiter, NULL);
+	g_source_attach (source, waiter->context);
+	g_source_unref (source);
+}
+
+/* This may be called in any thread */
+static void
+query_flight_waiter_cancelled_cb (GCancellable *cancellable, QueryFlightWaiter *waiter)
+{
+	QueryFlight *flight = query_flight_ref (waiter->flight);
+	GDataServicePrivate *priv = flight->service->priv;
+	gboolean is_async, cancel_request;
+
+	g_mutex_lock (&(priv->flights_mutex));
+
+	if (waiter->detached == TRUE) {
+		/* Already finished */
+		g_mutex_unlock (&(priv->flights_mutex));
+		query_flight_unref (flight);
+		return;
+	}
+
+	waiter->detached = TRUE;
+	waiter->cancelled = TRUE;
+	is_async = (waiter->result != NULL);
+	flight->waiters = g_list_remove (flight->waiters, waiter);
+
+	/* If that was the last waiter, abandon the flight, so that later identical queries don't join it only to be cancelled */
+	cancel_request = (flight->waiters == NULL);
+	if (cancel_request == TRUE && g_hash_table_lookup (priv->flights, flight->key) == flight)
+		g_hash_table_remove (priv->flights, flight->key);
+
+	g_cond_broadcast (&(flight->cond));
+	g_mutex_unlock (&(priv->flights_mutex));
+
+	if (is_async == TRUE)
+		query_flight_waiter_complete_in_idle (waiter);
+	if (cancel_request == TRUE)
+		g_cancellable_cancel (flight->cancellable);
+
+	query_flight_unref (flight);
+}
+
+/* Joins the in-progress query identified by @key (which is consumed), or starts a new flight for it if there isn't one. If a new flight is started, a
+ * reference to it is returned in @new_flight, and the caller must start the shared request using query_flight_start_sync() or
+ * query_flight_start_async() (for synchronous and asynchronous waiters, respectively). @result is %NULL for synchronous waiters, which are returned by
+ * query_flight_wait(); asynchronous waiters are handed the response automatically, using @deliver, which must complete @result.
+ *
+ * Synchronous waiters never join a flight whose shared request is being made asynchronously, since they could be blocking the main context which
+ * the request needs to progress; and no waiter joins a flight whose deadline is earlier than that of @cancellable. %NULL is returned in those
+ * cases, and the query should be made without coalescing it. */
+static QueryFlightWaiter *
+query_flight_join (GDataService *self, gchar *key, GCancellable *cancellable, GSimpleAsyncResult *result, QueryFlightDeliverFunc deliver,
+                   QueryFlight **new_flight)
+{
+	GDataServicePrivate *priv = self->priv;
+	QueryFlight *flight;
+	QueryFlightWaiter *waiter;
+	gint64 deadline;
+
+	*new_flight = NULL;
+	deadline = get_cancellable_deadline (cancellable);
+
+	g_mutex_lock (&(priv->flights_mutex));
+
+	flight = g_hash_table_lookup (priv->flights, key);
+
+	if (flight == NULL) {
+		flight = g_slice_new0 (QueryFlight);
+		flight->ref_count = 1;
+		flight->service = g_object_ref (self);
+		flight->key = key;
+		flight->is_async = (result != NULL);
+		flight->deadline = deadline;
+		flight->cancellable = (deadline != -1) ? gdata_deadline_cancellable_new (_gdata_deadline_cancellable_get_remaining_time (cancellable), NULL)
+		                                       : g_cancellable_new ();
+		g_cond_init (&(flight->cond));
+
+		g_hash_table_insert (priv->flights, flight->key, flight);
+		*new_flight = query_flight_ref (flight);
+	} else if ((flight->is_async == TRUE && result == NULL) || (flight->deadline != -1 && (deadline == -1 || deadline > flight->deadline))) {
+		g_mutex_unlock (&(priv->flights_mutex));
+		g_free (key);
+		return NULL;
+	} else {
+		g_free (key);
+	}
+
+	waiter = g_slice_new0 (QueryFlightWaiter);
+	waiter->flight = query_flight_ref (flight);
+
+	if (result != NULL) {
+		GMainContext *context = g_main_context_get_thread_default ();
+
+		waiter->result = g_object_ref (result);
+		waiter->context = g_main_context_ref ((context != NULL) ? context : g_main_context_default ());
+		waiter->deliver = deliver;
+	}
+
+	flight->waiters = g_list_prepend (flight->waiters, waiter);
+
+	g_mutex_unlock (&(priv->flights_mutex));
+
+	/* This calls query_flight_waiter_cancelled_cb() immediately if @cancellable has already been cancelled, so the lock mustn't be held */
+	if (cancellable != NULL) {
+		waiter->cancellable = g_object_ref (cancellable);
+		waiter->cancelled_id = g_cancellable_connect (cancellable, (GCallback) query_flight_waiter_cancelled_cb, waiter, NULL);
+	}
+
+	return waiter;
+}
+
+/* Finishes @flight with the result of its shared request, taking ownership of @message and @error, and hands the result to all the waiters which
+ * haven't been cancelled. @message is the processed response from process_query_response(). This may be called in any thread. */
+static void
+query_flight_finish (QueryFlight *flight, SoupMessage *message, GError *error)
+{
+	GDataServicePrivate *priv = flight->service->priv;
+	GList *async_waiters = NULL, *i;
+
+	g_mutex_lock (&(priv->flights_mutex));
+
+	flight->message = message;
+	flight->error = error;
+
+	if (g_hash_table_lookup (priv->flights, flight->key) == flight)
+		g_hash_table_remove (priv->flights, flight->key);
+
+	/* Synchronous waiters free themselves as soon as they're woken up, so only the asynchronous ones can be touched after unlocking */
+	for (i = flight->waiters; i != NULL; i = i->next) {
+		QueryFlightWaiter *waiter = i->data;
+
+		waiter->detached = TRUE;
+		if (waiter->result != NULL)
+			async_waiters = g_list_prepend (async_waiters, waiter);
+	}
+
+	g_list_free (flight->waiters);
+	flight->waiters = NULL;
+
+	g_cond_broadcast (&(flight->cond));
+	g_mutex_unlock (&(priv->flights_mutex));
+
+	for (i = async_waiters; i != NULL; i = i->next)
+		query_flight_waiter_complete_in_idle (i->data);
+	g_list_free (async_waiters);
+}
+
+/* Blocks until the synchronous @waiter has been handed its flight's response or has been cancelled, then frees @waiter and returns a new reference
+ * to the response (or %NULL), which the caller must parse. */
+static SoupMessage *
+query_flight_wait (QueryFlightWaiter *waiter, GError **error)
+{
+	QueryFlight *flight = waiter->flight;
+	GDataServicePrivate *priv = flight->service->priv;
+	SoupMessage *message = NULL;
+
+	g_mutex_lock (&(priv->flights_mutex));
+
+	while (waiter->detached == FALSE)
+		g_cond_wait (&(flight->cond), &(priv->flights_mutex));
+
+	if (waiter->cancelled == TRUE)
+		query_flight_waiter_set_cancelled_error (waiter, error);
+	else if (flight->error != NULL)
+		g_propagate_error (error, g_error_copy (flight->error));
+	else if (flight->message != NULL)
+		message = g_object_ref (flight->message);
+
+	g_mutex_unlock (&(priv->flights_mutex));
+
+	query_flight_waiter_free (waiter);
+
+	return message;
+}
+
+/* Maximum number of threads used to make the shared requests of synchronous flights. Each of them has at least one caller blocked waiting for it,
+ * so this bounds the number of extra threads used by coalescing; once they're all busy, new flights queue for a thread just as they'd queue for a
+ * connection in the session. This matches libsoup's default limit on the number of connections. */
+#define QUERY_FLIGHT_POOL_MAX_THREADS 10
+
+/* The shared request of a flight; @message is built by the leader, so that nothing else needs to be copied from its query */
+typedef struct {
+	QueryFlight *flight;
+	SoupMessage *message;
+	QueryCacheState cache_state;
+} QueryFlightRequest;
+
+static QueryFlightRequest *
+query_flight_request_new (QueryFlight *flight, GDataAuthorizationDomain *domain, const gchar *uri, GDataQuery *query)
+{
+	QueryFlightRequest *request;
+
+	request = g_slice_new0 (QueryFlightRequest);
+	request->flight = flight;
+	request->message = build_query_message (flight->service, domain, uri, query, &(request->cache_state));
+
+	return request;
+}
+
+static void
+query_flight_request_free (QueryFlightRequest *request)
+{
+	query_cache_state_clear (&(request->cache_state));
+	query_flight_unref (request->flight);
+	g_slice_free (QueryFlightRequest, request);
+}
+
+static void
+query_flight_request_job_cb (QueryFlightRequest *request, gpointer user_data)
+{
+	QueryFlight *flight = request->flight;
+	SoupMessage *message;
+	GError *error = NULL;
+	guint status;
 
-		/* Allow overriding the URI for testing. */
-		soup_uri_set_port (new_uri, _gdata_service_get_https_port ());
+	status = _gdata_service_send_message (flight->service, request->message, flight->cancellable, &error);
+	message = process_query_response (flight->service, request->message, status, &(request->cache_state), &error);
+	query_flight_finish (flight, message, error);
 
-		soup_message_set_uri (message, new_uri);
-		soup_uri_free (new_uri);
+	query_flight_request_free (request);
+}
 
-		/* Send the message again */
-		_gdata_service_actually_send_message (self->priv->session, message, cancellable, error);
-	}
+static gpointer
+query_flight_pool_new (gpointer user_data)
+{
+	return g_thread_pool_new ((GFunc) query_flight_request_job_cb, NULL, QUERY_FLIGHT_POOL_MAX_THREADS, FALSE, NULL);
+}
 
-	/* Not authorised, or authorisation has expired. If we were authorised in the first place, attempt to refresh the authorisation and
-	 * try sending the message again (but only once, so we don't get caught in an infinite loop of denied authorisation errors).
-	 *
-	 * Note that we have to re-process the message with the authoriser so that its authorisation headers get updated after the refresh
-	 * (bgo#653535). */
-	if (message->status_code == SOUP_STATUS_UNAUTHORIZED) {
-		GDataAuthorizer *authorizer = self->priv->authorizer;
+/* Makes the shared request for a new synchronous flight (as returned by query_flight_join()) in another thread, so that its leader doesn't have to
+ * wait for it if it's cancelled. This takes ownership of @flight. */
+static void
+query_flight_start_sync (QueryFlight *flight, GDataAuthorizationDomain *domain, const gchar *uri, GDataQuery *query)
+{
+	static GOnce query_flight_pool_once = G_ONCE_INIT;
 
-		if (authorizer != NULL && gdata_authorizer_refresh_authorization (authorizer, cancellable, NULL) == TRUE) {
-			GDataAuthorizationDomain *domain;
+	g_once (&query_flight_pool_once, query_flight_pool_new, NULL);
+	g_thread_pool_push (query_flight_pool_once.retval, query_flight_request_new (flight, domain, uri, query), NULL);
+}
 
-			/* Re-process the request */
-			domain = g_object_get_data (G_OBJECT (message), "gdata-authorization-domain");
-			g_assert (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
+static void
+query_flight_request_send_cb (GDataService *service, GAsyncResult *async_result, QueryFlightRequest *request)
+{
+	SoupMessage *message;
+	GError *error = NULL;
+	guint status;
 
-			gdata_authorizer_process_request (authorizer, domain, message);
+	status = _gdata_service_send_message_finish (service, async_result, &error);
+	message = process_query_response (service, request->message, status, &(request->cache_state), &error);
+	query_flight_finish (request->flight, message, error);
 
-			/* Send the message again */
-			g_clear_error (error);
-			_gdata_service_actually_send_message (self->priv->session, message, cancellable, error);
-		}
-	}
+	query_flight_request_free (request);
+}
 
-	return message->status_code;
+/* Makes the shared request for a new asynchronous flight (as returned by query_flight_join()) without blocking. This takes ownership of @flight. */
+static void
+query_flight_start_async (QueryFlight *flight, GDataAuthorizationDomain *domain, const gchar *uri, GDataQuery *query)
+{
+	QueryFlightRequest *request;
+
+	request = query_flight_request_new (flight, domain, uri, query);
+	_gdata_service_send_message_async (flight->service, request->message, flight->cancellable,
+	                                   (GAsyncReadyCallback) query_flight_request_send_cb, request);
 }
 
 typedef struct {
@@ -740,8 +3206,14 @@ typedef struct {
 	/* Output */
 	GDataFeed *feed;
 	GDataQueryProgressCallback progress_callback;
+	GDataQueryBatchProgressCallback batch_progress_callback;
 	gpointer progress_user_data;
 	GDestroyNotify destroy_progress_user_data;
+	GMainContext *context; /* main context the progress callbacks are dispatched in */
+
+	/* Request; these must stay at the end, as gdata_service_query_finish() relies on @feed being at the same offset as in GetRulesAsyncData */
+	SoupMessage *message;
+	QueryCacheState cache_state;
 } QueryAsyncData;
 
 static void
@@ -753,29 +3225,105 @@ query_async_data_free (QueryAsyncData *self)
 	g_free (self->feed_uri);
 	if (self->query)
 		g_object_unref (self->query);
+	if (self->message != NULL)
+		g_object_unref (self->message);
+	query_cache_state_clear (&(self->cache_state));
 	if (self->feed)
 		g_object_unref (self->feed);
 
+	/* The progress callbacks may be dispatched after the feed has been parsed, so we can only be sure they've finished once the operation has
+	 * completed */
+	if (self->destroy_progress_user_data != NULL)
+		self->destroy_progress_user_data (self->progress_user_data);
+	if (self->context != NULL)
+		g_main_context_unref (self->context);
+
 	g_slice_free (QueryAsyncData, self);
 }
 
 static void
-query_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
+query_parse_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
 {
 	GError *error = NULL;
 	QueryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
 
-	/* Execute the query and return */
-	data->feed = __gdata_service_query (service, data->domain, data->feed_uri, data->query, data->entry_type, cancellable,
-	                                    data->progress_callback, data->progress_user_data, &error, TRUE);
+	/* Parse the response and return */
+	data->feed = parse_query_response (service, data->message, data->query, data->entry_type, data->progress_callback,
+	                                   data->batch_progress_callback, data->progress_user_data, data->context, &error);
 	if (data->feed == NULL && error != NULL) {
 		g_simple_async_result_set_from_error (result, error);
 		g_error_free (error);
 	}
+}
+
+static void
+query_send_cb (GDataService *service, GAsyncResult *async_result, GSimpleAsyncResult *result)
+{
+	GError *error = NULL;
+	guint status;
+	QueryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	status = _gdata_service_send_message_finish (service, async_result, &error);
+	data->message = process_query_response (service, data->message, status, &(data->cache_state), &error);
+
+	if (data->message != NULL) {
+		/* Parse the response away from the main thread; this completes @result */
+		_gdata_service_run_in_parse_pool (result, (GSimpleAsyncThreadFunc) query_parse_thread, NULL);
+	} else {
+		/* Error, cancellation or a matching ETag */
+		if (error != NULL) {
+			g_simple_async_result_set_from_error (result, error);
+			g_error_free (error);
+		}
+
+		g_simple_async_result_complete (result);
+	}
+
+	g_object_unref (result);
+}
+
+/* Hands the response to a flight of coalesced feed queries to one of its asynchronous waiters, which parses its own feed from it so that its progress
+ * callbacks are called in the same way as for an uncoalesced query */
+static void
+query_flight_deliver_feed (GSimpleAsyncResult *result, SoupMessage *message, const GError *error)
+{
+	QueryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	if (message != NULL) {
+		/* This completes @result */
+		data->message = g_object_ref (message);
+		_gdata_service_run_in_parse_pool (result, (GSimpleAsyncThreadFunc) query_parse_thread, NULL);
+		return;
+	}
+
+	/* Error, cancellation or a matching ETag */
+	if (error != NULL)
+		g_simple_async_result_set_from_error (result, error);
+
+	g_simple_async_result_complete (result);
+}
+
+/* Send the query without blocking a thread; only the parsing of the response is done in a thread (from the parse pool). */
+static void
+query_async_start (GDataService *self, GSimpleAsyncResult *result, GCancellable *cancellable)
+{
+	QueryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	if (self->priv->coalesce_queries == TRUE) {
+		QueryFlight *flight;
 
-	if (data->destroy_progress_user_data != NULL) {
-		data->destroy_progress_user_data (data->progress_user_data);
+		if (query_flight_join (self, build_query_flight_key ("feed", data->domain, data->feed_uri, data->query, data->entry_type),
+		                       cancellable, result, query_flight_deliver_feed, &flight) != NULL) {
+			/* If we've started a new flight, make its request */
+			if (flight != NULL)
+				query_flight_start_async (flight, data->domain, data->feed_uri, data->query);
+
+			return;
+		}
 	}
+
+	data->message = build_query_message (self, data->domain, data->feed_uri, data->query, &(data->cache_state));
+	_gdata_service_send_message_async (self, data->message, cancellable, (GAsyncReadyCallback) query_send_cb, g_object_ref (result));
 }
 
 /**
@@ -796,7 +3344,8 @@ query_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *c
  * Queries the service's @feed_uri feed to build a #GDataFeed. @self, @feed_uri and
  * @query are all reffed/copied when this function is called, so can safely be freed after this function returns.
  *
- * For more details, see gdata_service_query(), which is the synchronous version of this function.
+ * For more details, see gdata_service_query(), which is the synchronous version of this function. @progress_callback is called in the
+ * thread-default main context of the thread this function is called in, and all calls to it are made before @callback is called.
  *
  * When the operation is finished, @callback will be called. You can then call gdata_service_query_finish()
  * to get the results of the operation.
@@ -823,14 +3372,82 @@ gdata_service_query_async (GDataService *self, GDataAuthorizationDomain *domain,
 	data->feed_uri = g_strdup (feed_uri);
 	data->query = (query != NULL) ? g_object_ref (query) : NULL;
 	data->entry_type = entry_type;
+	data->message = NULL;
+	memset (&(data->cache_state), 0, sizeof (QueryCacheState));
 	data->feed = NULL;
 	data->progress_callback = progress_callback;
+	data->batch_progress_callback = NULL;
+	data->progress_user_data = progress_user_data;
+	data->destroy_progress_user_data = destroy_progress_user_data;
+	data->context = g_main_context_get_thread_default ();
+	data->context = g_main_context_ref ((data->context != NULL) ? data->context : g_main_context_default ());
+
+	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_query_async);
+	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) query_async_data_free);
+	query_async_start (self, result, cancellable);
+	g_object_unref (result);
+}
+
+/**
+ * gdata_service_query_batched_async:
+ * @self: a #GDataService
+ * @domain: (allow-none): the #GDataAuthorizationDomain the query falls under, or %NULL
+ * @feed_uri: the feed URI to query, including the host name and protocol
+ * @query: (allow-none): a #GDataQuery with the query parameters, or %NULL
+ * @entry_type: a #GType for the #GDataEntry<!-- -->s to build from the XML
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @progress_callback: (allow-none) (closure progress_user_data): a #GDataQueryBatchProgressCallback to call when entries are loaded, or %NULL
+ * @progress_user_data: (closure): data to pass to the @progress_callback function
+ * @destroy_progress_user_data: (allow-none): the function to call when @progress_callback will not be called any more, or %NULL. This function will be
+ * called with @progress_user_data as a parameter and can be used to free any memory allocated for it.
+ * @callback: a #GAsyncReadyCallback to call when the query is finished
+ * @user_data: (closure): data to pass to the @callback function
+ *
+ * Queries the service's @feed_uri feed to build a #GDataFeed, in the same way as gdata_service_query_async(). The difference is that
+ * @progress_callback is passed the entries which have been parsed since it was last called (in batches of a limited size, so that the main context
+ * stays responsive), rather than being called once for each entry. This is more efficient for applications which add entries to a large model or
+ * view, since they can do so in bulk.
+ *
+ * When the operation is finished, @callback will be called. You can then call gdata_service_query_finish()
+ * to get the results of the operation.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_service_query_batched_async (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query,
+                                   GType entry_type, GCancellable *cancellable,
+                                   GDataQueryBatchProgressCallback progress_callback, gpointer progress_user_data,
+                                   GDestroyNotify destroy_progress_user_data, GAsyncReadyCallback callback, gpointer user_data)
+{
+	GSimpleAsyncResult *result;
+	QueryAsyncData *data;
+
+	g_return_if_fail (GDATA_IS_SERVICE (self));
+	g_return_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
+	g_return_if_fail (feed_uri != NULL);
+	g_return_if_fail (g_type_is_a (entry_type, GDATA_TYPE_ENTRY));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (callback != NULL);
+
+	data = g_slice_new (QueryAsyncData);
+	data->domain = (domain != NULL) ? g_object_ref (domain) : NULL;
+	data->feed_uri = g_strdup (feed_uri);
+	data->query = (query != NULL) ? g_object_ref (query) : NULL;
+	data->entry_type = entry_type;
+	data->message = NULL;
+	memset (&(data->cache_state), 0, sizeof (QueryCacheState));
+	data->feed = NULL;
+	data->progress_callback = NULL;
+	data->batch_progress_callback = progress_callback;
 	data->progress_user_data = progress_user_data;
 	data->destroy_progress_user_data = destroy_progress_user_data;
+	data->context = g_main_context_get_thread_default ();
+	data->context = g_main_context_ref ((data->context != NULL) ? data->context : g_main_context_default ());
 
+	/* Use the same source tag as gdata_service_query_async() so that gdata_service_query_finish() can be used */
 	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_query_async);
 	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) query_async_data_free);
-	g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) query_thread, G_PRIORITY_DEFAULT, cancellable);
+	query_async_start (self, result, cancellable);
 	g_object_unref (result);
 }
 
@@ -840,7 +3457,7 @@ gdata_service_query_async (GDataService *self, GDataAuthorizationDomain *domain,
  * @async_result: a #GAsyncResult
  * @error: a #GError, or %NULL
  *
- * Finishes an asynchronous query operation started with gdata_service_query_async().
+ * Finishes an asynchronous query operation started with gdata_service_query_async() or gdata_service_query_batched_async().
  *
  * Return value: (transfer full): a #GDataFeed of query results, or %NULL; unref with g_object_unref()
  **/
@@ -873,96 +3490,34 @@ _gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, cons
 {
 	SoupMessage *message;
 	guint status;
-	const gchar *etag = NULL;
-
-	/* Append the ETag header if possible */
-	if (query != NULL)
-		etag = gdata_query_get_etag (query);
+	QueryCacheState state = { NULL, };
 
-	/* Build the message */
-	if (query != NULL) {
-		gchar *query_uri = gdata_query_get_query_uri (query, feed_uri);
-		message = _gdata_service_build_message (self, domain, SOUP_METHOD_GET, query_uri, etag, FALSE);
-		g_free (query_uri);
-	} else {
-		message = _gdata_service_build_message (self, domain, SOUP_METHOD_GET, feed_uri, etag, FALSE);
-	}
+	message = build_query_message (self, domain, feed_uri, query, &state);
 
 	/* Note that cancellation only applies to network activity; not to the processing done afterwards */
 	status = _gdata_service_send_message (self, message, cancellable, error);
+	message = process_query_response (self, message, status, &state, error);
 
-	if (status == SOUP_STATUS_NOT_MODIFIED || status == SOUP_STATUS_CANCELLED) {
-		/* Not modified (ETag has worked), or cancelled (in which case the error has been set) */
-		g_object_unref (message);
-		return NULL;
-	} else if (status != SOUP_STATUS_OK) {
-		/* Error */
-		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (self);
-		g_assert (klass->parse_error_response != NULL);
-		klass->parse_error_response (self, GDATA_OPERATION_QUERY, status, message->reason_phrase, message->response_body->data,
-		                             message->response_body->length, error);
-		g_object_unref (message);
-		return NULL;
-	}
+	query_cache_state_clear (&state);
 
 	return message;
 }
 
 static GDataFeed *
 __gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query, GType entry_type,
-                       GCancellable *cancellable, GDataQueryProgressCallback progress_callback, gpointer progress_user_data, GError **error,
-                       gboolean is_async)
+                       GCancellable *cancellable, GDataQueryProgressCallback progress_callback,
+                       GDataQueryBatchProgressCallback batch_progress_callback, gpointer progress_user_data, GError **error)
 {
-	GDataServiceClass *klass;
-	GDataFeed *feed = NULL;
+	GDataFeed *feed;
 	SoupMessage *message;
-	SoupMessageHeaders *headers;
-	const gchar *content_type;
 
 	message = _gdata_service_query (self, domain, feed_uri, query, cancellable, error);
 	if (message == NULL)
 		return NULL;
 
-	g_assert (message->response_body->data != NULL);
-	klass = GDATA_SERVICE_GET_CLASS (self);
-
-	headers = message->response_headers;
-	content_type = soup_message_headers_get_content_type (headers, NULL);
-
-	if (content_type != NULL && strcmp (content_type, "application/json") == 0) {
-		/* Definitely JSON. */
-		g_debug("JSON content type detected.");
-		feed = _gdata_feed_new_from_json (klass->feed_type, message->response_body->data, message->response_body->length, entry_type,
-		                                  progress_callback, progress_user_data, is_async, error);
-	} else {
-		/* Potentially XML. Don't bother checking the Content-Type, since the parser
-		 * will fail gracefully if the response body is not valid XML. */
-		g_debug("XML content type detected.");
-		feed = _gdata_feed_new_from_xml (klass->feed_type, message->response_body->data, message->response_body->length, entry_type,
-		                                 progress_callback, progress_user_data, is_async, error);
-	}
-
+	feed = parse_query_response (self, message, query, entry_type, progress_callback, batch_progress_callback, progress_user_data, NULL, error);
 	g_object_unref (message);
 
-	if (feed == NULL)
-		return NULL;
-
-	/* Update the query with the feed's ETag */
-	if (query != NULL && feed != NULL && gdata_feed_get_etag (feed) != NULL)
-		gdata_query_set_etag (query, gdata_feed_get_etag (feed));
-
-	/* Update the query with the next and previous URIs from the feed */
-	if (query != NULL && feed != NULL) {
-		GDataLink *_link;
-
-		_link = gdata_feed_look_up_link (feed, "next");
-		if (_link != NULL)
-			_gdata_query_set_next_uri (query, gdata_link_get_uri (_link));
-		_link = gdata_feed_look_up_link (feed, "previous");
-		if (_link != NULL)
-			_gdata_query_set_previous_uri (query, gdata_link_get_uri (_link));
-	}
-
 	return feed;
 }
 
@@ -989,14 +3544,18 @@ __gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, con
  * A %GDATA_SERVICE_ERROR_PROTOCOL_ERROR will be returned if the server indicates there is a problem with the query, but subclasses may override
  * this and return their own errors. See their documentation for more details.
  *
- * For each entry in the response feed, @progress_callback will be called in the main thread. If there was an error parsing the XML response,
+ * For each entry in the response feed, @progress_callback will be called in the calling thread. If there was an error parsing the XML response,
  * a #GDataParserError will be returned.
  *
  * If the query is successful and the feed supports pagination, @query will be updated with the pagination URIs, and the next or previous page
  * can then be loaded by calling gdata_query_next_page() or gdata_query_previous_page() before running the query again.
  *
  * If the #GDataQuery's ETag is set and it finds a match on the server, %NULL will be returned, but @error will remain unset. Otherwise,
- * @query's ETag will be updated with the ETag from the returned feed, if available.
+ * @query's ETag will be updated with the ETag from the returned feed, if available. If #GDataService:cache is set and holds a response for the
+ * query with the same ETag (or @query's ETag is unset), the cached response will be parsed and returned instead of %NULL.
+ *
+ * If #GDataService:coalesce-queries is %TRUE and an identical query is already in progress, its request will be shared with this query. See the
+ * documentation for #GDataService:coalesce-queries for more details.
  *
  * Return value: (transfer full): a #GDataFeed of query results, or %NULL; unref with g_object_unref()
  *
@@ -1013,7 +3572,66 @@ gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, const
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	return __gdata_service_query (self, domain, feed_uri, query, entry_type, cancellable, progress_callback, progress_user_data, error, FALSE);
+	if (self->priv->coalesce_queries == TRUE) {
+		QueryFlightWaiter *waiter;
+		QueryFlight *flight;
+		GDataFeed *feed;
+
+		waiter = query_flight_join (self, build_query_flight_key ("feed", domain, feed_uri, query, entry_type), cancellable, NULL, NULL,
+		                            &flight);
+
+		if (waiter != NULL) {
+			SoupMessage *message;
+
+			/* If we've started a new flight, make its request */
+			if (flight != NULL)
+				query_flight_start_sync (flight, domain, feed_uri, query);
+
+			/* Parse our own feed from the shared response */
+			message = query_flight_wait (waiter, error);
+			if (message == NULL)
+				return NULL;
+
+			feed = parse_query_response (self, message, query, entry_type, progress_callback, NULL, progress_user_data, NULL, error);
+			g_object_unref (message);
+
+			return feed;
+		}
+	}
+
+	return __gdata_service_query (self, domain, feed_uri, query, entry_type, cancellable, progress_callback, NULL, progress_user_data, error);
+}
+
+/* Parses the single entry from the response to a query built by gdata_service_query_single_entry(). This may be called in any thread. */
+static GDataEntry *
+parse_single_entry_response (SoupMessage *message, GType entry_type, GError **error)
+{
+	GDataEntry *entry;
+	gint64 parse_start_time;
+
+	g_assert (message->response_body->data != NULL);
+	parse_start_time = g_get_monotonic_time ();
+	entry = GDATA_ENTRY (gdata_parsable_new_from_xml (entry_type, message->response_body->data, message->response_body->length, error));
+	_gdata_service_set_request_parse_stats (message, g_get_monotonic_time () - parse_start_time, (entry != NULL) ? 1 : 0);
+
+	return entry;
+}
+
+static GDataEntry *
+query_single_entry (GDataService *self, GDataAuthorizationDomain *domain, const gchar *entry_uri, GDataQuery *query, GType entry_type,
+                    GCancellable *cancellable, GError **error)
+{
+	GDataEntry *entry;
+	SoupMessage *message;
+
+	message = _gdata_service_query (self, domain, entry_uri, query, cancellable, error);
+	if (message == NULL)
+		return NULL;
+
+	entry = parse_single_entry_response (message, entry_type, error);
+	g_object_unref (message);
+
+	return entry;
 }
 
 /**
@@ -1033,7 +3651,10 @@ gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, const
  * will cause a server-side error if used. The most useful property to use is #GDataQuery:etag, which will cause the
  * server to not return anything if the entry hasn't been modified since it was given the specified ETag; thus saving
  * bandwidth. If the server does not return anything for this reason, gdata_service_query_single_entry() will return
- * %NULL, but will not set an error in @error.
+ * %NULL, but will not set an error in @error. (If #GDataService:cache is set and holds the unmodified entry, the cached entry will be returned
+ * instead.)
+ *
+ * Identical queries may be coalesced if #GDataService:coalesce-queries is %TRUE.
  *
  * Return value: (transfer full): a #GDataEntry, or %NULL; unref with g_object_unref()
  *
@@ -1046,7 +3667,7 @@ gdata_service_query_single_entry (GDataService *self, GDataAuthorizationDomain *
 	GDataEntryClass *klass;
 	GDataEntry *entry;
 	gchar *entry_uri;
-	SoupMessage *message;
+	QueryFlightWaiter *waiter = NULL;
 
 	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
 	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), NULL);
@@ -1061,18 +3682,31 @@ gdata_service_query_single_entry (GDataService *self, GDataAuthorizationDomain *
 	g_assert (klass->get_entry_uri != NULL);
 
 	entry_uri = klass->get_entry_uri (entry_id);
-	message = _gdata_service_query (GDATA_SERVICE (self), domain, entry_uri, query, cancellable, error);
-	g_free (entry_uri);
+	g_type_class_unref (klass);
 
-	if (message == NULL) {
-		g_type_class_unref (klass);
-		return NULL;
+	if (self->priv->coalesce_queries == TRUE) {
+		QueryFlight *flight;
+
+		waiter = query_flight_join (self, build_query_flight_key ("entry", domain, entry_uri, query, entry_type), cancellable, NULL, NULL,
+		                            &flight);
+
+		/* If we've started a new flight, make its request */
+		if (waiter != NULL && flight != NULL)
+			query_flight_start_sync (flight, domain, entry_uri, query);
 	}
 
-	g_assert (message->response_body->data != NULL);
-	entry = GDATA_ENTRY (gdata_parsable_new_from_xml (entry_type, message->response_body->data, message->response_body->length, error));
-	g_object_unref (message);
-	g_type_class_unref (klass);
+	if (waiter != NULL) {
+		/* Parse our own entry from the shared response */
+		SoupMessage *message = query_flight_wait (waiter, error);
+
+		entry = (message != NULL) ? parse_single_entry_response (message, entry_type, error) : NULL;
+		if (message != NULL)
+			g_object_unref (message);
+	} else {
+		entry = query_single_entry (self, domain, entry_uri, query, entry_type, cancellable, error);
+	}
+
+	g_free (entry_uri);
 
 	return entry;
 }
@@ -1082,6 +3716,8 @@ typedef struct {
 	gchar *entry_id;
 	GDataQuery *query;
 	GType entry_type;
+	SoupMessage *message;
+	QueryCacheState cache_state;
 } QuerySingleEntryAsyncData;
 
 static void
@@ -1093,18 +3729,21 @@ query_single_entry_async_data_free (QuerySingleEntryAsyncData *data)
 	g_free (data->entry_id);
 	if (data->query != NULL)
 		g_object_unref (data->query);
+	if (data->message != NULL)
+		g_object_unref (data->message);
+	query_cache_state_clear (&(data->cache_state));
 	g_slice_free (QuerySingleEntryAsyncData, data);
 }
 
 static void
-query_single_entry_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
+query_single_entry_parse_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
 {
 	GDataEntry *entry;
 	GError *error = NULL;
 	QuerySingleEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
 
-	/* Execute the query and return */
-	entry = gdata_service_query_single_entry (service, data->domain, data->entry_id, data->query, data->entry_type, cancellable, &error);
+	/* Parse the response and return */
+	entry = parse_single_entry_response (data->message, data->entry_type, &error);
 	if (entry == NULL && error != NULL) {
 		g_simple_async_result_set_from_error (result, error);
 		g_error_free (error);
@@ -1114,6 +3753,56 @@ query_single_entry_thread (GSimpleAsyncResult *result, GDataService *service, GC
 	g_simple_async_result_set_op_res_gpointer (result, entry, (GDestroyNotify) g_object_unref);
 }
 
+static void
+query_single_entry_send_cb (GDataService *service, GAsyncResult *async_result, GSimpleAsyncResult *result)
+{
+	GError *error = NULL;
+	guint status;
+	QuerySingleEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	status = _gdata_service_send_message_finish (service, async_result, &error);
+	data->message = process_query_response (service, data->message, status, &(data->cache_state), &error);
+
+	if (data->message != NULL) {
+		/* Parse the response away from the main thread; this completes @result */
+		_gdata_service_run_in_parse_pool (result, (GSimpleAsyncThreadFunc) query_single_entry_parse_thread, NULL);
+	} else {
+		/* Error, cancellation or a matching ETag */
+		if (error != NULL) {
+			g_simple_async_result_set_from_error (result, error);
+			g_error_free (error);
+		} else {
+			g_simple_async_result_set_op_res_gpointer (result, NULL, NULL);
+		}
+
+		g_simple_async_result_complete (result);
+	}
+
+	g_object_unref (result);
+}
+
+/* Hands the response to a flight of coalesced single entry queries to one of its asynchronous waiters, which parses its own entry from it */
+static void
+query_flight_deliver_entry (GSimpleAsyncResult *result, SoupMessage *message, const GError *error)
+{
+	QuerySingleEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	if (message != NULL) {
+		/* This completes @result */
+		data->message = g_object_ref (message);
+		_gdata_service_run_in_parse_pool (result, (GSimpleAsyncThreadFunc) query_single_entry_parse_thread, NULL);
+		return;
+	}
+
+	/* Error, cancellation or a matching ETag */
+	if (error != NULL)
+		g_simple_async_result_set_from_error (result, error);
+	else
+		g_simple_async_result_set_op_res_gpointer (result, NULL, NULL);
+
+	g_simple_async_result_complete (result);
+}
+
 /**
  * gdata_service_query_single_entry_async:
  * @self: a #GDataService
@@ -1142,6 +3831,9 @@ gdata_service_query_single_entry_async (GDataService *self, GDataAuthorizationDo
 {
 	GSimpleAsyncResult *result;
 	QuerySingleEntryAsyncData *data;
+	GDataEntryClass *klass;
+	QueryFlight *flight;
+	gchar *entry_uri;
 
 	g_return_if_fail (GDATA_IS_SERVICE (self));
 	g_return_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain));
@@ -1156,10 +3848,32 @@ gdata_service_query_single_entry_async (GDataService *self, GDataAuthorizationDo
 	data->query = (query != NULL) ? g_object_ref (query) : NULL;
 	data->entry_id = g_strdup (entry_id);
 	data->entry_type = entry_type;
+	data->message = NULL;
+	memset (&(data->cache_state), 0, sizeof (QueryCacheState));
+
+	/* Query for just the specified entry */
+	klass = GDATA_ENTRY_CLASS (g_type_class_ref (entry_type));
+	g_assert (klass->get_entry_uri != NULL);
+
+	entry_uri = klass->get_entry_uri (entry_id);
+	g_type_class_unref (klass);
 
 	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_query_single_entry_async);
 	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) query_single_entry_async_data_free);
-	g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) query_single_entry_thread, G_PRIORITY_DEFAULT, cancellable);
+
+	if (self->priv->coalesce_queries == TRUE &&
+	    query_flight_join (self, build_query_flight_key ("entry", domain, entry_uri, query, entry_type), cancellable, result,
+	                       query_flight_deliver_entry, &flight) != NULL) {
+		/* If we've started a new flight, make its request */
+		if (flight != NULL)
+			query_flight_start_async (flight, domain, entry_uri, query);
+	} else {
+		data->message = build_query_message (self, domain, entry_uri, query, &(data->cache_state));
+		_gdata_service_send_message_async (self, data->message, cancellable, (GAsyncReadyCallback) query_single_entry_send_cb,
+		                                   g_object_ref (result));
+	}
+
+	g_free (entry_uri);
 	g_object_unref (result);
 }
 
@@ -1196,10 +3910,141 @@ gdata_service_query_single_entry_finish (GDataService *self, GAsyncResult *async
 	return NULL;
 }
 
+static SoupMessage *
+build_insert_entry_message (GDataService *self, GDataAuthorizationDomain *domain, const gchar *upload_uri, GDataEntry *entry)
+{
+	SoupMessage *message;
+	gchar *upload_data;
+	GDataParsableClass *klass;
+
+	message = _gdata_service_build_message (self, domain, SOUP_METHOD_POST, upload_uri, NULL, FALSE);
+
+	/* Append the data */
+	klass = GDATA_PARSABLE_GET_CLASS (entry);
+	g_assert (klass->get_content_type != NULL);
+	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
+		upload_data = gdata_parsable_get_json (GDATA_PARSABLE (entry));
+		_gdata_service_set_request_body (self, message, "application/json", upload_data, strlen (upload_data));
+	} else {
+		upload_data = gdata_parsable_get_xml (GDATA_PARSABLE (entry));
+		_gdata_service_set_request_body (self, message, "application/atom+xml", upload_data, strlen (upload_data));
+	}
+
+	return message;
+}
+
+static SoupMessage *
+build_update_entry_message (GDataService *self, GDataAuthorizationDomain *domain, GDataEntry *entry)
+{
+	SoupMessage *message;
+	GDataLink *_link;
+	gchar *upload_data;
+	GDataParsableClass *klass;
+
+	/* Append the data */
+	klass = GDATA_PARSABLE_GET_CLASS (entry);
+	g_assert (klass->get_content_type != NULL);
+	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
+		/* Get the edit URI */
+		_link = gdata_entry_look_up_link (entry, GDATA_LINK_SELF);
+		g_assert (_link != NULL);
+		message = _gdata_service_build_message (self, domain, SOUP_METHOD_PUT, gdata_link_get_uri (_link), gdata_entry_get_etag (entry), TRUE);
+		upload_data = gdata_parsable_get_json (GDATA_PARSABLE (entry));
+		_gdata_service_set_request_body (self, message, "application/json", upload_data, strlen (upload_data));
+	} else {
+		/* Get the edit URI */
+		_link = gdata_entry_look_up_link (entry, GDATA_LINK_EDIT);
+		g_assert (_link != NULL);
+		message = _gdata_service_build_message (self, domain, SOUP_METHOD_PUT, gdata_link_get_uri (_link), gdata_entry_get_etag (entry), TRUE);
+		upload_data = gdata_parsable_get_xml (GDATA_PARSABLE (entry));
+		_gdata_service_set_request_body (self, message, "application/atom+xml", upload_data, strlen (upload_data));
+	}
+
+	return message;
+}
+
+static SoupMessage *
+build_delete_entry_message (GDataService *self, GDataAuthorizationDomain *domain, GDataEntry *entry)
+{
+	SoupMessage *message;
+	GDataLink *_link;
+	gchar *fixed_uri;
+	GDataParsableClass *klass;
+
+	/* Get the edit URI. We have to fix it to always use HTTPS as YouTube videos appear to incorrectly return a HTTP URI as their edit URI. */
+	klass = GDATA_PARSABLE_GET_CLASS (entry);
+	g_assert (klass->get_content_type != NULL);
+	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
+		_link = gdata_entry_look_up_link (entry, GDATA_LINK_SELF);
+	} else {
+		_link = gdata_entry_look_up_link (entry, GDATA_LINK_EDIT);
+	}
+	g_assert (_link != NULL);
+
+	fixed_uri = _gdata_service_fix_uri_scheme (gdata_link_get_uri (_link));
+	message = _gdata_service_build_message (self, domain, SOUP_METHOD_DELETE, fixed_uri, gdata_entry_get_etag (entry), TRUE);
+	g_free (fixed_uri);
+
+	return message;
+}
+
+/* Handles the response to an insertion or update of @entry, returning the updated entry parsed from the response on success. This may be called in
+ * any thread. */
+static GDataEntry *
+process_entry_response (GDataService *self, GDataOperationType operation_type, SoupMessage *message, guint status, GDataEntry *entry,
+                        GError **error)
+{
+	GDataParsableClass *klass;
+
+	if (status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
+		/* Redirect error or cancelled */
+		return NULL;
+	} else if (status != SOUP_STATUS_OK && (operation_type != GDATA_OPERATION_INSERTION || status != SOUP_STATUS_CREATED)) {
+		/* Error - for XML apis Google returns CREATED for insertions and for JSON it returns OK */
+		GDataServiceClass *service_klass = GDATA_SERVICE_GET_CLASS (self);
+		g_assert (service_klass->parse_error_response != NULL);
+		service_klass->parse_error_response (self, operation_type, status, message->reason_phrase, message->response_body->data,
+		                                     message->response_body->length, error);
+		return NULL;
+	}
+
+	/* Parse the XML or JSON according to GDataEntry type; create and return a new GDataEntry of the same type as @entry */
+	g_assert (message->response_body->data != NULL);
+	klass = GDATA_PARSABLE_GET_CLASS (entry);
+	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
+		return GDATA_ENTRY (gdata_parsable_new_from_json (G_OBJECT_TYPE (entry), message->response_body->data, message->response_body->length,
+		                                                  error));
+	} else {
+		return GDATA_ENTRY (gdata_parsable_new_from_xml (G_OBJECT_TYPE (entry), message->response_body->data, message->response_body->length,
+		                                                 error));
+	}
+}
+
+/* Handles the response to a deletion. */
+static gboolean
+process_delete_response (GDataService *self, SoupMessage *message, guint status, GError **error)
+{
+	if (status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
+		/* Redirect error or cancelled */
+		return FALSE;
+	} else if (status != SOUP_STATUS_OK) {
+		/* Error */
+		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (self);
+		g_assert (klass->parse_error_response != NULL);
+		klass->parse_error_response (self, GDATA_OPERATION_DELETION, status, message->reason_phrase, message->response_body->data,
+		                             message->response_body->length, error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 typedef struct {
 	GDataAuthorizationDomain *domain;
 	gchar *upload_uri;
 	GDataEntry *entry;
+	SoupMessage *message;
+	guint status;
 } InsertEntryAsyncData;
 
 static void
@@ -1211,19 +4056,21 @@ insert_entry_async_data_free (InsertEntryAsyncData *self)
 	g_free (self->upload_uri);
 	if (self->entry)
 		g_object_unref (self->entry);
+	if (self->message != NULL)
+		g_object_unref (self->message);
 
 	g_slice_free (InsertEntryAsyncData, self);
 }
 
 static void
-insert_entry_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
+insert_entry_parse_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
 {
 	GDataEntry *updated_entry;
 	GError *error = NULL;
 	InsertEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
 
-	/* Insert the entry and return */
-	updated_entry = gdata_service_insert_entry (service, data->domain, data->upload_uri, data->entry, cancellable, &error);
+	/* Parse the response and return */
+	updated_entry = process_entry_response (service, GDATA_OPERATION_INSERTION, data->message, data->status, data->entry, &error);
 	if (updated_entry == NULL) {
 		g_simple_async_result_set_from_error (result, error);
 		g_error_free (error);
@@ -1234,6 +4081,26 @@ insert_entry_thread (GSimpleAsyncResult *result, GDataService *service, GCancell
 	g_simple_async_result_set_op_res_gpointer (result, updated_entry, (GDestroyNotify) g_object_unref);
 }
 
+static void
+insert_entry_send_cb (GDataService *service, GAsyncResult *async_result, GSimpleAsyncResult *result)
+{
+	GError *error = NULL;
+	InsertEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	data->status = _gdata_service_send_message_finish (service, async_result, &error);
+
+	if (error != NULL) {
+		/* Redirect error or cancelled */
+		g_simple_async_result_take_error (result, error);
+		g_simple_async_result_complete (result);
+	} else {
+		/* Parse the response away from the main thread; this completes @result */
+		_gdata_service_run_in_parse_pool (result, (GSimpleAsyncThreadFunc) insert_entry_parse_thread, NULL);
+	}
+
+	g_object_unref (result);
+}
+
 /**
  * gdata_service_insert_entry_async:
  * @self: a #GDataService
@@ -1267,14 +4134,25 @@ gdata_service_insert_entry_async (GDataService *self, GDataAuthorizationDomain *
 	g_return_if_fail (GDATA_IS_ENTRY (entry));
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
+	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_insert_entry_async);
+
+	if (gdata_entry_is_inserted (entry) == TRUE) {
+		g_simple_async_result_set_error (result, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_ENTRY_ALREADY_INSERTED,
+		                                 _("The entry has already been inserted."));
+		g_simple_async_result_complete_in_idle (result);
+		g_object_unref (result);
+		return;
+	}
+
 	data = g_slice_new (InsertEntryAsyncData);
 	data->domain = (domain != NULL) ? g_object_ref (domain) : NULL;
 	data->upload_uri = g_strdup (upload_uri);
 	data->entry = g_object_ref (entry);
+	data->message = build_insert_entry_message (self, domain, upload_uri, entry);
+	data->status = SOUP_STATUS_NONE;
 
-	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_insert_entry_async);
 	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) insert_entry_async_data_free);
-	g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) insert_entry_thread, G_PRIORITY_DEFAULT, cancellable);
+	_gdata_service_send_message_async (self, data->message, cancellable, (GAsyncReadyCallback) insert_entry_send_cb, g_object_ref (result));
 	g_object_unref (result);
 }
 
@@ -1348,9 +4226,7 @@ gdata_service_insert_entry (GDataService *self, GDataAuthorizationDomain *domain
 {
 	GDataEntry *updated_entry;
 	SoupMessage *message;
-	gchar *upload_data;
 	guint status;
-	GDataParsableClass *klass;
 
 	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
 	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), NULL);
@@ -1365,45 +4241,11 @@ gdata_service_insert_entry (GDataService *self, GDataAuthorizationDomain *domain
 		return NULL;
 	}
 
-	message = _gdata_service_build_message (self, domain, SOUP_METHOD_POST, upload_uri, NULL, FALSE);
-
-	/* Append the data */
-	klass = GDATA_PARSABLE_GET_CLASS (entry);
-	g_assert (klass->get_content_type != NULL);
-	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
-		upload_data = gdata_parsable_get_json (GDATA_PARSABLE (entry));
-		soup_message_set_request (message, "application/json", SOUP_MEMORY_TAKE, upload_data, strlen (upload_data));
-	} else {
-		upload_data = gdata_parsable_get_xml (GDATA_PARSABLE (entry));
-		soup_message_set_request (message, "application/atom+xml", SOUP_MEMORY_TAKE, upload_data, strlen (upload_data));
-	}
+	message = build_insert_entry_message (self, domain, upload_uri, entry);
 
 	/* Send the message */
 	status = _gdata_service_send_message (self, message, cancellable, error);
-
-	if (status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
-		/* Redirect error or cancelled */
-		g_object_unref (message);
-		return NULL;
-	} else if (status != SOUP_STATUS_CREATED && status != SOUP_STATUS_OK) {
-		/* Error - for XML apis Google returns CREATED and for JSON it returns OK */
-		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (self);
-		g_assert (klass->parse_error_response != NULL);
-		klass->parse_error_response (self, GDATA_OPERATION_INSERTION, status, message->reason_phrase, message->response_body->data,
-		                             message->response_body->length, error);
-		g_object_unref (message);
-		return NULL;
-	}
-
-	/* Parse the XML or JSON according to GDataEntry type; create and return a new GDataEntry of the same type as @entry */
-	g_assert (message->response_body->data != NULL);
-	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
-		updated_entry = GDATA_ENTRY (gdata_parsable_new_from_json (G_OBJECT_TYPE (entry), message->response_body->data, message->response_body->length,
-		                             error));
-	} else {
-		updated_entry = GDATA_ENTRY (gdata_parsable_new_from_xml (G_OBJECT_TYPE (entry), message->response_body->data, message->response_body->length,
-		                             error));
-	}
+	updated_entry = process_entry_response (self, GDATA_OPERATION_INSERTION, message, status, entry, error);
 	g_object_unref (message);
 
 	return updated_entry;
@@ -1412,6 +4254,8 @@ gdata_service_insert_entry (GDataService *self, GDataAuthorizationDomain *domain
 typedef struct {
 	GDataAuthorizationDomain *domain;
 	GDataEntry *entry;
+	SoupMessage *message;
+	guint status;
 } UpdateEntryAsyncData;
 
 static void
@@ -1423,18 +4267,21 @@ update_entry_async_data_free (UpdateEntryAsyncData *data)
 	if (data->entry != NULL)
 		g_object_unref (data->entry);
 
+	if (data->message != NULL)
+		g_object_unref (data->message);
+
 	g_slice_free (UpdateEntryAsyncData, data);
 }
 
 static void
-update_entry_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
+update_entry_parse_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
 {
 	GDataEntry *updated_entry;
 	GError *error = NULL;
 	UpdateEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
 
-	/* Update the entry and return */
-	updated_entry = gdata_service_update_entry (service, data->domain, data->entry, cancellable, &error);
+	/* Parse the response and return */
+	updated_entry = process_entry_response (service, GDATA_OPERATION_UPDATE, data->message, data->status, data->entry, &error);
 	if (updated_entry == NULL) {
 		g_simple_async_result_set_from_error (result, error);
 		g_error_free (error);
@@ -1445,6 +4292,26 @@ update_entry_thread (GSimpleAsyncResult *result, GDataService *service, GCancell
 	g_simple_async_result_set_op_res_gpointer (result, updated_entry, (GDestroyNotify) g_object_unref);
 }
 
+static void
+update_entry_send_cb (GDataService *service, GAsyncResult *async_result, GSimpleAsyncResult *result)
+{
+	GError *error = NULL;
+	UpdateEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
+
+	data->status = _gdata_service_send_message_finish (service, async_result, &error);
+
+	if (error != NULL) {
+		/* Redirect error or cancelled */
+		g_simple_async_result_take_error (result, error);
+		g_simple_async_result_complete (result);
+	} else {
+		/* Parse the response away from the main thread; this completes @result */
+		_gdata_service_run_in_parse_pool (result, (GSimpleAsyncThreadFunc) update_entry_parse_thread, NULL);
+	}
+
+	g_object_unref (result);
+}
+
 /**
  * gdata_service_update_entry_async:
  * @self: a #GDataService
@@ -1479,10 +4346,12 @@ gdata_service_update_entry_async (GDataService *self, GDataAuthorizationDomain *
 	data = g_slice_new (UpdateEntryAsyncData);
 	data->domain = (domain != NULL) ? g_object_ref (domain) : NULL;
 	data->entry = g_object_ref (entry);
+	data->message = build_update_entry_message (self, domain, entry);
+	data->status = SOUP_STATUS_NONE;
 
 	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_update_entry_async);
 	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) update_entry_async_data_free);
-	g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) update_entry_thread, G_PRIORITY_DEFAULT, cancellable);
+	_gdata_service_send_message_async (self, data->message, cancellable, (GAsyncReadyCallback) update_entry_send_cb, g_object_ref (result));
 	g_object_unref (result);
 }
 
@@ -1550,62 +4419,20 @@ GDataEntry *
 gdata_service_update_entry (GDataService *self, GDataAuthorizationDomain *domain, GDataEntry *entry, GCancellable *cancellable, GError **error)
 {
 	GDataEntry *updated_entry;
-	GDataLink *_link;
 	SoupMessage *message;
-	gchar *upload_data;
 	guint status;
-	GDataParsableClass *klass;
-	
+
 	g_return_val_if_fail (GDATA_IS_SERVICE (self), NULL);
 	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), NULL);
 	g_return_val_if_fail (GDATA_IS_ENTRY (entry), NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-
-	/* Append the data */
-	klass = GDATA_PARSABLE_GET_CLASS (entry);
-	g_assert (klass->get_content_type != NULL);
-	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
-		/* Get the edit URI */
-		_link = gdata_entry_look_up_link (entry, GDATA_LINK_SELF);
-		g_assert (_link != NULL);
-		message = _gdata_service_build_message (self, domain, SOUP_METHOD_PUT, gdata_link_get_uri (_link), gdata_entry_get_etag (entry), TRUE);
-		upload_data = gdata_parsable_get_json (GDATA_PARSABLE (entry));
-		soup_message_set_request (message, "application/json", SOUP_MEMORY_TAKE, upload_data, strlen (upload_data));
-	} else {
-		/* Get the edit URI */
-		_link = gdata_entry_look_up_link (entry, GDATA_LINK_EDIT);
-		g_assert (_link != NULL);
-		message = _gdata_service_build_message (self, domain, SOUP_METHOD_PUT, gdata_link_get_uri (_link), gdata_entry_get_etag (entry), TRUE);
-		upload_data = gdata_parsable_get_xml (GDATA_PARSABLE (entry));
-		soup_message_set_request (message, "application/atom+xml", SOUP_MEMORY_TAKE, upload_data, strlen (upload_data));
-	}
+	message = build_update_entry_message (self, domain, entry);
 
 	/* Send the message */
 	status = _gdata_service_send_message (self, message, cancellable, error);
-	if (status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
-		/* Redirect error or cancelled */
-		g_object_unref (message);
-		return NULL;
-	} else if (status != SOUP_STATUS_OK) {
-		/* Error */
-		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (self);
-		g_assert (klass->parse_error_response != NULL);
-		klass->parse_error_response (self, GDATA_OPERATION_UPDATE, status, message->reason_phrase, message->response_body->data,
-		                             message->response_body->length, error);
-		g_object_unref (message);
-		return NULL;
-	}
-
-	/* Parse the XML; create and return a new GDataEntry of the same type as @entry */
-	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
-	updated_entry = GDATA_ENTRY (gdata_parsable_new_from_json (G_OBJECT_TYPE (entry), message->response_body->data, message->response_body->length,
-	                                                          error));
-	} else {
-	updated_entry = GDATA_ENTRY (gdata_parsable_new_from_xml (G_OBJECT_TYPE (entry), message->response_body->data, message->response_body->length,
-	                                                          error));
-	}
+	updated_entry = process_entry_response (self, GDATA_OPERATION_UPDATE, message, status, entry, error);
 	g_object_unref (message);
 
 	return updated_entry;
@@ -1614,6 +4441,7 @@ gdata_service_update_entry (GDataService *self, GDataAuthorizationDomain *domain
 typedef struct {
 	GDataAuthorizationDomain *domain;
 	GDataEntry *entry;
+	SoupMessage *message;
 } DeleteEntryAsyncData;
 
 static void
@@ -1625,26 +4453,34 @@ delete_entry_async_data_free (DeleteEntryAsyncData *data)
 	if (data->entry != NULL)
 		g_object_unref (data->entry);
 
+	if (data->message != NULL)
+		g_object_unref (data->message);
+
 	g_slice_free (DeleteEntryAsyncData, data);
 }
 
 static void
-delete_entry_thread (GSimpleAsyncResult *result, GDataService *service, GCancellable *cancellable)
+delete_entry_send_cb (GDataService *service, GAsyncResult *async_result, GSimpleAsyncResult *result)
 {
 	gboolean success;
+	guint status;
 	GError *error = NULL;
 	DeleteEntryAsyncData *data = g_simple_async_result_get_op_res_gpointer (result);
 
-	/* Delete the entry and return */
-	success = gdata_service_delete_entry (service, data->domain, data->entry, cancellable, &error);
+	/* There's nothing to parse on success, so we don't need a thread at all */
+	status = _gdata_service_send_message_finish (service, async_result, &error);
+	success = (error == NULL) ? process_delete_response (service, data->message, status, &error) : FALSE;
+
 	if (success == FALSE) {
 		g_simple_async_result_set_from_error (result, error);
 		g_error_free (error);
-		return;
+	} else {
+		/* Replace the entry with the success value */
+		g_simple_async_result_set_op_res_gboolean (result, success);
 	}
 
-	/* Replace the entry with the success value */
-	g_simple_async_result_set_op_res_gboolean (result, success);
+	g_simple_async_result_complete (result);
+	g_object_unref (result);
 }
 
 /**
@@ -1681,10 +4517,11 @@ gdata_service_delete_entry_async (GDataService *self, GDataAuthorizationDomain *
 	data = g_slice_new (DeleteEntryAsyncData);
 	data->domain = (domain != NULL) ? g_object_ref (domain) : NULL;
 	data->entry = g_object_ref (entry);
+	data->message = build_delete_entry_message (self, domain, entry);
 
 	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_service_delete_entry_async);
 	g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) delete_entry_async_data_free);
-	g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) delete_entry_thread, G_PRIORITY_DEFAULT, cancellable);
+	_gdata_service_send_message_async (self, data->message, cancellable, (GAsyncReadyCallback) delete_entry_send_cb, g_object_ref (result));
 	g_object_unref (result);
 }
 
@@ -1745,11 +4582,9 @@ gdata_service_delete_entry_finish (GDataService *self, GAsyncResult *async_resul
 gboolean
 gdata_service_delete_entry (GDataService *self, GDataAuthorizationDomain *domain, GDataEntry *entry, GCancellable *cancellable, GError **error)
 {
-	GDataLink *_link;
 	SoupMessage *message;
 	guint status;
-	gchar *fixed_uri;
-	GDataParsableClass *klass;
+	gboolean success;
 
 	g_return_val_if_fail (GDATA_IS_SERVICE (self), FALSE);
 	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), FALSE);
@@ -1757,42 +4592,14 @@ gdata_service_delete_entry (GDataService *self, GDataAuthorizationDomain *domain
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* Get the edit URI. We have to fix it to always use HTTPS as YouTube videos appear to incorrectly return a HTTP URI as their edit URI. */
-	/* Append the data */
-
-	klass = GDATA_PARSABLE_GET_CLASS (entry);
-	g_assert (klass->get_content_type != NULL);
-	if (g_strcmp0 (klass->get_content_type (), "application/json") == 0) {
-		_link = gdata_entry_look_up_link (entry, GDATA_LINK_SELF);
-	} else {
-		_link = gdata_entry_look_up_link (entry, GDATA_LINK_EDIT);
-	}
-	g_assert (_link != NULL);
-
-	fixed_uri = _gdata_service_fix_uri_scheme (gdata_link_get_uri (_link));
-	message = _gdata_service_build_message (self, domain, SOUP_METHOD_DELETE, fixed_uri, gdata_entry_get_etag (entry), TRUE);
-	g_free (fixed_uri);
+	message = build_delete_entry_message (self, domain, entry);
 
 	/* Send the message */
 	status = _gdata_service_send_message (self, message, cancellable, error);
-
-	if (status == SOUP_STATUS_NONE || status == SOUP_STATUS_CANCELLED) {
-		/* Redirect error or cancelled */
-		g_object_unref (message);
-		return FALSE;
-	} else if (status != SOUP_STATUS_OK) {
-		/* Error */
-		GDataServiceClass *klass = GDATA_SERVICE_GET_CLASS (self);
-		g_assert (klass->parse_error_response != NULL);
-		klass->parse_error_response (self, GDATA_OPERATION_DELETION, status, message->reason_phrase, message->response_body->data,
-		                             message->response_body->length, error);
-		g_object_unref (message);
-		return FALSE;
-	}
-
+	success = process_delete_response (self, message, status, error);
 	g_object_unref (message);
 
-	return TRUE;
+	return success;
 }
 
 static void
@@ -25,6 +25,13 @@
 #include <libsoup/soup.h>
 
 #include <gdata/gdata-authorizer.h>
+#include <gdata/gdata-cache.h>
+#include <gdata/gdata-connection-pool.h>
+#include <gdata/gdata-retry-policy.h>
+#include <gdata/gdata-rate-limiter.h>
+#include <gdata/gdata-request-scheduler.h>
+#include <gdata/gdata-hedging-policy.h>
+#include <gdata/gdata-circuit-breaker.h>
 #include <gdata/gdata-feed.h>
 
 G_BEGIN_DECLS
@@ -70,6 +77,8 @@ typedef enum {
  * @GDATA_SERVICE_ERROR_NETWORK_ERROR: The service is unavailable due to local network errors (e.g. no Internet connection)
  * @GDATA_SERVICE_ERROR_PROXY_ERROR: The service is unavailable due to proxy network errors (e.g. proxy unreachable)
  * @GDATA_SERVICE_ERROR_WITH_BATCH_OPERATION: Generic error when running a batch operation and the whole operation fails
+ * @GDATA_SERVICE_ERROR_CIRCUIT_OPEN: The request wasn't sent because recent requests to the same server have been failing; see
+ * #GDataCircuitBreaker (since 0.15.0)
  *
  * Error codes for #GDataService operations.
  **/
@@ -84,7 +93,8 @@ typedef enum {
 	GDATA_SERVICE_ERROR_BAD_QUERY_PARAMETER,
 	GDATA_SERVICE_ERROR_NETWORK_ERROR,
 	GDATA_SERVICE_ERROR_PROXY_ERROR,
-	GDATA_SERVICE_ERROR_WITH_BATCH_OPERATION
+	GDATA_SERVICE_ERROR_WITH_BATCH_OPERATION,
+	GDATA_SERVICE_ERROR_CIRCUIT_OPEN
 } GDataServiceError;
 
 /**
@@ -102,6 +112,80 @@ typedef enum {
  **/
 typedef void (*GDataQueryProgressCallback) (GDataEntry *entry, guint entry_key, guint entry_count, gpointer user_data);
 
+/**
+ * GDataQueryBatchProgressCallback:
+ * @entries: (array length=n_entries): an array of new #GDataEntry<!-- -->s
+ * @n_entries: the number of entries in @entries
+ * @first_entry_key: the key of the first entry in @entries (zero-based index of its position in the feed)
+ * @entry_count: the total number of entries in the feed
+ * @user_data: user data passed to the callback
+ *
+ * Callback function called with batches of the #GDataEntry<!-- -->s parsed in a #GDataFeed when loading the results of a query. The entries in
+ * @entries are consecutive in the feed, so the key of <code class="literal">entries[i]</code> is @first_entry_key + <code class="literal">i</code>.
+ * The entries are only guaranteed to stay alive for the duration of the callback; it must ref any it wants to keep.
+ *
+ * As with #GDataQueryProgressCallback, it is called in the main thread, and all the batches are guaranteed to be delivered before the
+ * #GAsyncReadyCallback which signals the completion of the query is called.
+ *
+ * Since: 0.15.0
+ */
+typedef void (*GDataQueryBatchProgressCallback) (GDataEntry **entries, guint n_entries, guint first_entry_key, guint entry_count,
+                                                 gpointer user_data);
+
+/**
+ * GDataRequestStats:
+ * @method: the HTTP method of the request, such as <literal>GET</literal>
+ * @uri: the URI the request was sent to
+ * @status_code: the HTTP status code of the response, or a libsoup transport error code
+ * @start_time: the monotonic time the request was started at, as returned by g_get_monotonic_time()
+ * @total_duration: the total time between the request being started and the response being received, including any redirections and
+ * re-authorizations, in microseconds
+ * @dns_duration: the time spent resolving the host name, in microseconds; <code class="literal">0</code> if an existing connection was reused
+ * @connect_duration: the time spent establishing a TCP connection, in microseconds; <code class="literal">0</code> if an existing connection was
+ * reused
+ * @tls_duration: the time spent performing the TLS handshake, in microseconds; <code class="literal">0</code> if an existing connection was reused
+ * @send_duration: the time spent sending the request body, in microseconds
+ * @wait_duration: the time between the request being sent and the response headers being received, in microseconds
+ * @receive_duration: the time spent receiving the response body, in microseconds
+ * @parse_duration: the time spent parsing the response body, in microseconds; <code class="literal">0</code> if it wasn't parsed by libgdata
+ * @request_bytes: the length of the request body, in bytes
+ * @response_bytes: the length of the response body after decompression, in bytes
+ * @response_encoded_bytes: the length of the response body as transferred over the network (before decompression), in bytes, or
+ * <code class="literal">-1</code> if the server compressed the response and didn't give its compressed length
+ * @n_entries: the number of #GDataEntry<!-- -->s parsed from the response body
+ *
+ * Timings and sizes for a single network request made by a #GDataService, as reported by the #GDataService::request-finished signal.
+ *
+ * Where a request was sent more than once (for example, to follow a redirection or to retry after refreshing authorization), the durations
+ * are summed over all the attempts, and the sizes are those of the last attempt.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< public >*/
+	gchar *method;
+	gchar *uri;
+	guint status_code;
+	gint64 start_time;
+	gint64 total_duration;
+	gint64 dns_duration;
+	gint64 connect_duration;
+	gint64 tls_duration;
+	gint64 send_duration;
+	gint64 wait_duration;
+	gint64 receive_duration;
+	gint64 parse_duration;
+	goffset request_bytes;
+	goffset response_bytes;
+	goffset response_encoded_bytes;
+	guint n_entries;
+} GDataRequestStats;
+
+#define GDATA_TYPE_REQUEST_STATS (gdata_request_stats_get_type ())
+GType gdata_request_stats_get_type (void) G_GNUC_CONST;
+GDataRequestStats *gdata_request_stats_copy (const GDataRequestStats *self) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+void gdata_request_stats_free (GDataRequestStats *self);
+
 #define GDATA_TYPE_SERVICE		(gdata_service_get_type ())
 #define GDATA_SERVICE(o)		(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_SERVICE, GDataService))
 #define GDATA_SERVICE_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_SERVICE, GDataServiceClass))
@@ -161,6 +245,35 @@ gboolean gdata_service_is_authorized (GDataService *self);
 GDataAuthorizer *gdata_service_get_authorizer (GDataService *self) G_GNUC_PURE;
 void gdata_service_set_authorizer (GDataService *self, GDataAuthorizer *authorizer);
 
+GDataCache *gdata_service_get_cache (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_cache (GDataService *self, GDataCache *cache);
+
+GDataConnectionPool *gdata_service_get_connection_pool (GDataService *self) G_GNUC_PURE;
+
+GDataRetryPolicy *gdata_service_get_retry_policy (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_retry_policy (GDataService *self, GDataRetryPolicy *retry_policy);
+
+GDataRateLimiter *gdata_service_get_rate_limiter (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_rate_limiter (GDataService *self, GDataRateLimiter *rate_limiter);
+
+gboolean gdata_service_get_coalesce_queries (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_coalesce_queries (GDataService *self, gboolean coalesce_queries);
+
+GDataRequestScheduler *gdata_service_get_request_scheduler (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_request_scheduler (GDataService *self, GDataRequestScheduler *request_scheduler);
+
+GDataHedgingPolicy *gdata_service_get_hedging_policy (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_hedging_policy (GDataService *self, GDataHedgingPolicy *hedging_policy);
+
+gboolean gdata_service_get_compress_requests (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_compress_requests (GDataService *self, gboolean compress_requests);
+
+guint gdata_service_get_compression_threshold (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_compression_threshold (GDataService *self, guint compression_threshold);
+
+GDataCircuitBreaker *gdata_service_get_circuit_breaker (GDataService *self) G_GNUC_PURE;
+void gdata_service_set_circuit_breaker (GDataService *self, GDataCircuitBreaker *circuit_breaker);
+
 #include <gdata/gdata-query.h>
 
 GDataFeed *gdata_service_query (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query, GType entry_type,
@@ -171,6 +284,10 @@ void gdata_service_query_async (GDataService *self, GDataAuthorizationDomain *do
                                 GCancellable *cancellable,
                                 GDataQueryProgressCallback progress_callback, gpointer progress_user_data, GDestroyNotify destroy_progress_user_data,
                                 GAsyncReadyCallback callback, gpointer user_data);
+void gdata_service_query_batched_async (GDataService *self, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query,
+                                        GType entry_type, GCancellable *cancellable,
+                                        GDataQueryBatchProgressCallback progress_callback, gpointer progress_user_data,
+                                        GDestroyNotify destroy_progress_user_data, GAsyncReadyCallback callback, gpointer user_data);
 GDataFeed *gdata_service_query_finish (GDataService *self, GAsyncResult *async_result, GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
 
 GDataEntry *gdata_service_query_single_entry (GDataService *self, GDataAuthorizationDomain *domain, const gchar *entry_id, GDataQuery *query,
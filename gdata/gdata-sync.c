@@ -0,0 +1,912 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gdata-sync
+ * @short_description: GData incremental feed synchronisation
+ * @stability: Unstable
+ * @include: gdata/gdata-sync.h
+ *
+ * #GDataSync keeps a local copy of the entries in a feed up to date by only retrieving the entries which have changed since it was last run.
+ *
+ * Each time gdata_sync_run() is called, the feed is queried for entries updated since the most recent update time seen so far (the
+ * #GDataSync:updated-min high-water mark), following pagination links until the whole delta has been retrieved. Each changed entry is then
+ * merged into the local set of entries, which is indexed by entry ID, and one of the #GDataSync::entry-added, #GDataSync::entry-updated or
+ * #GDataSync::entry-removed signals is emitted for it. Entries whose ETag hasn't changed since they were last seen are ignored, so the signals are
+ * only emitted for genuine changes.
+ *
+ * Deleted entries are detected using the entry's <literal>deleted</literal> or <literal>is-deleted</literal> property (as provided by, for example,
+ * #GDataContactsContact:deleted and #GDataDocumentsEntry:is-deleted). Most services only return deleted entries if asked to, so a #GDataQuery
+ * subclass with the relevant property set should normally be passed to gdata_sync_new(): for example, a #GDataContactsQuery with
+ * #GDataContactsQuery:show-deleted set to %TRUE. Entry types without either property can still be synchronised, but removals won't be noticed.
+ *
+ * The first run of a #GDataSync retrieves the whole feed, emitting #GDataSync::entry-added for every entry in it. To avoid this after restarting an
+ * application, the high-water mark can be saved and restored using #GDataSync:updated-min; entries which aren't in the local set when they
+ * change are reported as additions.
+ *
+ * <example>
+ *	<title>Keeping a Local Copy of a User's Contacts</title>
+ *	<programlisting>
+ *	GDataContactsQuery *query;
+ *	GDataSync *sync;
+ *	GError *error = NULL;
+ *
+ *	query = gdata_contacts_query_new (NULL);
+ *	gdata_contacts_query_set_show_deleted (query, TRUE);
+ *
+ *	sync = gdata_sync_new (GDATA_SERVICE (service), gdata_contacts_service_get_primary_authorization_domain (),
+ *	                       "https://www.google.com/m8/feeds/contacts/default/full", GDATA_QUERY (query), GDATA_TYPE_CONTACTS_CONTACT);
+ *	g_object_unref (query);
+ *
+ *	g_signal_connect (sync, "entry-added", (GCallback) contact_added_cb, NULL);
+ *	g_signal_connect (sync, "entry-updated", (GCallback) contact_updated_cb, NULL);
+ *	g_signal_connect (sync, "entry-removed", (GCallback) contact_removed_cb, NULL);
+ *
+ *	/<!-- -->* Call this periodically; only the changes since the last call will be downloaded *<!-- -->/
+ *	gdata_sync_run (sync, NULL, &error);
+ *
+ *	if (error != NULL) {
+ *		g_error ("Error synchronising contacts: %s", error->message);
+ *		g_error_free (error);
+ *	}
+ *	</programlisting>
+ * </example>
+ *
+ * Since: 0.15.0
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+#include <string.h>
+
+#include "gdata-sync.h"
+#include "gdata-private.h"
+
+static void gdata_sync_dispose (GObject *object);
+static void gdata_sync_finalize (GObject *object);
+static void gdata_sync_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec);
+static void gdata_sync_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec);
+
+struct _GDataSyncPrivate {
+	GDataService *service;
+	GDataAuthorizationDomain *domain;
+	gchar *feed_uri;
+	GDataQuery *query;
+	GType entry_type;
+
+	GHashTable *entries; /* string ID → GDataEntry */
+	gint64 updated_min; /* high-water mark of entry update times, or -1 */
+	volatile gint running; /* whether a run is in progress; runs share the query, so mustn't overlap */
+};
+
+enum {
+	PROP_SERVICE = 1,
+	PROP_AUTHORIZATION_DOMAIN,
+	PROP_FEED_URI,
+	PROP_QUERY,
+	PROP_ENTRY_TYPE,
+	PROP_UPDATED_MIN,
+};
+
+enum {
+	SIGNAL_ENTRY_ADDED,
+	SIGNAL_ENTRY_UPDATED,
+	SIGNAL_ENTRY_REMOVED,
+	LAST_SIGNAL
+};
+
+static guint sync_signals[LAST_SIGNAL] = { 0, };
+
+G_DEFINE_TYPE (GDataSync, gdata_sync, G_TYPE_OBJECT)
+
+static void
+gdata_sync_class_init (GDataSyncClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GDataSyncPrivate));
+
+	gobject_class->get_property = gdata_sync_get_property;
+	gobject_class->set_property = gdata_sync_set_property;
+	gobject_class->dispose = gdata_sync_dispose;
+	gobject_class->finalize = gdata_sync_finalize;
+
+	/**
+	 * GDataSync:service:
+	 *
+	 * The service to query the feed with.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_SERVICE,
+	                                 g_param_spec_object ("service",
+	                                                      "Service", "The service to query the feed with.",
+	                                                      GDATA_TYPE_SERVICE,
+	                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataSync:authorization-domain:
+	 *
+	 * The authorization domain the feed queries fall under, or %NULL.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_AUTHORIZATION_DOMAIN,
+	                                 g_param_spec_object ("authorization-domain",
+	                                                      "Authorization domain", "The authorization domain the feed queries fall under.",
+	                                                      GDATA_TYPE_AUTHORIZATION_DOMAIN,
+	                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataSync:feed-uri:
+	 *
+	 * The URI of the feed to synchronise, including the host name and protocol.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_FEED_URI,
+	                                 g_param_spec_string ("feed-uri",
+	                                                      "Feed URI", "The URI of the feed to synchronise.",
+	                                                      NULL,
+	                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataSync:query:
+	 *
+	 * The query used to retrieve changes to the feed. Its #GDataQuery:updated-min, pagination and ETag are controlled by the #GDataSync, and
+	 * must not be changed while the #GDataSync is in use; its other properties may be set before the #GDataSync is constructed to filter the
+	 * feed, or to request deleted entries.
+	 *
+	 * If %NULL is passed at construction time, a plain #GDataQuery is used.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_QUERY,
+	                                 g_param_spec_object ("query",
+	                                                      "Query", "The query used to retrieve changes to the feed.",
+	                                                      GDATA_TYPE_QUERY,
+	                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataSync:entry-type:
+	 *
+	 * The type of the entries in the feed. This must be a subtype of #GDataEntry.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_ENTRY_TYPE,
+	                                 g_param_spec_gtype ("entry-type",
+	                                                     "Entry type", "The type of the entries in the feed.",
+	                                                     GDATA_TYPE_ENTRY,
+	                                                     G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataSync:updated-min:
+	 *
+	 * The high-water mark of the synchronisation: the latest update time of any entry seen so far, as a UNIX timestamp. The next run will only
+	 * retrieve entries updated at or after this time. If this is <code class="literal">-1</code>, the next run will retrieve the whole feed.
+	 *
+	 * This is updated automatically after each successful run, and can be saved and restored to continue synchronising incrementally after the
+	 * application is restarted.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_UPDATED_MIN,
+	                                 g_param_spec_int64 ("updated-min",
+	                                                     "Minimum update date", "The high-water mark of the synchronisation.",
+	                                                     -1, G_MAXINT64, -1,
+	                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataSync::entry-added:
+	 * @self: the #GDataSync
+	 * @entry: the new entry
+	 *
+	 * The #GDataSync::entry-added signal is emitted during a run of the #GDataSync for each entry which has been added to the local set of
+	 * entries: either because it was created on the server, or because it was retrieved for the first time. @entry has been added to the
+	 * local set by the time the signal is emitted.
+	 *
+	 * Since: 0.15.0
+	 */
+	sync_signals[SIGNAL_ENTRY_ADDED] = g_signal_new ("entry-added",
+	                                                 G_TYPE_FROM_CLASS (klass),
+	                                                 G_SIGNAL_RUN_LAST,
+	                                                 0, NULL, NULL,
+	                                                 g_cclosure_marshal_VOID__OBJECT,
+	                                                 G_TYPE_NONE, 1, GDATA_TYPE_ENTRY);
+
+	/**
+	 * GDataSync::entry-updated:
+	 * @self: the #GDataSync
+	 * @entry: the updated entry
+	 *
+	 * The #GDataSync::entry-updated signal is emitted during a run of the #GDataSync for each entry in the local set which has changed on the
+	 * server. @entry is the new version of the entry, and has replaced the old version in the local set by the time the signal is emitted.
+	 *
+	 * Since: 0.15.0
+	 */
+	sync_signals[SIGNAL_ENTRY_UPDATED] = g_signal_new ("entry-updated",
+	                                                   G_TYPE_FROM_CLASS (klass),
+	                                                   G_SIGNAL_RUN_LAST,
+	                                                   0, NULL, NULL,
+	                                                   g_cclosure_marshal_VOID__OBJECT,
+	                                                   G_TYPE_NONE, 1, GDATA_TYPE_ENTRY);
+
+	/**
+	 * GDataSync::entry-removed:
+	 * @self: the #GDataSync
+	 * @entry: the removed entry
+	 *
+	 * The #GDataSync::entry-removed signal is emitted during a run of the #GDataSync for each entry in the local set which has been deleted on the
+	 * server. @entry is the last version of the entry held in the local set, from which it has been removed by the time the signal is emitted.
+	 *
+	 * Since: 0.15.0
+	 */
+	sync_signals[SIGNAL_ENTRY_REMOVED] = g_signal_new ("entry-removed",
+	                                                   G_TYPE_FROM_CLASS (klass),
+	                                                   G_SIGNAL_RUN_LAST,
+	                                                   0, NULL, NULL,
+	                                                   g_cclosure_marshal_VOID__OBJECT,
+	                                                   G_TYPE_NONE, 1, GDATA_TYPE_ENTRY);
+}
+
+static void
+gdata_sync_init (GDataSync *self)
+{
+	self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, GDATA_TYPE_SYNC, GDataSyncPrivate);
+	self->priv->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	self->priv->updated_min = -1;
+	self->priv->entry_type = GDATA_TYPE_ENTRY;
+}
+
+static void
+gdata_sync_dispose (GObject *object)
+{
+	GDataSyncPrivate *priv = GDATA_SYNC (object)->priv;
+
+	if (priv->service != NULL)
+		g_object_unref (priv->service);
+	priv->service = NULL;
+
+	if (priv->domain != NULL)
+		g_object_unref (priv->domain);
+	priv->domain = NULL;
+
+	if (priv->query != NULL)
+		g_object_unref (priv->query);
+	priv->query = NULL;
+
+	g_hash_table_remove_all (priv->entries);
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_sync_parent_class)->dispose (object);
+}
+
+static void
+gdata_sync_finalize (GObject *object)
+{
+	GDataSyncPrivate *priv = GDATA_SYNC (object)->priv;
+
+	g_free (priv->feed_uri);
+	g_hash_table_destroy (priv->entries);
+
+	/* Chain up to the parent class */
+	G_OBJECT_CLASS (gdata_sync_parent_class)->finalize (object);
+}
+
+static void
+gdata_sync_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	GDataSyncPrivate *priv = GDATA_SYNC (object)->priv;
+
+	switch (property_id) {
+		case PROP_SERVICE:
+			g_value_set_object (value, priv->service);
+			break;
+		case PROP_AUTHORIZATION_DOMAIN:
+			g_value_set_object (value, priv->domain);
+			break;
+		case PROP_FEED_URI:
+			g_value_set_string (value, priv->feed_uri);
+			break;
+		case PROP_QUERY:
+			g_value_set_object (value, priv->query);
+			break;
+		case PROP_ENTRY_TYPE:
+			g_value_set_gtype (value, priv->entry_type);
+			break;
+		case PROP_UPDATED_MIN:
+			g_value_set_int64 (value, priv->updated_min);
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+static void
+gdata_sync_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	GDataSyncPrivate *priv = GDATA_SYNC (object)->priv;
+
+	switch (property_id) {
+		/* Construct only */
+		case PROP_SERVICE:
+			priv->service = g_value_dup_object (value);
+			break;
+		case PROP_AUTHORIZATION_DOMAIN:
+			priv->domain = g_value_dup_object (value);
+			break;
+		case PROP_FEED_URI:
+			priv->feed_uri = g_value_dup_string (value);
+			break;
+		case PROP_QUERY:
+			priv->query = g_value_dup_object (value);
+
+			/* Fall back to a plain query so that we always have one to set the high-water mark on */
+			if (priv->query == NULL)
+				priv->query = gdata_query_new (NULL);
+
+			break;
+		case PROP_ENTRY_TYPE:
+			priv->entry_type = g_value_get_gtype (value);
+			break;
+		case PROP_UPDATED_MIN:
+			gdata_sync_set_updated_min (GDATA_SYNC (object), g_value_get_int64 (value));
+			break;
+		default:
+			/* We don't have any other property... */
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+			break;
+	}
+}
+
+/**
+ * gdata_sync_new:
+ * @service: the #GDataService to query the feed with
+ * @domain: (allow-none): the #GDataAuthorizationDomain the feed queries fall under, or %NULL
+ * @feed_uri: the URI of the feed to synchronise, including the host name and protocol
+ * @query: (allow-none): a #GDataQuery to filter the feed with, or %NULL
+ * @entry_type: a #GType for the #GDataEntry<!-- -->s in the feed
+ *
+ * Creates a new #GDataSync for the feed at @feed_uri. The local set of entries is initially empty, so the first run will retrieve the whole feed.
+ *
+ * @query is used for all queries made by the #GDataSync, and is modified by them; see #GDataSync:query for details.
+ *
+ * Return value: (transfer full): a new #GDataSync; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GDataSync *
+gdata_sync_new (GDataService *service, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query, GType entry_type)
+{
+	g_return_val_if_fail (GDATA_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), NULL);
+	g_return_val_if_fail (feed_uri != NULL && *feed_uri != '\0', NULL);
+	g_return_val_if_fail (query == NULL || GDATA_IS_QUERY (query), NULL);
+	g_return_val_if_fail (g_type_is_a (entry_type, GDATA_TYPE_ENTRY) == TRUE, NULL);
+
+	return g_object_new (GDATA_TYPE_SYNC,
+	                     "service", service,
+	                     "authorization-domain", domain,
+	                     "feed-uri", feed_uri,
+	                     "query", query,
+	                     "entry-type", entry_type,
+	                     NULL);
+}
+
+/* Mark a run as being in progress, or return a %G_IO_ERROR_PENDING error if there's one already. The run must be ended with end_run(). */
+static gboolean
+start_run (GDataSync *self, GError **error)
+{
+	if (g_atomic_int_compare_and_exchange (&(self->priv->running), FALSE, TRUE) == FALSE) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PENDING, _("A synchronisation run is already in progress."));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+end_run (GDataSync *self)
+{
+	g_atomic_int_set (&(self->priv->running), FALSE);
+}
+
+/* Reset the query to the first page of the delta since the current high-water mark. Must be called before fetch_changes(). */
+static void
+prepare_query (GDataSync *self)
+{
+	GDataSyncPrivate *priv = self->priv;
+
+	_gdata_query_set_next_uri (priv->query, NULL);
+	_gdata_query_set_previous_uri (priv->query, NULL);
+	gdata_query_set_start_index (priv->query, 0);
+	gdata_query_set_updated_min (priv->query, priv->updated_min);
+
+	/* The feed's ETag would only tell us that nothing has changed on the first page, which isn't enough to be useful */
+	gdata_query_set_etag (priv->query, NULL);
+}
+
+/* Retrieve all the pages of changed entries, returning them in a list in the order they were received (transfer full). This doesn't touch the
+ * local set of entries, so is safe to call from another thread. */
+static GList *
+fetch_changes (GDataSync *self, GCancellable *cancellable, GError **error)
+{
+	GDataSyncPrivate *priv = self->priv;
+	GList *changes = NULL;
+
+	while (TRUE) {
+		GDataFeed *feed;
+		GList *entries;
+
+		feed = gdata_service_query (priv->service, priv->domain, priv->feed_uri, priv->query, priv->entry_type, cancellable, NULL, NULL,
+		                            error);
+
+		if (feed == NULL) {
+			g_list_free_full (changes, g_object_unref);
+			return NULL;
+		}
+
+		entries = gdata_feed_get_entries (feed);
+
+		for (; entries != NULL; entries = entries->next)
+			changes = g_list_prepend (changes, g_object_ref (entries->data));
+
+		/* Stop once we've reached the last page. Also stop on an empty page, in case the server keeps giving us pagination links. */
+		if (gdata_feed_get_entries (feed) == NULL || gdata_feed_look_up_link (feed, "next") == NULL) {
+			g_object_unref (feed);
+			break;
+		}
+
+		g_object_unref (feed);
+		gdata_query_next_page (priv->query);
+	}
+
+	return g_list_reverse (changes);
+}
+
+/* Whether @entry is a tombstone for a deleted entry. There's no common interface for this, so check for the properties used by the services. */
+static gboolean
+entry_is_deleted (GDataEntry *entry)
+{
+	GObjectClass *klass = G_OBJECT_GET_CLASS (entry);
+	const gchar *property_name;
+	GParamSpec *pspec;
+	gboolean is_deleted = FALSE;
+
+	pspec = g_object_class_find_property (klass, "deleted");
+	if (pspec == NULL)
+		pspec = g_object_class_find_property (klass, "is-deleted");
+
+	if (pspec == NULL || pspec->value_type != G_TYPE_BOOLEAN || (pspec->flags & G_PARAM_READABLE) == 0)
+		return FALSE;
+
+	property_name = g_param_spec_get_name (pspec);
+	g_object_get (entry, property_name, &is_deleted, NULL);
+
+	return is_deleted;
+}
+
+/* Whether @new_entry is a different version of @old_entry. */
+static gboolean
+entry_has_changed (GDataEntry *old_entry, GDataEntry *new_entry)
+{
+	const gchar *old_etag, *new_etag;
+
+	old_etag = gdata_entry_get_etag (old_entry);
+	new_etag = gdata_entry_get_etag (new_entry);
+
+	/* Prefer ETags; fall back to update times if the service doesn't provide them */
+	if (old_etag != NULL && new_etag != NULL)
+		return (strcmp (old_etag, new_etag) != 0) ? TRUE : FALSE;
+
+	return (gdata_entry_get_updated (new_entry) > gdata_entry_get_updated (old_entry)) ? TRUE : FALSE;
+}
+
+/* Merge the changed entries into the local set, emitting signals for them, and update the high-water mark. Takes ownership of @changes. This must be
+ * called in the thread which owns the #GDataSync. */
+static void
+apply_changes (GDataSync *self, GList *changes)
+{
+	GDataSyncPrivate *priv = self->priv;
+	gint64 updated_min = priv->updated_min;
+	GList *i;
+
+	g_object_ref (self);
+
+	for (i = changes; i != NULL; i = i->next) {
+		GDataEntry *entry, *old_entry;
+		const gchar *id;
+
+		entry = GDATA_ENTRY (i->data);
+		id = gdata_entry_get_id (entry);
+
+		if (gdata_entry_get_updated (entry) > updated_min)
+			updated_min = gdata_entry_get_updated (entry);
+
+		if (id == NULL)
+			continue;
+
+		old_entry = g_hash_table_lookup (priv->entries, id);
+
+		if (entry_is_deleted (entry) == TRUE) {
+			if (old_entry != NULL) {
+				g_object_ref (old_entry);
+				g_hash_table_remove (priv->entries, id);
+				g_signal_emit (self, sync_signals[SIGNAL_ENTRY_REMOVED], 0, old_entry);
+				g_object_unref (old_entry);
+			}
+		} else if (old_entry == NULL) {
+			g_hash_table_insert (priv->entries, g_strdup (id), g_object_ref (entry));
+			g_signal_emit (self, sync_signals[SIGNAL_ENTRY_ADDED], 0, entry);
+		} else if (entry_has_changed (old_entry, entry) == TRUE) {
+			/* Entries updated at exactly the high-water mark are retrieved again on the next run (since #GDataQuery:updated-min is
+			 * inclusive); this check stops them being reported twice. */
+			g_hash_table_insert (priv->entries, g_strdup (id), g_object_ref (entry));
+			g_signal_emit (self, sync_signals[SIGNAL_ENTRY_UPDATED], 0, entry);
+		}
+	}
+
+	g_list_free_full (changes, g_object_unref);
+
+	if (updated_min != priv->updated_min)
+		gdata_sync_set_updated_min (self, updated_min);
+
+	g_object_unref (self);
+}
+
+/**
+ * gdata_sync_run:
+ * @self: a #GDataSync
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Retrieves all the entries in the feed which have changed since the last run, merges them into the local set of entries and emits
+ * #GDataSync::entry-added, #GDataSync::entry-updated and #GDataSync::entry-removed signals for them. On success, #GDataSync:updated-min is advanced
+ * to the latest update time seen.
+ *
+ * The changes are only merged once every page of them has been retrieved successfully. If an error occurs part-way through, the local set of entries
+ * and the high-water mark are left unchanged, and the next run will retrieve the same changes again.
+ *
+ * Only one run of @self may be in progress at once, since the runs would otherwise interfere with each other's queries. If another run (synchronous
+ * or asynchronous) is already in progress, %G_IO_ERROR_PENDING will be returned. Other errors are as for gdata_service_query(), and cancellation is
+ * handled in the same way.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_sync_run (GDataSync *self, GCancellable *cancellable, GError **error)
+{
+	GList *changes;
+	GError *child_error = NULL;
+
+	g_return_val_if_fail (GDATA_IS_SYNC (self), FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (start_run (self, error) == FALSE)
+		return FALSE;
+
+	prepare_query (self);
+
+	changes = fetch_changes (self, cancellable, &child_error);
+
+	if (child_error != NULL) {
+		end_run (self);
+		g_propagate_error (error, child_error);
+		return FALSE;
+	}
+
+	apply_changes (self, changes);
+	end_run (self);
+
+	return TRUE;
+}
+
+static void
+run_thread (GSimpleAsyncResult *result, GDataSync *self, GCancellable *cancellable)
+{
+	GList *changes;
+	GError *error = NULL;
+
+	/* Only fetch the changes here; they're applied in run_cb(), in the main thread, so that the signals are emitted there */
+	changes = fetch_changes (self, cancellable, &error);
+
+	if (error != NULL) {
+		g_simple_async_result_set_from_error (result, error);
+		g_error_free (error);
+		return;
+	}
+
+	g_simple_async_result_set_op_res_gpointer (result, changes, NULL);
+}
+
+static void
+run_cb (GDataSync *self, GAsyncResult *async_result, GSimpleAsyncResult *result)
+{
+	GSimpleAsyncResult *thread_result = G_SIMPLE_ASYNC_RESULT (async_result);
+	GError *error = NULL;
+
+	if (g_simple_async_result_propagate_error (thread_result, &error) == TRUE) {
+		g_simple_async_result_take_error (result, error);
+	} else {
+		apply_changes (self, g_simple_async_result_get_op_res_gpointer (thread_result));
+		g_simple_async_result_set_op_res_gboolean (result, TRUE);
+	}
+
+	/* End the run before calling the callback, so that it can start another one */
+	end_run (self);
+	g_simple_async_result_complete (result);
+	g_object_unref (result);
+}
+
+/**
+ * gdata_sync_run_async:
+ * @self: a #GDataSync
+ * @cancellable: (allow-none): optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the run is finished
+ * @user_data: (closure): data to pass to the @callback function
+ *
+ * Retrieves the changes to the feed since the last run and merges them into the local set of entries. @self is reffed when this function is called,
+ * so can safely be unreffed after this function returns.
+ *
+ * The changes are retrieved in another thread, but they are merged (and the #GDataSync signals emitted) in the main thread, just before @callback is
+ * called. If another run is already in progress, the operation fails with %G_IO_ERROR_PENDING. For more details, see gdata_sync_run(), which is the
+ * synchronous version of this function.
+ *
+ * When the operation is finished, @callback will be called. You can then call gdata_sync_run_finish() to get the results of the operation.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_sync_run_async (GDataSync *self, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+	GSimpleAsyncResult *result, *thread_result;
+	GError *error = NULL;
+
+	g_return_if_fail (GDATA_IS_SYNC (self));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (callback != NULL);
+
+	result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, gdata_sync_run_async);
+
+	if (start_run (self, &error) == FALSE) {
+		g_simple_async_result_take_error (result, error);
+		g_simple_async_result_complete_in_idle (result);
+		g_object_unref (result);
+		return;
+	}
+
+	prepare_query (self);
+
+	thread_result = g_simple_async_result_new (G_OBJECT (self), (GAsyncReadyCallback) run_cb, result, run_thread);
+	g_simple_async_result_run_in_thread (thread_result, (GSimpleAsyncThreadFunc) run_thread, G_PRIORITY_DEFAULT, cancellable);
+	g_object_unref (thread_result);
+}
+
+/**
+ * gdata_sync_run_finish:
+ * @self: a #GDataSync
+ * @async_result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Finishes an asynchronous run started with gdata_sync_run_async().
+ *
+ * Return value: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 0.15.0
+ */
+gboolean
+gdata_sync_run_finish (GDataSync *self, GAsyncResult *async_result, GError **error)
+{
+	GSimpleAsyncResult *result = G_SIMPLE_ASYNC_RESULT (async_result);
+
+	g_return_val_if_fail (GDATA_IS_SYNC (self), FALSE);
+	g_return_val_if_fail (G_IS_ASYNC_RESULT (async_result), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	g_warn_if_fail (g_simple_async_result_get_source_tag (result) == gdata_sync_run_async);
+
+	if (g_simple_async_result_propagate_error (result, error) == TRUE)
+		return FALSE;
+
+	return g_simple_async_result_get_op_res_gboolean (result);
+}
+
+/**
+ * gdata_sync_reset:
+ * @self: a #GDataSync
+ *
+ * Empties the local set of entries and resets #GDataSync:updated-min to <code class="literal">-1</code>, so that the next run retrieves the whole
+ * feed again. No signals are emitted for the entries removed from the local set.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_sync_reset (GDataSync *self)
+{
+	g_return_if_fail (GDATA_IS_SYNC (self));
+
+	g_hash_table_remove_all (self->priv->entries);
+	gdata_sync_set_updated_min (self, -1);
+}
+
+/**
+ * gdata_sync_look_up_entry:
+ * @self: a #GDataSync
+ * @id: the ID of the entry to look up
+ *
+ * Looks up the entry with the given @id in the local set of entries.
+ *
+ * Return value: (transfer none): the entry, or %NULL if it isn't in the local set
+ *
+ * Since: 0.15.0
+ */
+GDataEntry *
+gdata_sync_look_up_entry (GDataSync *self, const gchar *id)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), NULL);
+	g_return_val_if_fail (id != NULL, NULL);
+
+	return g_hash_table_lookup (self->priv->entries, id);
+}
+
+/**
+ * gdata_sync_get_entries:
+ * @self: a #GDataSync
+ *
+ * Gets all the entries in the local set of entries, in no particular order.
+ *
+ * Return value: (transfer container) (element-type GData.Entry): a list of the entries; free with g_list_free()
+ *
+ * Since: 0.15.0
+ */
+GList *
+gdata_sync_get_entries (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), NULL);
+
+	return g_hash_table_get_values (self->priv->entries);
+}
+
+/**
+ * gdata_sync_get_service:
+ * @self: a #GDataSync
+ *
+ * Gets the #GDataSync:service property.
+ *
+ * Return value: (transfer none): the service used to query the feed
+ *
+ * Since: 0.15.0
+ */
+GDataService *
+gdata_sync_get_service (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), NULL);
+	return self->priv->service;
+}
+
+/**
+ * gdata_sync_get_authorization_domain:
+ * @self: a #GDataSync
+ *
+ * Gets the #GDataSync:authorization-domain property.
+ *
+ * Return value: (transfer none) (allow-none): the authorization domain the feed queries fall under, or %NULL
+ *
+ * Since: 0.15.0
+ */
+GDataAuthorizationDomain *
+gdata_sync_get_authorization_domain (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), NULL);
+	return self->priv->domain;
+}
+
+/**
+ * gdata_sync_get_feed_uri:
+ * @self: a #GDataSync
+ *
+ * Gets the #GDataSync:feed-uri property.
+ *
+ * Return value: the URI of the feed being synchronised
+ *
+ * Since: 0.15.0
+ */
+const gchar *
+gdata_sync_get_feed_uri (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), NULL);
+	return self->priv->feed_uri;
+}
+
+/**
+ * gdata_sync_get_query:
+ * @self: a #GDataSync
+ *
+ * Gets the #GDataSync:query property.
+ *
+ * Return value: (transfer none): the query used to retrieve changes to the feed
+ *
+ * Since: 0.15.0
+ */
+GDataQuery *
+gdata_sync_get_query (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), NULL);
+	return self->priv->query;
+}
+
+/**
+ * gdata_sync_get_entry_type:
+ * @self: a #GDataSync
+ *
+ * Gets the #GDataSync:entry-type property.
+ *
+ * Return value: the type of the entries in the feed
+ *
+ * Since: 0.15.0
+ */
+GType
+gdata_sync_get_entry_type (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), G_TYPE_INVALID);
+	return self->priv->entry_type;
+}
+
+/**
+ * gdata_sync_get_updated_min:
+ * @self: a #GDataSync
+ *
+ * Gets the #GDataSync:updated-min property.
+ *
+ * Return value: the high-water mark of the synchronisation, or <code class="literal">-1</code>
+ *
+ * Since: 0.15.0
+ */
+gint64
+gdata_sync_get_updated_min (GDataSync *self)
+{
+	g_return_val_if_fail (GDATA_IS_SYNC (self), -1);
+	return self->priv->updated_min;
+}
+
+/**
+ * gdata_sync_set_updated_min:
+ * @self: a #GDataSync
+ * @updated_min: the new high-water mark, or <code class="literal">-1</code>
+ *
+ * Sets the #GDataSync:updated-min property. This should normally only be used to restore a previously saved high-water mark.
+ *
+ * Since: 0.15.0
+ */
+void
+gdata_sync_set_updated_min (GDataSync *self, gint64 updated_min)
+{
+	g_return_if_fail (GDATA_IS_SYNC (self));
+	g_return_if_fail (updated_min >= -1);
+
+	self->priv->updated_min = updated_min;
+	g_object_notify (G_OBJECT (self), "updated-min");
+}
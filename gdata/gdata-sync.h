@@ -0,0 +1,92 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_SYNC_H
+#define GDATA_SYNC_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include <gdata/gdata-service.h>
+#include <gdata/gdata-query.h>
+#include <gdata/gdata-entry.h>
+
+G_BEGIN_DECLS
+
+#define GDATA_TYPE_SYNC			(gdata_sync_get_type ())
+#define GDATA_SYNC(o)			(G_TYPE_CHECK_INSTANCE_CAST ((o), GDATA_TYPE_SYNC, GDataSync))
+#define GDATA_SYNC_CLASS(k)		(G_TYPE_CHECK_CLASS_CAST((k), GDATA_TYPE_SYNC, GDataSyncClass))
+#define GDATA_IS_SYNC(o)		(G_TYPE_CHECK_INSTANCE_TYPE ((o), GDATA_TYPE_SYNC))
+#define GDATA_IS_SYNC_CLASS(k)		(G_TYPE_CHECK_CLASS_TYPE ((k), GDATA_TYPE_SYNC))
+#define GDATA_SYNC_GET_CLASS(o)		(G_TYPE_INSTANCE_GET_CLASS ((o), GDATA_TYPE_SYNC, GDataSyncClass))
+
+typedef struct _GDataSyncPrivate	GDataSyncPrivate;
+
+/**
+ * GDataSync:
+ *
+ * All the fields in the #GDataSync structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObject parent;
+	GDataSyncPrivate *priv;
+} GDataSync;
+
+/**
+ * GDataSyncClass:
+ *
+ * All the fields in the #GDataSyncClass structure are private and should never be accessed directly.
+ *
+ * Since: 0.15.0
+ */
+typedef struct {
+	/*< private >*/
+	GObjectClass parent;
+} GDataSyncClass;
+
+GType gdata_sync_get_type (void) G_GNUC_CONST;
+
+GDataSync *gdata_sync_new (GDataService *service, GDataAuthorizationDomain *domain, const gchar *feed_uri, GDataQuery *query,
+                           GType entry_type) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+
+gboolean gdata_sync_run (GDataSync *self, GCancellable *cancellable, GError **error);
+void gdata_sync_run_async (GDataSync *self, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean gdata_sync_run_finish (GDataSync *self, GAsyncResult *async_result, GError **error);
+
+void gdata_sync_reset (GDataSync *self);
+
+GDataEntry *gdata_sync_look_up_entry (GDataSync *self, const gchar *id);
+GList *gdata_sync_get_entries (GDataSync *self) G_GNUC_WARN_UNUSED_RESULT;
+
+GDataService *gdata_sync_get_service (GDataSync *self) G_GNUC_PURE;
+GDataAuthorizationDomain *gdata_sync_get_authorization_domain (GDataSync *self) G_GNUC_PURE;
+const gchar *gdata_sync_get_feed_uri (GDataSync *self) G_GNUC_PURE;
+GDataQuery *gdata_sync_get_query (GDataSync *self) G_GNUC_PURE;
+GType gdata_sync_get_entry_type (GDataSync *self) G_GNUC_PURE;
+
+gint64 gdata_sync_get_updated_min (GDataSync *self);
+void gdata_sync_set_updated_min (GDataSync *self, gint64 updated_min);
+
+G_END_DECLS
+
+#endif /* !GDATA_SYNC_H */
@@ -0,0 +1,84 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GDATA_TRACE_H
+#define GDATA_TRACE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Static trace markers for the hot paths of the library: network requests, XML/JSON parsing and #GDataBuffer traffic.
+ *
+ * If libgdata was configured with --enable-tracing, each marker is a USDT probe in the "libgdata" provider, which can be attached to using
+ * perf, SystemTap or bpftrace (e.g. `perf probe sdt_libgdata:request_start`). A USDT probe is a single nop instruction plus an ELF note, so
+ * an unattached probe costs no more than evaluating its (cheap) arguments.
+ *
+ * If tracing is disabled (the default), the markers compile to nothing. ENABLE_TRACING comes from config.h, which must be included before this
+ * header.
+ */
+#ifdef ENABLE_TRACING
+
+#include <sys/sdt.h>
+
+/* (SoupMessage *message) */
+#define GDATA_TRACE_REQUEST_START(M) \
+	DTRACE_PROBE3 (libgdata, request_start, (M), (M)->method, soup_message_get_uri (M)->path)
+/* (SoupMessage *message) */
+#define GDATA_TRACE_REQUEST_END(M) \
+	DTRACE_PROBE2 (libgdata, request_end, (M), (M)->status_code)
+
+/* (GType parsable_type, gint length) */
+#define GDATA_TRACE_PARSE_START(T, L) \
+	DTRACE_PROBE2 (libgdata, parse_start, g_type_name (T), (L))
+/* (GType parsable_type, GDataParsable *parsable) */
+#define GDATA_TRACE_PARSE_END(T, P) \
+	DTRACE_PROBE2 (libgdata, parse_end, g_type_name (T), (P))
+
+/* (GType entry_type) */
+#define GDATA_TRACE_ENTRY_PARSE_START(T) \
+	DTRACE_PROBE1 (libgdata, entry_parse_start, g_type_name (T))
+/* (GType entry_type, GDataEntry *entry) */
+#define GDATA_TRACE_ENTRY_PARSE_END(T, E) \
+	DTRACE_PROBE2 (libgdata, entry_parse_end, g_type_name (T), (E))
+
+/* (GDataBuffer *buffer, gsize length) */
+#define GDATA_TRACE_BUFFER_PUSH(B, L) \
+	DTRACE_PROBE2 (libgdata, buffer_push, (B), (L))
+/* (GDataBuffer *buffer, gsize length) */
+#define GDATA_TRACE_BUFFER_POP(B, L) \
+	DTRACE_PROBE2 (libgdata, buffer_pop, (B), (L))
+
+#else /* !ENABLE_TRACING */
+
+#define GDATA_TRACE_REQUEST_START(M) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_REQUEST_END(M) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_PARSE_START(T, L) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_PARSE_END(T, P) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_ENTRY_PARSE_START(T) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_ENTRY_PARSE_END(T, E) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_BUFFER_PUSH(B, L) G_STMT_START { } G_STMT_END
+#define GDATA_TRACE_BUFFER_POP(B, L) G_STMT_START { } G_STMT_END
+
+#endif /* !ENABLE_TRACING */
+
+G_END_DECLS
+
+#endif /* !GDATA_TRACE_H */
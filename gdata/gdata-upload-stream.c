@@ -31,6 +31,9 @@
  * the file. Network communication may not actually begin until the first call to g_output_stream_write(), so having a #GDataUploadStream around is no
  * guarantee that data is being uploaded.
  *
+ * If the file to upload is a local file, gdata_upload_stream_new_from_file() can be used instead. It memory-maps the file and uploads it without
+ * copying it through the stream, so no data needs to be written to the stream; it just needs to be closed once the upload is finished.
+ *
  * Uploads of a file, or a file with associated metadata (a #GDataEntry) should use #GDataUploadStream, but if you want to simply upload a single
  * #GDataEntry, use gdata_service_insert_entry() instead. #GDataUploadStream is for large streaming uploads.
  *
@@ -40,6 +43,10 @@
  *
  * If the server returns an error instead of a success response, the error will be returned by g_output_stream_close() as a #GDataServiceError.
  *
+ * The asynchronous #GOutputStream methods, such as g_output_stream_write_async(), use GIO's default implementations, which run the synchronous
+ * methods in a thread from GIO's worker pool. Unlike the asynchronous #GDataService operations, each of them blocks a thread while it waits for the
+ * network.
+ *
  * The entire upload operation can be cancelled using the #GCancellable instance provided to gdata_upload_stream_new(), or returned by
  * gdata_upload_stream_get_cancellable(). Cancelling this at any time will cause all future #GOutputStream method calls to return
  * %G_IO_ERROR_CANCELLED. If any #GOutputStream methods are in the process of being called, they will be cancelled and return %G_IO_ERROR_CANCELLED as
@@ -51,6 +58,12 @@
  * had not managed to write any bytes to the network by that point. This is also the behaviour of g_output_stream_write() when the upload operation as
  * a whole is cancelled.
  *
+ * By default, g_output_stream_write() only returns once the data passed to it has been written to the network. If #GDataUploadStream:buffer-size is
+ * non-zero, it instead returns as soon as the data has been queued, as long as no more than #GDataUploadStream:buffer-size bytes are waiting to be
+ * written to the network, so that the application can produce the next data while the network catches up. In this case, an error writing the queued
+ * data will be returned by a later call to g_output_stream_write(), g_output_stream_flush() or g_output_stream_close(); and
+ * g_output_stream_flush() can be used to wait for all the queued data to be written.
+ *
  * In the case of g_output_stream_close(), the call will return immediately if network activity hasn't yet started. If it has, the network activity
  * will be cancelled, regardless of whether the call to g_output_stream_close() is cancelled. Cancelling a pending call to g_output_stream_close()
  * (either using the method's #GCancellable, or by cancelling the upload stream as a whole) will cause it to stop waiting for the network activity to
@@ -153,8 +166,9 @@
  * off the buffer, up to its chunk size, which is a non-blocking operation.
  *
  * The write() and close() operations on the output stream are synchronised with the network thread, so that the write() call only returns once the
- * network thread has written at least as many bytes as were passed to the write() call, and the close() call only returns once all network activity
- * has finished (including receiving the response from the server). Async versions of these calls are provided by GOutputStream.
+ * network thread has written at least as many bytes as were passed to the write() call (or, if ->buffer_size is non-zero, once no more than
+ * ->buffer_size bytes are left in the GDataBuffer), and the close() call only returns once all network activity has finished (including receiving
+ * the response from the server). Async versions of these calls are provided by GOutputStream.
  *
  * The number of bytes in the various buffers are recorded using:
  *  • message_bytes_outstanding: the number of bytes in the GDataBuffer which are waiting to be written to the SoupMessageBody
@@ -176,7 +190,10 @@
 #include "gdata-private.h"
 
 #define BOUNDARY_STRING "0003Z5W789deadbeefRTE456KlemsnoZV"
-#define MAX_RESUMABLE_CHUNK_SIZE (512 * 1024) /* bytes = 512 KiB */
+#define MIN_RESUMABLE_CHUNK_SIZE (256 * 1024) /* bytes = 256 KiB; the server requires chunks other than the last to be a multiple of this */
+#define INITIAL_RESUMABLE_CHUNK_SIZE (512 * 1024) /* bytes = 512 KiB */
+#define MAX_RESUMABLE_CHUNK_SIZE (8 * 1024 * 1024) /* bytes = 8 MiB */
+#define RESUMABLE_CHUNK_DURATION (5 * G_USEC_PER_SEC) /* microseconds; the chunk size grows while chunks take less than this to upload */
 
 static GObject *gdata_upload_stream_constructor (GType type, guint n_construct_params, GObjectConstructParam *construct_params);
 static void gdata_upload_stream_dispose (GObject *object);
@@ -222,8 +239,14 @@ struct _GDataUploadStreamPrivate {
 	gsize network_bytes_outstanding; /* the number of bytes which have been written to libsoup but not the network (signalled by write_cond) */
 	gsize network_bytes_written; /* the number of bytes which have been written to the network (signalled by write_cond) */
 	gsize chunk_size; /* the size of the current chunk (in bytes); 0 iff content_length <= 0; must be <= MAX_RESUMABLE_CHUNK_SIZE */
+	gboolean awaiting_response; /* TRUE once the current request's body is complete, until the next one starts (signalled by write_cond) */
+	gsize buffer_size; /* the maximum value of message_bytes_outstanding at which write() can return; 0 to wait for data to hit the network */
 	GCond write_cond; /* signalled when a chunk has been written (protected by write_mutex) */
 
+	/* Only accessed from the network thread */
+	gsize resumable_chunk_size; /* the size of chunks to use from now on, adapted to the connection; a multiple of MIN_RESUMABLE_CHUNK_SIZE */
+	gint64 chunk_idle_time; /* time (in microseconds) the current chunk has spent waiting for data to be written to the stream */
+
 	GCond finished_cond; /* signalled when sending the message (and receiving the response) is finished (protected by response_mutex) */
 	guint response_status; /* set once we finish receiving the response (SOUP_STATUS_NONE otherwise) (protected by response_mutex) */
 	GError *response_error; /* error asynchronously set by the network thread, and picked up by the main thread when appropriate */
@@ -240,6 +263,7 @@ enum {
 	PROP_CANCELLABLE,
 	PROP_AUTHORIZATION_DOMAIN,
 	PROP_CONTENT_LENGTH,
+	PROP_BUFFER_SIZE,
 };
 
 G_DEFINE_TYPE (GDataUploadStream, gdata_upload_stream, G_TYPE_OUTPUT_STREAM)
@@ -392,6 +416,23 @@ gdata_upload_stream_class_init (GDataUploadStreamClass *klass)
 	                                                      "Cancellable", "An optional cancellable used to cancel the entire upload operation.",
 	                                                      G_TYPE_CANCELLABLE,
 	                                                      G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GDataUploadStream:buffer-size:
+	 *
+	 * The maximum number of bytes of written data to hold in memory while waiting for them to be sent over the network. While fewer bytes than
+	 * this are waiting, g_output_stream_write() returns as soon as its data has been queued, rather than waiting for the data to be sent; any error
+	 * sending it is returned by a later call to g_output_stream_write(), g_output_stream_flush() or g_output_stream_close().
+	 *
+	 * If this is <code class="literal">0</code> (the default), g_output_stream_write() always waits for its data to be sent over the network.
+	 *
+	 * Since: 0.15.0
+	 */
+	g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
+	                                 g_param_spec_ulong ("buffer-size",
+	                                                     "Buffer size", "The maximum number of bytes of written data to hold in memory.",
+	                                                     0, G_MAXULONG, 0,
+	                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -501,7 +542,8 @@ gdata_upload_stream_constructor (GType type, guint n_construct_params, GObjectCo
 
 		/* Resumable uploads always start with an initial request, which either contains the XML or is empty. */
 		priv->state = STATE_INITIAL_REQUEST;
-		priv->chunk_size = MIN (priv->content_length, MAX_RESUMABLE_CHUNK_SIZE);
+		priv->resumable_chunk_size = INITIAL_RESUMABLE_CHUNK_SIZE;
+		priv->chunk_size = MIN (priv->content_length, priv->resumable_chunk_size);
 	}
 
 	/* Make sure the headers are set. HACK: This should actually be in build_message(), but we have to work around
@@ -606,6 +648,9 @@ gdata_upload_stream_get_property (GObject *object, guint property_id, GValue *va
 		case PROP_CANCELLABLE:
 			g_value_set_object (value, priv->cancellable);
 			break;
+		case PROP_BUFFER_SIZE:
+			g_value_set_ulong (value, priv->buffer_size);
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -648,6 +693,9 @@ gdata_upload_stream_set_property (GObject *object, guint property_id, const GVal
 			/* Construction only */
 			priv->cancellable = g_value_dup_object (value);
 			break;
+		case PROP_BUFFER_SIZE:
+			gdata_upload_stream_set_buffer_size (GDATA_UPLOAD_STREAM (object), g_value_get_ulong (value));
+			break;
 		default:
 			/* We don't have any other property... */
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -672,6 +720,17 @@ write_cancelled_cb (GCancellable *cancellable, CancelledData *data)
 	g_mutex_unlock (&(priv->write_mutex));
 }
 
+/* Returns TRUE if write() can return without waiting for the data it's queued in the GDataBuffer to be sent over the network. That's the case if
+ * write-behind is enabled and there's no more than ->buffer_size bytes queued; or if we're doing a resumable upload and the current request is
+ * waiting for its response while all the queued data fits in the next chunk. There's no point blocking in the latter case, since the data can't be
+ * sent until the next chunk's request starts. Must be called with ->write_mutex held. */
+static gboolean
+is_write_buffered (GDataUploadStreamPrivate *priv)
+{
+	return ((priv->buffer_size > 0 && priv->message_bytes_outstanding <= priv->buffer_size) ||
+	        (priv->awaiting_response == TRUE && priv->message_bytes_outstanding <= priv->chunk_size));
+}
+
 static gssize
 gdata_upload_stream_write (GOutputStream *stream, const void *buffer, gsize count, GCancellable *cancellable, GError **error_out)
 {
@@ -704,13 +763,13 @@ gdata_upload_stream_write (GOutputStream *stream, const void *buffer, gsize coun
 		goto done;
 	}
 
-	g_mutex_unlock (&(priv->write_mutex));
-
 	/* Increment the number of bytes outstanding for the new write, and keep a record of the old number written so we know if the write's
 	 * finished before we reach write_cond. */
 	old_total_network_bytes_written = priv->total_network_bytes_written;
 	priv->message_bytes_outstanding += count;
 
+	g_mutex_unlock (&(priv->write_mutex));
+
 	/* Handle the more common case of the network thread already having been created first */
 	if (priv->network_thread != NULL) {
 		/* Push the new data into the buffer */
@@ -731,11 +790,18 @@ gdata_upload_stream_write (GOutputStream *stream, const void *buffer, gsize coun
 write:
 	g_mutex_lock (&(priv->write_mutex));
 
-	/* Wait for it to be written */
-	while (priv->total_network_bytes_written - old_total_network_bytes_written < count && cancelled == FALSE && priv->state != STATE_FINISHED) {
+	/* Wait for it to be written, or for it to be buffered (see is_write_buffered()) */
+	while (priv->total_network_bytes_written - old_total_network_bytes_written < count && cancelled == FALSE && priv->state != STATE_FINISHED &&
+	       is_write_buffered (priv) == FALSE) {
 		g_cond_wait (&(priv->write_cond), &(priv->write_mutex));
 	}
-	length_written = MIN (count, priv->total_network_bytes_written - old_total_network_bytes_written);
+
+	if (cancelled == FALSE && priv->state != STATE_FINISHED && is_write_buffered (priv) == TRUE) {
+		/* Buffered; any error sending it will be returned by a later write(), flush() or close() */
+		length_written = count;
+	} else {
+		length_written = MIN (count, priv->total_network_bytes_written - old_total_network_bytes_written);
+	}
 
 	/* Check for an error and return if necessary */
 	if (cancelled == TRUE && length_written < 1) {
@@ -780,7 +846,7 @@ flush_cancelled_cb (GCancellable *cancellable, CancelledData *data)
 	g_mutex_unlock (&(priv->write_mutex));
 }
 
-/* Block until ->network_bytes_outstanding reaches zero. Cancelling the cancellable passed to gdata_upload_stream_flush() breaks out of the wait(),
+/* Block until ->message_bytes_outstanding and ->network_bytes_outstanding reach zero. Cancelling the cancellable passed to gdata_upload_stream_flush() breaks out of the wait(),
  * but doesn't stop the network thread from continuing to write the remaining bytes to the network.
  * The wrapper function, g_output_stream_flush(), calls g_output_stream_set_pending() before calling this function, and calls
  * g_output_stream_clear_pending() afterwards, so we don't need to worry about other operations happening concurrently. We also don't need to worry
@@ -815,8 +881,8 @@ gdata_upload_stream_flush (GOutputStream *stream, GCancellable *cancellable, GEr
 	/* Start the flush operation proper */
 	g_mutex_lock (&(priv->write_mutex));
 
-	/* Wait for all outstanding bytes to be written to the network */
-	while (priv->network_bytes_outstanding > 0 && cancelled == FALSE && priv->state != STATE_FINISHED) {
+	/* Wait for all outstanding bytes (including any buffered by write()) to be written to the network */
+	while ((priv->message_bytes_outstanding > 0 || priv->network_bytes_outstanding > 0) && cancelled == FALSE && priv->state != STATE_FINISHED) {
 		g_cond_wait (&(priv->write_cond), &(priv->write_mutex));
 	}
 
@@ -825,7 +891,7 @@ gdata_upload_stream_flush (GOutputStream *stream, GCancellable *cancellable, GEr
 		g_assert (g_cancellable_set_error_if_cancelled (cancellable, error) == TRUE ||
 		          g_cancellable_set_error_if_cancelled (priv->cancellable, error) == TRUE);
 		success = FALSE;
-	} else if (priv->state == STATE_FINISHED && priv->network_bytes_outstanding > 0) {
+	} else if (priv->state == STATE_FINISHED && (priv->message_bytes_outstanding > 0 || priv->network_bytes_outstanding > 0)) {
 		/* Resumable upload error. */
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, _("Error received from server after uploading a resumable upload chunk."));
 		success = FALSE;
@@ -987,6 +1053,21 @@ gdata_upload_stream_close (GOutputStream *stream, GCancellable *cancellable, GEr
 	return success;
 }
 
+/* In the network thread context, called once a resumable upload chunk has been acknowledged by the server, to choose the size of the next chunk.
+ * The chunk size is doubled while chunks are uploaded quickly, as the connection's healthy and larger chunks spend proportionally less time waiting
+ * for the server's response. It's halved if they're slow, so that a failed chunk loses less. @chunk_duration mustn't include the time spent waiting
+ * for the application to write data to the stream, or a slow producer would make the chunks shrink however fast the connection is. */
+static void
+update_resumable_chunk_size (GDataUploadStream *self, gint64 chunk_duration)
+{
+	GDataUploadStreamPrivate *priv = self->priv;
+
+	if (chunk_duration < RESUMABLE_CHUNK_DURATION)
+		priv->resumable_chunk_size = MIN (priv->resumable_chunk_size * 2, MAX_RESUMABLE_CHUNK_SIZE);
+	else if (chunk_duration > 2 * RESUMABLE_CHUNK_DURATION)
+		priv->resumable_chunk_size = MAX (priv->resumable_chunk_size / 2, MIN_RESUMABLE_CHUNK_SIZE);
+}
+
 /* In the network thread context, called just after writing the headers, or just after writing a chunk, to write the next chunk to libsoup.
  * We don't let it return until we've finished pushing all the data into the buffer.
  * This is due to http://bugzilla.gnome.org/show_bug.cgi?id=522147, which means that
@@ -998,13 +1079,15 @@ gdata_upload_stream_close (GOutputStream *stream, GCancellable *cancellable, GEr
 static void
 write_next_chunk (GDataUploadStream *self, SoupMessage *message)
 {
-	#define CHUNK_SIZE 8192 /* 8KiB */
+	#define BATCH_SIZE (1024 * 1024) /* 1MiB */
 
 	GDataUploadStreamPrivate *priv = self->priv;
 	gboolean has_network_bytes_outstanding, is_complete;
-	gsize length;
+	gsize length = 0, maximum_length;
 	gboolean reached_eof = FALSE;
-	guint8 next_buffer[CHUNK_SIZE];
+	GQueue batch = G_QUEUE_INIT;
+	SoupBuffer *buffer;
+	gint64 pop_start_time;
 
 	g_mutex_lock (&(priv->write_mutex));
 	has_network_bytes_outstanding = (priv->network_bytes_outstanding > 0);
@@ -1019,12 +1102,19 @@ write_next_chunk (GDataUploadStream *self, SoupMessage *message)
 	} else if (is_complete) {
 		soup_message_body_complete (priv->message->request_body);
 
+		/* Let write() buffer data for the next chunk while we wait for the response */
+		g_mutex_lock (&(priv->write_mutex));
+		priv->awaiting_response = (priv->content_length != -1);
+		g_cond_signal (&(priv->write_cond));
+		g_mutex_unlock (&(priv->write_mutex));
+
 		return;
 	}
 
-	/* Append the next chunk to the message body so it can join in the fun.
-	 * Note that this call isn't necessarily blocking, and can return less than the CHUNK_SIZE. This is because
-	 * we could deadlock if we block on getting CHUNK_SIZE bytes at the end of the stream. write() could
+	/* Append the next batch of data to the message body so it can join in the fun. The buffered chunks are handed to libsoup by reference, so
+	 * the data isn't copied again after write() pushed it into the buffer.
+	 * Note that we only block until the first chunk is available, and then take whatever else is already in the buffer, up to BATCH_SIZE. This
+	 * is because we could deadlock if we block on getting BATCH_SIZE bytes at the end of the stream. write() could
 	 * easily be called with fewer bytes, but has no way to notify us that we've reached the end of the
 	 * stream, so we'd happily block on receiving more bytes which weren't forthcoming.
 	 *
@@ -1032,22 +1122,41 @@ write_next_chunk (GDataUploadStream *self, SoupMessage *message)
 	 * time (in the case that we don't know the content length ahead of time). */
 	if (priv->content_length == -1) {
 		/* Non-resumable upload. */
-		length = gdata_buffer_pop_data_limited (priv->buffer, next_buffer, CHUNK_SIZE, &reached_eof);
+		maximum_length = BATCH_SIZE;
 	} else {
 		/* Resumable upload. Ensure we don't exceed the chunk size. */
-		length = gdata_buffer_pop_data_limited (priv->buffer, next_buffer,
-		                                        MIN (CHUNK_SIZE, priv->chunk_size - (priv->network_bytes_written +
-		                                                                             priv->network_bytes_outstanding)), &reached_eof);
+		maximum_length = MIN (BATCH_SIZE, priv->chunk_size - (priv->network_bytes_written + priv->network_bytes_outstanding));
 	}
 
+	pop_start_time = g_get_monotonic_time ();
+
+	do {
+		buffer = gdata_buffer_pop_buffer (priv->buffer, maximum_length - length, &reached_eof, NULL);
+		if (buffer == NULL)
+			break;
+
+		length += buffer->length;
+		g_queue_push_tail (&batch, buffer);
+	} while (reached_eof == FALSE && length < maximum_length && gdata_buffer_get_length (priv->buffer) > 0);
+
+	/* libsoup has nothing left to send at this point, so the connection's idle for as long as we blocked waiting for data above; don't count that
+	 * towards the chunk's duration */
+	priv->chunk_idle_time += g_get_monotonic_time () - pop_start_time;
+
 	g_mutex_lock (&(priv->write_mutex));
 
 	priv->message_bytes_outstanding -= length;
 	priv->network_bytes_outstanding += length;
 
+	/* Wake up any write() waiting for space in the buffer */
+	if (length > 0 && priv->buffer_size > 0)
+		g_cond_signal (&(priv->write_cond));
+
 	/* Append whatever data was returned */
-	if (length > 0)
-		soup_message_body_append (priv->message->request_body, SOUP_MEMORY_COPY, next_buffer, length);
+	while ((buffer = g_queue_pop_head (&batch)) != NULL) {
+		soup_message_body_append_buffer (priv->message->request_body, buffer);
+		soup_buffer_free (buffer);
+	}
 
 	/* Finish off the request body if we've reached EOF (i.e. the stream has been closed), or if we're doing a resumable upload and we reach
 	 * the maximum chunk size. */
@@ -1056,6 +1165,9 @@ write_next_chunk (GDataUploadStream *self, SoupMessage *message)
 		g_assert (reached_eof == FALSE || priv->message_bytes_outstanding == 0);
 
 		soup_message_body_complete (priv->message->request_body);
+
+		priv->awaiting_response = (priv->content_length != -1);
+		g_cond_signal (&(priv->write_cond));
 	}
 
 	g_mutex_unlock (&(priv->write_mutex));
@@ -1110,11 +1222,16 @@ upload_thread (GDataUploadStream *self)
 		gchar *new_uri;
 		SoupMessage *new_message;
 		gsize next_chunk_length;
+		gint64 start_time;
 
 		/* Connect to the wrote-* signals so we can prepare the next chunk for transmission */
 		wrote_headers_signal = g_signal_connect (priv->message, "wrote-headers", (GCallback) wrote_headers_cb, self);
 		wrote_body_data_signal = g_signal_connect (priv->message, "wrote-body-data", (GCallback) wrote_body_data_cb, self);
 
+		start_time = g_get_monotonic_time ();
+		priv->chunk_idle_time = 0;
+
+		_gdata_service_track_request (priv->service, priv->message);
 		_gdata_service_actually_send_message (priv->session, priv->message, priv->cancellable, NULL);
 
 		g_mutex_lock (&(priv->write_mutex));
@@ -1160,6 +1277,7 @@ upload_thread (GDataUploadStream *self)
 				if (priv->message->status_code == 308) {
 					/* Continuation: fall out and prepare the next message */
 					g_assert (priv->content_length == -1 || priv->total_network_bytes_written < (gsize) priv->content_length);
+					update_resumable_chunk_size (self, g_get_monotonic_time () - start_time - priv->chunk_idle_time);
 				} else if (SOUP_STATUS_IS_SUCCESSFUL (priv->message->status_code)) {
 					/* Completion. Check the server isn't misbehaving. */
 					g_assert (priv->content_length == -1 || priv->total_network_bytes_written == (gsize) priv->content_length);
@@ -1182,7 +1300,7 @@ upload_thread (GDataUploadStream *self)
 		/* Prepare the next message. */
 		g_assert (priv->content_length != -1);
 
-		next_chunk_length = MIN (priv->content_length - priv->total_network_bytes_written, MAX_RESUMABLE_CHUNK_SIZE);
+		next_chunk_length = MIN (priv->content_length - priv->total_network_bytes_written, priv->resumable_chunk_size);
 
 		new_uri = g_strdup (soup_message_headers_get_one (priv->message->response_headers, "Location"));
 		if (new_uri == NULL) {
@@ -1217,6 +1335,7 @@ upload_thread (GDataUploadStream *self)
 		g_assert (priv->network_bytes_outstanding == 0);
 		priv->chunk_size = next_chunk_length;
 		priv->network_bytes_written = 0;
+		priv->awaiting_response = FALSE;
 
 		/* Loop round and upload this chunk now. */
 		g_mutex_unlock (&(priv->write_mutex));
@@ -1337,6 +1456,11 @@ gdata_upload_stream_new (GDataService *service, GDataAuthorizationDomain *domain
  * <ulink type="http" url="http://code.google.com/apis/gdata/docs/resumable_upload.html">GData documentation on resumable uploads</ulink> for more
  * information.
  *
+ * The file is uploaded in chunks, each sent in a separate request. The first chunk is 512KiB; the chunk size is doubled (up to 8MiB) after each
+ * chunk which is uploaded quickly, and halved (down to 256KiB) after each one which is slow, so that fast connections don't spend most of their
+ * time waiting for the server to acknowledge small chunks. While the server's acknowledgement of one chunk is awaited, up to a chunk's worth of
+ * data can be written to the stream to be sent in the next chunk, without blocking.
+ *
  * The HTTP method to use should be specified in @method, and will typically be either %SOUP_METHOD_POST (for insertions) or %SOUP_METHOD_PUT
  * (for updates), according to the server and the @upload_uri.
  *
@@ -1391,6 +1515,118 @@ gdata_upload_stream_new_resumable (GDataService *service, GDataAuthorizationDoma
 	                                      NULL));
 }
 
+/**
+ * gdata_upload_stream_new_from_file:
+ * @service: a #GDataService
+ * @domain: (allow-none): the #GDataAuthorizationDomain to authorize the upload, or %NULL
+ * @method: the HTTP method to use
+ * @upload_uri: the URI to upload
+ * @entry: (allow-none): the entry to upload as metadata, or %NULL
+ * @file: the local file to upload
+ * @slug: (allow-none): the file's slug (filename), or %NULL to use the display name of @file
+ * @content_type: (allow-none): the content type of the file being uploaded, or %NULL to use the content type of @file
+ * @cancellable: (allow-none): a #GCancellable for the entire upload stream, or %NULL
+ * @error: a #GError, or %NULL
+ *
+ * Creates a new resumable #GDataUploadStream which uploads the contents of @file, as gdata_upload_stream_new_resumable() does. Rather than being
+ * copied through the stream's buffers, as it would be by g_output_stream_splice() from a #GFileInputStream, @file is memory-mapped and each chunk of
+ * it is sent over the network straight from the mapping. The content length is set to the size of @file.
+ *
+ * @file must be a local file (i.e. g_file_get_path() must return a path for it); otherwise, %G_IO_ERROR_NOT_SUPPORTED will be returned, and the
+ * file should be spliced into a stream from gdata_upload_stream_new_resumable() instead. Other errors from mapping @file or querying its information
+ * may also be returned. @file must not be modified while it's being uploaded.
+ *
+ * The whole of @file is queued for upload when the stream is created, and network communication begins immediately, so nothing should be written to
+ * the returned stream. Call g_output_stream_close() on it to wait for the upload to finish and to find out whether it succeeded; the server's response
+ * can then be retrieved with gdata_upload_stream_get_response() as normal.
+ *
+ * See gdata_upload_stream_new_resumable() for details of the other parameters.
+ *
+ * Return value: (transfer full): a new #GOutputStream, or %NULL; unref with g_object_unref()
+ *
+ * Since: 0.15.0
+ */
+GOutputStream *
+gdata_upload_stream_new_from_file (GDataService *service, GDataAuthorizationDomain *domain, const gchar *method, const gchar *upload_uri,
+                                   GDataEntry *entry, GFile *file, const gchar *slug, const gchar *content_type, GCancellable *cancellable,
+                                   GError **error)
+{
+	GDataUploadStream *self;
+	GFileInfo *file_info;
+	GMappedFile *mapped_file;
+	gchar *path;
+	gsize length;
+
+	g_return_val_if_fail (GDATA_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (domain == NULL || GDATA_IS_AUTHORIZATION_DOMAIN (domain), NULL);
+	g_return_val_if_fail (method != NULL, NULL);
+	g_return_val_if_fail (upload_uri != NULL, NULL);
+	g_return_val_if_fail (entry == NULL || GDATA_IS_ENTRY (entry), NULL);
+	g_return_val_if_fail (G_IS_FILE (file), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	path = g_file_get_path (file);
+	if (path == NULL) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, _("Only local files can be uploaded directly."));
+		return NULL;
+	}
+
+	file_info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+	                               G_FILE_QUERY_INFO_NONE, cancellable, error);
+	if (file_info == NULL) {
+		g_free (path);
+		return NULL;
+	}
+
+	/* Map the file. We take the content length from the mapping, rather than the file info, so they can't disagree. */
+	mapped_file = g_mapped_file_new (path, FALSE, error);
+	g_free (path);
+
+	if (mapped_file == NULL) {
+		g_object_unref (file_info);
+		return NULL;
+	}
+
+	length = g_mapped_file_get_length (mapped_file);
+
+	if (slug == NULL)
+		slug = g_file_info_get_display_name (file_info);
+	if (content_type == NULL)
+		content_type = g_file_info_get_content_type (file_info);
+	if (content_type == NULL)
+		content_type = "application/octet-stream";
+
+	self = GDATA_UPLOAD_STREAM (gdata_upload_stream_new_resumable (service, domain, method, upload_uri, entry, slug, content_type, length,
+	                                                               cancellable));
+	g_object_unref (file_info);
+
+	/* Queue the whole file for upload. The network thread pops it from the buffer in chunks which reference the mapping, so it's never copied. */
+	if (length > 0) {
+		SoupBuffer *buffer;
+
+		buffer = soup_buffer_new_with_owner (g_mapped_file_get_contents (mapped_file), length, g_mapped_file_ref (mapped_file),
+		                                     (GDestroyNotify) g_mapped_file_unref);
+		gdata_buffer_push_buffer (self->priv->buffer, buffer, NULL);
+		soup_buffer_free (buffer);
+
+		g_mutex_lock (&(self->priv->write_mutex));
+		self->priv->message_bytes_outstanding = length;
+		g_mutex_unlock (&(self->priv->write_mutex));
+	}
+
+	g_mapped_file_unref (mapped_file);
+
+	/* Start uploading */
+	create_network_thread (self, error);
+	if (self->priv->network_thread == NULL) {
+		g_object_unref (self);
+		return NULL;
+	}
+
+	return G_OUTPUT_STREAM (self);
+}
+
 /**
  * gdata_upload_stream_get_response:
  * @self: a #GDataUploadStream
@@ -1599,3 +1835,42 @@ gdata_upload_stream_get_cancellable (GDataUploadStream *self)
 	g_assert (self->priv->cancellable != NULL);
 	return self->priv->cancellable;
 }
+
+/**
+ * gdata_upload_stream_get_buffer_size:
+ * @self: a #GDataUploadStream
+ *
+ * Gets the value of #GDataUploadStream:buffer-size.
+ *
+ * Return value: the maximum number of bytes of written data to hold in memory, or <code class="literal">0</code> if writes wait for the network
+ *
+ * Since: 0.15.0
+ **/
+gsize
+gdata_upload_stream_get_buffer_size (GDataUploadStream *self)
+{
+	g_return_val_if_fail (GDATA_IS_UPLOAD_STREAM (self), 0);
+	return self->priv->buffer_size;
+}
+
+/**
+ * gdata_upload_stream_set_buffer_size:
+ * @self: a #GDataUploadStream
+ * @buffer_size: the maximum number of bytes of written data to hold in memory, or <code class="literal">0</code> to make writes wait for the network
+ *
+ * Sets the value of #GDataUploadStream:buffer-size. This takes effect immediately, even if the upload is in progress.
+ *
+ * Since: 0.15.0
+ **/
+void
+gdata_upload_stream_set_buffer_size (GDataUploadStream *self, gsize buffer_size)
+{
+	g_return_if_fail (GDATA_IS_UPLOAD_STREAM (self));
+
+	g_mutex_lock (&(self->priv->write_mutex));
+	self->priv->buffer_size = buffer_size;
+	g_cond_signal (&(self->priv->write_cond));
+	g_mutex_unlock (&(self->priv->write_mutex));
+
+	g_object_notify (G_OBJECT (self), "buffer-size");
+}
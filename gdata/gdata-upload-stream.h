@@ -96,6 +96,9 @@ GOutputStream *gdata_upload_stream_new (GDataService *service, GDataAuthorizatio
 GOutputStream *gdata_upload_stream_new_resumable (GDataService *service, GDataAuthorizationDomain *domain, const gchar *method, const gchar *upload_uri,
                                                   GDataEntry *entry, const gchar *slug, const gchar *content_type, goffset content_length,
                                                   GCancellable *cancellable) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
+GOutputStream *gdata_upload_stream_new_from_file (GDataService *service, GDataAuthorizationDomain *domain, const gchar *method, const gchar *upload_uri,
+                                                  GDataEntry *entry, GFile *file, const gchar *slug, const gchar *content_type,
+                                                  GCancellable *cancellable, GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_MALLOC;
 
 const gchar *gdata_upload_stream_get_response (GDataUploadStream *self, gssize *length);
 
@@ -109,6 +112,9 @@ const gchar *gdata_upload_stream_get_content_type (GDataUploadStream *self) G_GN
 goffset gdata_upload_stream_get_content_length (GDataUploadStream *self) G_GNUC_PURE;
 GCancellable *gdata_upload_stream_get_cancellable (GDataUploadStream *self) G_GNUC_PURE;
 
+gsize gdata_upload_stream_get_buffer_size (GDataUploadStream *self) G_GNUC_PURE;
+void gdata_upload_stream_set_buffer_size (GDataUploadStream *self, gsize buffer_size);
+
 G_END_DECLS
 
 #endif /* !GDATA_UPLOAD_STREAM_H */
@@ -37,6 +37,17 @@
 #include <gdata/gdata-batch-operation.h>
 #include <gdata/gdata-authorizer.h>
 #include <gdata/gdata-authorization-domain.h>
+#include <gdata/gdata-cache.h>
+#include <gdata/gdata-memory-cache.h>
+#include <gdata/gdata-file-cache.h>
+#include <gdata/gdata-sync.h>
+#include <gdata/gdata-connection-pool.h>
+#include <gdata/gdata-retry-policy.h>
+#include <gdata/gdata-rate-limiter.h>
+#include <gdata/gdata-request-scheduler.h>
+#include <gdata/gdata-deadline-cancellable.h>
+#include <gdata/gdata-hedging-policy.h>
+#include <gdata/gdata-circuit-breaker.h>
 #include <gdata/gdata-client-login-authorizer.h>
 #include <gdata/gdata-oauth1-authorizer.h>
 #ifdef GOA_API_IS_SUBJECT_TO_CHANGE
@@ -233,6 +233,54 @@ test_query_all_contacts (QueryAllContactsData *data, gconstpointer service)
 	gdata_mock_server_end_trace (mock_server);
 }
 
+static void
+request_finished_cb (GDataService *service, GDataRequestStats *stats, GDataRequestStats **stats_out)
+{
+	/* Only keep the stats for the first request */
+	if (*stats_out == NULL)
+		*stats_out = gdata_request_stats_copy (stats);
+}
+
+static void
+test_query_all_contacts_request_stats (QueryAllContactsData *data, gconstpointer service)
+{
+	GDataFeed *feed;
+	GDataRequestStats *stats = NULL;
+	gulong handler_id;
+	GError *error = NULL;
+
+	gdata_test_mock_server_start_trace (mock_server, "query-all-contacts-request-stats");
+
+	handler_id = g_signal_connect (service, "request-finished", (GCallback) request_finished_cb, &stats);
+
+	feed = gdata_contacts_service_query_contacts (GDATA_CONTACTS_SERVICE (service), NULL, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+
+	/* The signal is emitted in an idle callback */
+	while (stats == NULL)
+		g_main_context_iteration (NULL, TRUE);
+
+	g_signal_handler_disconnect (service, handler_id);
+
+	/* Check the stats are sensible */
+	g_assert (stats != NULL);
+	g_assert_cmpstr (stats->method, ==, "GET");
+	g_assert (strstr (stats->uri, "/m8/feeds/contacts/default/full") != NULL);
+	g_assert_cmpuint (stats->status_code, ==, SOUP_STATUS_OK);
+	g_assert_cmpint (stats->start_time, >, 0);
+	g_assert_cmpint (stats->total_duration, >=, stats->wait_duration + stats->receive_duration);
+	g_assert_cmpint (stats->request_bytes, ==, 0);
+	g_assert_cmpint (stats->response_bytes, >, 0);
+	g_assert_cmpint (stats->response_encoded_bytes, !=, 0);
+	g_assert_cmpuint (stats->n_entries, ==, g_list_length (gdata_feed_get_entries (feed)));
+
+	gdata_request_stats_free (stats);
+	g_object_unref (feed);
+
+	gdata_mock_server_end_trace (mock_server);
+}
+
 GDATA_ASYNC_CLOSURE_FUNCTIONS (query_all_contacts, QueryAllContactsData);
 
 GDATA_ASYNC_TEST_FUNCTIONS (query_all_contacts, QueryAllContactsData,
@@ -280,6 +328,66 @@ test_query_all_contacts_async_progress_closure (QueryAllContactsData *query_data
 	gdata_mock_server_end_trace (mock_server);
 }
 
+typedef struct {
+	GMainLoop *main_loop;
+	guint n_entries;
+} QueryBatchedData;
+
+static void
+query_batched_progress_cb (GDataEntry **entries, guint n_entries, guint first_entry_key, guint entry_count, QueryBatchedData *data)
+{
+	guint i;
+
+	/* Batches should be non-empty, in order and contiguous */
+	g_assert_cmpuint (n_entries, >, 0);
+	g_assert_cmpuint (first_entry_key, ==, data->n_entries);
+
+	for (i = 0; i < n_entries; i++)
+		g_assert (GDATA_IS_CONTACTS_CONTACT (entries[i]));
+
+	data->n_entries += n_entries;
+}
+
+static void
+query_batched_cb (GDataService *service, GAsyncResult *async_result, QueryBatchedData *data)
+{
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+
+	/* All the batches should have been delivered by now */
+	g_assert_cmpuint (data->n_entries, ==, g_list_length (gdata_feed_get_entries (feed)));
+
+	g_object_unref (feed);
+
+	g_main_loop_quit (data->main_loop);
+}
+
+static void
+test_query_all_contacts_async_batched (QueryAllContactsData *query_data, gconstpointer service)
+{
+	QueryBatchedData data;
+
+	gdata_test_mock_server_start_trace (mock_server, "query-all-contacts-async-batched");
+
+	data.main_loop = g_main_loop_new (NULL, FALSE);
+	data.n_entries = 0;
+
+	gdata_service_query_batched_async (GDATA_SERVICE (service), gdata_contacts_service_get_primary_authorization_domain (),
+	                                   "https://www.google.com/m8/feeds/contacts/default/full", NULL, GDATA_TYPE_CONTACTS_CONTACT, NULL,
+	                                   (GDataQueryBatchProgressCallback) query_batched_progress_cb, &data, NULL,
+	                                   (GAsyncReadyCallback) query_batched_cb, &data);
+	g_main_loop_run (data.main_loop);
+	g_main_loop_unref (data.main_loop);
+
+	g_assert_cmpuint (data.n_entries, >, 0);
+
+	gdata_mock_server_end_trace (mock_server);
+}
+
 typedef struct {
 	GDataContactsContact *new_contact;
 } InsertData;
@@ -2586,6 +2694,10 @@ main (int argc, char *argv[])
 	            test_query_all_contacts_async, tear_down_query_all_contacts_async);
 	g_test_add ("/contacts/query/all_contacts/async/progress_closure", QueryAllContactsData, service,
 	            set_up_query_all_contacts, test_query_all_contacts_async_progress_closure, tear_down_query_all_contacts);
+	g_test_add ("/contacts/query/all_contacts/request_stats", QueryAllContactsData, service, set_up_query_all_contacts,
+	            test_query_all_contacts_request_stats, tear_down_query_all_contacts);
+	g_test_add ("/contacts/query/all_contacts/async/batched", QueryAllContactsData, service,
+	            set_up_query_all_contacts, test_query_all_contacts_async_batched, tear_down_query_all_contacts);
 	g_test_add ("/contacts/query/all_contacts/cancellation", GDataAsyncTestData, service, set_up_query_all_contacts_async,
 	            test_query_all_contacts_async_cancellation, tear_down_query_all_contacts_async);
 
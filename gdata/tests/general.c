@@ -18,7 +18,9 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <locale.h>
+#include <string.h>
 
 #include "gdata.h"
 #include "common.h"
@@ -1423,6 +1425,690 @@ test_service_locale (void)
 	g_object_unref (service);
 }
 
+static void
+test_service_cache (void)
+{
+	GDataService *service;
+	GDataMemoryCache *cache;
+	GDataCache *cache2;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	cache = gdata_memory_cache_new (1024);
+
+	/* Test setting and getting the cache */
+	g_assert (gdata_service_get_cache (service) == NULL);
+	gdata_service_set_cache (service, GDATA_CACHE (cache));
+	g_assert (gdata_service_get_cache (service) == GDATA_CACHE (cache));
+
+	g_object_get (service, "cache", &cache2, NULL);
+	g_assert (cache2 == GDATA_CACHE (cache));
+	g_object_unref (cache2);
+
+	gdata_service_set_cache (service, NULL);
+	g_assert (gdata_service_get_cache (service) == NULL);
+
+	g_object_unref (cache);
+	g_object_unref (service);
+}
+
+static void
+test_service_retry_policy (void)
+{
+	GDataService *service;
+	GDataRetryPolicy *policy;
+	GDataRetryPolicy *policy2;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	policy = gdata_retry_policy_new ();
+
+	/* Check the policy's defaults */
+	g_assert_cmpuint (gdata_retry_policy_get_max_attempts (policy), ==, 4);
+	g_assert_cmpuint (gdata_retry_policy_get_initial_delay (policy), ==, 500);
+	g_assert_cmpuint (gdata_retry_policy_get_max_delay (policy), ==, 32000);
+	g_assert_cmpfloat (gdata_retry_policy_get_jitter (policy), ==, 0.5);
+	g_assert (gdata_retry_policy_get_honour_retry_after (policy) == TRUE);
+	g_assert (gdata_retry_policy_get_retry_non_idempotent (policy) == FALSE);
+
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_SERVICE_UNAVAILABLE) == TRUE);
+	g_assert (gdata_retry_policy_is_retryable_status (policy, 429) == TRUE);
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_CANT_CONNECT) == TRUE);
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_CANT_RESOLVE) == FALSE);
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_NOT_FOUND) == FALSE);
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_OK) == FALSE);
+
+	/* Change the set of retryable statuses */
+	gdata_retry_policy_add_retryable_status (policy, SOUP_STATUS_REQUEST_TIMEOUT);
+	gdata_retry_policy_remove_retryable_status (policy, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_REQUEST_TIMEOUT) == TRUE);
+	g_assert (gdata_retry_policy_is_retryable_status (policy, SOUP_STATUS_INTERNAL_SERVER_ERROR) == FALSE);
+
+	/* Test setting and getting the policy */
+	g_assert (gdata_service_get_retry_policy (service) == NULL);
+	gdata_service_set_retry_policy (service, policy);
+	g_assert (gdata_service_get_retry_policy (service) == policy);
+
+	g_object_get (service, "retry-policy", &policy2, NULL);
+	g_assert (policy2 == policy);
+	g_object_unref (policy2);
+
+	gdata_service_set_retry_policy (service, NULL);
+	g_assert (gdata_service_get_retry_policy (service) == NULL);
+
+	g_object_unref (policy);
+	g_object_unref (service);
+}
+
+static void
+test_service_rate_limiter (void)
+{
+	GDataService *service;
+	GDataRateLimiter *limiter, *limiter2;
+	GDataAuthorizationDomain *domain;
+	gdouble requests_per_second;
+	guint burst;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	limiter = gdata_rate_limiter_new (5.0, 20);
+	domain = g_object_new (GDATA_TYPE_AUTHORIZATION_DOMAIN, "service-name", "foo", "scope", "http://example.com/", NULL);
+
+	/* Check the limiter's properties */
+	g_assert_cmpfloat (gdata_rate_limiter_get_requests_per_second (limiter), ==, 5.0);
+	g_assert_cmpuint (gdata_rate_limiter_get_burst (limiter), ==, 20);
+	g_assert (gdata_rate_limiter_get_adaptive (limiter) == TRUE);
+
+	/* Domains without their own limits should use the defaults */
+	g_assert (gdata_rate_limiter_get_domain_limit (limiter, domain, &requests_per_second, &burst) == FALSE);
+	g_assert_cmpfloat (requests_per_second, ==, 5.0);
+	g_assert_cmpuint (burst, ==, 20);
+	g_assert_cmpfloat (gdata_rate_limiter_get_current_rate (limiter, domain), ==, 5.0);
+
+	gdata_rate_limiter_set_requests_per_second (limiter, 2.0);
+	g_assert_cmpfloat (gdata_rate_limiter_get_current_rate (limiter, domain), ==, 2.0);
+
+	/* Set and unset a domain-specific limit */
+	gdata_rate_limiter_set_domain_limit (limiter, domain, 1.5, 3);
+	g_assert (gdata_rate_limiter_get_domain_limit (limiter, domain, &requests_per_second, &burst) == TRUE);
+	g_assert_cmpfloat (requests_per_second, ==, 1.5);
+	g_assert_cmpuint (burst, ==, 3);
+	g_assert_cmpfloat (gdata_rate_limiter_get_current_rate (limiter, domain), ==, 1.5);
+	g_assert_cmpfloat (gdata_rate_limiter_get_current_rate (limiter, NULL), ==, 2.0);
+
+	gdata_rate_limiter_unset_domain_limit (limiter, domain);
+	g_assert (gdata_rate_limiter_get_domain_limit (limiter, domain, NULL, NULL) == FALSE);
+	g_assert_cmpfloat (gdata_rate_limiter_get_current_rate (limiter, domain), ==, 2.0);
+
+	/* Test setting and getting the limiter */
+	g_assert (gdata_service_get_rate_limiter (service) == NULL);
+	gdata_service_set_rate_limiter (service, limiter);
+	g_assert (gdata_service_get_rate_limiter (service) == limiter);
+
+	g_object_get (service, "rate-limiter", &limiter2, NULL);
+	g_assert (limiter2 == limiter);
+	g_object_unref (limiter2);
+
+	gdata_service_set_rate_limiter (service, NULL);
+	g_assert (gdata_service_get_rate_limiter (service) == NULL);
+
+	g_object_unref (domain);
+	g_object_unref (limiter);
+	g_object_unref (service);
+}
+
+static void
+test_service_request_scheduler (void)
+{
+	GDataService *service;
+	GDataRequestScheduler *scheduler, *scheduler2;
+	GDataQuery *query;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	scheduler = gdata_request_scheduler_new ();
+
+	/* Check the defaults */
+	g_assert_cmpuint (gdata_request_scheduler_get_max_requests (scheduler), ==, 2);
+	g_assert_cmpuint (gdata_request_scheduler_get_max_requests_for_priority (scheduler, GDATA_REQUEST_PRIORITY_INTERACTIVE), ==, 2);
+	g_assert_cmpuint (gdata_request_scheduler_get_max_requests_for_priority (scheduler, GDATA_REQUEST_PRIORITY_NORMAL), ==, 2);
+	g_assert_cmpuint (gdata_request_scheduler_get_max_requests_for_priority (scheduler, GDATA_REQUEST_PRIORITY_BULK), ==, 1);
+	g_assert_cmpuint (gdata_request_scheduler_get_n_active_requests (scheduler, GDATA_REQUEST_PRIORITY_NORMAL), ==, 0);
+	g_assert_cmpuint (gdata_request_scheduler_get_n_queued_requests (scheduler, GDATA_REQUEST_PRIORITY_NORMAL), ==, 0);
+
+	/* Change the limits */
+	gdata_request_scheduler_set_max_requests (scheduler, 6);
+	gdata_request_scheduler_set_max_requests_for_priority (scheduler, GDATA_REQUEST_PRIORITY_BULK, 3);
+	g_assert_cmpuint (gdata_request_scheduler_get_max_requests (scheduler), ==, 6);
+	g_assert_cmpuint (gdata_request_scheduler_get_max_requests_for_priority (scheduler, GDATA_REQUEST_PRIORITY_BULK), ==, 3);
+
+	/* Test setting and getting the scheduler */
+	g_assert (gdata_service_get_request_scheduler (service) == NULL);
+	gdata_service_set_request_scheduler (service, scheduler);
+	g_assert (gdata_service_get_request_scheduler (service) == scheduler);
+
+	g_object_get (service, "request-scheduler", &scheduler2, NULL);
+	g_assert (scheduler2 == scheduler);
+	g_object_unref (scheduler2);
+
+	gdata_service_set_request_scheduler (service, NULL);
+	g_assert (gdata_service_get_request_scheduler (service) == NULL);
+
+	/* Setting a query's priority shouldn't unset its ETag, since it doesn't change the query URI */
+	query = gdata_query_new (NULL);
+	g_assert_cmpint (gdata_query_get_priority (query), ==, GDATA_REQUEST_PRIORITY_NORMAL);
+
+	gdata_query_set_etag (query, "W/\"foobar\"");
+	gdata_query_set_priority (query, GDATA_REQUEST_PRIORITY_INTERACTIVE);
+	g_assert_cmpint (gdata_query_get_priority (query), ==, GDATA_REQUEST_PRIORITY_INTERACTIVE);
+	g_assert_cmpstr (gdata_query_get_etag (query), ==, "W/\"foobar\"");
+
+	g_object_unref (query);
+	g_object_unref (scheduler);
+	g_object_unref (service);
+}
+
+static void
+test_service_hedging_policy (void)
+{
+	GDataService *service;
+	GDataHedgingPolicy *policy, *policy2;
+	GDataFeed *feed;
+	GCancellable *cancellable;
+	GError *error = NULL;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	policy = gdata_hedging_policy_new ();
+
+	/* Check the defaults */
+	g_assert_cmpuint (gdata_hedging_policy_get_percentile (policy), ==, 95);
+	g_assert_cmpuint (gdata_hedging_policy_get_min_delay (policy), ==, 50);
+	g_assert_cmpfloat (gdata_hedging_policy_get_budget (policy), ==, 0.05);
+	g_assert_cmpuint (gdata_hedging_policy_get_n_hedged_requests (policy), ==, 0);
+
+	/* Change the settings */
+	gdata_hedging_policy_set_percentile (policy, 90);
+	gdata_hedging_policy_set_min_delay (policy, 0);
+	gdata_hedging_policy_set_budget (policy, 0.5);
+
+	g_assert_cmpuint (gdata_hedging_policy_get_percentile (policy), ==, 90);
+	g_assert_cmpuint (gdata_hedging_policy_get_min_delay (policy), ==, 0);
+	g_assert_cmpfloat (gdata_hedging_policy_get_budget (policy), ==, 0.5);
+
+	/* Test setting and getting the policy */
+	g_assert (gdata_service_get_hedging_policy (service) == NULL);
+	gdata_service_set_hedging_policy (service, policy);
+	g_assert (gdata_service_get_hedging_policy (service) == policy);
+
+	g_object_get (service, "hedging-policy", &policy2, NULL);
+	g_assert (policy2 == policy);
+	g_object_unref (policy2);
+
+	/* A hedged query which is cancelled before any network activity should fail normally, without being hedged */
+	cancellable = g_cancellable_new ();
+	g_cancellable_cancel (cancellable);
+
+	feed = gdata_service_query (service, NULL, "http://example.com/feed", NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_assert_cmpuint (gdata_hedging_policy_get_n_hedged_requests (policy), ==, 0);
+
+	gdata_service_set_hedging_policy (service, NULL);
+	g_assert (gdata_service_get_hedging_policy (service) == NULL);
+
+	g_object_unref (cancellable);
+	g_object_unref (policy);
+	g_object_unref (service);
+}
+
+static void
+test_service_compress_requests (void)
+{
+	GDataService *service;
+	gboolean compress_requests;
+	guint compression_threshold;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+
+	/* Check the defaults */
+	g_assert (gdata_service_get_compress_requests (service) == FALSE);
+	g_assert_cmpuint (gdata_service_get_compression_threshold (service), ==, 4096);
+
+	/* Test setting and getting the properties */
+	gdata_service_set_compress_requests (service, TRUE);
+	gdata_service_set_compression_threshold (service, 0);
+
+	g_assert (gdata_service_get_compress_requests (service) == TRUE);
+	g_assert_cmpuint (gdata_service_get_compression_threshold (service), ==, 0);
+
+	g_object_get (service,
+	              "compress-requests", &compress_requests,
+	              "compression-threshold", &compression_threshold,
+	              NULL);
+
+	g_assert (compress_requests == TRUE);
+	g_assert_cmpuint (compression_threshold, ==, 0);
+
+	g_object_unref (service);
+}
+
+static void
+test_service_circuit_breaker (void)
+{
+	GDataService *service;
+	GDataCircuitBreaker *breaker, *breaker2;
+	guint window_size;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	breaker = gdata_circuit_breaker_new ();
+
+	/* Check the defaults */
+	g_assert_cmpfloat (gdata_circuit_breaker_get_failure_threshold (breaker), ==, 0.5);
+	g_assert_cmpuint (gdata_circuit_breaker_get_window_size (breaker), ==, 20);
+	g_assert_cmpuint (gdata_circuit_breaker_get_open_duration (breaker), ==, 30000);
+
+	/* Change the settings */
+	gdata_circuit_breaker_set_failure_threshold (breaker, 0.25);
+	gdata_circuit_breaker_set_window_size (breaker, 4);
+	gdata_circuit_breaker_set_open_duration (breaker, 1000);
+
+	g_assert_cmpfloat (gdata_circuit_breaker_get_failure_threshold (breaker), ==, 0.25);
+	g_assert_cmpuint (gdata_circuit_breaker_get_window_size (breaker), ==, 4);
+	g_assert_cmpuint (gdata_circuit_breaker_get_open_duration (breaker), ==, 1000);
+
+	g_object_get (breaker, "window-size", &window_size, NULL);
+	g_assert_cmpuint (window_size, ==, 4);
+
+	/* Hosts which haven't been contacted yet have closed circuits, and resetting them does nothing */
+	g_assert_cmpint (gdata_circuit_breaker_get_state (breaker, "example.com"), ==, GDATA_CIRCUIT_STATE_CLOSED);
+	gdata_circuit_breaker_reset (breaker, "example.com");
+	g_assert_cmpint (gdata_circuit_breaker_get_state (breaker, "example.com"), ==, GDATA_CIRCUIT_STATE_CLOSED);
+
+	/* Test setting and getting the breaker */
+	g_assert (gdata_service_get_circuit_breaker (service) == NULL);
+	gdata_service_set_circuit_breaker (service, breaker);
+	g_assert (gdata_service_get_circuit_breaker (service) == breaker);
+
+	g_object_get (service, "circuit-breaker", &breaker2, NULL);
+	g_assert (breaker2 == breaker);
+	g_object_unref (breaker2);
+
+	gdata_service_set_circuit_breaker (service, NULL);
+	g_assert (gdata_service_get_circuit_breaker (service) == NULL);
+
+	g_object_unref (breaker);
+	g_object_unref (service);
+}
+
+static void
+test_service_deadline_cancellable (void)
+{
+	GDataService *service;
+	GCancellable *cancellable, *parent;
+	GDataFeed *feed;
+	gint64 now;
+	GError *error = NULL;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+
+	/* A deadline in the future */
+	parent = g_cancellable_new ();
+	now = g_get_monotonic_time ();
+	cancellable = gdata_deadline_cancellable_new (3600000, parent);
+
+	g_assert (GDATA_IS_DEADLINE_CANCELLABLE (cancellable));
+	g_assert_cmpint (gdata_deadline_cancellable_get_deadline (GDATA_DEADLINE_CANCELLABLE (cancellable)), >=, now + 3600000000);
+	g_assert_cmpuint (gdata_deadline_cancellable_get_remaining_time (GDATA_DEADLINE_CANCELLABLE (cancellable)), <=, 3600000);
+	g_assert_cmpuint (gdata_deadline_cancellable_get_remaining_time (GDATA_DEADLINE_CANCELLABLE (cancellable)), >, 0);
+	g_assert (gdata_deadline_cancellable_has_expired (GDATA_DEADLINE_CANCELLABLE (cancellable)) == FALSE);
+	g_assert (g_cancellable_is_cancelled (cancellable) == FALSE);
+
+	/* Cancelling the parent should cancel the deadline cancellable, and requests should report a normal cancellation */
+	g_cancellable_cancel (parent);
+	g_assert (g_cancellable_is_cancelled (cancellable) == TRUE);
+	g_assert (gdata_deadline_cancellable_has_expired (GDATA_DEADLINE_CANCELLABLE (cancellable)) == FALSE);
+
+	feed = gdata_service_query (service, NULL, "http://example.com/feed", NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_object_unref (cancellable);
+	g_object_unref (parent);
+
+	/* A deadline which passes straight away should cancel the cancellable, and requests should time out */
+	cancellable = gdata_deadline_cancellable_new (0, NULL);
+
+	while (g_cancellable_is_cancelled (cancellable) == FALSE)
+		g_usleep (G_USEC_PER_SEC / 100);
+
+	g_assert (gdata_deadline_cancellable_has_expired (GDATA_DEADLINE_CANCELLABLE (cancellable)) == TRUE);
+	g_assert_cmpuint (gdata_deadline_cancellable_get_remaining_time (GDATA_DEADLINE_CANCELLABLE (cancellable)), ==, 0);
+
+	feed = gdata_service_query (service, NULL, "http://example.com/feed", NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_object_unref (cancellable);
+	g_object_unref (service);
+}
+
+static void
+coalesced_query_cancelled_cb (GDataService *service, GAsyncResult *async_result, guint *n_pending)
+{
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	*n_pending = *n_pending - 1;
+}
+
+static void
+test_service_coalesce_queries (void)
+{
+	GDataService *service;
+	GCancellable *cancellable;
+	gboolean coalesce_queries;
+	guint n_pending = 2;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+
+	/* Test setting and getting the property */
+	g_assert (gdata_service_get_coalesce_queries (service) == FALSE);
+	gdata_service_set_coalesce_queries (service, TRUE);
+	g_assert (gdata_service_get_coalesce_queries (service) == TRUE);
+
+	g_object_get (service, "coalesce-queries", &coalesce_queries, NULL);
+	g_assert (coalesce_queries == TRUE);
+
+	/* Two identical queries which are both cancelled before any network activity should each be completed with a cancellation error */
+	cancellable = g_cancellable_new ();
+	g_cancellable_cancel (cancellable);
+
+	gdata_service_query_async (service, NULL, "http://example.com/feed", NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, NULL,
+	                           (GAsyncReadyCallback) coalesced_query_cancelled_cb, &n_pending);
+	gdata_service_query_async (service, NULL, "http://example.com/feed", NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, NULL,
+	                           (GAsyncReadyCallback) coalesced_query_cancelled_cb, &n_pending);
+
+	while (n_pending > 0)
+		g_main_context_iteration (NULL, TRUE);
+
+	g_object_unref (cancellable);
+	g_object_unref (service);
+}
+
+static void
+test_service_connection_pool (void)
+{
+	GDataConnectionPool *pool, *pool2;
+	GDataService *service, *service2;
+	GDataAuthorizer *authorizer;
+
+	/* Check the defaults */
+	pool = gdata_connection_pool_new ();
+
+	g_assert_cmpuint (gdata_connection_pool_get_max_connections (pool), ==, 10);
+	g_assert_cmpuint (gdata_connection_pool_get_max_connections_per_host (pool), ==, 2);
+	g_assert_cmpuint (gdata_connection_pool_get_idle_timeout (pool), ==, 60);
+
+	gdata_connection_pool_set_max_connections (pool, 20);
+	gdata_connection_pool_set_max_connections_per_host (pool, 4);
+	gdata_connection_pool_set_idle_timeout (pool, 0);
+
+	g_assert_cmpuint (gdata_connection_pool_get_max_connections (pool), ==, 20);
+	g_assert_cmpuint (gdata_connection_pool_get_max_connections_per_host (pool), ==, 4);
+	g_assert_cmpuint (gdata_connection_pool_get_idle_timeout (pool), ==, 0);
+
+	/* A service without a pool should get a private one */
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	g_assert (GDATA_IS_CONNECTION_POOL (gdata_service_get_connection_pool (service)));
+	g_assert (gdata_service_get_connection_pool (service) != pool);
+	g_object_unref (service);
+
+	/* Services and authorizers constructed with the same pool should share it, along with its timeout */
+	service = g_object_new (GDATA_TYPE_SERVICE, "connection-pool", pool, NULL);
+	service2 = g_object_new (GDATA_TYPE_SERVICE, "connection-pool", pool, NULL);
+	authorizer = g_object_new (GDATA_TYPE_CLIENT_LOGIN_AUTHORIZER, "client-id", CLIENT_ID, "connection-pool", pool, NULL);
+
+	g_assert (gdata_service_get_connection_pool (service) == pool);
+	g_assert (gdata_service_get_connection_pool (service2) == pool);
+	g_assert (gdata_client_login_authorizer_get_connection_pool (GDATA_CLIENT_LOGIN_AUTHORIZER (authorizer)) == pool);
+
+	g_object_get (service, "connection-pool", &pool2, NULL);
+	g_assert (pool2 == pool);
+	g_object_unref (pool2);
+
+	gdata_service_set_timeout (service, 30);
+	g_assert_cmpuint (gdata_service_get_timeout (service2), ==, 30);
+	g_assert_cmpuint (gdata_client_login_authorizer_get_timeout (GDATA_CLIENT_LOGIN_AUTHORIZER (authorizer)), ==, 30);
+
+	/* The pool should outlive the objects which were sharing it */
+	g_object_unref (service);
+	g_object_unref (service2);
+	g_object_unref (authorizer);
+
+	g_assert_cmpuint (gdata_connection_pool_get_max_connections (pool), ==, 20);
+
+	g_object_unref (pool);
+}
+
+static void
+check_cache_store_and_look_up (GDataCache *cache)
+{
+	SoupBuffer *body;
+	gchar *etag, *content_type;
+
+	/* Nothing cached yet */
+	g_assert (gdata_cache_look_up (cache, "http://example.com/feed", &etag, &content_type, &body) == FALSE);
+	g_assert (etag == NULL);
+	g_assert (content_type == NULL);
+	g_assert (body == NULL);
+
+	/* Store a response and look it up again */
+	body = soup_buffer_new (SOUP_MEMORY_STATIC, "<feed/>", 7);
+	gdata_cache_store (cache, "http://example.com/feed", "\"etag1\"", "application/atom+xml", body);
+	soup_buffer_free (body);
+
+	g_assert (gdata_cache_look_up (cache, "http://example.com/feed", &etag, &content_type, &body) == TRUE);
+	g_assert_cmpstr (etag, ==, "\"etag1\"");
+	g_assert_cmpstr (content_type, ==, "application/atom+xml");
+	g_assert_cmpuint (body->length, ==, 7);
+	g_assert (memcmp (body->data, "<feed/>", 7) == 0);
+
+	g_free (etag);
+	g_free (content_type);
+	soup_buffer_free (body);
+
+	/* Replace it, without a content type */
+	body = soup_buffer_new (SOUP_MEMORY_STATIC, "<feed></feed>", 13);
+	gdata_cache_store (cache, "http://example.com/feed", "\"etag2\"", NULL, body);
+	soup_buffer_free (body);
+
+	g_assert (gdata_cache_look_up (cache, "http://example.com/feed", &etag, &content_type, &body) == TRUE);
+	g_assert_cmpstr (etag, ==, "\"etag2\"");
+	g_assert (content_type == NULL);
+	g_assert_cmpuint (body->length, ==, 13);
+	g_assert (memcmp (body->data, "<feed></feed>", 13) == 0);
+
+	g_free (etag);
+	soup_buffer_free (body);
+
+	/* Output parameters are optional */
+	g_assert (gdata_cache_look_up (cache, "http://example.com/feed", NULL, NULL, NULL) == TRUE);
+
+	/* Remove it */
+	gdata_cache_remove (cache, "http://example.com/feed");
+	g_assert (gdata_cache_look_up (cache, "http://example.com/feed", NULL, NULL, NULL) == FALSE);
+
+	/* Store two and clear them both */
+	body = soup_buffer_new (SOUP_MEMORY_STATIC, "<entry/>", 8);
+	gdata_cache_store (cache, "http://example.com/entry1", "\"etag3\"", NULL, body);
+	gdata_cache_store (cache, "http://example.com/entry2", "\"etag4\"", NULL, body);
+	soup_buffer_free (body);
+
+	g_assert (gdata_cache_look_up (cache, "http://example.com/entry1", NULL, NULL, NULL) == TRUE);
+	g_assert (gdata_cache_look_up (cache, "http://example.com/entry2", NULL, NULL, NULL) == TRUE);
+
+	gdata_cache_clear (cache);
+
+	g_assert (gdata_cache_look_up (cache, "http://example.com/entry1", NULL, NULL, NULL) == FALSE);
+	g_assert (gdata_cache_look_up (cache, "http://example.com/entry2", NULL, NULL, NULL) == FALSE);
+}
+
+static void
+test_cache_memory (void)
+{
+	GDataMemoryCache *cache;
+	SoupBuffer *body;
+	guint64 max_size;
+
+	cache = gdata_memory_cache_new (1024);
+
+	g_assert_cmpuint (gdata_memory_cache_get_max_size (cache), ==, 1024);
+	g_object_get (cache, "max-size", &max_size, NULL);
+	g_assert_cmpuint (max_size, ==, 1024);
+
+	check_cache_store_and_look_up (GDATA_CACHE (cache));
+	g_assert_cmpuint (gdata_memory_cache_get_size (cache), ==, 0);
+
+	/* Check that the least recently used response is evicted when the cache gets full */
+	body = soup_buffer_new (SOUP_MEMORY_STATIC, "0123456789", 10);
+	gdata_memory_cache_set_max_size (cache, 25);
+
+	gdata_cache_store (GDATA_CACHE (cache), "http://example.com/1", "\"1\"", NULL, body);
+	gdata_cache_store (GDATA_CACHE (cache), "http://example.com/2", "\"2\"", NULL, body);
+	g_assert_cmpuint (gdata_memory_cache_get_size (cache), ==, 20);
+
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/1", NULL, NULL, NULL) == TRUE);
+	gdata_cache_store (GDATA_CACHE (cache), "http://example.com/3", "\"3\"", NULL, body);
+	g_assert_cmpuint (gdata_memory_cache_get_size (cache), ==, 20);
+
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/1", NULL, NULL, NULL) == TRUE);
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/2", NULL, NULL, NULL) == FALSE);
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/3", NULL, NULL, NULL) == TRUE);
+
+	/* Shrinking the cache should evict responses too */
+	gdata_memory_cache_set_max_size (cache, 15);
+	g_assert_cmpuint (gdata_memory_cache_get_size (cache), ==, 10);
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/1", NULL, NULL, NULL) == FALSE);
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/3", NULL, NULL, NULL) == TRUE);
+
+	/* Responses bigger than the whole cache shouldn't be stored */
+	gdata_memory_cache_set_max_size (cache, 5);
+	gdata_cache_store (GDATA_CACHE (cache), "http://example.com/4", "\"4\"", NULL, body);
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/4", NULL, NULL, NULL) == FALSE);
+	g_assert_cmpuint (gdata_memory_cache_get_size (cache), ==, 0);
+
+	soup_buffer_free (body);
+	g_object_unref (cache);
+}
+
+static void
+test_cache_file (void)
+{
+	GDataFileCache *cache;
+	SoupBuffer *body;
+	gchar *directory, *path;
+	GError *error = NULL;
+
+	directory = g_dir_make_tmp ("libgdata-cache-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	/* Use a subdirectory to check that it's created automatically */
+	path = g_build_filename (directory, "cache", NULL);
+	cache = gdata_file_cache_new (path);
+	g_assert_cmpstr (gdata_file_cache_get_directory (cache), ==, path);
+
+	check_cache_store_and_look_up (GDATA_CACHE (cache));
+
+	/* Check that responses persist between cache instances */
+	body = soup_buffer_new (SOUP_MEMORY_STATIC, "<feed/>", 7);
+	gdata_cache_store (GDATA_CACHE (cache), "http://example.com/feed", "\"etag\"", NULL, body);
+	soup_buffer_free (body);
+	g_object_unref (cache);
+
+	cache = gdata_file_cache_new (path);
+	g_assert (gdata_cache_look_up (GDATA_CACHE (cache), "http://example.com/feed", NULL, NULL, &body) == TRUE);
+	g_assert_cmpuint (body->length, ==, 7);
+	g_assert (memcmp (body->data, "<feed/>", 7) == 0);
+	soup_buffer_free (body);
+
+	gdata_cache_clear (GDATA_CACHE (cache));
+	g_object_unref (cache);
+
+	g_assert_cmpint (g_rmdir (path), ==, 0);
+	g_assert_cmpint (g_rmdir (directory), ==, 0);
+
+	g_free (path);
+	g_free (directory);
+}
+
+static void
+test_sync_properties (void)
+{
+	GDataService *service, *service2;
+	GDataQuery *query, *query2;
+	GDataSync *sync;
+	gchar *feed_uri;
+	GType entry_type;
+	gint64 updated_min;
+
+	service = g_object_new (GDATA_TYPE_SERVICE, NULL);
+	query = gdata_query_new ("foo");
+
+	sync = gdata_sync_new (service, NULL, "http://example.com/feed", query, GDATA_TYPE_ENTRY);
+
+	g_assert (gdata_sync_get_service (sync) == service);
+	g_assert (gdata_sync_get_authorization_domain (sync) == NULL);
+	g_assert_cmpstr (gdata_sync_get_feed_uri (sync), ==, "http://example.com/feed");
+	g_assert (gdata_sync_get_query (sync) == query);
+	g_assert (gdata_sync_get_entry_type (sync) == GDATA_TYPE_ENTRY);
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, -1);
+
+	g_object_get (sync,
+	              "service", &service2,
+	              "feed-uri", &feed_uri,
+	              "query", &query2,
+	              "entry-type", &entry_type,
+	              "updated-min", &updated_min,
+	              NULL);
+
+	g_assert (service2 == service);
+	g_assert_cmpstr (feed_uri, ==, "http://example.com/feed");
+	g_assert (query2 == query);
+	g_assert (entry_type == GDATA_TYPE_ENTRY);
+	g_assert_cmpint (updated_min, ==, -1);
+
+	g_object_unref (service2);
+	g_free (feed_uri);
+	g_object_unref (query2);
+
+	/* The local set of entries should start off empty */
+	g_assert (gdata_sync_get_entries (sync) == NULL);
+	g_assert (gdata_sync_look_up_entry (sync, "http://example.com/entry") == NULL);
+
+	/* Restoring and resetting the high-water mark */
+	gdata_sync_set_updated_min (sync, 1234567890);
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, 1234567890);
+
+	gdata_sync_reset (sync);
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, -1);
+
+	g_object_unref (sync);
+
+	/* A query should be created if one isn't provided */
+	sync = gdata_sync_new (service, NULL, "http://example.com/feed", NULL, GDATA_TYPE_ENTRY);
+	g_assert (GDATA_IS_QUERY (gdata_sync_get_query (sync)));
+	g_object_unref (sync);
+
+	g_object_unref (query);
+	g_object_unref (service);
+}
+
 static void
 test_access_rule_get_xml (void)
 {
@@ -4459,6 +5145,21 @@ main (int argc, char *argv[])
 
 	g_test_add_func ("/service/network_error", test_service_network_error);
 	g_test_add_func ("/service/locale", test_service_locale);
+	g_test_add_func ("/service/cache", test_service_cache);
+	g_test_add_func ("/service/connection_pool", test_service_connection_pool);
+	g_test_add_func ("/service/retry_policy", test_service_retry_policy);
+	g_test_add_func ("/service/rate_limiter", test_service_rate_limiter);
+	g_test_add_func ("/service/coalesce_queries", test_service_coalesce_queries);
+	g_test_add_func ("/service/request_scheduler", test_service_request_scheduler);
+	g_test_add_func ("/service/deadline_cancellable", test_service_deadline_cancellable);
+	g_test_add_func ("/service/hedging_policy", test_service_hedging_policy);
+	g_test_add_func ("/service/compress_requests", test_service_compress_requests);
+	g_test_add_func ("/service/circuit_breaker", test_service_circuit_breaker);
+
+	g_test_add_func ("/cache/memory", test_cache_memory);
+	g_test_add_func ("/cache/file", test_cache_file);
+
+	g_test_add_func ("/sync/properties", test_sync_properties);
 
 	g_test_add_func ("/entry/get_xml", test_entry_get_xml);
 	g_test_add_func ("/entry/get_json", test_entry_get_json);
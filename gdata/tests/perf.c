@@ -18,6 +18,12 @@
  */
 
 #include <glib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 #include "gdata.h"
 #include "common.h"
@@ -74,12 +80,165 @@ test_parse_feed (void)
 	g_object_unref (feed);
 }
 
+#define UPLOAD_SIZE (16 * 1024 * 1024) /* bytes = 16 MiB */
+#define UPLOAD_LATENCY 50 /* milliseconds; simulated round trip time for each chunk of a resumable upload */
+#define LARGE_UPLOAD_SIZE (128 * 1024 * 1024) /* bytes = 128 MiB */
+
+typedef struct {
+	guint latency; /* milliseconds */
+	guint n_requests;
+} UploadServerData;
+
+static gpointer
+run_server_thread (SoupServer *server)
+{
+	soup_server_run (server);
+
+	return NULL;
+}
+
+static gboolean
+quit_server_cb (SoupServer *server)
+{
+	soup_server_quit (server);
+
+	return FALSE;
+}
+
+static void
+upload_server_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                          UploadServerData *server_data)
+{
+	goffset range_start, range_end, range_length;
+	gchar *upload_uri;
+
+	server_data->n_requests++;
+
+	/* Simulate the latency of a real server acknowledging each request. */
+	g_usleep (server_data->latency * 1000);
+
+	/* Non-resumable uploads are completed by their only request; resumable ones by the request containing the last byte. */
+	if ((strcmp (path, "/") == 0 && soup_message_headers_get_one (message->request_headers, "X-Upload-Content-Length") == NULL) ||
+	    (strcmp (path, "/") != 0 &&
+	     soup_message_headers_get_content_range (message->request_headers, &range_start, &range_end, &range_length) == TRUE &&
+	     range_end + 1 == range_length)) {
+		const gchar *completion_response =
+			"<?xml version='1.0' encoding='UTF-8'?>"
+			"<entry xmlns='http://www.w3.org/2005/Atom'>"
+				"<title type='text'>Test title!</title>"
+				"<id>tag:youtube.com,2008:video:fooishbar</id>"
+				"<updated>2009-03-23T12:46:58Z</updated>"
+			"</entry>";
+
+		/* Completion. */
+		soup_message_set_status (message, SOUP_STATUS_CREATED);
+		soup_message_headers_set_content_type (message->response_headers, "application/atom+xml", NULL);
+		soup_message_body_append (message->response_body, SOUP_MEMORY_STATIC, completion_response, strlen (completion_response));
+
+		return;
+	}
+
+	/* Initial request or continuation. */
+	soup_message_set_status (message, (strcmp (path, "/") == 0) ? SOUP_STATUS_OK : 308);
+
+	upload_uri = g_strdup_printf ("http://%s:%u/upload",
+	                              soup_address_get_physical (soup_socket_get_local_address (soup_server_get_listener (server))),
+	                              soup_server_get_port (server));
+	soup_message_headers_replace (message->response_headers, "Location", upload_uri);
+	g_free (upload_uri);
+}
+
+/* Uploads @upload_size bytes to a local server which takes @latency milliseconds to respond to each request, and returns the number of requests
+ * made. */
+static guint
+test_upload (gsize upload_size, gboolean resumable, guint latency)
+{
+	struct sockaddr_in sock;
+	SoupAddress *addr;
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *port_string, *upload_uri;
+	GDataService *service;
+	GOutputStream *upload_stream;
+	guint8 *buffer;
+	gsize total_length_written = 0;
+	UploadServerData server_data;
+	GError *error = NULL;
+
+	server_data.latency = latency;
+	server_data.n_requests = 0;
+
+	/* Create and run the server */
+	memset (&sock, 0, sizeof (sock));
+	sock.sin_family = AF_INET;
+	sock.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	sock.sin_port = htons (0); /* random port */
+
+	addr = soup_address_new_from_sockaddr ((struct sockaddr *) &sock, sizeof (sock));
+	async_context = g_main_context_new ();
+	server = soup_server_new (SOUP_SERVER_INTERFACE, addr,
+	                          SOUP_SERVER_ASYNC_CONTEXT, async_context,
+	                          NULL);
+	soup_server_add_handler (server, NULL, (SoupServerCallback) upload_server_handler_cb, &server_data, NULL);
+	g_object_unref (addr);
+
+	thread = g_thread_new ("server-thread", (GThreadFunc) run_server_thread, server);
+
+	/* Set the port so that libgdata doesn't override it. */
+	port_string = g_strdup_printf ("%u", soup_server_get_port (server));
+	g_setenv ("LIBGDATA_HTTPS_PORT", port_string, TRUE);
+	g_free (port_string);
+
+	/* Upload the data */
+	upload_uri = g_strdup_printf ("http://%s:%u/",
+	                              soup_address_get_physical (soup_socket_get_local_address (soup_server_get_listener (server))),
+	                              soup_server_get_port (server));
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	if (resumable == TRUE) {
+		upload_stream = gdata_upload_stream_new_resumable (service, NULL, SOUP_METHOD_POST, upload_uri, NULL, "slug",
+		                                                   "application/octet-stream", upload_size, NULL);
+	} else {
+		upload_stream = gdata_upload_stream_new (service, NULL, SOUP_METHOD_POST, upload_uri, NULL, "slug", "application/octet-stream", NULL);
+	}
+	g_object_unref (service);
+	g_free (upload_uri);
+
+	buffer = g_malloc0 (64 * 1024);
+
+	while (total_length_written < upload_size) {
+		gssize length_written;
+
+		length_written = g_output_stream_write (upload_stream, buffer, MIN (64 * 1024, upload_size - total_length_written), NULL, &error);
+		g_assert_no_error (error);
+		g_assert_cmpint (length_written, >, 0);
+
+		total_length_written += length_written;
+	}
+
+	g_output_stream_close (upload_stream, NULL, &error);
+	g_assert_no_error (error);
+
+	g_free (buffer);
+	g_object_unref (upload_stream);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+
+	return server_data.n_requests;
+}
+
 int
 main (int argc, char *argv[])
 {
 	GTimeVal start_time, end_time;
-	guint i;
-	gdouble total_time;
+	clock_t start_clock, end_clock;
+	guint i, n_requests;
+	gdouble total_time, cpu_time;
 
 	#define ITERATIONS 10000
 
@@ -98,5 +257,28 @@ main (int argc, char *argv[])
 	g_message ("Parsing a feed %u times took:\n * Total: %fs\n * Per iteration: %fs",
 	           ITERATIONS, total_time, total_time / (gdouble) ITERATIONS);
 
+	/* Test resumable upload time */
+	g_get_current_time (&start_time);
+	n_requests = test_upload (UPLOAD_SIZE, TRUE, UPLOAD_LATENCY);
+	g_get_current_time (&end_time);
+
+	total_time = (gdouble) (end_time.tv_sec - start_time.tv_sec) + (gdouble) (end_time.tv_usec - start_time.tv_usec) / (gdouble) G_USEC_PER_SEC;
+
+	g_message ("Uploading %u bytes with %ums latency took:\n * Total: %fs\n * Requests: %u\n * Throughput: %fMiB/s",
+	           UPLOAD_SIZE, UPLOAD_LATENCY, total_time, n_requests, (gdouble) UPLOAD_SIZE / (1024.0 * 1024.0) / total_time);
+
+	/* Test the CPU cost of a large upload (note that this includes the CPU time used by the server thread) */
+	g_get_current_time (&start_time);
+	start_clock = clock ();
+	test_upload (LARGE_UPLOAD_SIZE, FALSE, 0);
+	end_clock = clock ();
+	g_get_current_time (&end_time);
+
+	total_time = (gdouble) (end_time.tv_sec - start_time.tv_sec) + (gdouble) (end_time.tv_usec - start_time.tv_usec) / (gdouble) G_USEC_PER_SEC;
+	cpu_time = (gdouble) (end_clock - start_clock) / (gdouble) CLOCKS_PER_SEC;
+
+	g_message ("Uploading %u bytes took:\n * Total: %fs\n * CPU: %fs\n * CPU per MiB: %fms",
+	           LARGE_UPLOAD_SIZE, total_time, cpu_time, cpu_time * 1000.0 / ((gdouble) LARGE_UPLOAD_SIZE / (1024.0 * 1024.0)));
+
 	return 0;
 }
@@ -0,0 +1,1836 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * GData Client
+ * Copyright (C) Philip Withnall 2014 <philip@tecnocode.co.uk>
+ *
+ * GData Client is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GData Client is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GData Client.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Tests for the request handling of #GDataService (caching, retries, rate limiting, etc.), run against a local server which counts and times the
+ * requests it receives. */
+
+#include <glib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "gdata.h"
+#include "common.h"
+
+/* A minimal service, since GDataService can be used directly for requests to arbitrary feeds */
+#define TEST_TYPE_SERVICE		(test_service_get_type ())
+
+typedef struct {
+	GDataService parent;
+} TestService;
+
+typedef struct {
+	GDataServiceClass parent;
+} TestServiceClass;
+
+static GType test_service_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (TestService, test_service, GDATA_TYPE_SERVICE)
+
+static void
+test_service_class_init (TestServiceClass *klass)
+{
+	/* Nothing to see here */
+}
+
+static void
+test_service_init (TestService *self)
+{
+	/* Nothing to see here */
+}
+
+/* A local server, run in its own thread. Tests which need more state embed this at the start of their own structure, since it's passed to the
+ * server's handler as its user data. The counters are accessed atomically, since the handler runs in the server thread. */
+typedef struct {
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *feed_uri;
+
+	volatile gint n_requests;
+	volatile gint status; /* status to respond with; SOUP_STATUS_OK means to respond with the test feed */
+} TestServer;
+
+static gpointer
+run_server_thread (SoupServer *server)
+{
+	soup_server_run (server);
+
+	return NULL;
+}
+
+static gboolean
+quit_server_cb (SoupServer *server)
+{
+	soup_server_quit (server);
+
+	return FALSE;
+}
+
+static void
+test_server_start (TestServer *test_server, SoupServerCallback callback)
+{
+	struct sockaddr_in sock;
+	SoupAddress *addr;
+	gchar *port_string;
+	GError *error = NULL;
+
+	test_server->n_requests = 0;
+	test_server->status = SOUP_STATUS_OK;
+
+	/* Create the server on a random port */
+	memset (&sock, 0, sizeof (sock));
+	sock.sin_family = AF_INET;
+	sock.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	sock.sin_port = htons (0);
+
+	addr = soup_address_new_from_sockaddr ((struct sockaddr *) &sock, sizeof (sock));
+	g_assert (addr != NULL);
+
+	test_server->async_context = g_main_context_new ();
+	test_server->server = soup_server_new (SOUP_SERVER_INTERFACE, addr,
+	                                       SOUP_SERVER_ASYNC_CONTEXT, test_server->async_context,
+	                                       NULL);
+	g_assert (test_server->server != NULL);
+	soup_server_add_handler (test_server->server, NULL, callback, test_server, NULL);
+
+	g_object_unref (addr);
+
+	test_server->feed_uri = g_strdup_printf ("http://%s:%u/feed",
+	                                         soup_address_get_physical (soup_socket_get_local_address (
+	                                                                            soup_server_get_listener (test_server->server))),
+	                                         soup_server_get_port (test_server->server));
+
+	/* Run the server */
+	test_server->thread = g_thread_try_new ("server-thread", (GThreadFunc) run_server_thread, test_server->server, &error);
+	g_assert_no_error (error);
+	g_assert (test_server->thread != NULL);
+
+	/* Set the port so that libgdata doesn't override it. */
+	port_string = g_strdup_printf ("%u", soup_server_get_port (test_server->server));
+	g_setenv ("LIBGDATA_HTTPS_PORT", port_string, TRUE);
+	g_free (port_string);
+}
+
+static void
+test_server_stop (TestServer *test_server)
+{
+	soup_add_completion (test_server->async_context, (GSourceFunc) quit_server_cb, test_server->server);
+	g_thread_join (test_server->thread);
+
+	g_free (test_server->feed_uri);
+	g_object_unref (test_server->server);
+	g_main_context_unref (test_server->async_context);
+}
+
+static GDataService *
+create_service (void)
+{
+	return GDATA_SERVICE (g_object_new (TEST_TYPE_SERVICE, NULL));
+}
+
+/* Respond to @message with a feed containing @n_entries entries, and the given @etag (if non-%NULL) */
+static void
+set_feed_response (SoupMessage *message, guint n_entries, const gchar *etag)
+{
+	GString *feed_xml;
+	guint i;
+
+	feed_xml = g_string_new ("<?xml version='1.0' encoding='UTF-8'?>"
+	                         "<feed xmlns='http://www.w3.org/2005/Atom'>"
+	                         "<id>http://example.com/feed</id>"
+	                         "<updated>2013-06-01T12:00:00Z</updated>"
+	                         "<title type='text'>Test feed</title>");
+
+	for (i = 0; i < n_entries; i++) {
+		g_string_append_printf (feed_xml,
+		                        "<entry>"
+		                        "<id>http://example.com/entry%u</id>"
+		                        "<updated>2013-06-01T12:00:00Z</updated>"
+		                        "<title type='text'>Entry %u</title>"
+		                        "</entry>", i, i);
+	}
+
+	g_string_append (feed_xml, "</feed>");
+
+	soup_message_set_status (message, SOUP_STATUS_OK);
+	if (etag != NULL)
+		soup_message_headers_replace (message->response_headers, "ETag", etag);
+	soup_message_set_response (message, "application/atom+xml", SOUP_MEMORY_TAKE, feed_xml->str, feed_xml->len);
+	g_string_free (feed_xml, FALSE);
+}
+
+/* Counts requests, and responds to each with the current status of the server (or the test feed) */
+static void
+test_server_status_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                               TestServer *test_server)
+{
+	guint status;
+
+	g_atomic_int_inc (&(test_server->n_requests));
+	status = g_atomic_int_get (&(test_server->status));
+
+	if (status == SOUP_STATUS_OK)
+		set_feed_response (message, 3, NULL);
+	else
+		soup_message_set_status (message, status);
+}
+
+static GMainLoop *main_loop = NULL;
+
+/* Stores the #GAsyncResult of an asynchronous operation in @user_data and quits the main loop, so the operation can be finished by the test */
+static void
+async_result_cb (GObject *source_object, GAsyncResult *async_result, GAsyncResult **result_out)
+{
+	*result_out = g_object_ref (async_result);
+	g_main_loop_quit (main_loop);
+}
+
+static void
+test_circuit_breaker_trip (void)
+{
+	TestServer test_server;
+	GDataService *service;
+	GDataCircuitBreaker *circuit_breaker;
+	GDataFeed *feed;
+	GAsyncResult *async_result = NULL;
+	guint i;
+	GError *error = NULL;
+
+	test_server_start (&test_server, (SoupServerCallback) test_server_status_handler_cb);
+	g_atomic_int_set (&(test_server.status), SOUP_STATUS_SERVICE_UNAVAILABLE);
+
+	service = create_service ();
+
+	circuit_breaker = gdata_circuit_breaker_new ();
+	gdata_circuit_breaker_set_window_size (circuit_breaker, 2);
+	gdata_circuit_breaker_set_failure_threshold (circuit_breaker, 1.0);
+	gdata_service_set_circuit_breaker (service, circuit_breaker);
+
+	/* Fill the breaker's window with failures, which should open its circuit */
+	for (i = 0; i < 2; i++) {
+		g_assert_cmpint (gdata_circuit_breaker_get_state (circuit_breaker, "127.0.0.1"), ==, GDATA_CIRCUIT_STATE_CLOSED);
+
+		feed = gdata_service_query (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+		g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR);
+		g_assert (feed == NULL);
+		g_clear_error (&error);
+	}
+
+	g_assert_cmpint (g_atomic_int_get (&(test_server.n_requests)), ==, 2);
+	g_assert_cmpint (gdata_circuit_breaker_get_state (circuit_breaker, "127.0.0.1"), ==, GDATA_CIRCUIT_STATE_OPEN);
+
+	/* Further queries should fail without reaching the server, even though it's now up again */
+	g_atomic_int_set (&(test_server.status), SOUP_STATUS_OK);
+
+	feed = gdata_service_query (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_CIRCUIT_OPEN);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	/* Asynchronous queries should fail in the same way */
+	main_loop = g_main_loop_new (NULL, FALSE);
+
+	gdata_service_query_async (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, NULL,
+	                           (GAsyncReadyCallback) async_result_cb, &async_result);
+	g_main_loop_run (main_loop);
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_CIRCUIT_OPEN);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+	g_object_unref (async_result);
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	g_assert_cmpint (g_atomic_int_get (&(test_server.n_requests)), ==, 2);
+
+	g_object_unref (circuit_breaker);
+	g_object_unref (service);
+	test_server_stop (&test_server);
+}
+
+static void
+test_circuit_breaker_half_open (void)
+{
+	TestServer test_server;
+	GDataService *service;
+	GDataCircuitBreaker *circuit_breaker;
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	test_server_start (&test_server, (SoupServerCallback) test_server_status_handler_cb);
+	g_atomic_int_set (&(test_server.status), SOUP_STATUS_SERVICE_UNAVAILABLE);
+
+	service = create_service ();
+
+	circuit_breaker = gdata_circuit_breaker_new ();
+	gdata_circuit_breaker_set_window_size (circuit_breaker, 1);
+	gdata_circuit_breaker_set_open_duration (circuit_breaker, 200);
+	gdata_service_set_circuit_breaker (service, circuit_breaker);
+
+	/* Open the circuit */
+	feed = gdata_service_query (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_assert_cmpint (gdata_circuit_breaker_get_state (circuit_breaker, "127.0.0.1"), ==, GDATA_CIRCUIT_STATE_OPEN);
+
+	/* Once the open duration has passed, a failed trial request should re-open the circuit */
+	g_usleep (250 * 1000);
+
+	feed = gdata_service_query (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_assert_cmpint (g_atomic_int_get (&(test_server.n_requests)), ==, 2);
+	g_assert_cmpint (gdata_circuit_breaker_get_state (circuit_breaker, "127.0.0.1"), ==, GDATA_CIRCUIT_STATE_OPEN);
+
+	feed = gdata_service_query (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_CIRCUIT_OPEN);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	/* ...and a successful one should close it again */
+	g_atomic_int_set (&(test_server.status), SOUP_STATUS_OK);
+	g_usleep (250 * 1000);
+
+	feed = gdata_service_query (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_assert_cmpuint (g_list_length (gdata_feed_get_entries (feed)), ==, 3);
+	g_object_unref (feed);
+
+	g_assert_cmpint (g_atomic_int_get (&(test_server.n_requests)), ==, 3);
+	g_assert_cmpint (gdata_circuit_breaker_get_state (circuit_breaker, "127.0.0.1"), ==, GDATA_CIRCUIT_STATE_CLOSED);
+
+	g_object_unref (circuit_breaker);
+	g_object_unref (service);
+	test_server_stop (&test_server);
+}
+
+/* Responds to every request with a large feed, for testing progress callbacks */
+static void
+test_server_large_feed_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                                   TestServer *test_server)
+{
+	g_atomic_int_inc (&(test_server->n_requests));
+	set_feed_response (message, 500, NULL);
+}
+
+typedef struct {
+	TestServer *test_server;
+	GThread *thread; /* thread the query is run in */
+	GMainContext *context; /* thread-default main context of @thread, for asynchronous queries */
+	GMainLoop *main_loop;
+	gboolean batched;
+
+	guint n_entries; /* number of entries passed to the progress callbacks so far */
+	gboolean finished; /* whether the query has finished */
+} QueryProgressData;
+
+static void
+query_progress_cb (GDataEntry *entry, guint entry_key, guint entry_count, QueryProgressData *data)
+{
+	/* The callbacks should be called in order, in the right thread, before the query has finished */
+	g_assert (GDATA_IS_ENTRY (entry));
+	g_assert_cmpuint (entry_key, ==, data->n_entries);
+	g_assert (g_thread_self () == data->thread);
+	g_assert (data->finished == FALSE);
+
+	if (data->context != NULL)
+		g_assert (g_main_context_get_thread_default () == data->context);
+
+	data->n_entries++;
+}
+
+static void
+query_batch_progress_cb (GDataEntry **entries, guint n_entries, guint first_entry_key, guint entry_count, QueryProgressData *data)
+{
+	guint i;
+
+	g_assert_cmpuint (n_entries, >, 0);
+	g_assert_cmpuint (first_entry_key, ==, data->n_entries);
+
+	for (i = 0; i < n_entries; i++)
+		query_progress_cb (entries[i], first_entry_key + i, entry_count, data);
+}
+
+static void
+query_progress_finished_cb (GDataService *service, GAsyncResult *async_result, QueryProgressData *data)
+{
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_assert_cmpuint (g_list_length (gdata_feed_get_entries (feed)), ==, 500);
+	g_object_unref (feed);
+
+	/* All the progress callbacks should have been called by now */
+	g_assert_cmpuint (data->n_entries, ==, 500);
+	data->finished = TRUE;
+
+	g_main_loop_quit (data->main_loop);
+}
+
+static gpointer
+query_progress_sync_thread (QueryProgressData *data)
+{
+	GDataService *service;
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	data->thread = g_thread_self ();
+	service = create_service ();
+
+	feed = gdata_service_query (service, NULL, data->test_server->feed_uri, NULL, GDATA_TYPE_ENTRY, NULL,
+	                            (GDataQueryProgressCallback) query_progress_cb, data, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_assert_cmpuint (data->n_entries, ==, 500);
+	g_object_unref (feed);
+
+	g_object_unref (service);
+
+	return NULL;
+}
+
+static gpointer
+query_progress_async_thread (QueryProgressData *data)
+{
+	GDataService *service;
+
+	data->thread = g_thread_self ();
+	data->context = g_main_context_new ();
+	g_main_context_push_thread_default (data->context);
+	data->main_loop = g_main_loop_new (data->context, FALSE);
+
+	service = create_service ();
+
+	if (data->batched == TRUE) {
+		gdata_service_query_batched_async (service, NULL, data->test_server->feed_uri, NULL, GDATA_TYPE_ENTRY, NULL,
+		                                   (GDataQueryBatchProgressCallback) query_batch_progress_cb, data, NULL,
+		                                   (GAsyncReadyCallback) query_progress_finished_cb, data);
+	} else {
+		gdata_service_query_async (service, NULL, data->test_server->feed_uri, NULL, GDATA_TYPE_ENTRY, NULL,
+		                           (GDataQueryProgressCallback) query_progress_cb, data, NULL,
+		                           (GAsyncReadyCallback) query_progress_finished_cb, data);
+	}
+
+	g_main_loop_run (data->main_loop);
+	g_assert (data->finished == TRUE);
+
+	g_object_unref (service);
+
+	g_main_loop_unref (data->main_loop);
+	g_main_context_pop_thread_default (data->context);
+	g_main_context_unref (data->context);
+
+	return NULL;
+}
+
+/* Run a query in another thread while nothing iterates the global default main context, to check that the progress callbacks don't rely on it */
+static void
+test_query_progress (gconstpointer user_data)
+{
+	TestServer test_server;
+	QueryProgressData data = { NULL, };
+	GThreadFunc thread_func;
+	GThread *thread;
+
+	test_server_start (&test_server, (SoupServerCallback) test_server_large_feed_handler_cb);
+
+	data.test_server = &test_server;
+	data.batched = (GPOINTER_TO_UINT (user_data) == 2) ? TRUE : FALSE;
+	thread_func = (GPOINTER_TO_UINT (user_data) == 0) ? (GThreadFunc) query_progress_sync_thread : (GThreadFunc) query_progress_async_thread;
+
+	thread = g_thread_new ("query-thread", thread_func, &data);
+	g_thread_join (thread);
+
+	g_assert_cmpuint (data.n_entries, ==, 500);
+	g_assert_cmpint (g_atomic_int_get (&(test_server.n_requests)), ==, 1);
+
+	test_server_stop (&test_server);
+}
+
+typedef struct {
+	TestServer *test_server;
+	GThread *thread;
+	GMainContext *context;
+	GMainLoop *main_loop;
+	gboolean query_finished;
+	gboolean request_finished;
+} RequestFinishedData;
+
+static void
+request_finished_cb (GDataService *service, GDataRequestStats *stats, RequestFinishedData *data)
+{
+	/* The signal should be emitted in the thread-default main context of the thread which made the request */
+	g_assert (g_thread_self () == data->thread);
+	g_assert (g_main_context_get_thread_default () == data->context);
+	g_assert_cmpuint (stats->status_code, ==, SOUP_STATUS_OK);
+	g_assert_cmpuint (stats->n_entries, ==, 3);
+
+	data->request_finished = TRUE;
+	if (data->query_finished == TRUE)
+		g_main_loop_quit (data->main_loop);
+}
+
+static void
+request_finished_query_cb (GDataService *service, GAsyncResult *async_result, RequestFinishedData *data)
+{
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_object_unref (feed);
+
+	data->query_finished = TRUE;
+	if (data->request_finished == TRUE)
+		g_main_loop_quit (data->main_loop);
+}
+
+static gpointer
+request_finished_thread (RequestFinishedData *data)
+{
+	GDataService *service;
+
+	data->thread = g_thread_self ();
+	data->context = g_main_context_new ();
+	g_main_context_push_thread_default (data->context);
+	data->main_loop = g_main_loop_new (data->context, FALSE);
+
+	service = create_service ();
+	g_signal_connect (service, "request-finished", (GCallback) request_finished_cb, data);
+
+	gdata_service_query_async (service, NULL, data->test_server->feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, NULL,
+	                           (GAsyncReadyCallback) request_finished_query_cb, data);
+	g_main_loop_run (data->main_loop);
+
+	g_object_unref (service);
+
+	g_main_loop_unref (data->main_loop);
+	g_main_context_pop_thread_default (data->context);
+	g_main_context_unref (data->context);
+
+	return NULL;
+}
+
+/* Check that GDataService::request-finished is emitted in the context of an asynchronous query made in another thread, rather than in whichever
+ * thread the request happened to finish in */
+static void
+test_request_finished_context (void)
+{
+	TestServer test_server;
+	RequestFinishedData data = { NULL, };
+	GThread *thread;
+
+	test_server_start (&test_server, (SoupServerCallback) test_server_status_handler_cb);
+
+	data.test_server = &test_server;
+	thread = g_thread_new ("query-thread", (GThreadFunc) request_finished_thread, &data);
+	g_thread_join (thread);
+
+	g_assert (data.query_finished == TRUE);
+	g_assert (data.request_finished == TRUE);
+
+	test_server_stop (&test_server);
+}
+
+typedef struct {
+	GDataFeed *feed;
+	GError *error;
+	guint n_entries; /* number of entries passed to the progress callback */
+	guint *n_finished;
+} CoalescedQueryData;
+
+static void
+coalesced_query_progress_cb (GDataEntry *entry, guint entry_key, guint entry_count, CoalescedQueryData *data)
+{
+	g_assert (GDATA_IS_ENTRY (entry));
+	g_assert_cmpuint (entry_key, ==, data->n_entries);
+	data->n_entries++;
+}
+
+static void
+coalesced_query_finished_cb (GDataService *service, GAsyncResult *async_result, CoalescedQueryData *data)
+{
+	data->feed = gdata_service_query_finish (service, async_result, &(data->error));
+
+	if (++(*(data->n_finished)) == 2)
+		g_main_loop_quit (main_loop);
+}
+
+/* Make two identical queries at once, and check that they share one request but each get their own feed. If @user_data is 1, cancel the first query
+ * straight away; the second should be unaffected. */
+static void
+test_query_coalesce (gconstpointer user_data)
+{
+	TestServer test_server;
+	GDataService *service;
+	GCancellable *cancellable;
+	CoalescedQueryData data[2] = { { NULL, }, };
+	guint n_finished = 0, i;
+	gboolean cancel_first = (GPOINTER_TO_UINT (user_data) == 1) ? TRUE : FALSE;
+
+	test_server_start (&test_server, (SoupServerCallback) test_server_status_handler_cb);
+
+	service = create_service ();
+	gdata_service_set_coalesce_queries (service, TRUE);
+
+	cancellable = g_cancellable_new ();
+	main_loop = g_main_loop_new (NULL, FALSE);
+
+	for (i = 0; i < 2; i++) {
+		data[i].n_finished = &n_finished;
+		gdata_service_query_async (service, NULL, test_server.feed_uri, NULL, GDATA_TYPE_ENTRY, (i == 0) ? cancellable : NULL,
+		                           (GDataQueryProgressCallback) coalesced_query_progress_cb, &(data[i]), NULL,
+		                           (GAsyncReadyCallback) coalesced_query_finished_cb, &(data[i]));
+	}
+
+	if (cancel_first == TRUE)
+		g_cancellable_cancel (cancellable);
+
+	g_main_loop_run (main_loop);
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	/* The server should only have seen one request, even if the query which made it was cancelled */
+	g_assert_cmpint (g_atomic_int_get (&(test_server.n_requests)), ==, 1);
+
+	for (i = 0; i < 2; i++) {
+		if (i == 0 && cancel_first == TRUE) {
+			g_assert_error (data[i].error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+			g_assert (data[i].feed == NULL);
+			g_clear_error (&(data[i].error));
+			continue;
+		}
+
+		/* Each query should have parsed its own feed, and had its progress callback called for it */
+		g_assert_no_error (data[i].error);
+		g_assert (GDATA_IS_FEED (data[i].feed));
+		g_assert_cmpuint (g_list_length (gdata_feed_get_entries (data[i].feed)), ==, 3);
+		g_assert_cmpuint (data[i].n_entries, ==, 3);
+	}
+
+	if (cancel_first == FALSE)
+		g_assert (data[0].feed != data[1].feed);
+
+	for (i = 0; i < 2; i++) {
+		if (data[i].feed != NULL)
+			g_object_unref (data[i].feed);
+	}
+
+	g_object_unref (cancellable);
+	g_object_unref (service);
+	test_server_stop (&test_server);
+}
+
+/* A local server which supports revalidation of its feed using ETags, and counts the revalidations */
+typedef struct {
+	TestServer parent;
+	volatile gint n_not_modified;
+} CacheTestServer;
+
+static void
+test_server_etag_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                             CacheTestServer *cache_server)
+{
+	const gchar *if_none_match;
+
+	g_atomic_int_inc (&(cache_server->parent.n_requests));
+
+	if_none_match = soup_message_headers_get_one (message->request_headers, "If-None-Match");
+
+	if (if_none_match != NULL && strcmp (if_none_match, "\"v1\"") == 0) {
+		g_atomic_int_inc (&(cache_server->n_not_modified));
+		soup_message_set_status (message, SOUP_STATUS_NOT_MODIFIED);
+	} else {
+		set_feed_response (message, 3, "\"v1\"");
+	}
+}
+
+/* Check that a cached response is revalidated using its ETag, and that the cached body is parsed when the server says it's not been modified */
+static void
+test_cache_revalidation (void)
+{
+	CacheTestServer cache_server;
+	GDataService *service;
+	GDataMemoryCache *cache;
+	GDataFeed *feed;
+	guint i;
+	GError *error = NULL;
+
+	cache_server.n_not_modified = 0;
+	test_server_start (&(cache_server.parent), (SoupServerCallback) test_server_etag_handler_cb);
+
+	service = create_service ();
+	cache = gdata_memory_cache_new (0);
+	gdata_service_set_cache (service, GDATA_CACHE (cache));
+
+	/* The first query should get a full response, which should be cached; the others should be revalidated and served from the cache */
+	for (i = 0; i < 3; i++) {
+		feed = gdata_service_query (service, NULL, cache_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (GDATA_IS_FEED (feed));
+		g_assert_cmpuint (g_list_length (gdata_feed_get_entries (feed)), ==, 3);
+		g_object_unref (feed);
+
+		g_assert_cmpint (g_atomic_int_get (&(cache_server.parent.n_requests)), ==, i + 1);
+		g_assert_cmpint (g_atomic_int_get (&(cache_server.n_not_modified)), ==, i);
+	}
+
+	g_assert_cmpuint (gdata_memory_cache_get_size (cache), >, 0);
+
+	/* Once the cache has been cleared, a full response should be needed again */
+	gdata_cache_clear (GDATA_CACHE (cache));
+
+	feed = gdata_service_query (service, NULL, cache_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_assert_cmpuint (g_list_length (gdata_feed_get_entries (feed)), ==, 3);
+	g_object_unref (feed);
+
+	g_assert_cmpint (g_atomic_int_get (&(cache_server.parent.n_requests)), ==, 4);
+	g_assert_cmpint (g_atomic_int_get (&(cache_server.n_not_modified)), ==, 2);
+
+	g_object_unref (cache);
+	g_object_unref (service);
+	test_server_stop (&(cache_server.parent));
+}
+
+/* A local server which responds to the first few requests with 503 Service Unavailable (and an optional Retry-After header), and to the rest with
+ * the test feed, recording when each request was received */
+typedef struct {
+	TestServer parent;
+	gint n_failures; /* number of requests to fail */
+	const gchar *retry_after; /* value of the Retry-After header for failures, or %NULL */
+	gint64 request_times[8];
+} RetryTestServer;
+
+static void
+test_server_retry_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                              RetryTestServer *retry_server)
+{
+	gint n_requests;
+
+	n_requests = g_atomic_int_add (&(retry_server->parent.n_requests), 1);
+	if (n_requests < (gint) G_N_ELEMENTS (retry_server->request_times))
+		retry_server->request_times[n_requests] = g_get_monotonic_time ();
+
+	if (n_requests < retry_server->n_failures) {
+		soup_message_set_status (message, SOUP_STATUS_SERVICE_UNAVAILABLE);
+		if (retry_server->retry_after != NULL)
+			soup_message_headers_replace (message->response_headers, "Retry-After", retry_server->retry_after);
+	} else {
+		set_feed_response (message, 3, NULL);
+	}
+}
+
+static GDataService *
+create_retrying_service (guint max_attempts)
+{
+	GDataService *service;
+	GDataRetryPolicy *retry_policy;
+
+	retry_policy = gdata_retry_policy_new ();
+	gdata_retry_policy_set_max_attempts (retry_policy, max_attempts);
+	gdata_retry_policy_set_initial_delay (retry_policy, 10);
+	gdata_retry_policy_set_max_delay (retry_policy, 5000);
+	gdata_retry_policy_set_jitter (retry_policy, 0.0);
+
+	service = create_service ();
+	gdata_service_set_retry_policy (service, retry_policy);
+	g_object_unref (retry_policy);
+
+	return service;
+}
+
+/* Check that 503 responses are retried with exponential backoff, until the policy's maximum number of attempts is reached */
+static void
+test_retry_backoff (void)
+{
+	RetryTestServer retry_server = { { NULL, }, };
+	GDataService *service;
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	test_server_start (&(retry_server.parent), (SoupServerCallback) test_server_retry_handler_cb);
+
+	/* Two failures should be retried with delays of 10 ms and 20 ms, and the third attempt should succeed */
+	retry_server.n_failures = 2;
+	service = create_retrying_service (3);
+
+	feed = gdata_service_query (service, NULL, retry_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_assert_cmpuint (g_list_length (gdata_feed_get_entries (feed)), ==, 3);
+	g_object_unref (feed);
+
+	g_assert_cmpint (g_atomic_int_get (&(retry_server.parent.n_requests)), ==, 3);
+	g_assert_cmpint (retry_server.request_times[1] - retry_server.request_times[0], >=, 10 * 1000);
+	g_assert_cmpint (retry_server.request_times[2] - retry_server.request_times[1], >=, 20 * 1000);
+
+	g_object_unref (service);
+
+	/* With only two attempts allowed, the query should fail */
+	g_atomic_int_set (&(retry_server.parent.n_requests), 0);
+	service = create_retrying_service (2);
+
+	feed = gdata_service_query (service, NULL, retry_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_assert_cmpint (g_atomic_int_get (&(retry_server.parent.n_requests)), ==, 2);
+
+	g_object_unref (service);
+	test_server_stop (&(retry_server.parent));
+}
+
+/* Check that the delay requested by a Retry-After header is waited for before retrying, and that a request isn't retried at all if the requested
+ * delay is longer than the policy's maximum delay */
+static void
+test_retry_after (void)
+{
+	RetryTestServer retry_server = { { NULL, }, };
+	GDataService *service;
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	test_server_start (&(retry_server.parent), (SoupServerCallback) test_server_retry_handler_cb);
+
+	retry_server.n_failures = 1;
+	retry_server.retry_after = "1";
+	service = create_retrying_service (3);
+
+	feed = gdata_service_query (service, NULL, retry_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_object_unref (feed);
+
+	/* The retry should have waited for the full second, rather than the policy's 10 ms */
+	g_assert_cmpint (g_atomic_int_get (&(retry_server.parent.n_requests)), ==, 2);
+	g_assert_cmpint (retry_server.request_times[1] - retry_server.request_times[0], >=, G_USEC_PER_SEC);
+
+	/* A delay longer than the policy's 5 s maximum shouldn't be waited for */
+	g_atomic_int_set (&(retry_server.parent.n_requests), 0);
+	retry_server.retry_after = "10";
+
+	feed = gdata_service_query (service, NULL, retry_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+	g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_PROTOCOL_ERROR);
+	g_assert (feed == NULL);
+	g_clear_error (&error);
+
+	g_assert_cmpint (g_atomic_int_get (&(retry_server.parent.n_requests)), ==, 1);
+
+	g_object_unref (service);
+	test_server_stop (&(retry_server.parent));
+}
+
+static void
+rate_limited_query_cb (GDataService *service, GAsyncResult *async_result, guint *n_remaining)
+{
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_object_unref (feed);
+
+	if (--(*n_remaining) == 0)
+		g_main_loop_quit (main_loop);
+}
+
+/* Make five queries (synchronously if @user_data is 0, or all at once asynchronously otherwise) through a rate limiter which allows a burst of two
+ * requests and then 10 per second, and check that the server receives the requests after the burst 100 ms apart */
+static void
+test_rate_limiter_spacing (gconstpointer user_data)
+{
+	RetryTestServer retry_server = { { NULL, }, };
+	GDataService *service;
+	GDataRateLimiter *rate_limiter;
+	guint i;
+
+	test_server_start (&(retry_server.parent), (SoupServerCallback) test_server_retry_handler_cb);
+
+	service = create_service ();
+	rate_limiter = gdata_rate_limiter_new (10.0, 2);
+	gdata_service_set_rate_limiter (service, rate_limiter);
+
+	if (GPOINTER_TO_UINT (user_data) == 0) {
+		for (i = 0; i < 5; i++) {
+			GDataFeed *feed;
+			GError *error = NULL;
+
+			feed = gdata_service_query (service, NULL, retry_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+			g_assert_no_error (error);
+			g_assert (GDATA_IS_FEED (feed));
+			g_object_unref (feed);
+		}
+	} else {
+		guint n_remaining = 5;
+
+		main_loop = g_main_loop_new (NULL, FALSE);
+
+		for (i = 0; i < 5; i++) {
+			gdata_service_query_async (service, NULL, retry_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, NULL,
+			                           (GAsyncReadyCallback) rate_limited_query_cb, &n_remaining);
+		}
+
+		g_main_loop_run (main_loop);
+
+		g_main_loop_unref (main_loop);
+		main_loop = NULL;
+	}
+
+	g_assert_cmpint (g_atomic_int_get (&(retry_server.parent.n_requests)), ==, 5);
+
+	/* Allow a little leeway for the requests' journeys to the server, which can bring the arrival of consecutive requests closer together */
+	for (i = 2; i < 5; i++)
+		g_assert_cmpint (retry_server.request_times[i] - retry_server.request_times[i - 1], >=, 80 * 1000);
+	g_assert_cmpint (retry_server.request_times[4] - retry_server.request_times[0], >=, 280 * 1000);
+
+	g_object_unref (rate_limiter);
+	g_object_unref (service);
+	test_server_stop (&(retry_server.parent));
+}
+
+/* A local server which holds on to each request for @delay milliseconds before responding, and records the greatest number of requests it's had in
+ * progress at once */
+typedef struct {
+	TestServer parent;
+	guint delay;
+	volatile gint n_in_progress;
+	volatile gint max_in_progress;
+} PoolTestServer;
+
+typedef struct {
+	PoolTestServer *pool_server;
+	SoupServer *server;
+	SoupMessage *message;
+} DelayedResponse;
+
+static gboolean
+delayed_response_cb (DelayedResponse *response)
+{
+	g_atomic_int_add (&(response->pool_server->n_in_progress), -1);
+
+	set_feed_response (response->message, 3, NULL);
+	soup_server_unpause_message (response->server, response->message);
+
+	g_slice_free (DelayedResponse, response);
+
+	return FALSE;
+}
+
+static void
+test_server_delayed_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                                PoolTestServer *pool_server)
+{
+	DelayedResponse *response;
+	GSource *source;
+	gint n_in_progress;
+
+	g_atomic_int_inc (&(pool_server->parent.n_requests));
+
+	/* Only the server thread touches these, so they don't need to be updated in one go */
+	n_in_progress = g_atomic_int_add (&(pool_server->n_in_progress), 1) + 1;
+	if (n_in_progress > g_atomic_int_get (&(pool_server->max_in_progress)))
+		g_atomic_int_set (&(pool_server->max_in_progress), n_in_progress);
+
+	response = g_slice_new (DelayedResponse);
+	response->pool_server = pool_server;
+	response->server = server;
+	response->message = message;
+
+	soup_server_pause_message (server, message);
+
+	source = g_timeout_source_new (pool_server->delay);
+	g_source_set_callback (source, (GSourceFunc) delayed_response_cb, response, NULL);
+	g_source_attach (source, pool_server->parent.async_context);
+	g_source_unref (source);
+}
+
+static void
+pool_query_cb (GDataService *service, GAsyncResult *async_result, guint *n_remaining)
+{
+	GDataFeed *feed;
+	GError *error = NULL;
+
+	feed = gdata_service_query_finish (service, async_result, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_FEED (feed));
+	g_object_unref (feed);
+
+	if (--(*n_remaining) == 0)
+		g_main_loop_quit (main_loop);
+}
+
+/* Make four concurrent queries, split between two services sharing a connection pool which allows @user_data connections per host, and check that
+ * the server sees exactly that many requests at once at most. The default limit is 2, so using 1 and 3 checks that the pool's limit is applied. */
+static void
+test_connection_pool_limits (gconstpointer user_data)
+{
+	PoolTestServer pool_server;
+	GDataConnectionPool *pool;
+	GDataService *services[2];
+	guint max_connections_per_host = GPOINTER_TO_UINT (user_data);
+	guint n_remaining = 4, i;
+
+	pool_server.delay = 100;
+	pool_server.n_in_progress = 0;
+	pool_server.max_in_progress = 0;
+	test_server_start (&(pool_server.parent), (SoupServerCallback) test_server_delayed_handler_cb);
+
+	pool = gdata_connection_pool_new ();
+	gdata_connection_pool_set_max_connections_per_host (pool, max_connections_per_host);
+
+	for (i = 0; i < G_N_ELEMENTS (services); i++) {
+		services[i] = GDATA_SERVICE (g_object_new (TEST_TYPE_SERVICE, "connection-pool", pool, NULL));
+		g_assert (gdata_service_get_connection_pool (services[i]) == pool);
+	}
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+
+	for (i = 0; i < n_remaining; i++) {
+		gdata_service_query_async (services[i % 2], NULL, pool_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, NULL,
+		                           (GAsyncReadyCallback) pool_query_cb, &n_remaining);
+	}
+
+	g_main_loop_run (main_loop);
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	g_assert_cmpint (g_atomic_int_get (&(pool_server.parent.n_requests)), ==, 4);
+	g_assert_cmpint (g_atomic_int_get (&(pool_server.max_in_progress)), ==, max_connections_per_host);
+
+	for (i = 0; i < G_N_ELEMENTS (services); i++)
+		g_object_unref (services[i]);
+	g_object_unref (pool);
+	test_server_stop (&(pool_server.parent));
+}
+
+static void
+deadline_query_cb (GDataService *service, GAsyncResult *async_result, GDataFeed **feed_out)
+{
+	GError *error = NULL;
+
+	*feed_out = gdata_service_query_finish (service, async_result, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_clear_error (&error);
+
+	g_main_loop_quit (main_loop);
+}
+
+/* Make a query (synchronously if @user_data is 0, asynchronously if it's 1, or synchronously with query coalescing enabled if it's 2) with a 200 ms
+ * deadline to a server which takes a second to respond, and check that it's cut short with a timeout error once the deadline has passed */
+static void
+test_deadline_mid_request (gconstpointer user_data)
+{
+	PoolTestServer pool_server;
+	GDataService *service;
+	GCancellable *cancellable;
+	GDataFeed *feed = NULL;
+	gint64 start_time, elapsed;
+
+	pool_server.delay = 1000;
+	pool_server.n_in_progress = 0;
+	pool_server.max_in_progress = 0;
+	test_server_start (&(pool_server.parent), (SoupServerCallback) test_server_delayed_handler_cb);
+
+	service = create_service ();
+	gdata_service_set_coalesce_queries (service, (GPOINTER_TO_UINT (user_data) == 2) ? TRUE : FALSE);
+	cancellable = gdata_deadline_cancellable_new (200, NULL);
+	start_time = g_get_monotonic_time ();
+
+	if (GPOINTER_TO_UINT (user_data) != 1) {
+		GError *error = NULL;
+
+		feed = gdata_service_query (service, NULL, pool_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, &error);
+		g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+		g_clear_error (&error);
+	} else {
+		main_loop = g_main_loop_new (NULL, FALSE);
+
+		gdata_service_query_async (service, NULL, pool_server.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, cancellable, NULL, NULL, NULL,
+		                           (GAsyncReadyCallback) deadline_query_cb, &feed);
+		g_main_loop_run (main_loop);
+
+		g_main_loop_unref (main_loop);
+		main_loop = NULL;
+	}
+
+	elapsed = g_get_monotonic_time () - start_time;
+
+	/* The request should have reached the server, and been cancelled while it was waiting for the response */
+	g_assert (feed == NULL);
+	g_assert_cmpint (g_atomic_int_get (&(pool_server.parent.n_requests)), ==, 1);
+	g_assert (gdata_deadline_cancellable_has_expired (GDATA_DEADLINE_CANCELLABLE (cancellable)) == TRUE);
+	g_assert_cmpint (elapsed, >=, 200 * 1000);
+	g_assert_cmpint (elapsed, <, 1000 * 1000);
+
+	g_object_unref (cancellable);
+	g_object_unref (service);
+
+	/* Give the server a chance to respond to the abandoned request before stopping it */
+	g_usleep (1000 * 1000);
+	test_server_stop (&(pool_server.parent));
+}
+
+/* A delaying server (as above) which only delays the request with the given index, and responds to the others straight away */
+typedef struct {
+	PoolTestServer parent;
+	gint slow_request;
+} HedgeTestServer;
+
+static void
+test_server_hedge_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                              HedgeTestServer *hedge_server)
+{
+	if (g_atomic_int_get (&(hedge_server->parent.parent.n_requests)) == hedge_server->slow_request) {
+		test_server_delayed_handler_cb (server, message, path, query, client, &(hedge_server->parent));
+	} else {
+		g_atomic_int_inc (&(hedge_server->parent.parent.n_requests));
+		set_feed_response (message, 3, NULL);
+	}
+}
+
+/* Check that once the hedging policy has enough samples, a request which is slow to respond is hedged after the hedging delay, that the duplicate's
+ * response is used, and that the slow request is cancelled rather than left to hold on to its connection */
+static void
+test_hedging_slow_request (void)
+{
+	HedgeTestServer hedge_server;
+	GDataConnectionPool *pool;
+	GDataService *service;
+	GDataHedgingPolicy *hedging_policy;
+	GDataFeed *feed;
+	gint64 start_time, elapsed;
+	guint i, n_remaining;
+	GError *error = NULL;
+
+	/* The request after the 20 needed to estimate the latency percentile is slow */
+	hedge_server.parent.delay = 2000;
+	hedge_server.parent.n_in_progress = 0;
+	hedge_server.parent.max_in_progress = 0;
+	hedge_server.slow_request = 20;
+	test_server_start (&(hedge_server.parent.parent), (SoupServerCallback) test_server_hedge_handler_cb);
+
+	pool = gdata_connection_pool_new ();
+	gdata_connection_pool_set_max_connections_per_host (pool, 2);
+	service = GDATA_SERVICE (g_object_new (TEST_TYPE_SERVICE, "connection-pool", pool, NULL));
+	g_object_unref (pool);
+
+	hedging_policy = gdata_hedging_policy_new ();
+	gdata_hedging_policy_set_percentile (hedging_policy, 50);
+	gdata_hedging_policy_set_min_delay (hedging_policy, 50);
+	gdata_hedging_policy_set_budget (hedging_policy, 1.0);
+	gdata_service_set_hedging_policy (service, hedging_policy);
+
+	for (i = 0; i < 21; i++) {
+		start_time = g_get_monotonic_time ();
+
+		feed = gdata_service_query (service, NULL, hedge_server.parent.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (GDATA_IS_FEED (feed));
+		g_assert_cmpuint (g_list_length (gdata_feed_get_entries (feed)), ==, 3);
+		g_object_unref (feed);
+
+		elapsed = g_get_monotonic_time () - start_time;
+	}
+
+	/* The last query should have been hedged, with the duplicate sent after 50 ms and responding long before the slow request would have */
+	g_assert_cmpint (g_atomic_int_get (&(hedge_server.parent.parent.n_requests)), ==, 22);
+	g_assert_cmpuint (gdata_hedging_policy_get_n_hedged_requests (hedging_policy), ==, 1);
+	g_assert_cmpint (elapsed, >=, 50 * 1000);
+	g_assert_cmpint (elapsed, <, 1000 * 1000);
+
+	/* If the slow request hadn't been cancelled, it would be taking up one of the two connections for another couple of seconds, so two concurrent
+	 * queries couldn't both be answered quickly */
+	main_loop = g_main_loop_new (NULL, FALSE);
+	start_time = g_get_monotonic_time ();
+	n_remaining = 2;
+
+	for (i = 0; i < 2; i++) {
+		gdata_service_query_async (service, NULL, hedge_server.parent.parent.feed_uri, NULL, GDATA_TYPE_ENTRY, NULL, NULL, NULL, NULL,
+		                           (GAsyncReadyCallback) pool_query_cb, &n_remaining);
+	}
+
+	g_main_loop_run (main_loop);
+	elapsed = g_get_monotonic_time () - start_time;
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	g_assert_cmpint (elapsed, <, 1000 * 1000);
+	g_assert_cmpint (g_atomic_int_get (&(hedge_server.parent.parent.n_requests)), ==, 24);
+
+	g_object_unref (hedging_policy);
+	g_object_unref (service);
+
+	/* Give the server a chance to respond to the abandoned request before stopping it */
+	g_usleep (2000 * 1000);
+	test_server_stop (&(hedge_server.parent.parent));
+}
+
+/* A delaying server (as above) which also records the order it receives requests in, by their q parameters */
+typedef struct {
+	PoolTestServer parent;
+	GMutex mutex;
+	GString *order; /* protected by @mutex */
+} SchedulerTestServer;
+
+static void
+test_server_ordering_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                                 SchedulerTestServer *scheduler_server)
+{
+	g_mutex_lock (&(scheduler_server->mutex));
+	g_string_append_printf (scheduler_server->order, "%s ", (query != NULL) ? (const gchar *) g_hash_table_lookup (query, "q") : "");
+	g_mutex_unlock (&(scheduler_server->mutex));
+
+	test_server_delayed_handler_cb (server, message, path, query, client, &(scheduler_server->parent));
+}
+
+static void
+scheduler_test_server_start (SchedulerTestServer *scheduler_server)
+{
+	scheduler_server->parent.delay = 100;
+	scheduler_server->parent.n_in_progress = 0;
+	scheduler_server->parent.max_in_progress = 0;
+	g_mutex_init (&(scheduler_server->mutex));
+	scheduler_server->order = g_string_new (NULL);
+
+	test_server_start (&(scheduler_server->parent.parent), (SoupServerCallback) test_server_ordering_handler_cb);
+}
+
+static void
+scheduler_test_server_stop (SchedulerTestServer *scheduler_server)
+{
+	test_server_stop (&(scheduler_server->parent.parent));
+
+	g_string_free (scheduler_server->order, TRUE);
+	g_mutex_clear (&(scheduler_server->mutex));
+}
+
+/* Start an asynchronous query with the given @q and @priority, which decrements @n_remaining when it's finished */
+static void
+start_prioritised_query (GDataService *service, SchedulerTestServer *scheduler_server, const gchar *q, GDataRequestPriority priority,
+                         guint *n_remaining)
+{
+	GDataQuery *query;
+
+	query = gdata_query_new (q);
+	gdata_query_set_priority (query, priority);
+
+	gdata_service_query_async (service, NULL, scheduler_server->parent.parent.feed_uri, query, GDATA_TYPE_ENTRY, NULL, NULL, NULL, NULL,
+	                           (GAsyncReadyCallback) pool_query_cb, n_remaining);
+	(*n_remaining)++;
+
+	g_object_unref (query);
+}
+
+/* Check that when the scheduler only allows one request at a time, waiting requests are sent in priority order, and in the order they were made
+ * within each priority */
+static void
+test_request_scheduler_priorities (void)
+{
+	SchedulerTestServer scheduler_server;
+	GDataService *service;
+	GDataRequestScheduler *scheduler;
+	guint n_remaining = 0;
+
+	scheduler_test_server_start (&scheduler_server);
+
+	service = create_service ();
+	scheduler = gdata_request_scheduler_new ();
+	gdata_request_scheduler_set_max_requests (scheduler, 1);
+	gdata_service_set_request_scheduler (service, scheduler);
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+
+	/* The first query gets the slot straight away; the others have to wait for it */
+	start_prioritised_query (service, &scheduler_server, "bulk1", GDATA_REQUEST_PRIORITY_BULK, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "bulk2", GDATA_REQUEST_PRIORITY_BULK, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "normal1", GDATA_REQUEST_PRIORITY_NORMAL, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "interactive1", GDATA_REQUEST_PRIORITY_INTERACTIVE, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "normal2", GDATA_REQUEST_PRIORITY_NORMAL, &n_remaining);
+
+	g_assert_cmpuint (gdata_request_scheduler_get_n_active_requests (scheduler, GDATA_REQUEST_PRIORITY_BULK), ==, 1);
+	g_assert_cmpuint (gdata_request_scheduler_get_n_queued_requests (scheduler, GDATA_REQUEST_PRIORITY_NORMAL), ==, 2);
+
+	g_main_loop_run (main_loop);
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	g_assert_cmpstr (scheduler_server.order->str, ==, "bulk1 interactive1 normal1 normal2 bulk2 ");
+	g_assert_cmpint (g_atomic_int_get (&(scheduler_server.parent.max_in_progress)), ==, 1);
+
+	g_object_unref (scheduler);
+	g_object_unref (service);
+	scheduler_test_server_stop (&scheduler_server);
+}
+
+/* Check that a priority's own limit stops it taking all of the scheduler's slots, while leaving them available to other priorities */
+static void
+test_request_scheduler_priority_limits (void)
+{
+	SchedulerTestServer scheduler_server;
+	GDataConnectionPool *pool;
+	GDataService *service;
+	GDataRequestScheduler *scheduler;
+	guint n_remaining = 0;
+
+	scheduler_test_server_start (&scheduler_server);
+
+	/* Make sure the connection pool isn't the bottleneck */
+	pool = gdata_connection_pool_new ();
+	gdata_connection_pool_set_max_connections_per_host (pool, 4);
+	service = GDATA_SERVICE (g_object_new (TEST_TYPE_SERVICE, "connection-pool", pool, NULL));
+	g_object_unref (pool);
+
+	scheduler = gdata_request_scheduler_new ();
+	gdata_request_scheduler_set_max_requests (scheduler, 3);
+	gdata_request_scheduler_set_max_requests_for_priority (scheduler, GDATA_REQUEST_PRIORITY_BULK, 1);
+	gdata_service_set_request_scheduler (service, scheduler);
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+
+	start_prioritised_query (service, &scheduler_server, "bulk1", GDATA_REQUEST_PRIORITY_BULK, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "bulk2", GDATA_REQUEST_PRIORITY_BULK, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "bulk3", GDATA_REQUEST_PRIORITY_BULK, &n_remaining);
+
+	/* Only one bulk request should be in progress, even though the scheduler has slots free... */
+	g_assert_cmpuint (gdata_request_scheduler_get_n_active_requests (scheduler, GDATA_REQUEST_PRIORITY_BULK), ==, 1);
+	g_assert_cmpuint (gdata_request_scheduler_get_n_queued_requests (scheduler, GDATA_REQUEST_PRIORITY_BULK), ==, 2);
+
+	/* ...which interactive requests can use straight away */
+	start_prioritised_query (service, &scheduler_server, "interactive1", GDATA_REQUEST_PRIORITY_INTERACTIVE, &n_remaining);
+	start_prioritised_query (service, &scheduler_server, "interactive2", GDATA_REQUEST_PRIORITY_INTERACTIVE, &n_remaining);
+
+	g_assert_cmpuint (gdata_request_scheduler_get_n_active_requests (scheduler, GDATA_REQUEST_PRIORITY_INTERACTIVE), ==, 2);
+	g_assert_cmpuint (gdata_request_scheduler_get_n_queued_requests (scheduler, GDATA_REQUEST_PRIORITY_INTERACTIVE), ==, 0);
+
+	g_main_loop_run (main_loop);
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	/* The server should have seen one bulk request and both interactive ones at once, and no more */
+	g_assert_cmpint (g_atomic_int_get (&(scheduler_server.parent.parent.n_requests)), ==, 5);
+	g_assert_cmpint (g_atomic_int_get (&(scheduler_server.parent.max_in_progress)), ==, 3);
+	g_assert (g_str_has_suffix (scheduler_server.order->str, "bulk2 bulk3 ") == TRUE);
+
+	g_object_unref (scheduler);
+	g_object_unref (service);
+	scheduler_test_server_stop (&scheduler_server);
+}
+
+/* A local server which accepts entry insertions, and records the Content-Encoding and (still encoded) body of the last one */
+typedef struct {
+	TestServer parent;
+	GMutex mutex;
+	gchar *content_encoding; /* protected by @mutex */
+	GByteArray *body; /* protected by @mutex */
+} UploadTestServer;
+
+static void
+test_server_upload_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                               UploadTestServer *upload_server)
+{
+	SoupBuffer *body;
+	const gchar *entry_xml =
+		"<?xml version='1.0' encoding='UTF-8'?>"
+		"<entry xmlns='http://www.w3.org/2005/Atom'>"
+		"<id>http://example.com/entry0</id>"
+		"<updated>2013-06-01T12:00:00Z</updated>"
+		"<title type='text'>Inserted entry</title>"
+		"</entry>";
+
+	g_atomic_int_inc (&(upload_server->parent.n_requests));
+
+	body = soup_message_body_flatten (message->request_body);
+
+	g_mutex_lock (&(upload_server->mutex));
+
+	g_free (upload_server->content_encoding);
+	upload_server->content_encoding = g_strdup (soup_message_headers_get_one (message->request_headers, "Content-Encoding"));
+
+	g_byte_array_set_size (upload_server->body, 0);
+	g_byte_array_append (upload_server->body, (const guint8 *) body->data, body->length);
+
+	g_mutex_unlock (&(upload_server->mutex));
+
+	soup_buffer_free (body);
+
+	soup_message_set_status (message, SOUP_STATUS_CREATED);
+	soup_message_set_response (message, "application/atom+xml", SOUP_MEMORY_STATIC, entry_xml, strlen (entry_xml));
+}
+
+/* Decompress the gzipped @data, returning it as a nul-terminated string */
+static gchar *
+gunzip (const guint8 *data, gsize length)
+{
+	GConverter *decompressor;
+	GInputStream *memory_stream, *converter_stream;
+	GString *output;
+	gchar buffer[4096];
+	gssize n_read;
+	GError *error = NULL;
+
+	decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+	memory_stream = g_memory_input_stream_new_from_data (data, length, NULL);
+	converter_stream = g_converter_input_stream_new (memory_stream, decompressor);
+	output = g_string_new (NULL);
+
+	while ((n_read = g_input_stream_read (converter_stream, buffer, sizeof (buffer), NULL, &error)) > 0)
+		g_string_append_len (output, buffer, n_read);
+
+	g_assert_no_error (error);
+
+	g_object_unref (converter_stream);
+	g_object_unref (memory_stream);
+	g_object_unref (decompressor);
+
+	return g_string_free (output, FALSE);
+}
+
+/* Insert an entry with a title of @title_length characters, and return the XML of the request body as received by the server, decompressing it if
+ * necessary. Whether it was compressed is returned in @compressed. */
+static gchar *
+insert_entry_and_get_body (GDataService *service, UploadTestServer *upload_server, guint title_length, gboolean *compressed)
+{
+	GDataEntry *entry, *inserted_entry;
+	gchar *title, *body;
+	GError *error = NULL;
+
+	title = g_strnfill (title_length, 'a');
+	entry = gdata_entry_new (NULL);
+	gdata_entry_set_title (entry, title);
+	g_free (title);
+
+	inserted_entry = gdata_service_insert_entry (service, NULL, upload_server->parent.feed_uri, entry, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_ENTRY (inserted_entry));
+	g_assert_cmpstr (gdata_entry_get_title (inserted_entry), ==, "Inserted entry");
+	g_object_unref (inserted_entry);
+	g_object_unref (entry);
+
+	g_mutex_lock (&(upload_server->mutex));
+
+	*compressed = (g_strcmp0 (upload_server->content_encoding, "gzip") == 0) ? TRUE : FALSE;
+	if (*compressed == TRUE)
+		body = gunzip (upload_server->body->data, upload_server->body->len);
+	else
+		body = g_strndup ((const gchar *) upload_server->body->data, upload_server->body->len);
+
+	/* Compression should actually have made the body smaller */
+	if (*compressed == TRUE)
+		g_assert_cmpuint (upload_server->body->len, <, strlen (body));
+
+	g_mutex_unlock (&(upload_server->mutex));
+
+	return body;
+}
+
+/* Check that entry bodies at least as long as the compression threshold are gzipped (with the right Content-Encoding), and others aren't */
+static void
+test_compress_requests (void)
+{
+	UploadTestServer upload_server;
+	GDataService *service;
+	gchar *body, *title;
+	gboolean compressed;
+
+	g_mutex_init (&(upload_server.mutex));
+	upload_server.content_encoding = NULL;
+	upload_server.body = g_byte_array_new ();
+	test_server_start (&(upload_server.parent), (SoupServerCallback) test_server_upload_handler_cb);
+
+	service = create_service ();
+	title = g_strnfill (8192, 'a');
+
+	/* Compression is off by default */
+	body = insert_entry_and_get_body (service, &upload_server, 8192, &compressed);
+	g_assert (compressed == FALSE);
+	g_assert (strstr (body, title) != NULL);
+	g_free (body);
+
+	gdata_service_set_compress_requests (service, TRUE);
+
+	/* A large body should be compressed, and decompress to the entry's XML */
+	body = insert_entry_and_get_body (service, &upload_server, 8192, &compressed);
+	g_assert (compressed == TRUE);
+	g_assert (g_str_has_prefix (body, "<?xml") == TRUE);
+	g_assert (strstr (body, title) != NULL);
+	g_free (body);
+
+	/* A body below the threshold shouldn't be */
+	body = insert_entry_and_get_body (service, &upload_server, 10, &compressed);
+	g_assert (compressed == FALSE);
+	g_assert (strstr (body, "aaaaaaaaaa") != NULL);
+	g_free (body);
+
+	g_assert_cmpint (g_atomic_int_get (&(upload_server.parent.n_requests)), ==, 3);
+
+	g_free (title);
+	g_object_unref (service);
+	test_server_stop (&(upload_server.parent));
+
+	g_byte_array_unref (upload_server.body);
+	g_free (upload_server.content_encoding);
+	g_mutex_clear (&(upload_server.mutex));
+}
+
+/* A local server for testing #GDataSync, which responds to each request with the feed of changes set by the test, and records the updated-min
+ * parameter of the request. */
+typedef struct {
+	TestServer parent;
+	GMutex mutex;
+	gchar *response; /* protected by @mutex */
+	gchar *updated_min; /* protected by @mutex */
+} SyncTestServer;
+
+typedef struct {
+	const gchar *id;
+	const gchar *etag;
+	const gchar *updated;
+	gboolean deleted;
+} SyncTestEntry;
+
+static void
+test_server_sync_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query, SoupClientContext *client,
+                             SyncTestServer *sync_server)
+{
+	g_atomic_int_inc (&(sync_server->parent.n_requests));
+
+	g_mutex_lock (&(sync_server->mutex));
+
+	g_free (sync_server->updated_min);
+	sync_server->updated_min = (query != NULL) ? g_strdup (g_hash_table_lookup (query, "updated-min")) : NULL;
+
+	soup_message_set_status (message, SOUP_STATUS_OK);
+	soup_message_set_response (message, "application/atom+xml", SOUP_MEMORY_COPY, sync_server->response, strlen (sync_server->response));
+
+	g_mutex_unlock (&(sync_server->mutex));
+}
+
+/* Set the feed of changes which @sync_server will respond with */
+static void
+sync_test_server_set_changes (SyncTestServer *sync_server, const SyncTestEntry *entries, guint n_entries)
+{
+	GString *feed_xml;
+	guint i;
+
+	feed_xml = g_string_new ("<?xml version='1.0' encoding='UTF-8'?>"
+	                         "<feed xmlns='http://www.w3.org/2005/Atom' xmlns:gd='http://schemas.google.com/g/2005'>"
+	                         "<id>http://example.com/feed</id>"
+	                         "<updated>2013-06-01T12:00:00Z</updated>"
+	                         "<title type='text'>Test feed</title>");
+
+	for (i = 0; i < n_entries; i++) {
+		g_string_append_printf (feed_xml,
+		                        "<entry gd:etag='%s'>"
+		                        "<id>http://example.com/entry%s</id>"
+		                        "<updated>%s</updated>"
+		                        "<title type='text'>Entry %s</title>"
+		                        "%s"
+		                        "</entry>",
+		                        entries[i].etag, entries[i].id, entries[i].updated, entries[i].id,
+		                        (entries[i].deleted == TRUE) ? "<gd:deleted/>" : "");
+	}
+
+	g_string_append (feed_xml, "</feed>");
+
+	g_mutex_lock (&(sync_server->mutex));
+	g_free (sync_server->response);
+	sync_server->response = g_string_free (feed_xml, FALSE);
+	g_mutex_unlock (&(sync_server->mutex));
+}
+
+static void
+sync_test_server_start (SyncTestServer *sync_server)
+{
+	g_mutex_init (&(sync_server->mutex));
+	sync_server->response = NULL;
+	sync_server->updated_min = NULL;
+	sync_test_server_set_changes (sync_server, NULL, 0);
+
+	test_server_start (&(sync_server->parent), (SoupServerCallback) test_server_sync_handler_cb);
+}
+
+static void
+sync_test_server_stop (SyncTestServer *sync_server)
+{
+	test_server_stop (&(sync_server->parent));
+
+	g_free (sync_server->updated_min);
+	g_free (sync_server->response);
+	g_mutex_clear (&(sync_server->mutex));
+}
+
+/* Appends a line to the @log for each signal emitted by the #GDataSync */
+static void
+sync_entry_added_cb (GDataSync *sync, GDataEntry *entry, GString *log)
+{
+	g_assert (gdata_sync_look_up_entry (sync, gdata_entry_get_id (entry)) == entry);
+	g_string_append_printf (log, "added %s %s\n", gdata_entry_get_id (entry), gdata_entry_get_etag (entry));
+}
+
+static void
+sync_entry_updated_cb (GDataSync *sync, GDataEntry *entry, GString *log)
+{
+	g_assert (gdata_sync_look_up_entry (sync, gdata_entry_get_id (entry)) == entry);
+	g_string_append_printf (log, "updated %s %s\n", gdata_entry_get_id (entry), gdata_entry_get_etag (entry));
+}
+
+static void
+sync_entry_removed_cb (GDataSync *sync, GDataEntry *entry, GString *log)
+{
+	g_assert (gdata_sync_look_up_entry (sync, gdata_entry_get_id (entry)) == NULL);
+	g_string_append_printf (log, "removed %s %s\n", gdata_entry_get_id (entry), gdata_entry_get_etag (entry));
+}
+
+static GDataSync *
+create_sync (GDataService *service, SyncTestServer *sync_server, GString *log)
+{
+	GDataSync *sync;
+
+	/* Contacts have a deleted property, so removals can be detected */
+	sync = gdata_sync_new (service, NULL, sync_server->parent.feed_uri, NULL, GDATA_TYPE_CONTACTS_CONTACT);
+	g_signal_connect (sync, "entry-added", (GCallback) sync_entry_added_cb, log);
+	g_signal_connect (sync, "entry-updated", (GCallback) sync_entry_updated_cb, log);
+	g_signal_connect (sync, "entry-removed", (GCallback) sync_entry_removed_cb, log);
+
+	return sync;
+}
+
+/* Run the sync and check the signals it emits, and the updated-min parameter of its request */
+static void
+run_sync_and_check (GDataSync *sync, SyncTestServer *sync_server, GString *log, const gchar *expected_updated_min, const gchar *expected_log)
+{
+	gboolean success;
+	GError *error = NULL;
+
+	g_string_truncate (log, 0);
+
+	success = gdata_sync_run (sync, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	g_mutex_lock (&(sync_server->mutex));
+	g_assert_cmpstr (sync_server->updated_min, ==, expected_updated_min);
+	g_mutex_unlock (&(sync_server->mutex));
+
+	g_assert_cmpstr (log->str, ==, expected_log);
+}
+
+/* Check that changes are merged into the local set of entries, using the entries' ETags to spot genuine changes, and that the high-water mark
+ * advances so that only changes are requested */
+static void
+test_sync_merge (void)
+{
+	SyncTestServer sync_server;
+	GDataService *service;
+	GDataSync *sync;
+	GString *log;
+	GList *entries;
+
+	const SyncTestEntry first_changes[] = {
+		{ "A", "\"a1\"", "2013-06-01T12:00:00Z", FALSE },
+		{ "B", "\"b1\"", "2013-06-01T12:00:00Z", FALSE },
+	};
+	const SyncTestEntry second_changes[] = {
+		/* A is returned again (since updated-min is inclusive) but hasn't changed, so shouldn't be reported */
+		{ "A", "\"a1\"", "2013-06-01T12:00:00Z", FALSE },
+		{ "B", "\"b2\"", "2013-06-01T13:00:00Z", FALSE },
+		{ "C", "\"c1\"", "2013-06-01T13:00:00Z", FALSE },
+	};
+	const SyncTestEntry third_changes[] = {
+		{ "B", "\"b3\"", "2013-06-01T14:00:00Z", TRUE },
+		/* Deleting an entry we've never seen shouldn't be reported */
+		{ "D", "\"d1\"", "2013-06-01T14:00:00Z", TRUE },
+	};
+
+	sync_test_server_start (&sync_server);
+
+	service = create_service ();
+	log = g_string_new (NULL);
+	sync = create_sync (service, &sync_server, log);
+
+	/* The first run should retrieve the whole feed */
+	sync_test_server_set_changes (&sync_server, first_changes, G_N_ELEMENTS (first_changes));
+	run_sync_and_check (sync, &sync_server, log, NULL,
+	                    "added http://example.com/entryA \"a1\"\n"
+	                    "added http://example.com/entryB \"b1\"\n");
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, 1370088000);
+
+	sync_test_server_set_changes (&sync_server, second_changes, G_N_ELEMENTS (second_changes));
+	run_sync_and_check (sync, &sync_server, log, "2013-06-01T12:00:00Z",
+	                    "updated http://example.com/entryB \"b2\"\n"
+	                    "added http://example.com/entryC \"c1\"\n");
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, 1370091600);
+	g_assert_cmpstr (gdata_entry_get_etag (gdata_sync_look_up_entry (sync, "http://example.com/entryB")), ==, "\"b2\"");
+
+	sync_test_server_set_changes (&sync_server, third_changes, G_N_ELEMENTS (third_changes));
+	run_sync_and_check (sync, &sync_server, log, "2013-06-01T13:00:00Z",
+	                    "removed http://example.com/entryB \"b2\"\n");
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, 1370095200);
+
+	g_assert (gdata_sync_look_up_entry (sync, "http://example.com/entryA") != NULL);
+	g_assert (gdata_sync_look_up_entry (sync, "http://example.com/entryB") == NULL);
+	g_assert (gdata_sync_look_up_entry (sync, "http://example.com/entryC") != NULL);
+	g_assert (gdata_sync_look_up_entry (sync, "http://example.com/entryD") == NULL);
+
+	entries = gdata_sync_get_entries (sync);
+	g_assert_cmpuint (g_list_length (entries), ==, 2);
+	g_list_free (entries);
+
+	g_assert_cmpint (g_atomic_int_get (&(sync_server.parent.n_requests)), ==, 3);
+
+	g_object_unref (sync);
+	g_string_free (log, TRUE);
+	g_object_unref (service);
+	sync_test_server_stop (&sync_server);
+}
+
+/* Check that a second run can't be started while one is in progress, since the two would share the query and high-water mark */
+static void
+test_sync_overlapping_runs (void)
+{
+	SyncTestServer sync_server;
+	GDataService *service;
+	GDataSync *sync;
+	GString *log;
+	GAsyncResult *first_result = NULL, *second_result = NULL;
+	gboolean success;
+	GError *error = NULL;
+
+	const SyncTestEntry changes[] = {
+		{ "A", "\"a1\"", "2013-06-01T12:00:00Z", FALSE },
+	};
+
+	sync_test_server_start (&sync_server);
+	sync_test_server_set_changes (&sync_server, changes, G_N_ELEMENTS (changes));
+
+	service = create_service ();
+	log = g_string_new (NULL);
+	sync = create_sync (service, &sync_server, log);
+
+	main_loop = g_main_loop_new (NULL, FALSE);
+
+	gdata_sync_run_async (sync, NULL, (GAsyncReadyCallback) async_result_cb, &first_result);
+
+	/* Synchronous and asynchronous runs should both be refused while the first run is in progress */
+	success = gdata_sync_run (sync, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_PENDING);
+	g_assert (success == FALSE);
+	g_clear_error (&error);
+
+	gdata_sync_run_async (sync, NULL, (GAsyncReadyCallback) async_result_cb, &second_result);
+
+	while (first_result == NULL || second_result == NULL)
+		g_main_loop_run (main_loop);
+
+	success = gdata_sync_run_finish (sync, second_result, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_PENDING);
+	g_assert (success == FALSE);
+	g_clear_error (&error);
+
+	/* The first run should have been unaffected */
+	success = gdata_sync_run_finish (sync, first_result, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	g_assert_cmpstr (log->str, ==, "added http://example.com/entryA \"a1\"\n");
+	g_assert_cmpint (gdata_sync_get_updated_min (sync), ==, 1370088000);
+	g_assert_cmpint (g_atomic_int_get (&(sync_server.parent.n_requests)), ==, 1);
+
+	g_object_unref (second_result);
+	g_object_unref (first_result);
+
+	g_main_loop_unref (main_loop);
+	main_loop = NULL;
+
+	/* Another run can be started once the first has finished */
+	run_sync_and_check (sync, &sync_server, log, "2013-06-01T12:00:00Z", "");
+	g_assert_cmpint (g_atomic_int_get (&(sync_server.parent.n_requests)), ==, 2);
+
+	g_object_unref (sync);
+	g_string_free (log, TRUE);
+	g_object_unref (service);
+	sync_test_server_stop (&sync_server);
+}
+
+int
+main (int argc, char *argv[])
+{
+	gdata_test_init (argc, argv);
+
+	g_test_add_data_func ("/service/query/progress/sync", GUINT_TO_POINTER (0), test_query_progress);
+	g_test_add_data_func ("/service/query/progress/async", GUINT_TO_POINTER (1), test_query_progress);
+	g_test_add_data_func ("/service/query/progress/batched", GUINT_TO_POINTER (2), test_query_progress);
+	g_test_add_data_func ("/service/query/coalesce", GUINT_TO_POINTER (0), test_query_coalesce);
+	g_test_add_data_func ("/service/query/coalesce/cancel-first", GUINT_TO_POINTER (1), test_query_coalesce);
+
+	g_test_add_func ("/service/request-finished/context", test_request_finished_context);
+
+	g_test_add_func ("/service/cache/revalidation", test_cache_revalidation);
+
+	g_test_add_func ("/service/retry/backoff", test_retry_backoff);
+	g_test_add_func ("/service/retry/retry-after", test_retry_after);
+
+	g_test_add_data_func ("/service/rate-limiter/spacing/sync", GUINT_TO_POINTER (0), test_rate_limiter_spacing);
+	g_test_add_data_func ("/service/rate-limiter/spacing/async", GUINT_TO_POINTER (1), test_rate_limiter_spacing);
+
+	g_test_add_data_func ("/service/connection-pool/limits/1", GUINT_TO_POINTER (1), test_connection_pool_limits);
+	g_test_add_data_func ("/service/connection-pool/limits/3", GUINT_TO_POINTER (3), test_connection_pool_limits);
+
+	g_test_add_data_func ("/service/deadline/mid-request/sync", GUINT_TO_POINTER (0), test_deadline_mid_request);
+	g_test_add_data_func ("/service/deadline/mid-request/async", GUINT_TO_POINTER (1), test_deadline_mid_request);
+	g_test_add_data_func ("/service/deadline/mid-request/coalesced", GUINT_TO_POINTER (2), test_deadline_mid_request);
+
+	g_test_add_func ("/service/hedging/slow-request", test_hedging_slow_request);
+
+	g_test_add_func ("/service/request-scheduler/priorities", test_request_scheduler_priorities);
+	g_test_add_func ("/service/request-scheduler/priority-limits", test_request_scheduler_priority_limits);
+
+	g_test_add_func ("/service/compress-requests", test_compress_requests);
+
+	g_test_add_func ("/service/sync/merge", test_sync_merge);
+	g_test_add_func ("/service/sync/overlapping-runs", test_sync_overlapping_runs);
+
+	g_test_add_func ("/service/circuit-breaker/trip", test_circuit_breaker_trip);
+	g_test_add_func ("/service/circuit-breaker/half-open", test_circuit_breaker_half_open);
+
+	return g_test_run ();
+}
@@ -24,6 +24,7 @@
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include "gdata.h"
 #include "common.h"
@@ -198,6 +199,514 @@ test_download_stream_download_content_length (void)
 	g_main_context_unref (async_context);
 }
 
+static void
+test_download_stream_download_read_buffer (void)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string;
+	GDataService *service;
+	GInputStream *download_stream;
+	SoupBuffer *buffer;
+	GString *contents;
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_content_length_handler_cb, NULL, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	/* Read the entire stream as buffers, mixing in some normal reads to check the two interact correctly */
+	contents = g_string_new (NULL);
+
+	while ((buffer = gdata_download_stream_read_buffer (GDATA_DOWNLOAD_STREAM (download_stream), 20, NULL, &error)) != NULL) {
+		guint8 data[7];
+		gssize length_read;
+
+		g_assert_cmpuint (buffer->length, >, 0);
+		g_assert_cmpuint (buffer->length, <=, 20);
+
+		g_string_append_len (contents, buffer->data, buffer->length);
+		soup_buffer_free (buffer);
+
+		length_read = g_input_stream_read (download_stream, data, sizeof (data), NULL, &error);
+		g_assert_no_error (error);
+		g_assert_cmpint (length_read, >=, 0);
+
+		g_string_append_len (contents, (const gchar*) data, length_read);
+	}
+
+	/* Check we've reached EOF successfully */
+	g_assert_no_error (error);
+	g_assert (gdata_download_stream_read_buffer (GDATA_DOWNLOAD_STREAM (download_stream), 20, NULL, &error) == NULL);
+	g_assert_no_error (error);
+
+	/* Close the stream */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Compare the downloaded string to the original */
+	test_string = get_test_string (1, 1000);
+
+	g_assert_cmpint (contents->len, ==, strlen (test_string) + 1);
+	g_assert_cmpstr (contents->str, ==, test_string);
+
+	g_free (test_string);
+	g_string_free (contents, TRUE);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+static void
+test_download_stream_download_buffer_size (void)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string;
+	GDataService *service;
+	GInputStream *download_stream;
+	gssize length_read;
+	GString *contents;
+	guint8 buffer[1000];
+	gulong buffer_size;
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_content_length_handler_cb, NULL, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	/* Check the default and set a tiny buffer size so that the download is paused repeatedly */
+	g_assert_cmpuint (gdata_download_stream_get_buffer_size (GDATA_DOWNLOAD_STREAM (download_stream)), ==, 1024 * 1024);
+	gdata_download_stream_set_buffer_size (GDATA_DOWNLOAD_STREAM (download_stream), 64);
+
+	g_object_get (download_stream, "buffer-size", &buffer_size, NULL);
+	g_assert_cmpuint (buffer_size, ==, 64);
+
+	/* Read more than the buffer size in one go, which must not deadlock, then read the rest in small pieces */
+	contents = g_string_new (NULL);
+
+	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, sizeof (buffer));
+	g_string_append_len (contents, (const gchar*) buffer, length_read);
+
+	while ((length_read = g_input_stream_read (download_stream, buffer, 10, NULL, &error)) > 0)
+		g_string_append_len (contents, (const gchar*) buffer, length_read);
+
+	/* Check we've reached EOF successfully */
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, 0);
+
+	/* Close the stream */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Compare the downloaded string to the original */
+	test_string = get_test_string (1, 1000);
+
+	g_assert_cmpint (contents->len, ==, strlen (test_string) + 1);
+	g_assert_cmpstr (contents->str, ==, test_string);
+
+	g_free (test_string);
+	g_string_free (contents, TRUE);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+static gboolean
+quit_main_loop_cb (GMainLoop *main_loop)
+{
+	g_main_loop_quit (main_loop);
+
+	return FALSE;
+}
+
+static void
+test_download_stream_download_prefetch_notify_cb (GObject *object, GParamSpec *pspec, GMainLoop *main_loop)
+{
+	GSource *source;
+
+	/* This is emitted in the network thread, so quit the main loop from inside it, in case it hasn't started running yet */
+	source = g_idle_source_new ();
+	g_source_set_callback (source, (GSourceFunc) quit_main_loop_cb, g_main_loop_ref (main_loop), (GDestroyNotify) g_main_loop_unref);
+	g_source_attach (source, g_main_loop_get_context (main_loop));
+	g_source_unref (source);
+}
+
+static void
+test_download_stream_download_prefetch (void)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string;
+	GDataService *service;
+	GInputStream *download_stream;
+	gssize length_read;
+	GString *contents;
+	guint8 buffer[20];
+	GMainContext *main_context;
+	GMainLoop *main_loop;
+	gulong notify_signal;
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_content_length_handler_cb, NULL, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	main_context = g_main_context_new ();
+	main_loop = g_main_loop_new (main_context, FALSE);
+	notify_signal = g_signal_connect (download_stream, "notify::content-length", (GCallback) test_download_stream_download_prefetch_notify_cb,
+	                                  main_loop);
+
+	/* Start the download without reading from the stream; prefetching twice should be harmless */
+	success = gdata_download_stream_prefetch (GDATA_DOWNLOAD_STREAM (download_stream), &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	success = gdata_download_stream_prefetch (GDATA_DOWNLOAD_STREAM (download_stream), &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* The response headers should arrive without any reads */
+	if (gdata_download_stream_get_content_length (GDATA_DOWNLOAD_STREAM (download_stream)) == -1)
+		g_main_loop_run (main_loop);
+
+	g_signal_handler_disconnect (download_stream, notify_signal);
+	g_main_loop_unref (main_loop);
+	g_main_context_unref (main_context);
+
+	test_string = get_test_string (1, 1000);
+	g_assert_cmpint (gdata_download_stream_get_content_length (GDATA_DOWNLOAD_STREAM (download_stream)), ==, strlen (test_string) + 1);
+
+	/* Read the file as normal */
+	contents = g_string_new (NULL);
+
+	while ((length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error)) > 0)
+		g_string_append_len (contents, (const gchar*) buffer, length_read);
+
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, 0);
+
+	g_assert_cmpint (contents->len, ==, strlen (test_string) + 1);
+	g_assert_cmpstr (contents->str, ==, test_string);
+
+	g_free (test_string);
+	g_string_free (contents, TRUE);
+
+	/* Close the stream, after which prefetching should fail */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	success = gdata_download_stream_prefetch (GDATA_DOWNLOAD_STREAM (download_stream), &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED);
+	g_assert (success == FALSE);
+	g_clear_error (&error);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+typedef struct {
+	volatile gint n_range_requests;
+	gboolean change_file; /* whether to change the file's ETag once the first range has been requested */
+} RangeTestData;
+
+static void
+test_download_stream_download_server_range_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query,
+                                                       SoupClientContext *client, RangeTestData *data)
+{
+	gchar *test_string;
+	const gchar *etag;
+	goffset test_string_length;
+	SoupRange *ranges;
+	int n_ranges;
+
+	/* Large enough to be split into several ranges */
+	test_string = get_test_string (1, 250000);
+	test_string_length = strlen (test_string) + 1;
+
+	etag = (data->change_file == TRUE && g_atomic_int_get (&(data->n_range_requests)) > 0) ? "\"version-2\"" : "\"version-1\"";
+
+	soup_message_headers_set_content_type (message->response_headers, "text/plain", NULL);
+	soup_message_headers_append (message->response_headers, "Accept-Ranges", "bytes");
+	soup_message_headers_replace (message->response_headers, "ETag", etag);
+
+	/* Every range must be validated, and is only returned if it's from the same version of the file as the others; otherwise, as for If-Range,
+	 * the whole of the current version is returned */
+	if (soup_message_headers_get_ranges (message->request_headers, test_string_length, &ranges, &n_ranges) == TRUE &&
+	    g_strcmp0 (soup_message_headers_get_one (message->request_headers, "If-Range"), etag) == 0) {
+		/* Only single ranges are supported */
+		g_assert_cmpint (n_ranges, ==, 1);
+
+		g_atomic_int_inc (&(data->n_range_requests));
+
+		soup_message_set_status (message, SOUP_STATUS_PARTIAL_CONTENT);
+		soup_message_headers_set_content_range (message->response_headers, ranges[0].start, ranges[0].end, test_string_length);
+		soup_message_body_append (message->response_body, SOUP_MEMORY_COPY, test_string + ranges[0].start,
+		                          ranges[0].end - ranges[0].start + 1);
+
+		soup_message_headers_free_ranges (message->request_headers, ranges);
+	} else {
+		/* A range request with the wrong validator should only be made if the file's changed */
+		g_assert (soup_message_headers_get_one (message->request_headers, "Range") == NULL || data->change_file == TRUE);
+
+		soup_message_set_status (message, SOUP_STATUS_OK);
+		soup_message_headers_set_content_length (message->response_headers, test_string_length);
+
+		if (message->method != SOUP_METHOD_HEAD)
+			soup_message_body_append (message->response_body, SOUP_MEMORY_COPY, test_string, test_string_length);
+	}
+
+	g_free (test_string);
+}
+
+/* Download a file to disk over several connections. If @user_data is 1, the file changes on the server after the first range has been downloaded,
+ * so the download should fail rather than mixing ranges from the two versions. */
+static void
+test_download_stream_download_to_file (gconstpointer user_data)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string, *contents, *temp_path;
+	gsize length;
+	GDataService *service;
+	GInputStream *download_stream;
+	GFile *destination;
+	RangeTestData data = { 0, FALSE };
+	gint fd;
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	data.change_file = (GPOINTER_TO_UINT (user_data) == 1) ? TRUE : FALSE;
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_range_handler_cb, &data, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	/* Download the file over several connections */
+	fd = g_file_open_tmp ("libgdata-download-to-file-XXXXXX", &temp_path, &error);
+	g_assert_no_error (error);
+	close (fd);
+
+	destination = g_file_new_for_path (temp_path);
+
+	success = gdata_download_stream_download_to_file (GDATA_DOWNLOAD_STREAM (download_stream), destination, 4, NULL, &error);
+
+	if (data.change_file == TRUE) {
+		g_assert_error (error, GDATA_SERVICE_ERROR, GDATA_SERVICE_ERROR_CONFLICT);
+		g_assert (success == FALSE);
+		g_clear_error (&error);
+
+		/* Only the first range should have been returned */
+		g_assert_cmpint (g_atomic_int_get (&(data.n_range_requests)), ==, 1);
+
+		goto done;
+	}
+
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Check the file really was downloaded in several ranges */
+	g_assert_cmpint (g_atomic_int_get (&(data.n_range_requests)), >, 1);
+
+	/* Compare the downloaded file to the original */
+	success = g_file_load_contents (destination, NULL, &contents, &length, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	test_string = get_test_string (1, 250000);
+
+	g_assert_cmpuint (length, ==, strlen (test_string) + 1);
+	g_assert_cmpstr (contents, ==, test_string);
+
+	g_free (test_string);
+	g_free (contents);
+
+done:
+	g_file_delete (destination, NULL, NULL);
+	g_object_unref (destination);
+	g_free (temp_path);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+static void
+test_download_stream_download_server_resume_wrote_body_data_cb (SoupMessage *message, SoupBuffer *chunk, SoupClientContext *client)
+{
+	/* Drop the connection part-way through the response */
+	soup_socket_disconnect (soup_client_context_get_socket (client));
+}
+
+static void
+test_download_stream_download_server_resume_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query,
+                                                        SoupClientContext *client, guint *n_requests)
+{
+	gchar *test_string;
+	goffset test_string_length, start, end;
+	SoupRange *ranges;
+	int n_ranges;
+
+	test_string = get_test_string (1, 1000);
+	test_string_length = strlen (test_string) + 1;
+
+	soup_message_headers_replace (message->response_headers, "ETag", "\"resume-test\"");
+	soup_message_headers_set_content_type (message->response_headers, "text/plain", NULL);
+
+	if (*n_requests == 0) {
+		/* Claim to send the whole file, but only send half of it before dropping the connection */
+		soup_message_set_status (message, SOUP_STATUS_OK);
+		soup_message_headers_set_content_length (message->response_headers, test_string_length);
+		soup_message_body_append (message->response_body, SOUP_MEMORY_COPY, test_string, test_string_length / 2);
+
+		g_signal_connect (message, "wrote-body-data", (GCallback) test_download_stream_download_server_resume_wrote_body_data_cb, client);
+	} else {
+		/* The resumed request must ask for the rest of the same version of the file */
+		g_assert_cmpstr (soup_message_headers_get_one (message->request_headers, "If-Range"), ==, "\"resume-test\"");
+		g_assert (soup_message_headers_get_ranges (message->request_headers, test_string_length, &ranges, &n_ranges) == TRUE);
+		g_assert_cmpint (n_ranges, ==, 1);
+
+		start = ranges[0].start;
+		end = ranges[0].end;
+		soup_message_headers_free_ranges (message->request_headers, ranges);
+
+		g_assert_cmpint (start, ==, test_string_length / 2);
+
+		soup_message_set_status (message, SOUP_STATUS_PARTIAL_CONTENT);
+		soup_message_headers_set_content_range (message->response_headers, start, end, test_string_length);
+		soup_message_body_append (message->response_body, SOUP_MEMORY_COPY, test_string + start, end - start + 1);
+	}
+
+	*n_requests += 1;
+
+	g_free (test_string);
+}
+
+static void
+test_download_stream_download_resume (void)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string;
+	GDataService *service;
+	GDataRetryPolicy *policy;
+	GInputStream *download_stream;
+	gssize length_read;
+	GString *contents;
+	guint8 buffer[20];
+	guint n_requests = 0;
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_resume_handler_cb, &n_requests, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server, with a retry policy so that the download's resumed */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+
+	policy = gdata_retry_policy_new ();
+	gdata_retry_policy_set_initial_delay (policy, 10);
+	gdata_service_set_retry_policy (service, policy);
+	g_object_unref (policy);
+
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	/* Read the whole file, which shouldn't give an error despite the connection being dropped */
+	contents = g_string_new (NULL);
+
+	while ((length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error)) > 0)
+		g_string_append_len (contents, (const gchar*) buffer, length_read);
+
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, 0);
+	g_assert_cmpuint (n_requests, ==, 2);
+
+	/* Close the stream */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Compare the downloaded string to the original */
+	test_string = get_test_string (1, 1000);
+
+	g_assert_cmpint (contents->len, ==, strlen (test_string) + 1);
+	g_assert_cmpstr (contents->str, ==, test_string);
+
+	g_free (test_string);
+	g_string_free (contents, TRUE);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
 static void
 test_download_stream_download_server_seek_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query,
                                                       SoupClientContext *client, gpointer user_data)
@@ -288,39 +797,250 @@ test_download_stream_download_seek_before_start (void)
 	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), >, test_string_length - sizeof (buffer));
 	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), <=, test_string_length);
 
-	/* Close the stream */
-	success = g_input_stream_close (download_stream, NULL, &error);
-	g_assert_no_error (error);
-	g_assert (success == TRUE);
+	/* Close the stream */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+/* Test seeking forwards after the first read */
+static void
+test_download_stream_download_seek_after_start_forwards (void)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string;
+	goffset test_string_offset = 0;
+	guint test_string_length;
+	GDataService *service;
+	GInputStream *download_stream;
+	gssize length_read;
+	guint8 buffer[20];
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_seek_handler_cb, NULL, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	/* Read alternating blocks into a string and compare with what we expect as we go. i.e. Read 20 bytes, then skip 20 bytes, etc. */
+	test_string = get_test_string (1, 1000);
+	test_string_length = strlen (test_string) + 1;
+
+	while (TRUE) {
+		/* Check the seek offset */
+		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+
+		/* Read a buffer-load */
+		length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+
+		g_assert_no_error (error);
+		g_assert_cmpint (length_read, <=, sizeof (buffer));
+
+		/* Check the buffer-load against the test string */
+		g_assert (memcmp (buffer, test_string + test_string_offset, length_read) == 0);
+		test_string_offset += length_read;
+
+		/* Check the seek offset again */
+		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+
+		if (length_read < (gssize) sizeof (buffer)) {
+			/* Done */
+			break;
+		}
+
+		/* Seek forward a buffer length */
+		if (g_seekable_seek (G_SEEKABLE (download_stream), sizeof (buffer), G_SEEK_CUR, NULL, &error) == FALSE) {
+			/* Tried to seek past the end of the stream */
+			g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+			g_clear_error (&error);
+			break;
+		}
+
+		test_string_offset += sizeof (buffer);
+		g_assert_no_error (error);
+
+		/* Check the seek offset again */
+		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+	}
+
+	g_free (test_string);
+
+	/* Check the seek offset is within one buffer-load of the end */
+	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), >, test_string_length - sizeof (buffer));
+	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), <=, test_string_length);
+
+	/* Close the stream */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+/* Test seeking backwards after the first read */
+static void
+test_download_stream_download_seek_after_start_backwards (void)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *download_uri, *test_string;
+	goffset test_string_offset = 0;
+	guint repeat_count;
+	GDataService *service;
+	GInputStream *download_stream;
+	gssize length_read;
+	guint8 buffer[20];
+	gboolean success;
+	GError *error = NULL;
+
+	/* Create and run the server */
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_seek_handler_cb, NULL, &async_context);
+	thread = run_server (server);
+
+	/* Create a new download stream connected to the server */
+	download_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	download_stream = gdata_download_stream_new (service, NULL, download_uri, NULL);
+	g_object_unref (service);
+	g_free (download_uri);
+
+	/* Read a block in, then skip back over the block again. i.e. Read the first block, read the second block, skip back over the second block,
+	 * read the second block again, skip back over it, etc. Close the stream after doing this several times. */
+	test_string = get_test_string (1, 1000);
+
+	/* Read a buffer-load to begin with */
+	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+
+	g_assert_no_error (error);
+	test_string_offset += length_read;
+
+	for (repeat_count = 6; repeat_count > 0; repeat_count--) {
+		/* Check the seek offset */
+		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+
+		/* Read a buffer-load */
+		length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+
+		g_assert_no_error (error);
+		g_assert_cmpint (length_read, <=, sizeof (buffer));
+
+		/* Check the buffer-load against the test string */
+		g_assert (memcmp (buffer, test_string + test_string_offset, length_read) == 0);
+		test_string_offset += length_read;
+
+		/* Check the seek offset again */
+		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+
+		/* Seek backwards a buffer length */
+		success = g_seekable_seek (G_SEEKABLE (download_stream), -length_read, G_SEEK_CUR, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (success == TRUE);
+		test_string_offset -= length_read;
+
+		/* Check the seek offset again */
+		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+	}
+
+	g_free (test_string);
+
+	/* Check the seek offset is at the end of the first buffer-load */
+	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, sizeof (buffer));
+
+	/* Close the stream */
+	success = g_input_stream_close (download_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (download_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+}
+
+static void
+test_download_stream_download_server_range_counting_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query,
+                                                                SoupClientContext *client, guint *n_get_requests)
+{
+	gchar *test_string;
+	goffset test_string_length;
+	SoupRange *ranges;
+	int n_ranges;
+
+	test_string = get_test_string (1, 1000);
+	test_string_length = strlen (test_string) + 1;
+
+	soup_message_headers_set_content_type (message->response_headers, "text/plain", NULL);
+
+	if (message->method == SOUP_METHOD_HEAD) {
+		/* Only give the Content-Length in response to HEAD requests */
+		soup_message_set_status (message, SOUP_STATUS_OK);
+		soup_message_headers_set_content_length (message->response_headers, test_string_length);
+	} else if (soup_message_headers_get_ranges (message->request_headers, test_string_length, &ranges, &n_ranges) == TRUE) {
+		g_assert_cmpint (n_ranges, ==, 1);
+
+		soup_message_set_status (message, SOUP_STATUS_PARTIAL_CONTENT);
+		soup_message_headers_set_content_range (message->response_headers, ranges[0].start, ranges[0].end, test_string_length);
+		soup_message_body_append (message->response_body, SOUP_MEMORY_COPY, test_string + ranges[0].start,
+		                          ranges[0].end - ranges[0].start + 1);
 
-	/* Kill the server and wait for it to die */
-	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
-	g_thread_join (thread);
+		soup_message_headers_free_ranges (message->request_headers, ranges);
+		*n_get_requests += 1;
+	} else {
+		soup_message_set_status (message, SOUP_STATUS_OK);
+		soup_message_headers_set_encoding (message->response_headers, SOUP_ENCODING_CHUNKED);
+		soup_message_body_append (message->response_body, SOUP_MEMORY_COPY, test_string, test_string_length);
+		*n_get_requests += 1;
+	}
 
-	g_object_unref (download_stream);
-	g_object_unref (server);
-	g_main_context_unref (async_context);
+	g_free (test_string);
 }
 
-/* Test seeking forwards after the first read */
+/* Test that seeking backwards into the seek window doesn't restart the download, but seeking back further does */
 static void
-test_download_stream_download_seek_after_start_forwards (void)
+test_download_stream_download_seek_window (void)
 {
 	SoupServer *server;
 	GMainContext *async_context;
 	GThread *thread;
 	gchar *download_uri, *test_string;
-	goffset test_string_offset = 0;
-	guint test_string_length;
 	GDataService *service;
 	GInputStream *download_stream;
 	gssize length_read;
 	guint8 buffer[20];
+	gulong seek_window_size;
+	guint n_get_requests = 0;
 	gboolean success;
 	GError *error = NULL;
 
 	/* Create and run the server */
-	server = create_server ((SoupServerCallback) test_download_stream_download_server_seek_handler_cb, NULL, &async_context);
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_range_counting_handler_cb, &n_get_requests, &async_context);
 	thread = run_server (server);
 
 	/* Create a new download stream connected to the server */
@@ -330,52 +1050,52 @@ test_download_stream_download_seek_after_start_forwards (void)
 	g_object_unref (service);
 	g_free (download_uri);
 
-	/* Read alternating blocks into a string and compare with what we expect as we go. i.e. Read 20 bytes, then skip 20 bytes, etc. */
-	test_string = get_test_string (1, 1000);
-	test_string_length = strlen (test_string) + 1;
+	g_assert_cmpuint (gdata_download_stream_get_seek_window_size (GDATA_DOWNLOAD_STREAM (download_stream)), ==, 64 * 1024);
+	gdata_download_stream_set_seek_window_size (GDATA_DOWNLOAD_STREAM (download_stream), 100);
 
-	while (TRUE) {
-		/* Check the seek offset */
-		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+	g_object_get (download_stream, "seek-window-size", &seek_window_size, NULL);
+	g_assert_cmpuint (seek_window_size, ==, 100);
 
-		/* Read a buffer-load */
-		length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+	test_string = get_test_string (1, 1000);
 
+	/* Read a few blocks, then seek back into them and read them again */
+	while (g_seekable_tell (G_SEEKABLE (download_stream)) < 60) {
+		length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
 		g_assert_no_error (error);
-		g_assert_cmpint (length_read, <=, sizeof (buffer));
-
-		/* Check the buffer-load against the test string */
-		g_assert (memcmp (buffer, test_string + test_string_offset, length_read) == 0);
-		test_string_offset += length_read;
+		g_assert_cmpint (length_read, >, 0);
+	}
 
-		/* Check the seek offset again */
-		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+	success = g_seekable_seek (G_SEEKABLE (download_stream), 10, G_SEEK_SET, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
 
-		if (length_read < (gssize) sizeof (buffer)) {
-			/* Done */
-			break;
-		}
+	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, sizeof (buffer));
+	g_assert (memcmp (buffer, test_string + 10, length_read) == 0);
+	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, 30);
 
-		/* Seek forward a buffer length */
-		if (g_seekable_seek (G_SEEKABLE (download_stream), sizeof (buffer), G_SEEK_CUR, NULL, &error) == FALSE) {
-			/* Tried to seek past the end of the stream */
-			g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
-			g_clear_error (&error);
-			break;
-		}
+	g_assert_cmpuint (n_get_requests, ==, 1);
 
-		test_string_offset += sizeof (buffer);
+	/* Read on past the window, then seek back to the start, which must restart the download */
+	while (g_seekable_tell (G_SEEKABLE (download_stream)) < 300) {
+		length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
 		g_assert_no_error (error);
-
-		/* Check the seek offset again */
-		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+		g_assert_cmpint (length_read, >, 0);
 	}
 
-	g_free (test_string);
+	success = g_seekable_seek (G_SEEKABLE (download_stream), 5, G_SEEK_SET, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
 
-	/* Check the seek offset is within one buffer-load of the end */
-	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), >, test_string_length - sizeof (buffer));
-	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), <=, test_string_length);
+	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, >, 0);
+	g_assert (memcmp (buffer, test_string + 5, length_read) == 0);
+
+	g_assert_cmpuint (n_get_requests, ==, 2);
+
+	g_free (test_string);
 
 	/* Close the stream */
 	success = g_input_stream_close (download_stream, NULL, &error);
@@ -391,25 +1111,25 @@ test_download_stream_download_seek_after_start_forwards (void)
 	g_main_context_unref (async_context);
 }
 
-/* Test seeking backwards after the first read */
+/* Test seeking relative to the end of the stream when the server only gives the Content-Length in response to a HEAD request */
 static void
-test_download_stream_download_seek_after_start_backwards (void)
+test_download_stream_download_seek_end (void)
 {
 	SoupServer *server;
 	GMainContext *async_context;
 	GThread *thread;
 	gchar *download_uri, *test_string;
-	goffset test_string_offset = 0;
-	guint repeat_count;
+	goffset test_string_length;
 	GDataService *service;
 	GInputStream *download_stream;
 	gssize length_read;
 	guint8 buffer[20];
+	guint n_get_requests = 0;
 	gboolean success;
 	GError *error = NULL;
 
 	/* Create and run the server */
-	server = create_server ((SoupServerCallback) test_download_stream_download_server_seek_handler_cb, NULL, &async_context);
+	server = create_server ((SoupServerCallback) test_download_stream_download_server_range_counting_handler_cb, &n_get_requests, &async_context);
 	thread = run_server (server);
 
 	/* Create a new download stream connected to the server */
@@ -419,48 +1139,31 @@ test_download_stream_download_seek_after_start_backwards (void)
 	g_object_unref (service);
 	g_free (download_uri);
 
-	/* Read a block in, then skip back over the block again. i.e. Read the first block, read the second block, skip back over the second block,
-	 * read the second block again, skip back over it, etc. Close the stream after doing this several times. */
 	test_string = get_test_string (1, 1000);
+	test_string_length = strlen (test_string) + 1;
 
-	/* Read a buffer-load to begin with */
-	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
-
+	/* Seek to just before the end before anything's been downloaded */
+	success = g_seekable_seek (G_SEEKABLE (download_stream), -(goffset) sizeof (buffer), G_SEEK_END, NULL, &error);
 	g_assert_no_error (error);
-	test_string_offset += length_read;
-
-	for (repeat_count = 6; repeat_count > 0; repeat_count--) {
-		/* Check the seek offset */
-		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
-
-		/* Read a buffer-load */
-		length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
-
-		g_assert_no_error (error);
-		g_assert_cmpint (length_read, <=, sizeof (buffer));
+	g_assert (success == TRUE);
 
-		/* Check the buffer-load against the test string */
-		g_assert (memcmp (buffer, test_string + test_string_offset, length_read) == 0);
-		test_string_offset += length_read;
+	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_length - sizeof (buffer));
+	g_assert_cmpint (gdata_download_stream_get_content_length (GDATA_DOWNLOAD_STREAM (download_stream)), ==, test_string_length);
 
-		/* Check the seek offset again */
-		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
+	/* Read the end of the file */
+	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, sizeof (buffer));
+	g_assert (memcmp (buffer, test_string + test_string_length - sizeof (buffer), length_read) == 0);
 
-		/* Seek backwards a buffer length */
-		success = g_seekable_seek (G_SEEKABLE (download_stream), -length_read, G_SEEK_CUR, NULL, &error);
-		g_assert_no_error (error);
-		g_assert (success == TRUE);
-		test_string_offset -= length_read;
+	length_read = g_input_stream_read (download_stream, buffer, sizeof (buffer), NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (length_read, ==, 0);
 
-		/* Check the seek offset again */
-		g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, test_string_offset);
-	}
+	g_assert_cmpuint (n_get_requests, ==, 1);
 
 	g_free (test_string);
 
-	/* Check the seek offset is at the end of the first buffer-load */
-	g_assert_cmpint (g_seekable_tell (G_SEEKABLE (download_stream)), ==, sizeof (buffer));
-
 	/* Close the stream */
 	success = g_input_stream_close (download_stream, NULL, &error);
 	g_assert_no_error (error);
@@ -561,6 +1264,192 @@ test_upload_stream_upload_no_entry_content_length (void)
 	g_main_context_unref (async_context);
 }
 
+/* A server for testing write-behind, which is held (blocking its thread so that it doesn't read anything from the network) until the test releases
+ * it, and can reject uploads with an error as soon as it's received their headers */
+typedef struct {
+	GMutex mutex;
+	GCond cond;
+	gboolean held; /* protected by mutex */
+	gboolean released; /* protected by mutex */
+	gboolean fail;
+	gsize expected_length;
+	volatile gint n_received; /* number of requests whose body has been received by the handler */
+} BufferTestServer;
+
+static gboolean
+test_upload_stream_upload_buffer_size_hold_cb (BufferTestServer *data)
+{
+	g_mutex_lock (&(data->mutex));
+
+	data->held = TRUE;
+	g_cond_broadcast (&(data->cond));
+
+	while (data->released == FALSE)
+		g_cond_wait (&(data->cond), &(data->mutex));
+
+	g_mutex_unlock (&(data->mutex));
+
+	return FALSE;
+}
+
+static void
+test_upload_stream_upload_buffer_size_got_headers_cb (SoupMessage *message, BufferTestServer *data)
+{
+	/* Reject the upload without reading its body */
+	soup_message_set_status (message, SOUP_STATUS_FORBIDDEN);
+}
+
+static void
+test_upload_stream_upload_buffer_size_request_started_cb (SoupServer *server, SoupMessage *message, SoupClientContext *client,
+                                                          BufferTestServer *data)
+{
+	if (data->fail == TRUE)
+		g_signal_connect (message, "got-headers", (GCallback) test_upload_stream_upload_buffer_size_got_headers_cb, data);
+}
+
+static void
+test_upload_stream_upload_buffer_size_server_handler_cb (SoupServer *server, SoupMessage *message, const char *path, GHashTable *query,
+                                                         SoupClientContext *client, BufferTestServer *data)
+{
+	g_atomic_int_inc (&(data->n_received));
+
+	if (data->fail == TRUE) {
+		soup_message_set_status (message, SOUP_STATUS_FORBIDDEN);
+		return;
+	}
+
+	/* Check the client sent all the data */
+	g_assert_cmpuint (message->request_body->length, ==, data->expected_length);
+
+	soup_message_set_status (message, SOUP_STATUS_OK);
+	soup_message_headers_set_content_type (message->response_headers, "text/plain", NULL);
+	soup_message_body_append (message->response_body, SOUP_MEMORY_STATIC, "Test passed!", 13);
+}
+
+/* Test write-behind using GDataUploadStream:buffer-size. The server is held, so that it can't receive anything, until the first write has returned.
+ * If @user_data is 0, that write is of more data than the kernel's socket buffers can hold, so it could only have returned by buffering it. If it's
+ * 1, the server rejects the upload, and the error should be returned by a later write, flush or close, rather than by the write which buffered the
+ * data. */
+static void
+test_upload_stream_upload_buffer_size (gconstpointer user_data)
+{
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *upload_uri, *test_string;
+	GDataService *service;
+	GOutputStream *upload_stream;
+	gssize length_written;
+	gsize test_string_length;
+	gboolean success;
+	BufferTestServer data;
+	GError *error = NULL;
+
+	memset (&data, 0, sizeof (data));
+	g_mutex_init (&(data.mutex));
+	g_cond_init (&(data.cond));
+	data.fail = (GPOINTER_TO_UINT (user_data) == 1) ? TRUE : FALSE;
+
+	if (data.fail == TRUE) {
+		test_string = get_test_string (1, 1000);
+		test_string_length = strlen (test_string) + 1;
+	} else {
+		/* Much more than will fit in the socket buffers, so the data can't reach the network while the server's held */
+		test_string_length = 32 * 1024 * 1024;
+		test_string = g_malloc (test_string_length);
+		memset (test_string, 'a', test_string_length);
+	}
+
+	data.expected_length = test_string_length;
+
+	/* Create the server, and hold it before it can accept any connections */
+	server = create_server ((SoupServerCallback) test_upload_stream_upload_buffer_size_server_handler_cb, &data, &async_context);
+	g_signal_connect (server, "request-started", (GCallback) test_upload_stream_upload_buffer_size_request_started_cb, &data);
+
+	soup_add_completion (async_context, (GSourceFunc) test_upload_stream_upload_buffer_size_hold_cb, &data);
+	thread = run_server (server);
+
+	g_mutex_lock (&(data.mutex));
+	while (data.held == FALSE)
+		g_cond_wait (&(data.cond), &(data.mutex));
+	g_mutex_unlock (&(data.mutex));
+
+	/* Create a new upload stream uploading to the server */
+	upload_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	upload_stream = gdata_upload_stream_new (service, NULL, SOUP_METHOD_POST, upload_uri, NULL, "slug", "text/plain", NULL);
+	g_object_unref (service);
+	g_free (upload_uri);
+
+	/* Writes wait for the network by default */
+	g_assert_cmpuint (gdata_upload_stream_get_buffer_size (GDATA_UPLOAD_STREAM (upload_stream)), ==, 0);
+
+	gdata_upload_stream_set_buffer_size (GDATA_UPLOAD_STREAM (upload_stream), test_string_length);
+	g_assert_cmpuint (gdata_upload_stream_get_buffer_size (GDATA_UPLOAD_STREAM (upload_stream)), ==, test_string_length);
+
+	/* The entire test string fits in the buffer, so should be written in one go without waiting for the network */
+	length_written = g_output_stream_write (upload_stream, test_string, test_string_length, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (length_written, ==, test_string_length);
+
+	g_free (test_string);
+
+	/* The write returned while the server was held, so it can't have received the data */
+	g_assert_cmpint (g_atomic_int_get (&(data.n_received)), ==, 0);
+
+	g_mutex_lock (&(data.mutex));
+	data.released = TRUE;
+	g_cond_broadcast (&(data.cond));
+	g_mutex_unlock (&(data.mutex));
+
+	if (data.fail == TRUE) {
+		/* The error must be returned by one of the later calls. Keep writing until it's seen, since the upload can't finish while we do. */
+		guint i;
+
+		for (i = 0; i < 1000 && error == NULL; i++) {
+			if (g_output_stream_write (upload_stream, "data", 4, NULL, &error) == -1)
+				break;
+			g_usleep (1000);
+		}
+
+		if (error == NULL)
+			g_output_stream_flush (upload_stream, NULL, &error);
+
+		if (error == NULL) {
+			success = g_output_stream_close (upload_stream, NULL, &error);
+			g_assert (success == FALSE);
+		} else {
+			g_output_stream_close (upload_stream, NULL, NULL);
+		}
+
+		g_assert (error != NULL);
+		g_clear_error (&error);
+	} else {
+		/* Wait for it to hit the network */
+		success = g_output_stream_flush (upload_stream, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (success == TRUE);
+
+		/* Close the stream */
+		success = g_output_stream_close (upload_stream, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (success == TRUE);
+
+		g_assert_cmpint (g_atomic_int_get (&(data.n_received)), ==, 1);
+	}
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (upload_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+
+	g_cond_clear (&(data.cond));
+	g_mutex_clear (&(data.mutex));
+}
+
 /* Test parameters for a run of test_upload_stream_resumable(). */
 typedef struct {
 	enum {
@@ -595,7 +1484,6 @@ static const gchar *upload_stream_resumable_error_type_names[] = {
 typedef struct {
 	UploadStreamResumableTestParams *test_params;
 	gsize next_range_start;
-	gsize next_range_end;
 	guint next_path_index;
 	const gchar *test_string;
 } UploadStreamResumableServerData;
@@ -697,20 +1585,22 @@ test_upload_stream_resumable_server_handler_cb (SoupServer *server, SoupMessage
 				g_assert_cmpstr (soup_message_headers_get_content_type (message->request_headers, NULL), ==, "text/plain");
 				g_assert_cmpint (soup_message_headers_get_content_length (message->request_headers), ==, message->request_body->length);
 				g_assert_cmpint (message->request_body->length, >, 0);
-				g_assert_cmpint (message->request_body->length, <=, 512 * 1024 /* 512 KiB */);
+				g_assert_cmpint (message->request_body->length, <=, 8 * 1024 * 1024 /* 8 MiB */);
 				g_assert (soup_message_headers_get_content_range (message->request_headers, &range_start, &range_end,
 				                                                  &range_length) == TRUE);
 				g_assert_cmpint (range_start, ==, server_data->next_range_start);
-				g_assert_cmpint (range_end, ==, server_data->next_range_end);
+				g_assert_cmpint (range_end - range_start + 1, ==, message->request_body->length);
 				g_assert_cmpint (range_length, ==, test_params->file_size);
 
+				/* Chunk sizes may vary, but all chunks apart from the last must be a multiple of 256 KiB. */
+				g_assert (range_end + 1 == (goffset) test_params->file_size || message->request_body->length % (256 * 1024) == 0);
+
 				/* Check the content. */
 				g_assert (memcmp (server_data->test_string + range_start, message->request_body->data,
 				                  message->request_body->length) == 0);
 
 				/* Update the expected values. */
 				server_data->next_range_start = range_end + 1;
-				server_data->next_range_end = MIN (server_data->next_range_start + 512 * 1024, test_params->file_size) - 1;
 				server_data->next_path_index++;
 
 				break;
@@ -863,7 +1753,6 @@ test_upload_stream_resumable (gconstpointer user_data)
 	/* Create and run the server */
 	server_data.test_params = test_params;
 	server_data.next_range_start = 0;
-	server_data.next_range_end = MIN (test_params->file_size, 512 * 1024 /* 512 KiB */) - 1;
 	server_data.next_path_index = 0;
 	server_data.test_string = test_string;
 
@@ -943,6 +1832,77 @@ test_upload_stream_resumable (gconstpointer user_data)
 	g_main_context_unref (async_context);
 }
 
+static void
+test_upload_stream_upload_from_file (void)
+{
+	UploadStreamResumableTestParams test_params = { CONTENT_ONLY, 1025 * 1024 /* > 1024 KiB */, NO_ERROR };
+	UploadStreamResumableServerData server_data;
+	SoupServer *server;
+	GMainContext *async_context;
+	GThread *thread;
+	gchar *upload_uri, *test_string, *file_path;
+	GFile *file;
+	GDataService *service;
+	GOutputStream *upload_stream;
+	gint fd;
+	gboolean success;
+	GError *error = NULL;
+
+	/* Write the test string out to a file */
+	test_string = get_test_string (1, test_params.file_size / 4 /* arbitrary number which should generate enough data */);
+	test_string[test_params.file_size - 1] = '\0'; /* trim the string to the right length */
+
+	fd = g_file_open_tmp ("libgdata-streams-XXXXXX", &file_path, &error);
+	g_assert_no_error (error);
+	close (fd);
+
+	g_file_set_contents (file_path, test_string, test_params.file_size, &error);
+	g_assert_no_error (error);
+
+	file = g_file_new_for_path (file_path);
+
+	/* Create and run the server */
+	server_data.test_params = &test_params;
+	server_data.next_range_start = 0;
+	server_data.next_path_index = 0;
+	server_data.test_string = test_string;
+
+	server = create_server ((SoupServerCallback) test_upload_stream_resumable_server_handler_cb, &server_data, &async_context);
+	thread = run_server (server);
+
+	/* Create a new upload stream uploading the file to the server */
+	upload_uri = build_server_uri (server);
+	service = GDATA_SERVICE (gdata_youtube_service_new ("developer-key", NULL));
+	upload_stream = gdata_upload_stream_new_from_file (service, NULL, SOUP_METHOD_POST, upload_uri, NULL, file, "slug", "text/plain", NULL,
+	                                                   &error);
+	g_assert_no_error (error);
+	g_assert (GDATA_IS_UPLOAD_STREAM (upload_stream));
+	g_object_unref (service);
+	g_free (upload_uri);
+
+	g_assert_cmpint (gdata_upload_stream_get_content_length (GDATA_UPLOAD_STREAM (upload_stream)), ==, test_params.file_size);
+
+	/* Wait for the upload to finish */
+	success = g_output_stream_close (upload_stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success == TRUE);
+
+	g_assert_cmpuint (server_data.next_range_start, ==, test_params.file_size);
+
+	/* Kill the server and wait for it to die */
+	soup_add_completion (async_context, (GSourceFunc) quit_server_cb, server);
+	g_thread_join (thread);
+
+	g_object_unref (upload_stream);
+	g_object_unref (server);
+	g_main_context_unref (async_context);
+
+	g_file_delete (file, NULL, NULL);
+	g_object_unref (file);
+	g_free (file_path);
+	g_free (test_string);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -952,11 +1912,22 @@ main (int argc, char *argv[])
 	g_setenv ("LIBGDATA_DEBUG", "2" /* GDATA_LOG_HEADERS */, TRUE);
 
 	g_test_add_func ("/download-stream/download_content_length", test_download_stream_download_content_length);
+	g_test_add_func ("/download-stream/download_read_buffer", test_download_stream_download_read_buffer);
+	g_test_add_func ("/download-stream/download_buffer_size", test_download_stream_download_buffer_size);
+	g_test_add_func ("/download-stream/download_prefetch", test_download_stream_download_prefetch);
+	g_test_add_data_func ("/download-stream/download_to_file", GUINT_TO_POINTER (0), test_download_stream_download_to_file);
+	g_test_add_data_func ("/download-stream/download_to_file/changed", GUINT_TO_POINTER (1), test_download_stream_download_to_file);
+	g_test_add_func ("/download-stream/download_resume", test_download_stream_download_resume);
 	g_test_add_func ("/download-stream/download_seek/before_start", test_download_stream_download_seek_before_start);
 	g_test_add_func ("/download-stream/download_seek/after_start_forwards", test_download_stream_download_seek_after_start_forwards);
 	g_test_add_func ("/download-stream/download_seek/after_start_backwards", test_download_stream_download_seek_after_start_backwards);
+	g_test_add_func ("/download-stream/download_seek/window", test_download_stream_download_seek_window);
+	g_test_add_func ("/download-stream/download_seek/end", test_download_stream_download_seek_end);
 
 	g_test_add_func ("/upload-stream/upload_no_entry_content_length", test_upload_stream_upload_no_entry_content_length);
+	g_test_add_data_func ("/upload-stream/upload_buffer_size", GUINT_TO_POINTER (0), test_upload_stream_upload_buffer_size);
+	g_test_add_data_func ("/upload-stream/upload_buffer_size/error", GUINT_TO_POINTER (1), test_upload_stream_upload_buffer_size);
+	g_test_add_func ("/upload-stream/upload_from_file", test_upload_stream_upload_from_file);
 
 	/* Test all possible combinations of conditions for resumable uploads. */
 	{
@@ -968,6 +1939,7 @@ main (int argc, char *argv[])
 			666 * 1024, /* > 512 KiB, < 1024 KiB */
 			1024 * 1024, /* 1024 KiB */
 			1025 * 1024, /* > 1024 KiB */
+			3 * 1024 * 1024 + 17, /* several chunks of increasing size */
 		};
 
 		for (i = 0; i < UPLOAD_STREAM_RESUMABLE_MAX_CONTENT_TYPE + 1; i++) {